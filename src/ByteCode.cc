@@ -0,0 +1,1645 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "config.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "ByteCode.h"
+#include "Debug.h"
+#include "Expr.h"
+#include "Frame.h"
+#include "Func.h"
+#include "Reporter.h"
+#include "Scope.h"
+#include "Stmt.h"
+#include "Traverse.h"
+
+int use_bytecode = 0;
+
+// Kinds of values in the unboxed register file.
+enum RegKind {
+	RK_NONE = -1,
+	RK_INT,		// bool, int, enum
+	RK_UINT,	// count, counter, port
+	RK_DOUBLE,	// double, time, interval
+	RK_ADDR,
+};
+
+enum ByteCodeOp {
+	// Loads into Val registers. The first two jump to c if the value
+	// isn't set, the third if the interpreter doesn't yield a value,
+	// which is what makes the interpreter abandon the statement.
+	BC_LOAD_LOCAL,		// v[a] = frame[x.i]
+	BC_LOAD_GLOBAL,		// v[a] = value of x.id
+	BC_EVAL,		// v[a] = x.e evaluated by the interpreter
+	BC_LOAD_CONST,		// v[a] = x.v
+
+	// Constants in unboxed registers.
+	BC_CONST_I, BC_CONST_U, BC_CONST_D,	// n[a] = x
+
+	// Transfers between the two register files. Unboxing releases v[b].
+	BC_UNBOX_I, BC_UNBOX_U, BC_UNBOX_D, BC_UNBOX_A,	// n[a] = v[b]
+	BC_BOX,			// v[a] = n[b] as a Val of type x.t and kind c
+
+	BC_MOVE_N,		// n[a] = n[b]
+	BC_MOVE_V,		// v[a] = v[b], releasing v[b]
+
+	// n[a] = n[b] op n[c]. Division and modulo report errors on behalf
+	// of expr.
+	BC_ADD_I, BC_ADD_U, BC_ADD_D,
+	BC_SUB_I, BC_SUB_U, BC_SUB_D,
+	BC_MUL_I, BC_MUL_U, BC_MUL_D,
+	BC_DIV_I, BC_DIV_U, BC_DIV_D,
+	BC_MOD_I, BC_MOD_U,
+
+	// n[a] = op n[b].
+	BC_NEG_I, BC_NEG_D,
+	BC_NOT,
+	BC_I2U, BC_I2D, BC_U2I, BC_U2D, BC_D2I, BC_D2U,
+
+	// n[a].i = n[b] op n[c]. For > and >=, the operands get swapped.
+	BC_LT_I, BC_LE_I, BC_EQ_I, BC_NE_I,
+	BC_LT_U, BC_LE_U, BC_EQ_U, BC_NE_U,
+	BC_LT_D, BC_LE_D, BC_EQ_D, BC_NE_D,
+	BC_LT_A, BC_LE_A, BC_EQ_A, BC_NE_A,
+
+	// n[a].i = v[b] op v[c] for the comparison with tag x.i, on strings.
+	// Releases both.
+	BC_CMP_S,
+
+	// Records. Field c of the record in v[b], with x.e as the field's
+	// &default expression, if any.
+	BC_FIELD,		// v[a] = v[b]$c, releasing v[b]
+	BC_HAS_FIELD,		// n[a].i = v[b]?$c, releasing v[b]
+	BC_STORE_FIELD,		// v[a]$c = v[b], releasing both
+
+	// Assignments. If c is zero, they release v[b].
+	BC_STORE_LOCAL,		// frame[x.i] = v[b]
+	BC_STORE_GLOBAL,	// x.id = v[b]
+
+	BC_DISCARD,		// Release v[b].
+
+	BC_JUMP,		// goto a
+	BC_JUMP_IF_FALSE,	// if ( ! n[b].i ) goto a
+	BC_JUMP_IF_TRUE,	// if ( n[b].i ) goto a
+
+	BC_EXEC,		// Execute statement x.s by the interpreter.
+	BC_ACCESS,		// Count an execution of statement x.s.
+	BC_EVAL_DISCARD,	// Evaluate x.e by the interpreter for effect.
+	BC_CHECK_DELAYED,	// Return if the frame got delayed.
+	BC_RETURN,		// Return v[b], or nothing if b is negative.
+	BC_END,			// Fall off the end of the body.
+};
+
+union ByteCodeReg {
+	bro_int_t i;
+	bro_uint_t u;
+	double d;
+	in6_addr a;
+};
+
+struct ByteCodeInstr {
+	int op;
+	int a, b, c;
+
+	union {
+		bro_int_t i;
+		bro_uint_t u;
+		double d;
+		Val* v;
+		BroType* t;
+		ID* id;
+		const Expr* e;
+		const Stmt* s;
+	} x;
+
+	// The expression this instruction reports errors for.
+	const Expr* expr;
+};
+
+// Registers of one execution. Small ones live on the stack.
+class ByteCodeRegisters {
+public:
+	ByteCodeRegisters(int arg_num_n, int arg_num_v)
+		{
+		num_v = arg_num_v;
+		n = arg_num_n <= MAX_STACK_REGS ? n_buf : new ByteCodeReg[arg_num_n];
+		v = num_v <= MAX_STACK_REGS ? v_buf : new Val*[num_v];
+
+		for ( int i = 0; i < num_v; ++i )
+			v[i] = 0;
+		}
+
+	~ByteCodeRegisters()
+		{
+		// There may be values left when we bail out early.
+		for ( int i = 0; i < num_v; ++i )
+			Unref(v[i]);
+
+		if ( n != n_buf )
+			delete [] n;
+
+		if ( v != v_buf )
+			delete [] v;
+		}
+
+	ByteCodeReg* n;
+	Val** v;
+
+private:
+	static const int MAX_STACK_REGS = 16;
+
+	ByteCodeReg n_buf[MAX_STACK_REGS];
+	Val* v_buf[MAX_STACK_REGS];
+	int num_v;
+};
+
+static int reg_kind(const BroType* t)
+	{
+	switch ( t->InternalType() ) {
+	case TYPE_INTERNAL_INT:		return RK_INT;
+	case TYPE_INTERNAL_UNSIGNED:	return RK_UINT;
+	case TYPE_INTERNAL_DOUBLE:	return RK_DOUBLE;
+	case TYPE_INTERNAL_ADDR:	return RK_ADDR;
+	default:			return RK_NONE;
+	}
+	}
+
+static Val* box(const ByteCodeReg& r, int kind, BroType* t)
+	{
+	switch ( kind ) {
+	case RK_INT:
+		switch ( t->Tag() ) {
+		case TYPE_BOOL:	return val_mgr->GetBool(r.i);
+		case TYPE_INT:	return val_mgr->GetInt(r.i);
+		case TYPE_ENUM:	return new EnumVal(r.i, t->AsEnumType());
+		default:	return new Val(r.i, t->Tag());
+		}
+
+	case RK_UINT:
+		switch ( t->Tag() ) {
+		case TYPE_COUNT:	return val_mgr->GetCount(r.u);
+		case TYPE_PORT:		return val_mgr->GetPort(uint32(r.u));
+		default:		return new Val(r.u, t->Tag());
+		}
+
+	case RK_DOUBLE:
+		return new Val(r.d, t->Tag());
+
+	case RK_ADDR:
+		return new AddrVal(IPAddr(r.a));
+
+	default:
+		reporter->InternalError("bad register kind in bytecode");
+		return 0;
+	}
+	}
+
+// Looks for constructs that may change state outside of the current frame.
+class SideEffectFinder : public TraversalCallback {
+public:
+	SideEffectFinder()	{ found = false; }
+
+	virtual TraversalCode PreStmt(const Stmt* s)
+		{
+		switch ( s->Tag() ) {
+		case STMT_PRINT:
+		case STMT_EVENT:
+		case STMT_ADD:
+		case STMT_DELETE:
+		case STMT_WHEN:
+			found = true;
+			return TC_ABORTALL;
+
+		default:
+			return TC_CONTINUE;
+		}
+		}
+
+	virtual TraversalCode PreExpr(const Expr* e)
+		{
+		switch ( e->Tag() ) {
+		case EXPR_ASSIGN:
+			{
+			// Assigning to locals is fine.
+			const Expr* lhs = ((const AssignExpr*) e)->Op1();
+
+			if ( lhs->Tag() == EXPR_REF )
+				lhs = ((const RefExpr*) lhs)->Op();
+
+			if ( lhs->Tag() == EXPR_NAME &&
+			     ! ((const NameExpr*) lhs)->Id()->IsGlobal() )
+				return TC_CONTINUE;
+
+			found = true;
+			return TC_ABORTALL;
+			}
+
+		case EXPR_INCR:
+		case EXPR_DECR:
+		case EXPR_ADD_TO:
+		case EXPR_REMOVE_FROM:
+		case EXPR_EVENT:
+		case EXPR_SCHEDULE:
+			found = true;
+			return TC_ABORTALL;
+
+		case EXPR_CALL:
+			if ( ! e->IsPure() )
+				{
+				found = true;
+				return TC_ABORTALL;
+				}
+
+			return TC_CONTINUE;
+
+		default:
+			return TC_CONTINUE;
+		}
+		}
+
+	bool found;
+};
+
+class ByteCodeCompiler {
+public:
+	ByteCodeCompiler(ByteCode* arg_bc);
+
+	void CompileBody(const Stmt* body);
+
+private:
+	// Where an expression's value ends up.
+	struct Operand {
+		enum { CONST, NUM, VAL } form;
+		int reg;
+		int kind;	// For NUM
+		BroType* type;	// For NUM, the type to box it as
+		Val* val;	// For CONST
+	};
+
+	void CompileStmt(const Stmt* s);
+	void CompileIf(const IfStmt* s);
+	void CompileReturn(const ReturnStmt* s);
+	void Interpret(const Stmt* s);
+
+	void CompileExpr(const Expr* e, Operand* op);
+	void CompileForEffect(const Expr* e);
+	bool CompileAssign(const Expr* e, bool keep, Operand* op);
+	bool CompileArith(const BinaryExpr* e, Operand* op);
+	bool CompileComparison(const BinaryExpr* e, Operand* op);
+	bool CompileBool(const BinaryExpr* e, Operand* op);
+	bool CompileCond(const CondExpr* e, Operand* op);
+	bool CompileCoerce(const UnaryExpr* e, Operand* op);
+	bool CompileNegate(const UnaryExpr* e, Operand* op);
+	void Interpret(const Expr* e, Operand* op);
+
+	// Moves an operand into the respective register file.
+	int ToNum(const Operand& op, int kind);
+	int ToVal(const Operand& op);
+
+	void SetNum(Operand* op, int reg, int kind, BroType* t);
+	void SetVal(Operand* op, int reg);
+
+	int Emit(int op, int a = 0, int b = 0, int c = 0);
+	int NewNum();
+	int NewVal();
+
+	// Makes the instruction jump to wherever the interpreter would
+	// continue if the current statement has to be abandoned.
+	void AddAbort(int instr)	{ aborts.push_back(instr); }
+
+	void PatchJumps(const std::vector<int>& jumps, int target);
+
+	void CheckSideEffects(const Stmt* s);
+	void CheckSideEffects(const Expr* e);
+
+	ByteCode* bc;
+	std::vector<ByteCodeInstr> code;
+
+	int next_n, next_v;
+	std::vector<int> aborts;
+	int num_evals;
+};
+
+ByteCodeCompiler::ByteCodeCompiler(ByteCode* arg_bc)
+	{
+	bc = arg_bc;
+	next_n = next_v = 0;
+	num_evals = 0;
+	}
+
+void ByteCodeCompiler::CompileBody(const Stmt* body)
+	{
+	CompileStmt(body);
+	Emit(BC_END);
+
+	bc->code_len = code.size();
+	bc->code = new ByteCodeInstr[code.size()];
+	std::copy(code.begin(), code.end(), bc->code);
+	}
+
+int ByteCodeCompiler::Emit(int op, int a, int b, int c)
+	{
+	ByteCodeInstr i;
+	i.op = op;
+	i.a = a;
+	i.b = b;
+	i.c = c;
+	i.x.v = 0;
+	i.expr = 0;
+
+	code.push_back(i);
+	return code.size() - 1;
+	}
+
+int ByteCodeCompiler::NewNum()
+	{
+	if ( ++next_n > bc->num_nregs )
+		bc->num_nregs = next_n;
+
+	return next_n - 1;
+	}
+
+int ByteCodeCompiler::NewVal()
+	{
+	if ( ++next_v > bc->num_vregs )
+		bc->num_vregs = next_v;
+
+	return next_v - 1;
+	}
+
+void ByteCodeCompiler::PatchJumps(const std::vector<int>& jumps, int target)
+	{
+	for ( size_t i = 0; i < jumps.size(); ++i )
+		{
+		ByteCodeInstr& instr = code[jumps[i]];
+
+		if ( instr.op == BC_JUMP || instr.op == BC_JUMP_IF_FALSE ||
+		     instr.op == BC_JUMP_IF_TRUE )
+			instr.a = target;
+		else
+			instr.c = target;
+		}
+	}
+
+void ByteCodeCompiler::CheckSideEffects(const Stmt* s)
+	{
+	SideEffectFinder cb;
+	s->Traverse(&cb);
+
+	if ( cb.found )
+		bc->side_effect_free = false;
+	}
+
+void ByteCodeCompiler::CheckSideEffects(const Expr* e)
+	{
+	SideEffectFinder cb;
+	e->Traverse(&cb);
+
+	if ( cb.found )
+		bc->side_effect_free = false;
+	}
+
+void ByteCodeCompiler::CompileStmt(const Stmt* s)
+	{
+	// Temporaries don't live across statements.
+	next_n = next_v = 0;
+
+	std::vector<int> saved_aborts;
+	saved_aborts.swap(aborts);
+
+	switch ( s->Tag() ) {
+	case STMT_LIST:
+	case STMT_EXPR:
+	case STMT_IF:
+	case STMT_RETURN:
+	case STMT_NULL:
+		// The interpreter counts the executions of each statement,
+		// which the script coverage statistics build on. For the
+		// ones we compile, we have to do that ourselves.
+		code[Emit(BC_ACCESS)].x.s = s;
+		break;
+
+	default:
+		break;
+	}
+
+	switch ( s->Tag() ) {
+	case STMT_LIST:
+		{
+		const stmt_list& stmts = s->AsStmtList()->Stmts();
+
+		loop_over_list(stmts, i)
+			{
+			int evals = num_evals;
+			CompileStmt(stmts[i]);
+
+			// Interpreted calls may delay the function, in
+			// which case the interpreter doesn't go on.
+			if ( num_evals > evals )
+				Emit(BC_CHECK_DELAYED);
+			}
+
+		break;
+		}
+
+	case STMT_EXPR:
+		CompileForEffect(((const ExprStmt*) s)->StmtExpr());
+		PatchJumps(aborts, code.size());
+		++bc->num_compiled_stmts;
+		break;
+
+	case STMT_IF:
+		CompileIf((const IfStmt*) s);
+		++bc->num_compiled_stmts;
+		break;
+
+	case STMT_RETURN:
+		CompileReturn((const ReturnStmt*) s);
+		++bc->num_compiled_stmts;
+		break;
+
+	case STMT_NULL:
+		break;
+
+	default:
+		Interpret(s);
+		break;
+	}
+
+	aborts.swap(saved_aborts);
+	}
+
+void ByteCodeCompiler::CompileIf(const IfStmt* s)
+	{
+	Operand cond;
+	CompileExpr(s->StmtExpr(), &cond);
+
+	int jf = Emit(BC_JUMP_IF_FALSE, -1, ToNum(cond, RK_INT));
+
+	// Without a value for the condition, we execute neither branch.
+	std::vector<int> cond_aborts;
+	cond_aborts.swap(aborts);
+
+	CompileStmt(s->TrueBranch());
+	int jend = Emit(BC_JUMP, -1);
+
+	code[jf].a = code.size();
+	CompileStmt(s->FalseBranch());
+
+	code[jend].a = code.size();
+	PatchJumps(cond_aborts, code.size());
+	}
+
+void ByteCodeCompiler::CompileReturn(const ReturnStmt* s)
+	{
+	const Expr* e = s->StmtExpr();
+
+	if ( ! e )
+		{
+		Emit(BC_RETURN, 0, -1);
+		return;
+		}
+
+	Operand op;
+	CompileExpr(e, &op);
+	Emit(BC_RETURN, 0, ToVal(op));
+
+	// Without a value, we return nothing.
+	if ( aborts.size() )
+		{
+		PatchJumps(aborts, code.size());
+		Emit(BC_RETURN, 0, -1);
+		}
+	}
+
+void ByteCodeCompiler::Interpret(const Stmt* s)
+	{
+	int i = Emit(BC_EXEC);
+	code[i].x.s = s;
+
+	++bc->num_interpreted_stmts;
+	CheckSideEffects(s);
+	}
+
+void ByteCodeCompiler::CompileForEffect(const Expr* e)
+	{
+	Operand op;
+
+	if ( e->Tag() == EXPR_ASSIGN && CompileAssign(e, false, &op) )
+		return;
+
+	CompileExpr(e, &op);
+
+	if ( op.form != Operand::VAL )
+		return;
+
+	ByteCodeInstr& last = code.back();
+
+	if ( last.op == BC_EVAL && last.a == op.reg )
+		{
+		// No need to hold on to the value, nor to abandon the
+		// statement if there is none.
+		last.op = BC_EVAL_DISCARD;
+		aborts.pop_back();
+		}
+	else
+		Emit(BC_DISCARD, 0, op.reg);
+	}
+
+void ByteCodeCompiler::SetNum(Operand* op, int reg, int kind, BroType* t)
+	{
+	op->form = Operand::NUM;
+	op->reg = reg;
+	op->kind = kind;
+	op->type = t;
+	op->val = 0;
+	}
+
+void ByteCodeCompiler::SetVal(Operand* op, int reg)
+	{
+	op->form = Operand::VAL;
+	op->reg = reg;
+	op->kind = RK_NONE;
+	op->type = 0;
+	op->val = 0;
+	}
+
+int ByteCodeCompiler::ToNum(const Operand& op, int kind)
+	{
+	if ( op.form == Operand::NUM )
+		return op.reg;
+
+	int r = NewNum();
+
+	if ( op.form == Operand::CONST && kind != RK_ADDR )
+		{
+		switch ( kind ) {
+		case RK_INT:
+			code[Emit(BC_CONST_I, r)].x.i = op.val->InternalInt();
+			break;
+
+		case RK_UINT:
+			code[Emit(BC_CONST_U, r)].x.u = op.val->InternalUnsigned();
+			break;
+
+		case RK_DOUBLE:
+			code[Emit(BC_CONST_D, r)].x.d = op.val->InternalDouble();
+			break;
+		}
+
+		return r;
+		}
+
+	int v = ToVal(op);
+
+	switch ( kind ) {
+	case RK_INT:	Emit(BC_UNBOX_I, r, v); break;
+	case RK_UINT:	Emit(BC_UNBOX_U, r, v); break;
+	case RK_DOUBLE:	Emit(BC_UNBOX_D, r, v); break;
+	case RK_ADDR:	Emit(BC_UNBOX_A, r, v); break;
+	}
+
+	return r;
+	}
+
+int ByteCodeCompiler::ToVal(const Operand& op)
+	{
+	if ( op.form == Operand::VAL )
+		return op.reg;
+
+	int r = NewVal();
+
+	if ( op.form == Operand::CONST )
+		code[Emit(BC_LOAD_CONST, r)].x.v = op.val;
+	else
+		code[Emit(BC_BOX, r, op.reg, op.kind)].x.t = op.type;
+
+	return r;
+	}
+
+void ByteCodeCompiler::Interpret(const Expr* e, Operand* op)
+	{
+	int r = NewVal();
+	int i = Emit(BC_EVAL, r, 0, -1);
+	code[i].x.e = e;
+	AddAbort(i);
+
+	SetVal(op, r);
+
+	++bc->num_interpreted_exprs;
+	++num_evals;
+	CheckSideEffects(e);
+	}
+
+void ByteCodeCompiler::CompileExpr(const Expr* e, Operand* op)
+	{
+	if ( e->IsError() || IsVector(e->Type()->Tag()) )
+		{
+		Interpret(e, op);
+		return;
+		}
+
+	switch ( e->Tag() ) {
+	case EXPR_CONST:
+		op->form = Operand::CONST;
+		op->reg = -1;
+		op->kind = RK_NONE;
+		op->type = 0;
+		op->val = ((const ConstExpr*) e)->Value();
+		return;
+
+	case EXPR_NAME:
+		{
+		ID* id = ((const NameExpr*) e)->Id();
+
+		if ( id->AsType() )
+			break;
+
+		int r = NewVal();
+		int i;
+
+		if ( id->IsGlobal() )
+			{
+			i = Emit(BC_LOAD_GLOBAL, r, 0, -1);
+			code[i].x.id = id;
+			}
+		else
+			{
+			i = Emit(BC_LOAD_LOCAL, r, 0, -1);
+			code[i].x.i = id->Offset();
+			}
+
+		code[i].expr = e;
+		AddAbort(i);
+		SetVal(op, r);
+		return;
+		}
+
+	case EXPR_NOT:
+		{
+		const Expr* operand = ((const UnaryExpr*) e)->Op();
+
+		if ( reg_kind(operand->Type()) != RK_INT ||
+		     IsVector(operand->Type()->Tag()) )
+			break;
+
+		Operand o;
+		CompileExpr(operand, &o);
+
+		int r = NewNum();
+		Emit(BC_NOT, r, ToNum(o, RK_INT));
+		SetNum(op, r, RK_INT, base_type_no_ref(e->Type()->Tag()));
+		return;
+		}
+
+	case EXPR_NEGATE:
+		if ( CompileNegate((const UnaryExpr*) e, op) )
+			return;
+
+		break;
+
+	case EXPR_ADD:
+	case EXPR_SUB:
+	case EXPR_TIMES:
+	case EXPR_DIVIDE:
+	case EXPR_MOD:
+		if ( CompileArith((const BinaryExpr*) e, op) )
+			return;
+
+		break;
+
+	case EXPR_LT:
+	case EXPR_LE:
+	case EXPR_EQ:
+	case EXPR_NE:
+	case EXPR_GE:
+	case EXPR_GT:
+		if ( CompileComparison((const BinaryExpr*) e, op) )
+			return;
+
+		break;
+
+	case EXPR_AND:
+	case EXPR_OR:
+		if ( CompileBool((const BinaryExpr*) e, op) )
+			return;
+
+		break;
+
+	case EXPR_COND:
+		if ( CompileCond((const CondExpr*) e, op) )
+			return;
+
+		break;
+
+	case EXPR_ARITH_COERCE:
+		if ( CompileCoerce((const UnaryExpr*) e, op) )
+			return;
+
+		break;
+
+	case EXPR_FIELD:
+		{
+		const FieldExpr* fe = (const FieldExpr*) e;
+		const Expr* rec = fe->Op();
+
+		if ( fe->Field() < 0 || rec->Type()->Tag() != TYPE_RECORD )
+			break;
+
+		Operand o;
+		CompileExpr(rec, &o);
+
+		int r = NewVal();
+		int i = Emit(BC_FIELD, r, ToVal(o), fe->Field());
+		code[i].expr = e;
+
+		const TypeDecl* td =
+			rec->Type()->AsRecordType()->FieldDecl(fe->Field());
+		const Attr* def = td ? td->FindAttr(ATTR_DEFAULT) : 0;
+		code[i].x.e = def ? def->AttrExpr() : 0;
+
+		SetVal(op, r);
+		return;
+		}
+
+	case EXPR_HAS_FIELD:
+		{
+		const HasFieldExpr* he = (const HasFieldExpr*) e;
+		const Expr* rec = he->Op();
+
+		if ( rec->Type()->Tag() != TYPE_RECORD )
+			break;
+
+		int field = rec->Type()->AsRecordType()->FieldOffset(he->FieldName());
+
+		if ( field < 0 )
+			break;
+
+		Operand o;
+		CompileExpr(rec, &o);
+
+		int r = NewNum();
+		Emit(BC_HAS_FIELD, r, ToVal(o), field);
+		SetNum(op, r, RK_INT, base_type_no_ref(TYPE_BOOL));
+		return;
+		}
+
+	case EXPR_ASSIGN:
+		if ( CompileAssign(e, true, op) )
+			return;
+
+		break;
+
+	default:
+		break;
+	}
+
+	Interpret(e, op);
+	}
+
+bool ByteCodeCompiler::CompileAssign(const Expr* e, bool keep, Operand* op)
+	{
+	const AssignExpr* ae = (const AssignExpr*) e;
+
+	if ( ae->IsError() || ae->IsInit() || ae->AssignVal() )
+		return false;
+
+	const Expr* lhs = ae->Op1();
+
+	if ( lhs->Tag() == EXPR_REF )
+		lhs = ((const RefExpr*) lhs)->Op();
+
+	if ( lhs->Tag() == EXPR_NAME )
+		{
+		ID* id = ((const NameExpr*) lhs)->Id();
+
+		if ( id->AsType() )
+			return false;
+
+		Operand rhs;
+		CompileExpr(ae->Op2(), &rhs);
+		int r = ToVal(rhs);
+
+		if ( id->IsGlobal() )
+			{
+			code[Emit(BC_STORE_GLOBAL, 0, r, keep)].x.id = id;
+			bc->side_effect_free = false;
+			}
+		else
+			code[Emit(BC_STORE_LOCAL, 0, r, keep)].x.i = id->Offset();
+
+		if ( keep )
+			SetVal(op, r);
+
+		return true;
+		}
+
+	if ( lhs->Tag() == EXPR_FIELD && ! keep )
+		{
+		// The interpreter yields the assigned value even if there's no
+		// record to assign to, which we only can ignore if the value
+		// isn't needed.
+		const FieldExpr* fe = (const FieldExpr*) lhs;
+		const Expr* rec = fe->Op();
+
+		if ( fe->IsError() || fe->Field() < 0 ||
+		     rec->Type()->Tag() != TYPE_RECORD )
+			return false;
+
+		Operand rhs;
+		CompileExpr(ae->Op2(), &rhs);
+		int v = ToVal(rhs);
+
+		Operand r;
+		CompileExpr(rec, &r);
+
+		Emit(BC_STORE_FIELD, ToVal(r), v, fe->Field());
+		bc->side_effect_free = false;
+		return true;
+		}
+
+	return false;
+	}
+
+bool ByteCodeCompiler::CompileArith(const BinaryExpr* e, Operand* op)
+	{
+	int kind = reg_kind(e->Type());
+	const Expr* op1 = e->Op1();
+	const Expr* op2 = e->Op2();
+
+	if ( IsVector(op1->Type()->Tag()) || IsVector(op2->Type()->Tag()) ||
+	     reg_kind(op1->Type()) != kind || reg_kind(op2->Type()) != kind )
+		return false;
+
+	int base;
+
+	switch ( e->Tag() ) {
+	case EXPR_ADD:		base = BC_ADD_I; break;
+	case EXPR_SUB:		base = BC_SUB_I; break;
+	case EXPR_TIMES:	base = BC_MUL_I; break;
+	case EXPR_DIVIDE:	base = BC_DIV_I; break;
+	case EXPR_MOD:		base = BC_MOD_I; break;
+	default:		return false;
+	}
+
+	if ( kind == RK_NONE || kind == RK_ADDR ||
+	     (kind == RK_DOUBLE && e->Tag() == EXPR_MOD) )
+		return false;
+
+	Operand o1, o2;
+	CompileExpr(op1, &o1);
+	int r1 = ToNum(o1, kind);
+	CompileExpr(op2, &o2);
+	int r2 = ToNum(o2, kind);
+
+	int r = NewNum();
+	int i = Emit(base + kind, r, r1, r2);
+	code[i].expr = e;
+
+	SetNum(op, r, kind, base_type_no_ref(e->Type()->Tag()));
+	return true;
+	}
+
+bool ByteCodeCompiler::CompileComparison(const BinaryExpr* e, Operand* op)
+	{
+	const Expr* op1 = e->Op1();
+	const Expr* op2 = e->Op2();
+
+	if ( IsVector(op1->Type()->Tag()) || IsVector(op2->Type()->Tag()) )
+		return false;
+
+	BroExprTag tag = e->Tag();
+	bool swap = false;
+
+	if ( tag == EXPR_GT || tag == EXPR_GE )
+		{
+		swap = true;
+		tag = (tag == EXPR_GT ? EXPR_LT : EXPR_LE);
+		}
+
+	int kind = reg_kind(op1->Type());
+	int r = NewNum();
+
+	if ( op1->Type()->Tag() == TYPE_STRING &&
+	     op2->Type()->Tag() == TYPE_STRING )
+		{
+		Operand o1, o2;
+		CompileExpr(op1, &o1);
+		int r1 = ToVal(o1);
+		CompileExpr(op2, &o2);
+		int r2 = ToVal(o2);
+
+		code[Emit(BC_CMP_S, r, r1, r2)].x.i = e->Tag();
+		SetNum(op, r, RK_INT, base_type_no_ref(TYPE_BOOL));
+		return true;
+		}
+
+	if ( kind == RK_NONE || reg_kind(op2->Type()) != kind ||
+	     op1->Type()->Tag() == TYPE_PATTERN )
+		return false;
+
+	Operand o1, o2;
+	CompileExpr(op1, &o1);
+	int r1 = ToNum(o1, kind);
+	CompileExpr(op2, &o2);
+	int r2 = ToNum(o2, kind);
+
+	int base;
+
+	switch ( kind ) {
+	case RK_INT:	base = BC_LT_I; break;
+	case RK_UINT:	base = BC_LT_U; break;
+	case RK_DOUBLE:	base = BC_LT_D; break;
+	default:	base = BC_LT_A; break;
+	}
+
+	int offset;
+
+	switch ( tag ) {
+	case EXPR_LT:	offset = 0; break;
+	case EXPR_LE:	offset = 1; break;
+	case EXPR_EQ:	offset = 2; break;
+	default:	offset = 3; break;
+	}
+
+	if ( swap )
+		Emit(base + offset, r, r2, r1);
+	else
+		Emit(base + offset, r, r1, r2);
+
+	SetNum(op, r, RK_INT, base_type_no_ref(TYPE_BOOL));
+	return true;
+	}
+
+bool ByteCodeCompiler::CompileBool(const BinaryExpr* e, Operand* op)
+	{
+	if ( e->Type()->Tag() != TYPE_BOOL ||
+	     IsVector(e->Op1()->Type()->Tag()) ||
+	     IsVector(e->Op2()->Type()->Tag()) )
+		return false;
+
+	int r = NewNum();
+
+	Operand o1;
+	CompileExpr(e->Op1(), &o1);
+	Emit(BC_MOVE_N, r, ToNum(o1, RK_INT));
+
+	// Short-circuit.
+	int j = Emit(e->Tag() == EXPR_AND ? BC_JUMP_IF_FALSE : BC_JUMP_IF_TRUE,
+		     -1, r);
+
+	Operand o2;
+	CompileExpr(e->Op2(), &o2);
+	Emit(BC_MOVE_N, r, ToNum(o2, RK_INT));
+
+	code[j].a = code.size();
+
+	SetNum(op, r, RK_INT, base_type_no_ref(TYPE_BOOL));
+	return true;
+	}
+
+bool ByteCodeCompiler::CompileCond(const CondExpr* e, Operand* op)
+	{
+	if ( IsVector(e->Op1()->Type()->Tag()) ||
+	     reg_kind(e->Op1()->Type()) != RK_INT )
+		return false;
+
+	Operand cond;
+	CompileExpr(e->Op1(), &cond);
+	int jf = Emit(BC_JUMP_IF_FALSE, -1, ToNum(cond, RK_INT));
+
+	// The branches' values may come with different types, so we keep
+	// whatever Val they yield.
+	int r = NewVal();
+
+	Operand o2;
+	CompileExpr(e->Op2(), &o2);
+	Emit(BC_MOVE_V, r, ToVal(o2));
+	int jend = Emit(BC_JUMP, -1);
+
+	code[jf].a = code.size();
+
+	Operand o3;
+	CompileExpr(e->Op3(), &o3);
+	Emit(BC_MOVE_V, r, ToVal(o3));
+
+	code[jend].a = code.size();
+
+	SetVal(op, r);
+	return true;
+	}
+
+bool ByteCodeCompiler::CompileCoerce(const UnaryExpr* e, Operand* op)
+	{
+	const Expr* operand = e->Op();
+	int from = reg_kind(operand->Type());
+	int to = reg_kind(e->Type());
+
+	if ( IsVector(operand->Type()->Tag()) ||
+	     from == RK_NONE || from == RK_ADDR ||
+	     to == RK_NONE || to == RK_ADDR )
+		return false;
+
+	Operand o;
+	CompileExpr(operand, &o);
+	int src = ToNum(o, from);
+	int r = src;
+
+	if ( from != to )
+		{
+		static const int conversions[3][3] = {
+			{ -1, BC_I2U, BC_I2D },
+			{ BC_U2I, -1, BC_U2D },
+			{ BC_D2I, BC_D2U, -1 },
+		};
+
+		r = NewNum();
+		Emit(conversions[from][to], r, src);
+		}
+
+	// Like the interpreter, we yield a plain int, count, or double
+	// regardless of the target type.
+	static const TypeTag tags[3] = { TYPE_INT, TYPE_COUNT, TYPE_DOUBLE };
+	SetNum(op, r, to, base_type_no_ref(tags[to]));
+	return true;
+	}
+
+bool ByteCodeCompiler::CompileNegate(const UnaryExpr* e, Operand* op)
+	{
+	const Expr* operand = e->Op();
+	TypeTag t = operand->Type()->Tag();
+	int kind = reg_kind(operand->Type());
+
+	if ( IsVector(t) )
+		return false;
+
+	if ( kind == RK_DOUBLE && t != TYPE_DOUBLE && t != TYPE_INTERVAL )
+		return false;
+
+	if ( kind != RK_INT && kind != RK_UINT && kind != RK_DOUBLE )
+		return false;
+
+	Operand o;
+	CompileExpr(operand, &o);
+	int src = ToNum(o, kind);
+	int r = NewNum();
+
+	if ( kind == RK_DOUBLE )
+		{
+		Emit(BC_NEG_D, r, src);
+		SetNum(op, r, RK_DOUBLE, base_type_no_ref(t));
+		return true;
+		}
+
+	if ( kind == RK_UINT )
+		{
+		int i = NewNum();
+		Emit(BC_U2I, i, src);
+		src = i;
+		}
+
+	Emit(BC_NEG_I, r, src);
+	SetNum(op, r, RK_INT, base_type_no_ref(TYPE_INT));
+	return true;
+	}
+
+ByteCode::ByteCode()
+	{
+	code = 0;
+	code_len = 0;
+	num_nregs = num_vregs = 0;
+	num_compiled_stmts = 0;
+	num_interpreted_stmts = 0;
+	num_interpreted_exprs = 0;
+	side_effect_free = true;
+	}
+
+ByteCode::~ByteCode()
+	{
+	delete [] code;
+	}
+
+ByteCode* ByteCode::Compile(const Stmt* body)
+	{
+	// The debugger needs to see each statement.
+	if ( g_policy_debug )
+		return 0;
+
+	ByteCode* bc = new ByteCode();
+	ByteCodeCompiler compiler(bc);
+	compiler.CompileBody(body);
+
+	return bc;
+	}
+
+// Reports that a variable has no value, just like the interpreter does.
+static void value_not_set(const Expr* e, Frame* f)
+	{
+	Unref(e->Eval(f));
+	}
+
+Val* ByteCode::Exec(Frame* f, stmt_flow_type& flow) const
+	{
+	ByteCodeRegisters regs(num_nregs, num_vregs);
+	ByteCodeReg* n = regs.n;
+	Val** v = regs.v;
+
+	flow = FLOW_NEXT;
+
+	for ( const ByteCodeInstr* i = code; ; ++i )
+		{
+		switch ( i->op ) {
+		case BC_LOAD_LOCAL:
+			{
+			Val* val = f->NthElement(i->x.i);
+
+			if ( ! val )
+				{
+				value_not_set(i->expr, f);
+				i = code + i->c - 1;
+				break;
+				}
+
+			Unref(v[i->a]);
+			v[i->a] = val->Ref();
+			break;
+			}
+
+		case BC_LOAD_GLOBAL:
+			{
+			Val* val = i->x.id->ID_Val();
+
+			if ( ! val )
+				{
+				value_not_set(i->expr, f);
+				i = code + i->c - 1;
+				break;
+				}
+
+			Unref(v[i->a]);
+			v[i->a] = val->Ref();
+			break;
+			}
+
+		case BC_EVAL:
+			{
+			Val* val = i->x.e->Eval(f);
+
+			if ( ! val )
+				{
+				i = code + i->c - 1;
+				break;
+				}
+
+			Unref(v[i->a]);
+			v[i->a] = val;
+			break;
+			}
+
+		case BC_LOAD_CONST:
+			Unref(v[i->a]);
+			v[i->a] = i->x.v->Ref();
+			break;
+
+		case BC_CONST_I:	n[i->a].i = i->x.i; break;
+		case BC_CONST_U:	n[i->a].u = i->x.u; break;
+		case BC_CONST_D:	n[i->a].d = i->x.d; break;
+
+#define UNBOX(expr) \
+			expr; \
+			Unref(v[i->b]); \
+			v[i->b] = 0; \
+			break;
+
+		case BC_UNBOX_I:	UNBOX(n[i->a].i = v[i->b]->InternalInt())
+		case BC_UNBOX_U:	UNBOX(n[i->a].u = v[i->b]->InternalUnsigned())
+		case BC_UNBOX_D:	UNBOX(n[i->a].d = v[i->b]->InternalDouble())
+		case BC_UNBOX_A:	UNBOX(v[i->b]->AsAddr().CopyIPv6(&n[i->a].a))
+
+		case BC_BOX:
+			Unref(v[i->a]);
+			v[i->a] = box(n[i->b], i->c, i->x.t);
+			break;
+
+		case BC_MOVE_N:
+			n[i->a] = n[i->b];
+			break;
+
+		case BC_MOVE_V:
+			if ( i->a != i->b )
+				{
+				Unref(v[i->a]);
+				v[i->a] = v[i->b];
+				v[i->b] = 0;
+				}
+			break;
+
+#define ARITH(m, op) n[i->a].m = n[i->b].m op n[i->c].m; break;
+
+		case BC_ADD_I:	ARITH(i, +)
+		case BC_ADD_U:	ARITH(u, +)
+		case BC_ADD_D:	ARITH(d, +)
+		case BC_SUB_I:	ARITH(i, -)
+		case BC_SUB_U:	ARITH(u, -)
+		case BC_SUB_D:	ARITH(d, -)
+		case BC_MUL_I:	ARITH(i, *)
+		case BC_MUL_U:	ARITH(u, *)
+		case BC_MUL_D:	ARITH(d, *)
+
+#define CHECKED_ARITH(m, op, msg) \
+			if ( n[i->c].m == 0 ) \
+				reporter->ExprRuntimeError(i->expr, msg); \
+			ARITH(m, op)
+
+		case BC_DIV_I:	CHECKED_ARITH(i, /, "division by zero")
+		case BC_DIV_U:	CHECKED_ARITH(u, /, "division by zero")
+		case BC_DIV_D:	CHECKED_ARITH(d, /, "division by zero")
+		case BC_MOD_I:	CHECKED_ARITH(i, %, "modulo by zero")
+		case BC_MOD_U:	CHECKED_ARITH(u, %, "modulo by zero")
+
+		case BC_NEG_I:	n[i->a].i = - n[i->b].i; break;
+		case BC_NEG_D:	n[i->a].d = - n[i->b].d; break;
+		case BC_NOT:	n[i->a].i = ! n[i->b].i; break;
+
+		case BC_I2U:	n[i->a].u = bro_uint_t(n[i->b].i); break;
+		case BC_I2D:	n[i->a].d = double(n[i->b].i); break;
+		case BC_U2I:	n[i->a].i = bro_int_t(n[i->b].u); break;
+		case BC_U2D:	n[i->a].d = double(n[i->b].u); break;
+		case BC_D2I:	n[i->a].i = bro_int_t(n[i->b].d); break;
+		case BC_D2U:	n[i->a].u = bro_uint_t(n[i->b].d); break;
+
+#define COMPARE(m, op) n[i->a].i = (n[i->b].m op n[i->c].m); break;
+
+		case BC_LT_I:	COMPARE(i, <)
+		case BC_LE_I:	COMPARE(i, <=)
+		case BC_EQ_I:	COMPARE(i, ==)
+		case BC_NE_I:	COMPARE(i, !=)
+		case BC_LT_U:	COMPARE(u, <)
+		case BC_LE_U:	COMPARE(u, <=)
+		case BC_EQ_U:	COMPARE(u, ==)
+		case BC_NE_U:	COMPARE(u, !=)
+		case BC_LT_D:	COMPARE(d, <)
+		case BC_LE_D:	COMPARE(d, <=)
+		case BC_EQ_D:	COMPARE(d, ==)
+		case BC_NE_D:	COMPARE(d, !=)
+
+#define COMPARE_ADDR(op) \
+			n[i->a].i = (memcmp(&n[i->b].a, &n[i->c].a, sizeof(in6_addr)) op 0); \
+			break;
+
+		case BC_LT_A:	COMPARE_ADDR(<)
+		case BC_LE_A:	COMPARE_ADDR(<=)
+		case BC_EQ_A:	COMPARE_ADDR(==)
+		case BC_NE_A:	COMPARE_ADDR(!=)
+
+		case BC_CMP_S:
+			{
+			int cmp = Bstr_cmp(v[i->b]->AsString(), v[i->c]->AsString());
+			bool result;
+
+			switch ( i->x.i ) {
+			case EXPR_LT:	result = cmp < 0; break;
+			case EXPR_LE:	result = cmp <= 0; break;
+			case EXPR_EQ:	result = cmp == 0; break;
+			case EXPR_NE:	result = cmp != 0; break;
+			case EXPR_GE:	result = cmp >= 0; break;
+			default:	result = cmp > 0; break;
+			}
+
+			n[i->a].i = result;
+
+			Unref(v[i->b]);
+			Unref(v[i->c]);
+			v[i->b] = v[i->c] = 0;
+			break;
+			}
+
+		case BC_FIELD:
+			{
+			Val* rec = v[i->b];
+			Val* val = rec->AsRecordVal()->Lookup(i->c);
+
+			if ( val )
+				val->Ref();
+
+			else if ( i->x.e )
+				val = i->x.e->Eval(0);
+
+			else
+				reporter->ExprRuntimeError(i->expr, "field value missing");
+
+			v[i->b] = 0;
+			Unref(rec);
+
+			Unref(v[i->a]);
+			v[i->a] = val;
+			break;
+			}
+
+		case BC_HAS_FIELD:
+			n[i->a].i = (v[i->b]->AsRecordVal()->Lookup(i->c) != 0);
+			Unref(v[i->b]);
+			v[i->b] = 0;
+			break;
+
+		case BC_STORE_FIELD:
+			v[i->a]->AsRecordVal()->Assign(i->c, v[i->b]);
+			Unref(v[i->a]);
+			v[i->a] = v[i->b] = 0;
+			break;
+
+		case BC_STORE_LOCAL:
+			f->SetElement(i->x.i, i->c ? v[i->b]->Ref() : v[i->b]);
+
+			if ( ! i->c )
+				v[i->b] = 0;
+
+			break;
+
+		case BC_STORE_GLOBAL:
+			i->x.id->SetVal(i->c ? v[i->b]->Ref() : v[i->b]);
+
+			if ( ! i->c )
+				v[i->b] = 0;
+
+			break;
+
+		case BC_DISCARD:
+			Unref(v[i->b]);
+			v[i->b] = 0;
+			break;
+
+		case BC_JUMP:
+			i = code + i->a - 1;
+			break;
+
+		case BC_JUMP_IF_FALSE:
+			if ( ! n[i->b].i )
+				i = code + i->a - 1;
+			break;
+
+		case BC_JUMP_IF_TRUE:
+			if ( n[i->b].i )
+				i = code + i->a - 1;
+			break;
+
+		case BC_EXEC:
+			{
+			Val* result = i->x.s->Exec(f, flow);
+
+			if ( flow != FLOW_NEXT || result || f->HasDelayed() )
+				return result;
+
+			break;
+			}
+
+		case BC_EVAL_DISCARD:
+			Unref(i->x.e->Eval(f));
+			break;
+
+		case BC_ACCESS:
+			i->x.s->RegisterAccess();
+			break;
+
+		case BC_CHECK_DELAYED:
+			if ( f->HasDelayed() )
+				return 0;
+			break;
+
+		case BC_RETURN:
+			flow = FLOW_RETURN;
+
+			if ( i->b >= 0 )
+				{
+				Val* result = v[i->b];
+				v[i->b] = 0;
+				return result;
+				}
+
+			return 0;
+
+		case BC_END:
+			return 0;
+
+		default:
+			reporter->InternalError("bad bytecode instruction %d", i->op);
+		}
+		}
+	}
+
+static Val* synthesize_arg(BroType* t)
+	{
+	switch ( t->Tag() ) {
+	case TYPE_BOOL:		return val_mgr->GetBool(true);
+	case TYPE_INT:		return val_mgr->GetInt(int64(-42));
+	case TYPE_COUNT:	return val_mgr->GetCount(uint64(42));
+	case TYPE_DOUBLE:	return new Val(0.5, TYPE_DOUBLE);
+	case TYPE_TIME:		return new Val(1400000000.0, TYPE_TIME);
+	case TYPE_INTERVAL:	return new IntervalVal(60.0, 1.0);
+	case TYPE_PORT:		return val_mgr->GetPort(80, TRANSPORT_TCP);
+	case TYPE_ADDR:		return new AddrVal("192.168.1.1");
+	case TYPE_SUBNET:	return new SubNetVal("192.168.0.0", 16);
+	case TYPE_STRING:	return new StringVal("www.example.com");
+
+	case TYPE_ENUM:
+		{
+		EnumType::enum_name_list names = t->AsEnumType()->Names();
+
+		if ( names.empty() )
+			return 0;
+
+		return new EnumVal(names.front().second, t->AsEnumType());
+		}
+
+	default:
+		return 0;
+	}
+	}
+
+static Val* run_body(const BroFunc* func, const Stmt* body,
+		     const ByteCode* bc, val_list* args)
+	{
+	Frame* f = new Frame(func->FrameSize(), func, args);
+
+	loop_over_list(*args, i)
+		f->SetElement(i, (*args)[i]->Ref());
+
+	stmt_flow_type flow;
+	Val* result = 0;
+
+	try
+		{
+		result = bc ? bc->Exec(f, flow) : body->Exec(f, flow);
+		}
+
+	catch ( InterpreterException& e )
+		{
+		Unref(f);
+		throw;
+		}
+
+	Unref(f);
+	return result;
+	}
+
+static bool id_less(const ID* a, const ID* b)
+	{
+	return strcmp(a->Name(), b->Name()) < 0;
+	}
+
+void bytecode_benchmark(int iterations)
+	{
+	std::vector<ID*> ids;
+
+	PDict(ID)* globals = global_scope()->Vars();
+	IterCookie* cookie = globals->InitForIteration();
+	HashKey* key;
+	ID* id;
+
+	while ( (id = globals->NextEntry(key, cookie)) )
+		{
+		delete key;
+		ids.push_back(id);
+		}
+
+	std::sort(ids.begin(), ids.end(), id_less);
+
+	int num_bodies = 0;
+	int num_instructions = 0;
+	int num_compiled = 0;
+	int num_interpreted = 0;
+	int num_exprs = 0;
+	int num_timed = 0;
+	double total[2] = { 0.0, 0.0 };
+
+	printf("%-45s %12s %12s %8s\n", "function", "ast us/call",
+	       "bc us/call", "speedup");
+
+	for ( size_t k = 0; k < ids.size(); ++k )
+		{
+		Val* fv = ids[k]->ID_Val();
+
+		if ( ! fv || fv->Type()->Tag() != TYPE_FUNC ||
+		     fv->AsFunc()->GetKind() != Func::BRO_FUNC )
+			continue;
+
+		const BroFunc* func = (const BroFunc*) fv->AsFunc();
+		const vector<Func::Body>& bodies = func->GetBodies();
+
+		for ( size_t b = 0; b < bodies.size(); ++b )
+			{
+			ByteCode* bc = ByteCode::Compile(bodies[b].stmts);
+
+			if ( ! bc )
+				continue;
+
+			++num_bodies;
+			num_instructions += bc->NumInstructions();
+			num_compiled += bc->NumCompiledStmts();
+			num_interpreted += bc->NumInterpretedStmts();
+			num_exprs += bc->NumInterpretedExprs();
+
+			// We time only functions whose bodies we can run
+			// repeatedly without changing anything.
+			if ( func->Flavor() != FUNC_FLAVOR_FUNCTION ||
+			     ! bc->IsSideEffectFree() )
+				{
+				delete bc;
+				continue;
+				}
+
+			RecordType* params = func->FType()->Args();
+			val_list* args = new val_list;
+
+			for ( int i = 0; i < params->NumFields(); ++i )
+				{
+				Val* a = synthesize_arg(params->FieldType(i));
+
+				if ( ! a )
+					break;
+
+				args->append(a);
+				}
+
+			bool ok = (args->length() == params->NumFields());
+			double elapsed[2];
+			int errors = reporter->Errors();
+
+			try
+				{
+				// Check that the two agree first.
+				Val* r1 = ok ? run_body(func, bodies[b].stmts, 0, args) : 0;
+				Val* r2 = ok ? run_body(func, bodies[b].stmts, bc, args) : 0;
+
+				ODesc d1;
+				ODesc d2;
+
+				if ( r1 )
+					r1->Describe(&d1);
+
+				if ( r2 )
+					r2->Describe(&d2);
+
+				if ( ok && strcmp(d1.Description(), d2.Description()) != 0 )
+					{
+					reporter->Warning("%s: interpreter returns %s, bytecode %s",
+							  func->Name(), d1.Description(),
+							  d2.Description());
+					ok = false;
+					}
+
+				Unref(r1);
+				Unref(r2);
+
+				for ( int mode = 0; mode < 2 && ok; ++mode )
+					{
+					const ByteCode* code = mode ? bc : 0;
+					double start = current_time(true);
+
+					for ( int j = 0; j < iterations; ++j )
+						Unref(run_body(func, bodies[b].stmts, code, args));
+
+					elapsed[mode] = current_time(true) - start;
+					}
+				}
+
+			catch ( InterpreterException& e )
+				{
+				ok = false;
+				}
+
+			if ( reporter->Errors() > errors )
+				ok = false;
+
+			if ( ok )
+				{
+				printf("%-45s %12.3f %12.3f %7.2fx\n", func->Name(),
+				       elapsed[0] * 1e6 / iterations,
+				       elapsed[1] * 1e6 / iterations,
+				       elapsed[1] > 0 ? elapsed[0] / elapsed[1] : 0.0);
+
+				total[0] += elapsed[0];
+				total[1] += elapsed[1];
+				++num_timed;
+				}
+
+			loop_over_list(*args, i)
+				Unref((*args)[i]);
+
+			delete args;
+			delete bc;
+			}
+		}
+
+	printf("\n%d bodies, %d instructions; %d statements compiled, "
+	       "%d statements and %d expressions interpreted\n",
+	       num_bodies, num_instructions, num_compiled,
+	       num_interpreted, num_exprs);
+
+	if ( num_timed )
+		printf("%d functions timed: interpreter %.3fs, bytecode %.3fs (%.2fx)\n",
+		       num_timed, total[0], total[1],
+		       total[1] > 0 ? total[0] / total[1] : 0.0);
+	}
@@ -0,0 +1,79 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Compilation of script function bodies into a register-based bytecode.
+//
+// The compiler lowers the statements and expressions that dominate typical
+// handlers -- statement lists, ifs, returns, local and record field
+// assignments, arithmetic, comparisons, boolean logic, and record field
+// access -- into instructions operating on two register files: one of
+// unboxed integers, counts, doubles, and addresses, and one of Val
+// pointers. Intermediary results of arithmetic and comparisons thus never
+// become Val objects. Anything else gets evaluated by handing the
+// corresponding AST node to the interpreter, so every body can be
+// compiled. Locals always stay in the Frame, so that mixing compiled and
+// interpreted code is transparent.
+
+#ifndef bytecode_h
+#define bytecode_h
+
+#include "StmtEnums.h"
+
+class BroFunc;
+class BroType;
+class Expr;
+class Frame;
+class ID;
+class Stmt;
+class Val;
+
+// If true, BroFunc compiles its bodies when they are defined.
+extern int use_bytecode;
+
+struct ByteCodeInstr;
+
+class ByteCode {
+public:
+	// Returns the compiled body, or nil if compilation is disabled,
+	// e.g. because we are running under the script debugger.
+	static ByteCode* Compile(const Stmt* body);
+
+	~ByteCode();
+
+	// Executes the body in the given frame, with the same semantics as
+	// Stmt::Exec() of the body it was compiled from.
+	Val* Exec(Frame* f, stmt_flow_type& flow) const;
+
+	int NumInstructions() const	{ return code_len; }
+
+	// Number of statements compiled to instructions, and number of
+	// statements and expressions left to the interpreter.
+	int NumCompiledStmts() const	{ return num_compiled_stmts; }
+	int NumInterpretedStmts() const	{ return num_interpreted_stmts; }
+	int NumInterpretedExprs() const	{ return num_interpreted_exprs; }
+
+	// True if executing the body can't change any state outside of its
+	// frame, as far as we can tell statically.
+	bool IsSideEffectFree() const	{ return side_effect_free; }
+
+protected:
+	friend class ByteCodeCompiler;
+
+	ByteCode();
+
+	ByteCodeInstr* code;
+	int code_len;
+	int num_nregs;	// Unboxed registers
+	int num_vregs;	// Val registers
+
+	int num_compiled_stmts;
+	int num_interpreted_stmts;
+	int num_interpreted_exprs;
+	bool side_effect_free;
+};
+
+// Compiles all script functions and compares their execution time when
+// interpreted and when compiled on synthesized arguments, for those
+// functions that don't have side effects.
+extern void bytecode_benchmark(int iterations);
+
+#endif
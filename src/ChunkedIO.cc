@@ -13,6 +13,7 @@
 #include "ChunkedIO.h"
 #include "NetVar.h"
 #include "RemoteSerializer.h"
+#include "threading/Queue.h"
 
 ChunkedIO::ChunkedIO() : stats(), tag(), pure()
 	{
@@ -389,6 +390,11 @@ ChunkedIO::Chunk* ChunkedIOFd::ConcatChunks(Chunk* c1, Chunk* c2)
 
 void ChunkedIO::Log(const char* str)
 	{
+	// The communication thread mustn't raise events; its errors reach
+	// the main thread via its own messages.
+	if ( SocketComm::InThread() )
+		return;
+
 	RemoteSerializer::Log(RemoteSerializer::LogError, str);
 	}
 
@@ -656,7 +662,7 @@ void ChunkedIOFd::Clear()
 
 const char* ChunkedIOFd::Error()
 	{
-	static char buffer[1024];
+	static __thread char buffer[1024];
 	safe_snprintf(buffer, sizeof(buffer), "%s [%d]", strerror(errno), errno);
 
 	return buffer;
@@ -1198,6 +1204,189 @@ void ChunkedIOSSL::Stats(char* buffer, int length)
 	ChunkedIO::Stats(buffer + i, length - i);
 	}
 
+typedef threading::Queue<ChunkedIO::Chunk*> ChunkQueue;
+
+struct ChunkedIOQueue::Channel {
+	Channel(threading::BasicThread* a, threading::BasicThread* b)
+		: to_b(b, a), to_a(a, b)
+		{
+		refs = 2;
+		closed[0] = closed[1] = 0;
+		}
+
+	~Channel()
+		{
+		Drain(&to_a);
+		Drain(&to_b);
+		}
+
+	// Deletes the chunks the reader hasn't retrieved.
+	static void Drain(ChunkQueue* q)
+		{
+		while ( q->Ready() )
+			delete q->Get();
+		}
+
+	ChunkQueue* In(int side)	{ return side ? &to_b : &to_a; }
+	ChunkQueue* Out(int side)	{ return side ? &to_a : &to_b; }
+
+	ChunkQueue to_b;	// Written by side 0, read by side 1.
+	ChunkQueue to_a;	// Written by side 1, read by side 0.
+	int refs;
+	int closed[2];
+};
+
+void ChunkedIOQueue::CreatePair(const char* tag,
+                                ChunkedIOQueue** a, threading::BasicThread* a_thread,
+                                ChunkedIOQueue** b, threading::BasicThread* b_thread)
+	{
+	Channel* channel = new Channel(a_thread, b_thread);
+	*a = new ChunkedIOQueue(tag, channel, 0);
+	*b = new ChunkedIOQueue(tag, channel, 1);
+	}
+
+ChunkedIOQueue::ChunkedIOQueue(const char* arg_tag, Channel* arg_channel,
+                               int arg_side)
+	{
+	tag = arg_tag;
+	channel = arg_channel;
+	side = arg_side;
+	eof = false;
+	error = 0;
+	}
+
+ChunkedIOQueue::~ChunkedIOQueue()
+	{
+	__atomic_store_n(&channel->closed[side], 1, __ATOMIC_SEQ_CST);
+
+	// Let the other side notice.
+	channel->Out(side)->WakeUp();
+
+	if ( __atomic_sub_fetch(&channel->refs, 1, __ATOMIC_ACQ_REL) == 0 )
+		delete channel;
+	}
+
+bool ChunkedIOQueue::PeerClosed()
+	{
+	return __atomic_load_n(&channel->closed[1 - side], __ATOMIC_SEQ_CST);
+	}
+
+bool ChunkedIOQueue::Read(Chunk** chunk, bool may_block)
+	{
+	*chunk = 0;
+
+	// Check this first: once the other side is gone, everything it
+	// wrote is in the queue.
+	bool closed = PeerClosed();
+	ChunkQueue* in = channel->In(side);
+
+	if ( ! in->Ready() )
+		{
+		if ( closed )
+			{
+			eof = true;
+			error = "end of file";
+#ifdef DEBUG_COMMUNICATION
+			AddToBuffer("<false:read-chunk>", true);
+#endif
+			return false;
+			}
+
+		if ( ! may_block )
+			{
+#ifdef DEBUG_COMMUNICATION
+			AddToBuffer("<null:no-data>", true);
+#endif
+			return true;
+			}
+		}
+
+	// Only waits if may_block is set.
+	*chunk = in->Get();
+
+	if ( ! *chunk )
+		return true;
+
+	++stats.chunks_read;
+	++stats.reads;
+	stats.bytes_read += (*chunk)->len;
+
+#ifdef DEBUG_COMMUNICATION
+	AddToBuffer(*chunk, true);
+#endif
+
+	return true;
+	}
+
+bool ChunkedIOQueue::Write(Chunk* chunk)
+	{
+#ifdef DEBUG
+	DBG_LOG(DBG_CHUNKEDIO, "write of size %d [%s]",
+		chunk->len, fmt_bytes(chunk->data, min((uint32)20, chunk->len)));
+#endif
+
+	if ( PeerClosed() )
+		{
+		eof = true;
+		error = "end of file";
+		return false;
+		}
+
+	ChunkQueue* out = channel->Out(side);
+
+	// Reject if the other side isn't keeping up. Otherwise, memory
+	// could fill up if it doesn't read.
+	if ( out->Size() > MAX_BUFFERED_CHUNKS )
+		{
+		DBG_LOG(DBG_CHUNKEDIO, "write queue full");
+
+#ifdef DEBUG_COMMUNICATION
+		AddToBuffer("<false:write-queue-full>", false);
+#endif
+
+		error = "write queue full";
+		return false;
+		}
+
+#ifdef DEBUG_COMMUNICATION
+	AddToBuffer(chunk, false);
+#endif
+
+	++stats.chunks_written;
+	++stats.writes;
+	stats.bytes_written += chunk->len;
+
+	out->Put(chunk);
+	return true;
+	}
+
+bool ChunkedIOQueue::CanRead()
+	{
+	return channel->In(side)->Ready();
+	}
+
+bool ChunkedIOQueue::IsIdle()
+	{
+	return ! channel->In(side)->MaybeReady();
+	}
+
+bool ChunkedIOQueue::IsFillingUp()
+	{
+	return channel->Out(side)->Size() > MAX_BUFFERED_CHUNKS_SOFT;
+	}
+
+int ChunkedIOQueue::Fd()
+	{
+	return channel->In(side)->FD();
+	}
+
+void ChunkedIOQueue::Stats(char* buffer, int length)
+	{
+	int i = safe_snprintf(buffer, length, "pending=%" PRIu64 " ",
+	                      channel->Out(side)->Size());
+	ChunkedIO::Stats(buffer + i, length - i);
+	}
+
 bool CompressedChunkedIO::Init()
 	{
 	zin.zalloc = 0;
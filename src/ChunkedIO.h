@@ -19,6 +19,8 @@
 
 class CompressedChunkedIO;
 
+namespace threading { class BasicThread; }
+
 // #define DEBUG_COMMUNICATION 10
 
 // Abstract base class.
@@ -143,8 +145,8 @@ public:
 
 protected:
 	void InternalError(const char* msg)
-		// We can't use the reporter here as we might be running in a
-		// sub-process.
+		// We can't use the reporter here as we might be running in
+		// the communication thread.
 		{ fprintf(stderr, "%s", msg); abort(); }
 
 	Statistics stats;
@@ -317,6 +319,57 @@ private:
 	bro::Flare write_flare;
 };
 
+// Chunked I/O between two threads of the same process. Rather than being
+// serialized into a byte stream, chunks are handed over by pointer through
+// a lock-free queue for each direction. Fd() becomes ready for reading
+// when the other side has written something.
+class ChunkedIOQueue : public ChunkedIO {
+public:
+	// Creates two connected endpoints, each reading what the other one
+	// writes. An endpoint must only be used by a single thread, given
+	// as its corresponding argument (null for the main thread). They
+	// may be deleted in any order; the remaining one returns EOF once
+	// it has read everything written before.
+	static void CreatePair(const char* tag,
+	                       ChunkedIOQueue** a, threading::BasicThread* a_thread,
+	                       ChunkedIOQueue** b, threading::BasicThread* b_thread);
+
+	virtual ~ChunkedIOQueue();
+
+	virtual bool Read(Chunk** chunk, bool may_block = false);
+	virtual bool Write(Chunk* chunk);
+	virtual bool Flush()	{ return true; }
+	virtual const char* Error()	{ return error; }
+	virtual bool CanRead();
+	virtual bool CanWrite()	{ return false; }
+	virtual bool IsIdle();
+	virtual bool IsFillingUp();
+	virtual void Clear()	{ }
+	virtual bool Eof()	{ return eof; }
+	virtual int Fd();
+	virtual void Stats(char* buffer, int length);
+
+private:
+	struct Channel;
+
+	ChunkedIOQueue(const char* tag, Channel* channel, int side);
+
+	// True once the other side has been deleted.
+	bool PeerClosed();
+
+	// We report that we're filling up when the other side hasn't yet
+	// retrieved more than this number of chunks.
+	static const uint32 MAX_BUFFERED_CHUNKS_SOFT = 400000;
+
+	// Maximum number of chunks queued before rejecting writes.
+	static const uint32 MAX_BUFFERED_CHUNKS = 500000;
+
+	Channel* channel;
+	int side;	// 0 or 1, our index into the channel
+	bool eof;
+	const char* error;
+};
+
 #include <zlib.h>
 
 // Wrapper class around a another ChunkedIO which the (un-)compresses data.
@@ -17,6 +17,9 @@
 #include "analyzer/Analyzer.h"
 #include "analyzer/Manager.h"
 
+IMPLEMENT_SLAB_ALLOCATION(Connection, "Connection")
+IMPLEMENT_SLAB_ALLOCATION(ConnectionTimer, "ConnectionTimer")
+
 void ConnectionTimer::Init(Connection* arg_conn, timer_func arg_timer,
 				int arg_do_expire)
 	{
@@ -114,6 +117,91 @@ unsigned int Connection::external_connections = 0;
 
 IMPLEMENT_SERIAL(Connection, SER_CONNECTION);
 
+// Fields of the connection record computed on demand.
+static const int CONN_VAL_ENDPOINTS = (1 << 1) | (1 << 2);
+static const int CONN_VAL_START_TIME = (1 << 3);
+static const int CONN_VAL_DURATION = (1 << 4);
+static const int CONN_VAL_HISTORY = (1 << 8);
+static const int CONN_VAL_PROGRESS = CONN_VAL_ENDPOINTS | CONN_VAL_START_TIME |
+					CONN_VAL_DURATION | CONN_VAL_HISTORY;
+
+ConnectionVal::ConnectionVal(Connection* c) : RecordVal(connection_type)
+	{
+	conn = c;
+
+	// Nothing is outdated until the record has been filled in, see
+	// Connection::BuildConnVal().
+	stale = 0;
+	lazy = true;
+	}
+
+ConnectionVal::ConnectionVal(Connection* c, RecordVal* from)
+	: RecordVal(connection_type)
+	{
+	conn = c;
+	stale = 0;
+
+	for ( int i = 0; i < record_type->NumFields(); ++i )
+		{
+		Val* v = from->Lookup(i);
+		Assign(i, v ? v->Ref() : 0);
+		}
+
+	lazy = true;
+	}
+
+void ConnectionVal::Invalidate()
+	{
+	if ( conn )
+		stale = CONN_VAL_PROGRESS;
+	}
+
+void ConnectionVal::Detach()
+	{
+	if ( RefCnt() > 1 )
+		// Somebody else may still look at the fields.
+		MaterializeAll();
+
+	lazy = false;
+	conn = 0;
+	}
+
+void ConnectionVal::Materialize(int field) const
+	{
+	if ( ! (stale & (1 << field)) )
+		return;
+
+	// Clear the bits first, as the updates access the fields, too.
+	RecordVal* self = const_cast<ConnectionVal*>(this);
+
+	switch ( field ) {
+	case 1:
+	case 2:
+		// The analyzers update both endpoints at once.
+		stale &= ~CONN_VAL_ENDPOINTS;
+
+		if ( conn->root_analyzer )
+			conn->root_analyzer->UpdateConnVal(self);
+		break;
+
+	case 3:
+		stale &= ~CONN_VAL_START_TIME;
+		self->Assign(3, new Val(conn->start_time, TYPE_TIME));
+		break;
+
+	case 4:
+		stale &= ~CONN_VAL_DURATION;
+		self->Assign(4, new Val(conn->last_time - conn->start_time,
+					TYPE_INTERVAL));
+		break;
+
+	case 8:
+		stale &= ~CONN_VAL_HISTORY;
+		self->Assign(8, new StringVal(conn->history.c_str()));
+		break;
+	}
+	}
+
 Connection::Connection(NetSessions* s, HashKey* k, double t, const ConnID* id,
                        uint32 flow, const EncapsulationStack* arg_encap)
 	{
@@ -183,6 +271,11 @@ Connection::~Connection()
 	if ( ! finished )
 		reporter->InternalError("Done() not called before destruction of Connection");
 
+	// Detach before canceling timers, as updating the record may
+	// schedule new ones.
+	if ( conn_val )
+		((ConnectionVal*) conn_val)->Detach();
+
 	CancelTimers();
 
 	if ( conn_val )
@@ -338,9 +431,13 @@ void Connection::EnableStatusUpdateTimer()
 
 void Connection::StatusUpdateTimer(double t)
 	{
-	val_list* vl = new val_list(1);
-	vl->append(BuildConnVal());
-	ConnectionEvent(connection_status_update, 0, vl);
+	if ( connection_status_update )
+		{
+		val_list* vl = new val_list(1);
+		vl->append(BuildConnVal());
+		ConnectionEvent(connection_status_update, 0, vl);
+		}
+
 	ADD_TIMER(&Connection::StatusUpdateTimer,
 			network_time + connection_status_update_interval, 0,
 			TIMER_CONN_STATUS_UPDATE);
@@ -350,25 +447,25 @@ RecordVal* Connection::BuildConnVal()
 	{
 	if ( ! conn_val )
 		{
-		conn_val = new RecordVal(connection_type);
+		conn_val = new ConnectionVal(this);
 
 		TransportProto prot_type = ConnTransport();
 
 		RecordVal* id_val = new RecordVal(conn_id);
 		id_val->Assign(0, new AddrVal(orig_addr));
-		id_val->Assign(1, new PortVal(ntohs(orig_port), prot_type));
+		id_val->Assign(1, val_mgr->GetPort(ntohs(orig_port), prot_type));
 		id_val->Assign(2, new AddrVal(resp_addr));
-		id_val->Assign(3, new PortVal(ntohs(resp_port), prot_type));
+		id_val->Assign(3, val_mgr->GetPort(ntohs(resp_port), prot_type));
 
 		RecordVal *orig_endp = new RecordVal(endpoint);
-		orig_endp->Assign(0, new Val(0, TYPE_COUNT));
-		orig_endp->Assign(1, new Val(0, TYPE_COUNT));
-		orig_endp->Assign(4, new Val(orig_flow_label, TYPE_COUNT));
+		orig_endp->Assign(0, val_mgr->GetCount(0));
+		orig_endp->Assign(1, val_mgr->GetCount(0));
+		orig_endp->Assign(4, val_mgr->GetCount(orig_flow_label));
 
 		RecordVal *resp_endp = new RecordVal(endpoint);
-		resp_endp->Assign(0, new Val(0, TYPE_COUNT));
-		resp_endp->Assign(1, new Val(0, TYPE_COUNT));
-		resp_endp->Assign(4, new Val(resp_flow_label, TYPE_COUNT));
+		resp_endp->Assign(0, val_mgr->GetCount(0));
+		resp_endp->Assign(1, val_mgr->GetCount(0));
+		resp_endp->Assign(4, val_mgr->GetCount(resp_flow_label));
 
 		conn_val->Assign(0, id_val);
 		conn_val->Assign(1, orig_endp);
@@ -376,7 +473,7 @@ RecordVal* Connection::BuildConnVal()
 		// 3 and 4 are set below.
 		conn_val->Assign(5, new TableVal(string_set));	// service
 		conn_val->Assign(6, new StringVal(""));	// addl
-		conn_val->Assign(7, new Val(0, TYPE_COUNT));	// hot
+		conn_val->Assign(7, val_mgr->GetCount(0));	// hot
 		conn_val->Assign(8, new StringVal(""));	// history
 
 		if ( ! uid )
@@ -388,12 +485,9 @@ RecordVal* Connection::BuildConnVal()
 			conn_val->Assign(10, encapsulation->GetVectorVal());
 		}
 
-	if ( root_analyzer )
-		root_analyzer->UpdateConnVal(conn_val);
-
-	conn_val->Assign(3, new Val(start_time, TYPE_TIME));	// ###
-	conn_val->Assign(4, new Val(last_time - start_time, TYPE_INTERVAL));
-	conn_val->Assign(8, new StringVal(history.c_str()));
+	// Endpoints, start time, duration, and history get updated once a
+	// script looks at them.
+	((ConnectionVal*) conn_val)->Invalidate();
 
 	conn_val->SetOrigin(this);
 
@@ -481,7 +575,7 @@ Val* Connection::BuildVersionVal(const char* s, int len)
 		;
 
 	if ( s != e )
-		major = new Val(atoi(s), TYPE_INT);
+		major = val_mgr->GetInt(atoi(s));
 
 	// Find second number seperated only by punctuation chars -
 	// that's the minor version.
@@ -491,7 +585,7 @@ Val* Connection::BuildVersionVal(const char* s, int len)
 		;
 
 	if ( s != e )
-		minor = new Val(atoi(s), TYPE_INT);
+		minor = val_mgr->GetInt(atoi(s));
 
 	// Find second number seperated only by punctuation chars; -
 	// that's the minor version.
@@ -501,7 +595,7 @@ Val* Connection::BuildVersionVal(const char* s, int len)
 		;
 
 	if ( s != e )
-		minor2 = new Val(atoi(s), TYPE_INT);
+		minor2 = val_mgr->GetInt(atoi(s));
 
 	// Anything after following punctuation and until next white space is
 	// an additional version string.
@@ -538,9 +632,9 @@ Val* Connection::BuildVersionVal(const char* s, int len)
 		}
 
 	RecordVal* version = new RecordVal(software_version);
-	version->Assign(0, major ? major : new Val(-1, TYPE_INT));
-	version->Assign(1, minor ? minor : new Val(-1, TYPE_INT));
-	version->Assign(2, minor2 ? minor2 : new Val(-1, TYPE_INT));
+	version->Assign(0, major ? major : val_mgr->GetInt(-1));
+	version->Assign(1, minor ? minor : val_mgr->GetInt(-1));
+	version->Assign(2, minor2 ? minor2 : val_mgr->GetInt(-1));
 	version->Assign(3, addl ? addl : new StringVal(""));
 
 	RecordVal* sw = new RecordVal(software);
@@ -722,6 +816,10 @@ TimerMgr* Connection::GetTimerMgr() const
 
 void Connection::FlipRoles()
 	{
+	if ( conn_val )
+		// Anybody still holding on to the record sees the old roles.
+		((ConnectionVal*) conn_val)->Detach();
+
 	IPAddr tmp_addr = resp_addr;
 	resp_addr = orig_addr;
 	orig_addr = tmp_addr;
@@ -916,6 +1014,13 @@ bool Connection::DoUnserialize(UnserialInfo* info)
 	UNSERIALIZE_OPTIONAL(conn_val,
 			(RecordVal*) Val::Unserialize(info, connection_type));
 
+	if ( conn_val )
+		{
+		RecordVal* rv = conn_val;
+		conn_val = new ConnectionVal(this, rv);
+		Unref(rv);
+		}
+
 	int iproto;
 
 	if ( ! (UNSERIALIZE(&iproto) &&
@@ -975,7 +1080,7 @@ void Connection::CheckFlowLabel(bool is_orig, uint32 flow_label)
 		if ( conn_val )
 			{
 			RecordVal *endp = conn_val->Lookup(is_orig ? 1 : 2)->AsRecordVal();
-			endp->Assign(4, new Val(flow_label, TYPE_COUNT));
+			endp->Assign(4, val_mgr->GetCount(flow_label));
 			}
 
 		if ( connection_flow_label_changed &&
@@ -983,9 +1088,9 @@ void Connection::CheckFlowLabel(bool is_orig, uint32 flow_label)
 			{
 			val_list* vl = new val_list(4);
 			vl->append(BuildConnVal());
-			vl->append(new Val(is_orig, TYPE_BOOL));
-			vl->append(new Val(my_flow_label, TYPE_COUNT));
-			vl->append(new Val(flow_label, TYPE_COUNT));
+			vl->append(val_mgr->GetBool(is_orig));
+			vl->append(val_mgr->GetCount(my_flow_label));
+			vl->append(val_mgr->GetCount(flow_label));
 			ConnectionEvent(connection_flow_label_changed, 0, vl);
 			}
 
@@ -20,6 +20,7 @@
 
 class Connection;
 class ConnectionTimer;
+class ConnectionVal;
 class NetSessions;
 class LoginConn;
 class RuleHdrTest;
@@ -59,6 +60,8 @@ public:
 	           uint32 flow, const EncapsulationStack* arg_encap);
 	virtual ~Connection();
 
+	DECLARE_SLAB_ALLOCATION()
+
 	// Invoked when an encapsulation is discovered. It records the
 	// encapsulation with the connection and raises a "tunnel_changed"
 	// event if it's different from the previous encapsulation (or the
@@ -277,6 +280,7 @@ protected:
 
 	// Allow other classes to access pointers to these:
 	friend class ConnectionTimer;
+	friend class ConnectionVal;
 
 	void InactivityTimer(double t);
 	void StatusUpdateTimer(double t);
@@ -326,6 +330,30 @@ protected:
 	Bro::UID uid;	// Globally unique connection ID.
 };
 
+// The script-level connection record. The fields reflecting the
+// connection's progress (the endpoints, start time, duration, and
+// history) are only brought up to date when a script accesses them.
+class ConnectionVal : public RecordVal {
+public:
+	ConnectionVal(Connection* c);
+
+	// Takes over the fields of a plain connection record.
+	ConnectionVal(Connection* c, RecordVal* from);
+
+	// Flags the progress fields as outdated.
+	void Invalidate();
+
+	// Brings all fields up to date and decouples the record from the
+	// connection, which is about to go away or change roles.
+	void Detach();
+
+protected:
+	void Materialize(int field) const;
+
+	Connection* conn;
+	mutable int stale;	// bitmask of outdated fields
+};
+
 class ConnectionTimer : public Timer {
 public:
 	ConnectionTimer(Connection* arg_conn, timer_func arg_timer,
@@ -334,6 +362,8 @@ public:
 		{ Init(arg_conn, arg_timer, arg_do_expire); }
 	virtual ~ConnectionTimer();
 
+	DECLARE_SLAB_ALLOCATION()
+
 	void Dispatch(double t, int is_expire);
 
 protected:
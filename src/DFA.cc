@@ -30,6 +30,23 @@ DFA_State::DFA_State(int arg_state_num, const EquivClass* ec,
 		xtions[i] = DFA_UNCOMPUTED_STATE_PTR;
 	}
 
+DFA_State::DFA_State(int arg_state_num, int arg_num_sym,
+			AcceptingSet* arg_accept)
+	{
+	state_num = arg_state_num;
+	num_sym = arg_num_sym;
+	nfa_states = new NFA_state_list;
+	accept = arg_accept;
+	mark = 0;
+	centry = 0;
+	meta_ec = 0;
+
+	xtions = new DFA_State*[num_sym];
+
+	for ( int i = 0; i < num_sym; ++i )
+		xtions[i] = DFA_UNCOMPUTED_STATE_PTR;
+	}
+
 DFA_State::~DFA_State()
 	{
 	delete [] xtions;
@@ -402,6 +419,12 @@ DFA_Machine::DFA_Machine(NFA_Machine* n, EquivClass* arg_ec)
 
 	ec = arg_ec;
 
+	num_ecs = ec->NumClasses();
+	max_states = 0;
+	xtion_table = 0;
+	accepts = 0;
+	states = 0;
+
 	dfa_state_cache = new DFA_State_Cache(dfa_state_cache_size);
 
 	NFA_state_list* ns = new NFA_state_list;
@@ -419,10 +442,90 @@ DFA_Machine::DFA_Machine(NFA_Machine* n, EquivClass* arg_ec)
 		}
 	}
 
+DFA_Machine::DFA_Machine(EquivClass* arg_ec, int arg_num_ecs)
+	{
+	state_count = 0;
+	nfa = 0;
+	ec = arg_ec;
+	start_state = 0;
+	dfa_state_cache = new DFA_State_Cache(dfa_state_cache_size);
+
+	num_ecs = arg_num_ecs;
+	max_states = 0;
+	xtion_table = 0;
+	accepts = 0;
+	states = 0;
+	}
+
 DFA_Machine::~DFA_Machine()
 	{
 	delete dfa_state_cache;
 	Unref(nfa);
+
+	delete [] xtion_table;
+	delete [] accepts;
+	delete [] states;
+	}
+
+void DFA_Machine::AddState(DFA_State* d)
+	{
+	int s = d->StateNum();
+
+	if ( s >= max_states )
+		{
+		int new_max = max_states ? max_states * 2 : 16;
+
+		while ( new_max <= s )
+			new_max *= 2;
+
+		int32* new_table = new int32[new_max * num_ecs];
+		const AcceptingSet** new_accepts = new const AcceptingSet*[new_max];
+		DFA_State** new_states = new DFA_State*[new_max];
+
+		if ( max_states )
+			{
+			memcpy(new_table, xtion_table,
+			       max_states * num_ecs * sizeof(int32));
+			memcpy(new_accepts, accepts,
+			       max_states * sizeof(AcceptingSet*));
+			memcpy(new_states, states, max_states * sizeof(DFA_State*));
+			}
+
+		delete [] xtion_table;
+		delete [] accepts;
+		delete [] states;
+
+		xtion_table = new_table;
+		accepts = new_accepts;
+		states = new_states;
+		max_states = new_max;
+		}
+
+	int32* row = xtion_table + s * num_ecs;
+
+	for ( int sym = 0; sym < num_ecs; ++sym )
+		{
+		DFA_State* next = d->xtions[sym];
+
+		if ( next == DFA_UNCOMPUTED_STATE_PTR )
+			row[sym] = DFA_UNCOMPUTED_STATE;
+		else
+			row[sym] = next ? next->StateNum() : DFA_JAM_STATE;
+		}
+
+	accepts[s] = d->Accept();
+	states[s] = d;
+	}
+
+int DFA_Machine::ComputeXtion(int state, int sym)
+	{
+	DFA_State* next = states[state]->Xtion(sym, this);
+	int n = next ? next->StateNum() : DFA_JAM_STATE;
+
+	// Computing the transition may have grown the table.
+	xtion_table[state * num_ecs + sym] = n;
+
+	return n;
 	}
 
 void DFA_Machine::Describe(ODesc* d) const
@@ -458,7 +561,10 @@ unsigned int DFA_Machine::MemoryAllocation() const
 	return padded_sizeof(*this)
 		+ s.mem
 		+ padded_sizeof(*start_state)
-		+ nfa->MemoryAllocation();
+		+ (nfa ? nfa->MemoryAllocation() : 0)
+		+ pad_size(max_states * num_ecs * sizeof(int32))
+		+ pad_size(max_states * sizeof(AcceptingSet*))
+		+ pad_size(max_states * sizeof(DFA_State*));
 	}
 
 int DFA_Machine::StateSetToDFA_State(NFA_state_list* state_set,
@@ -488,6 +594,7 @@ int DFA_Machine::StateSetToDFA_State(NFA_state_list* state_set,
 
 	DFA_State* ds = new DFA_State(state_count++, ec, state_set, accept);
 	d = dfa_state_cache->Insert(ds, hash);
+	AddState(ds);
 
 	return 1;
 	}
@@ -500,3 +607,44 @@ int DFA_Machine::Rep(int sym)
 
 	return -1;
 	}
+
+bool DFA_Machine::Expand(int max_states)
+	{
+	if ( ! start_state )
+		return true;
+
+	// States get appended as they are created, so walking the list
+	// visits each one once.
+	DFA_state_list states;
+	states.append(start_state);
+	start_state->SetMark(start_state);
+
+	bool complete = true;
+
+	for ( int i = 0; i < states.length(); ++i )
+		{
+		DFA_State* d = states[i];
+
+		for ( int sym = 0; sym < ec->NumClasses(); ++sym )
+			{
+			DFA_State* next = d->Xtion(sym, this);
+
+			if ( next && ! next->Mark() )
+				{
+				next->SetMark(next);
+				states.append(next);
+				}
+			}
+
+		if ( dfa_state_cache->NumEntries() > max_states )
+			{
+			complete = false;
+			break;
+			}
+		}
+
+	loop_over_list(states, j)
+		states[j]->SetMark(0);
+
+	return complete;
+	}
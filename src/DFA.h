@@ -13,6 +13,9 @@ class DFA_State;
 #define DFA_UNCOMPUTED_STATE -2
 #define DFA_UNCOMPUTED_STATE_PTR ((DFA_State*) DFA_UNCOMPUTED_STATE)
 
+// State number standing for "no match possible anymore".
+#define DFA_JAM_STATE -1
+
 #include "NFA.h"
 
 extern int dfa_state_cache_size;
@@ -25,6 +28,11 @@ class DFA_State : public BroObj {
 public:
 	DFA_State(int state_num, const EquivClass* ec,
 			NFA_state_list* nfa_states, AcceptingSet* accept);
+
+	// A state whose transitions are all known up front, so that it
+	// doesn't need any NFA states.
+	DFA_State(int state_num, int num_sym, AcceptingSet* accept);
+
 	~DFA_State();
 
 	int StateNum() const		{ return state_num; }
@@ -53,6 +61,8 @@ public:
 
 protected:
 	friend class DFA_State_Cache;
+	friend class DFA_Machine;
+	friend class DFA_Cache;
 
 	DFA_State* ComputeXtion(int sym, DFA_Machine* machine);
 	void AppendIfNew(int sym, int_list* sym_list);
@@ -122,18 +132,30 @@ typedef PList(DFA_State) DFA_state_list;
 class DFA_Machine : public BroObj {
 public:
 	DFA_Machine(NFA_Machine* n, EquivClass* ec);
-	DFA_Machine(int** xtion_ptrs, int num_states, int num_ecs,
-			int* acc_array);
 	~DFA_Machine();
 
 	DFA_State* StartState() const	{ return start_state; }
 
+	// The matchers walk the machine by state number, using a table
+	// that holds the transitions of all states contiguously, row by
+	// row, indexed by equivalence class. Returns DFA_JAM_STATE if there
+	// is no transition.
+	int StartStateNum() const
+		{ return start_state ? start_state->StateNum() : DFA_JAM_STATE; }
+	inline int Xtion(int state, int sym);
+	const AcceptingSet* Accept(int state) const	{ return accepts[state]; }
+
 	int NumStates() const	{ return dfa_state_cache->NumEntries(); }
 
 	DFA_State_Cache* Cache()	{ return dfa_state_cache; }
 
 	int Rep(int sym);
 
+	// Computes all transitions that haven't been computed yet. Returns
+	// false, leaving the machine partially expanded, if that would
+	// take more than max_states states.
+	bool Expand(int max_states);
+
 	void Describe(ODesc* d) const;
 	void Dump(FILE* f);
 	void DumpStats(FILE* f);
@@ -143,6 +165,15 @@ public:
 protected:
 	friend class DFA_State;	// for DFA_State::ComputeXtion
 	friend class DFA_State_Cache;
+	friend class DFA_Cache;
+
+	// A machine without an NFA, for the DFA cache to fill in.
+	DFA_Machine(EquivClass* ec, int num_ecs);
+
+	// Adds a row for a new state to the transition table, with the
+	// transitions the state already knows.
+	void AddState(DFA_State* d);
+	int ComputeXtion(int state, int sym);
 
 	int state_count;
 
@@ -156,6 +187,12 @@ protected:
 	DFA_State_Cache* dfa_state_cache;
 
 	NFA_Machine* nfa;
+
+	int num_ecs;
+	int max_states;	// rows allocated in the tables below
+	int32* xtion_table;	// num_ecs entries per state
+	const AcceptingSet** accepts;	// per state
+	DFA_State** states;	// per state
 };
 
 inline DFA_State* DFA_State::Xtion(int sym, DFA_Machine* machine)
@@ -166,4 +203,14 @@ inline DFA_State* DFA_State::Xtion(int sym, DFA_Machine* machine)
 		return xtions[sym];
 	}
 
+inline int DFA_Machine::Xtion(int state, int sym)
+	{
+	int next = xtion_table[state * num_ecs + sym];
+
+	if ( next == DFA_UNCOMPUTED_STATE )
+		return ComputeXtion(state, sym);
+
+	return next;
+	}
+
 #endif
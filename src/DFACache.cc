@@ -0,0 +1,340 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "config.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <openssl/md5.h>
+
+#include "DFACache.h"
+#include "DFA.h"
+#include "EquivClass.h"
+#include "Reporter.h"
+
+DFA_Cache* dfa_cache = 0;
+
+// Bump the version whenever the entry layout changes.
+static const char dfa_cache_magic[] = "BRO-DFA-CACHE-1\n";
+static const int dfa_cache_magic_len = sizeof(dfa_cache_magic) - 1;
+
+// Upper bound on the number of ints in one entry. Machines we cache
+// stay far below, so anything larger means the file is corrupt.
+static const uint32 dfa_cache_max_entry_len = 16 * 1024 * 1024;
+
+// An entry is a flat vector of ints:
+//
+//	num_syms num_ecs equiv_class[num_syms] rep[num_syms]
+//	num_states start_state
+//	for each state: num_accept accept[num_accept] xtion[num_ecs]
+//
+// with states given by their index and -1 for the jam state.
+
+DFA_Cache::DFA_Cache(const char* arg_filename)
+	{
+	filename = arg_filename;
+	dirty = false;
+	}
+
+DFA_Cache::~DFA_Cache()
+	{
+	}
+
+std::string DFA_Cache::Hash(const std::string& key) const
+	{
+	u_char digest[MD5_DIGEST_LENGTH];
+	MD5((const u_char*) key.data(), key.size(), digest);
+	return std::string((const char*) digest, sizeof(digest));
+	}
+
+void DFA_Cache::Load()
+	{
+	FILE* f = fopen(filename.c_str(), "r");
+
+	if ( ! f )
+		{
+		if ( errno != ENOENT )
+			reporter->Warning("can't read DFA cache %s: %s",
+					  filename.c_str(), strerror(errno));
+		return;
+		}
+
+	struct stat st;
+
+	if ( fstat(fileno(f), &st) < 0 )
+		{
+		reporter->Warning("can't read DFA cache %s: %s",
+				  filename.c_str(), strerror(errno));
+		fclose(f);
+		return;
+		}
+
+	char magic[dfa_cache_magic_len];
+	uint32 num_entries;
+
+	if ( fread(magic, dfa_cache_magic_len, 1, f) != 1 ||
+	     memcmp(magic, dfa_cache_magic, dfa_cache_magic_len) != 0 ||
+	     fread(&num_entries, sizeof(num_entries), 1, f) != 1 )
+		{
+		reporter->Warning("ignoring DFA cache %s of unknown format",
+				  filename.c_str());
+		fclose(f);
+		return;
+		}
+
+	off_t left = st.st_size - dfa_cache_magic_len - sizeof(num_entries);
+
+	for ( uint32 i = 0; i < num_entries; ++i )
+		{
+		char digest[MD5_DIGEST_LENGTH];
+		uint32 len;
+
+		if ( fread(digest, sizeof(digest), 1, f) != 1 ||
+		     fread(&len, sizeof(len), 1, f) != 1 )
+			break;
+
+		left -= sizeof(digest) + sizeof(len);
+
+		// Don't trust the length before allocating for it.
+		if ( len > dfa_cache_max_entry_len ||
+		     off_t(len) * off_t(sizeof(int)) > left )
+			break;
+
+		left -= len * sizeof(int);
+
+		Entry e(len);
+
+		if ( len && fread(&e[0], sizeof(int), len, f) != len )
+			break;
+
+		entries[std::string(digest, sizeof(digest))].swap(e);
+		}
+
+	if ( entries.size() != num_entries )
+		reporter->Warning("DFA cache %s is truncated", filename.c_str());
+
+	fclose(f);
+	}
+
+void DFA_Cache::Save()
+	{
+	if ( ! dirty )
+		return;
+
+	// Write to a temporary file first so that concurrent readers never
+	// see a partial cache.
+	std::string tmp = filename + ".tmp";
+	FILE* f = fopen(tmp.c_str(), "w");
+
+	if ( ! f )
+		{
+		reporter->Warning("can't write DFA cache %s: %s",
+				  tmp.c_str(), strerror(errno));
+		return;
+		}
+
+	uint32 num_entries = entries.size();
+	bool ok = fwrite(dfa_cache_magic, dfa_cache_magic_len, 1, f) == 1 &&
+		  fwrite(&num_entries, sizeof(num_entries), 1, f) == 1;
+
+	for ( EntryMap::const_iterator i = entries.begin();
+	      ok && i != entries.end(); ++i )
+		{
+		uint32 len = i->second.size();
+
+		ok = fwrite(i->first.data(), i->first.size(), 1, f) == 1 &&
+		     fwrite(&len, sizeof(len), 1, f) == 1 &&
+		     (! len ||
+		      fwrite(&i->second[0], sizeof(int), len, f) == len);
+		}
+
+	if ( fclose(f) != 0 )
+		ok = false;
+
+	if ( ! ok || rename(tmp.c_str(), filename.c_str()) < 0 )
+		{
+		reporter->Warning("can't write DFA cache %s: %s",
+				  filename.c_str(), strerror(errno));
+		unlink(tmp.c_str());
+		return;
+		}
+
+	dirty = false;
+	}
+
+DFA_Machine* DFA_Cache::Lookup(const std::string& key, EquivClass* ec)
+	{
+	EntryMap::const_iterator i = entries.find(Hash(key));
+
+	if ( i == entries.end() )
+		return 0;
+
+	DFA_Machine* dfa = Decode(i->second, ec);
+
+	if ( ! dfa )
+		reporter->Warning("ignoring corrupt entry in DFA cache %s",
+				  filename.c_str());
+
+	return dfa;
+	}
+
+DFA_Machine* DFA_Cache::Decode(const Entry& e, EquivClass* ec) const
+	{
+	int n = e.size();
+	int num_syms = ec->NumSyms();
+
+	if ( n < 2 || e[0] != num_syms )
+		return 0;
+
+	int num_ecs = e[1];
+	int p = 2 + 2 * num_syms;
+
+	if ( num_ecs <= 0 || num_ecs > num_syms || p + 2 > n )
+		return 0;
+
+	for ( int i = 0; i < num_syms; ++i )
+		if ( e[2 + i] < 0 || e[2 + i] >= num_ecs ||
+		     e[2 + num_syms + i] < 0 ||
+		     e[2 + num_syms + i] >= num_syms )
+			return 0;
+
+	int num_states = e[p++];
+	int start = e[p++];
+
+	if ( num_states < 0 || start < -1 || start >= num_states )
+		return 0;
+
+	DFA_Machine* dfa = new DFA_Machine(ec, num_ecs);
+	DFA_state_list states;
+
+	for ( int i = 0; i < num_states; ++i )
+		{
+		// Transitions can only be set once all states exist, so
+		// just check that they are there for now.
+		if ( p >= n || e[p] < 0 || e[p] > n - p - 1 - num_ecs )
+			{
+			loop_over_list(states, j)
+				Unref(states[j]);
+			Unref(dfa);
+			return 0;
+			}
+
+		int num_accept = e[p++];
+		AcceptingSet* accept = 0;
+
+		if ( num_accept )
+			{
+			accept = new AcceptingSet;
+
+			for ( int j = 0; j < num_accept; ++j )
+				accept->insert(e[p++]);
+			}
+
+		states.append(new DFA_State(i, num_ecs, accept));
+		p += num_ecs;
+		}
+
+	// Second pass for the transitions.
+	p = 4 + 2 * num_syms;
+
+	for ( int i = 0; i < num_states; ++i )
+		{
+		p += 1 + e[p];
+
+		for ( int sym = 0; sym < num_ecs; ++sym )
+			{
+			int next = e[p++];
+
+			if ( next < -1 || next >= num_states )
+				{
+				loop_over_list(states, j)
+					Unref(states[j]);
+				Unref(dfa);
+				return 0;
+				}
+
+			states[i]->AddXtion(sym, next >= 0 ? states[next] : 0);
+			}
+		}
+
+	// The machine's state cache owns the states from here on.
+	loop_over_list(states, i)
+		{
+		dfa->dfa_state_cache->Insert(states[i], new HashKey(bro_int_t(i)));
+		dfa->AddState(states[i]);
+		}
+
+	dfa->state_count = num_states;
+	dfa->start_state = start >= 0 ? states[start] : 0;
+
+	ec->SetECs(num_ecs, &e[2], &e[2 + num_syms]);
+
+	return dfa;
+	}
+
+void DFA_Cache::Insert(const std::string& key, DFA_Machine* dfa,
+			const EquivClass* ec)
+	{
+	if ( ! dfa->Expand(dfa_state_cache_size) )
+		return;
+
+	int num_syms = ec->NumSyms();
+	int num_ecs = ec->NumClasses();
+
+	// Number the reachable states in the order we encounter them.
+	DFA_state_list states;
+	std::map<DFA_State*, int> index;
+
+	if ( dfa->StartState() )
+		{
+		states.append(dfa->StartState());
+		index[dfa->StartState()] = 0;
+		}
+
+	for ( int i = 0; i < states.length(); ++i )
+		for ( int sym = 0; sym < num_ecs; ++sym )
+			{
+			DFA_State* next = states[i]->xtions[sym];
+
+			if ( next && index.find(next) == index.end() )
+				{
+				index[next] = states.length();
+				states.append(next);
+				}
+			}
+
+	Entry e;
+	e.push_back(num_syms);
+	e.push_back(num_ecs);
+
+	for ( int i = 0; i < num_syms; ++i )
+		e.push_back(ec->SymEquivClass(i));
+
+	for ( int i = 0; i < num_syms; ++i )
+		e.push_back(ec->Reps()[i]);
+
+	e.push_back(states.length());
+	e.push_back(states.length() ? 0 : -1);
+
+	loop_over_list(states, i)
+		{
+		const AcceptingSet* accept = states[i]->Accept();
+
+		e.push_back(accept ? accept->size() : 0);
+
+		if ( accept )
+			for ( AcceptingSet::const_iterator j = accept->begin();
+			      j != accept->end(); ++j )
+				e.push_back(*j);
+
+		for ( int sym = 0; sym < num_ecs; ++sym )
+			{
+			DFA_State* next = states[i]->xtions[sym];
+			e.push_back(next ? index[next] : -1);
+			}
+		}
+
+	entries[Hash(key)].swap(e);
+	dirty = true;
+	}
@@ -0,0 +1,54 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// A file-backed cache of fully expanded DFAs, keyed by the patterns they
+// were compiled from. On a cache hit, a regular expression matcher skips
+// parsing its patterns and building the NFA, and it doesn't need to
+// compute any DFA states on the fly later.
+
+#ifndef dfacache_h
+#define dfacache_h
+
+#include <map>
+#include <string>
+#include <vector>
+
+class DFA_Machine;
+class EquivClass;
+
+class DFA_Cache {
+public:
+	DFA_Cache(const char* filename);
+	~DFA_Cache();
+
+	// Reads the cache file, if it exists.
+	void Load();
+
+	// Writes the cache file back if machines have been added.
+	void Save();
+
+	// Returns the cached machine for the given pattern key, or nil if
+	// there is none. On success, ec gets set to the machine's
+	// equivalence classes.
+	DFA_Machine* Lookup(const std::string& key, EquivClass* ec);
+
+	// Fully expands the machine and adds it to the cache, unless it has
+	// too many states.
+	void Insert(const std::string& key, DFA_Machine* dfa,
+			const EquivClass* ec);
+
+protected:
+	typedef std::vector<int> Entry;
+	typedef std::map<std::string, Entry> EntryMap;
+
+	std::string Hash(const std::string& key) const;
+	DFA_Machine* Decode(const Entry& e, EquivClass* ec) const;
+
+	std::string filename;
+	EntryMap entries;
+	bool dirty;
+};
+
+// Nil unless a cache file has been given on the command line.
+extern DFA_Cache* dfa_cache;
+
+#endif
@@ -6,68 +6,199 @@
 #include <memory.h>
 #endif
 
+#include <vector>
+
 #include "Dict.h"
 #include "Reporter.h"
 
-// If the mean bucket length exceeds the following then Insert() will
-// increase the size of the hash table.
-#define DEFAULT_DENSITY_THRESH 3.0
+// If the fraction of used slots (including tombstones) exceeds the
+// following then Insert() will increase the size of the hash table (or
+// rebuild it at the same size if it's mostly tombstones).
+#define DICT_MAX_LOAD 0.75
+
+// While robust cookies are active we don't rehash, and instead let the
+// table fill up beyond DICT_MAX_LOAD.  Once it reaches this load, we
+// detach the cookies from the table layout and resize regardless.
+#define DICT_FORCE_LOAD 0.9
+
+// Smallest table we allocate.
+#define DICT_MIN_SLOTS 8
+
+// Per call, MoveChains() moves at most this many entries, and looks at
+// no more than this many slots.
+#define DICT_MOVE_ENTRIES 8
+#define DICT_MOVE_SLOTS 128
 
-// Threshold above which we do not try to ensure that the hash size
-// is prime.
-#define PRIME_THRESH 1000
+// Keys up to this size are stored inside the slot itself, others in a
+// separate heap buffer.  With 64-bit pointers, this makes a slot fill
+// exactly one cache line while still holding a ConnID key inline.
+#define DICT_INLINE_KEY_SIZE 40
+
+// Values of DictEntry::len for slots not holding an entry.
+#define DICT_EMPTY -1
+#define DICT_DELETED -2
 
 class DictEntry {
 public:
-	DictEntry(void* k, int l, hash_t h, void* val)
-		{ key = k; len = l; hash = h; value = val; }
+	int IsUsed() const	{ return len >= 0; }
+	int HasInlineKey() const	{ return len <= DICT_INLINE_KEY_SIZE; }
+
+	const void* Key() const
+		{ return HasInlineKey() ? (const void*) key.bytes : key.ptr; }
 
-	~DictEntry()
+	int Matches(const void* k, int k_len, hash_t h) const
 		{
-		delete [] (char*) key;
+		// The stored hash doubles as a fingerprint, so we only
+		// touch the key if it's very likely to match.
+		return hash == h && len == k_len && ! memcmp(k, Key(), k_len);
+		}
+
+	void DeleteKey()
+		{
+		if ( ! HasInlineKey() )
+			delete [] (char*) key.ptr;
 		}
 
-	void* key;
-	int len;
 	hash_t hash;
 	void* value;
+	union {
+		void* ptr;
+		char bytes[DICT_INLINE_KEY_SIZE];
+	} key;
+	int len;	// < 0 for unused slots
 };
 
-// The value of an iteration cookie is the bucket and offset within the
-// bucket at which to start looking for the next value to return.
+// A copy of an entry's key kept outside of the table, which we need
+// where entries could move around underneath us: for ordered
+// dictionaries (in insertion order), and for detached cookies.
+class DictKey {
+public:
+	DictKey(const void* k, int l, hash_t h)
+		{
+		key = new char[l];
+		memcpy(key, k, l);
+		len = l;
+		hash = h;
+		}
+
+	~DictKey()	{ delete [] key; }
+
+	char* key;
+	int len;
+	hash_t hash;
+};
+
+// An iteration cookie is the table and slot at which to start looking
+// for the next value to return.  Once detached from the table layout
+// (see Dictionary::DetachCookies()), it instead holds the keys of all
+// entries it has yet to return.
 class IterCookie {
 public:
-	IterCookie(int b, int o)
+	IterCookie()
 		{
-		bucket = b;
-		offset = o;
-		ttbl = 0;
-		num_buckets_p = 0;
+		second_table = 0;
+		slot = 0;
+		pending = 0;
 		}
 
-	int bucket, offset;
-	PList(DictEntry)** ttbl;
-	const int* num_buckets_p;
-	PList(DictEntry) inserted;	// inserted while iterating
+	~IterCookie()
+		{
+		if ( pending )
+			{
+			loop_over_list(*pending, i)
+				delete (*pending)[i];
+
+			delete pending;
+			}
+		}
+
+	int second_table;	// iterating over tbl2 rather than tbl
+	int slot;
+	std::vector<int> inserted;	// slots filled behind us while iterating
+	PList(DictKey)* pending;
 };
 
+// Maps a hash to its home slot in a table of 2^bits slots.  The
+// multiplication spreads hashes whose low bits don't vary much.
+static inline int home_slot(hash_t hash, int bits)
+	{
+	return int((hash * 0x9e3779b97f4a7c15ULL) >> (64 - bits));
+	}
+
+// Returns the slot holding the given key, or -1 if there's none.  All
+// slots below skip_below are known to not hold any entries.
+static int probe(const DictEntry* t, int bits, int skip_below,
+			const void* key, int key_size, hash_t hash)
+	{
+	if ( ! t )
+		return -1;
+
+	int mask = (1 << bits) - 1;
+
+	if ( skip_below > mask )
+		return -1;
+
+	int i = home_slot(hash, bits);
+
+	for ( int n = 0; n <= mask; ++n, i = (i + 1) & mask )
+		{
+		if ( i < skip_below )
+			i = skip_below;
+
+		const DictEntry* e = &t[i];
+
+		if ( e->len == DICT_EMPTY )
+			return -1;
+
+		if ( e->Matches(key, key_size, hash) )
+			return i;
+		}
+
+	return -1;
+	}
+
+// Returns the first slot of the given hash's probe sequence that's
+// available for a new entry.  The table must not be full.
+static int free_slot(const DictEntry* t, int bits, hash_t hash)
+	{
+	int mask = (1 << bits) - 1;
+	int i = home_slot(hash, bits);
+
+	while ( t[i].IsUsed() )
+		i = (i + 1) & mask;
+
+	return i;
+	}
+
+static DictEntry* new_table(int num_slots)
+	{
+	DictEntry* t = new DictEntry[num_slots];
+
+	for ( int i = 0; i < num_slots; ++i )
+		t[i].len = DICT_EMPTY;
+
+	return t;
+	}
+
 Dictionary::Dictionary(dict_order ordering, int initial_size)
 	{
-	Init(initial_size);
+	init_size = initial_size;
+	tbl = 0;
+	num_slots = slot_bits = 0;
+	num_entries = num_deleted = thresh_entries = force_entries = 0;
+	max_num_entries = 0;
+
 	tbl2 = 0;
+	num_slots2 = slot_bits2 = 0;
+	num_entries2 = num_deleted2 = thresh_entries2 = force_entries2 = 0;
 
 	if ( ordering == ORDERED )
-		order = new PList(DictEntry);
+		order = new PList(DictKey);
 	else
 		order = 0;
 
-	SetDensityThresh(DEFAULT_DENSITY_THRESH);
-
 	delete_func = 0;
 	tbl_next_ind = 0;
-
-	num_buckets2 = num_entries2 = max_num_entries2 = thresh_entries2 = 0;
-	den_thresh2 = 0;
 	}
 
 Dictionary::~Dictionary()
@@ -79,181 +210,265 @@ Dictionary::~Dictionary()
 void Dictionary::Clear()
 	{
 	DeInit();
-	Init(2);
-	tbl2 = 0;
 	}
 
 void Dictionary::DeInit()
 	{
-	for ( int i = 0; i < num_buckets; ++i )
-		if ( tbl[i] )
+	for ( int i = 0; i < num_slots; ++i )
+		if ( tbl[i].IsUsed() )
 			{
-			PList(DictEntry)* chain = tbl[i];
-			loop_over_list(*chain, j)
-				{
-				DictEntry* e = (*chain)[j];
-				if ( delete_func )
-					delete_func(e->value);
-				delete e;
-				}
+			if ( delete_func )
+				delete_func(tbl[i].value);
+			tbl[i].DeleteKey();
+			}
 
-			delete chain;
+	for ( int i = 0; i < num_slots2; ++i )
+		if ( tbl2[i].IsUsed() )
+			{
+			if ( delete_func )
+				delete_func(tbl2[i].value);
+			tbl2[i].DeleteKey();
 			}
 
 	delete [] tbl;
+	delete [] tbl2;
 
-	if ( tbl2 == 0 )
-		return;
+	tbl = tbl2 = 0;
+	num_slots = slot_bits = num_slots2 = slot_bits2 = 0;
+	num_entries = num_deleted = num_entries2 = num_deleted2 = 0;
+	thresh_entries = force_entries = 0;
+	thresh_entries2 = force_entries2 = 0;
+	tbl_next_ind = 0;
 
-	for ( int i = 0; i < num_buckets2; ++i )
-		if ( tbl2[i] )
-			{
-			PList(DictEntry)* chain = tbl2[i];
-			loop_over_list(*chain, j)
-				{
-				DictEntry* e = (*chain)[j];
-				if ( delete_func )
-					delete_func(e->value);
-				delete e;
-				}
+	if ( order )
+		{
+		loop_over_list(*order, i)
+			delete (*order)[i];
+
+		order->clear();
+		}
+	}
 
-			delete chain;
+int Dictionary::Locate(const void* key, int key_size, hash_t hash,
+			bool& second) const
+	{
+	if ( tbl2 )
+		{
+		int i = probe(tbl2, slot_bits2, 0, key, key_size, hash);
+		if ( i >= 0 )
+			{
+			second = true;
+			return i;
 			}
+		}
 
-	delete [] tbl2;
-	tbl2 = 0;
+	// Whatever we've already moved over to tbl2 is gone from tbl.
+	second = false;
+	return probe(tbl, slot_bits, tbl2 ? tbl_next_ind : 0,
+			key, key_size, hash);
 	}
 
-void* Dictionary::Lookup(const void* key, int key_size, hash_t hash) const
+DictEntry* Dictionary::FindEntry(const void* key, int key_size,
+					hash_t hash) const
 	{
-	hash_t h;
-	PList(DictEntry)* chain;
+	bool second;
+	int i = Locate(key, key_size, hash, second);
 
-	// Figure out which hash table to look in.
-	h = hash % num_buckets;
-	if ( ! tbl2 || h >= tbl_next_ind )
-		chain = tbl[h];
-	else
-		chain = tbl2[hash % num_buckets2];
+	if ( i < 0 )
+		return 0;
 
-	if ( chain )
-		{
-		for ( int i = 0; i < chain->length(); ++i )
-			{
-			DictEntry* entry = (*chain)[i];
+	return second ? &tbl2[i] : &tbl[i];
+	}
 
-			if ( entry->hash == hash && entry->len == key_size &&
-			     ! memcmp(key, entry->key, key_size) )
-				return entry->value;
-			}
-		}
+void* Dictionary::Lookup(const void* key, int key_size, hash_t hash) const
+	{
+	DictEntry* entry = FindEntry(key, key_size, hash);
+	return entry ? entry->value : 0;
+	}
 
-	return 0;
+void* Dictionary::Insert(HashKey* key, void* val)
+	{
+	// Short keys get copied into the table anyway, so there's no
+	// point in taking over the HashKey's buffer.
+	if ( key->Size() <= DICT_INLINE_KEY_SIZE )
+		return Insert((void*) key->Key(), key->Size(), key->Hash(),
+				val, 1);
+
+	return Insert(key->TakeKey(), key->Size(), key->Hash(), val, 0);
 	}
 
 void* Dictionary::Insert(void* key, int key_size, hash_t hash, void* val,
 				int copy_key)
 	{
-	DictEntry* new_entry = new DictEntry(key, key_size, hash, val);
-	void* old_val = Insert(new_entry, copy_key);
+	DictEntry* entry = FindEntry(key, key_size, hash);
 
-	if ( old_val )
+	if ( entry )
 		{
-		// We didn't need the new DictEntry, the key was already
-		// present.
-		delete new_entry;
+		// Key already present, just replace the value.
+		void* old_value = entry->value;
+		entry->value = val;
+
+		if ( ! copy_key )
+			delete [] (char*) key;
+
+		return old_value;
 		}
-	else if ( order )
-		order->append(new_entry);
 
-	// Resize logic.
-	if ( tbl2 )
-		MoveChains();
-	else if ( num_entries >= thresh_entries )
-		StartChangeSize(num_buckets * 2 + 1);
+	MakeRoom();
 
-	return old_val;
-	}
+	// While resizing, new entries always go into the new table.
+	bool second = (tbl2 != 0);
+	DictEntry* ttbl = second ? tbl2 : tbl;
+	int slot = free_slot(ttbl, second ? slot_bits2 : slot_bits, hash);
 
-void* Dictionary::Remove(const void* key, int key_size, hash_t hash,
-				bool dont_delete)
-	{
-	hash_t h;
-	PList(DictEntry)* chain;
-	int* num_entries_ptr;
+	entry = &ttbl[slot];
+
+	if ( entry->len == DICT_DELETED )
+		--*(second ? &num_deleted2 : &num_deleted);
 
-	// Figure out which hash table to look in
-	h = hash % num_buckets;
-	if ( ! tbl2 || h >= tbl_next_ind )
+	entry->hash = hash;
+	entry->value = val;
+	entry->len = key_size;
+
+	if ( entry->HasInlineKey() )
 		{
-		chain = tbl[h];
-		num_entries_ptr = &num_entries;
+		memcpy(entry->key.bytes, key, key_size);
+
+		if ( ! copy_key )
+			delete [] (char*) key;
 		}
-	else
+
+	else if ( copy_key )
 		{
-		chain = tbl2[hash % num_buckets2];
-		num_entries_ptr = &num_entries2;
+		entry->key.ptr = new char[key_size];
+		memcpy(entry->key.ptr, key, key_size);
 		}
 
-	if ( ! chain )
-		return 0;
+	else
+		entry->key.ptr = key;
 
-	for ( int i = 0; i < chain->length(); ++i )
-		{
-		DictEntry* entry = (*chain)[i];
+	++*(second ? &num_entries2 : &num_entries);
 
-		if ( entry->hash == hash && entry->len == key_size &&
-		     ! memcmp(key, entry->key, key_size) )
-			{
-			void* entry_value = DoRemove(entry, h, chain, i);
+	if ( Length() > max_num_entries )
+		max_num_entries = Length();
 
-			if ( dont_delete )
-				entry->key = 0;
+	if ( order )
+		order->append(new DictKey(entry->Key(), key_size, hash));
 
-			delete entry;
-			--*num_entries_ptr;
-			return entry_value;
-			}
+	// For ongoing iterations: If we already passed the slot where this
+	// entry was put, add it to the cookie's list of inserted entries.
+	loop_over_list(cookies, i)
+		{
+		IterCookie* c = cookies[i];
+
+		if ( c->pending )
+			c->pending->append(new DictKey(entry->Key(), key_size,
+							hash));
+
+		else if ( c->second_table == second && slot < c->slot )
+			c->inserted.push_back(slot);
 		}
 
+	// Resize logic.
+	if ( tbl2 )
+		MoveChains();
+	else if ( num_entries + num_deleted >= thresh_entries )
+		StartChangeSize(NewSize());
+
 	return 0;
 	}
 
-void* Dictionary::DoRemove(DictEntry* entry, hash_t h,
-				PList(DictEntry)* chain, int chain_offset)
+void* Dictionary::Remove(const void* key, int key_size, hash_t hash,
+				bool dont_delete)
 	{
+	bool second;
+	int slot = Locate(key, key_size, hash, second);
+
+	if ( slot < 0 )
+		return 0;
+
+	DictEntry* entry = second ? &tbl2[slot] : &tbl[slot];
 	void* entry_value = entry->value;
 
-	chain->remove_nth(chain_offset);
+	if ( ! dont_delete )
+		entry->DeleteKey();
+
 	if ( order )
-		order->remove(entry);
+		{
+		loop_over_list(*order, i)
+			{
+			DictKey* oe = (*order)[i];
+
+			if ( oe->hash == hash && oe->len == key_size &&
+			     ! memcmp(oe->key, key, key_size) )
+				{
+				order->remove_nth(i);
+				delete oe;
+				break;
+				}
+			}
+		}
 
-	// Adjust existing cookies.
+	// This item may have been inserted during an iteration.
 	loop_over_list(cookies, i)
 		{
 		IterCookie* c = cookies[i];
 
-		// Is the affected bucket the current one?
-		if ( (unsigned int) c->bucket == h )
+		if ( c->pending || c->second_table != second )
+			continue;
+
+		for ( unsigned int j = 0; j < c->inserted.size(); ++j )
+			if ( c->inserted[j] == slot )
+				{
+				c->inserted.erase(c->inserted.begin() + j);
+				break;
+				}
+		}
+
+	--*(second ? &num_entries2 : &num_entries);
+	ClearSlot(second, slot);
+
+	return entry_value;
+	}
+
+void Dictionary::ClearSlot(bool second, int slot)
+	{
+	DictEntry* ttbl = second ? tbl2 : tbl;
+
+	// When the old table is being moved over, or cookies rely on
+	// entries staying put, we leave a tombstone.
+	if ( (! second && tbl2) || HaveBlockingCookies() )
+		{
+		ttbl[slot].len = DICT_DELETED;
+		++*(second ? &num_deleted2 : &num_deleted);
+		return;
+		}
+
+	// Otherwise, shift back the entries following in the probe
+	// sequence that would no longer be found with the slot emptied.
+	// Tombstones have no home slot, so they can always be moved.
+	int bits = second ? slot_bits2 : slot_bits;
+	int mask = (1 << bits) - 1;
+	int hole = slot;
+
+	for ( int i = (hole + 1) & mask; ttbl[i].len != DICT_EMPTY;
+	      i = (i + 1) & mask )
+		{
+		if ( ttbl[i].IsUsed() )
 			{
-			if ( c->offset > chain_offset )
-				--c->offset;
-
-			// The only other important case here occurs when we
-			// are deleting the current entry which
-			// simultaniously happens to be the last one in this
-			// bucket. This means that we would have to move on
-			// to the next non-empty bucket. Fortunately,
-			// NextEntry() will do exactly the right thing in
-			// this case. :-)
+			int home = home_slot(ttbl[i].hash, bits);
+
+			// Stays if its home is cyclically in (hole, i].
+			if ( hole <= i ? (hole < home && home <= i) :
+					 (hole < home || home <= i) )
+				continue;
 			}
 
-		// This item may have been inserted during this iteration.
-		if ( (unsigned int) c->bucket > h )
-			c->inserted.remove(entry);
+		ttbl[hole] = ttbl[i];
+		hole = i;
 		}
 
-	return entry_value;
+	ttbl[hole].len = DICT_EMPTY;
 	}
 
 void* Dictionary::NthEntry(int n, const void*& key, int& key_len) const
@@ -261,233 +476,252 @@ void* Dictionary::NthEntry(int n, const void*& key, int& key_len) const
 	if ( ! order || n < 0 || n >= Length() )
 		return 0;
 
-	DictEntry* entry = (*order)[n];
+	DictKey* entry = (*order)[n];
 	key = entry->key;
 	key_len = entry->len;
-	return entry->value;
+	return Lookup(entry->key, entry->len, entry->hash);
 	}
 
 IterCookie* Dictionary::InitForIteration() const
 	{
-	return new IterCookie(0, 0);
+	return new IterCookie();
 	}
 
 void Dictionary::StopIteration(IterCookie* cookie) const
 	{
+	const_cast<PList(IterCookie)*>(&cookies)->remove(cookie);
 	delete cookie;
 	}
 
 void* Dictionary::NextEntry(HashKey*& h, IterCookie*& cookie, int return_hash) const
 	{
-	// If there are any inserted entries, return them first.
-	// That keeps the list small and helps avoiding searching
-	// a large list when deleting an entry.
+	const DictEntry* entry = NextSlot(cookie);
 
-	DictEntry* entry;
+	if ( ! entry )
+		return 0;
 
-	if ( cookie->inserted.length() )
-		{
-		// Return the last one. Order doesn't matter,
-		// and removing from the tail is cheaper.
-		entry = cookie->inserted.remove_nth(cookie->inserted.length()-1);
-		if ( return_hash )
-			h = new HashKey(entry->key, entry->len, entry->hash);
+	if ( return_hash )
+		h = new HashKey(entry->Key(), entry->len, entry->hash);
 
-		return entry->value;
-		}
+	return entry->value;
+	}
 
-	int b = cookie->bucket;
-	int o = cookie->offset;
-	PList(DictEntry)** ttbl;
-	const int* num_buckets_p;
+void* Dictionary::NextEntry(const void*& key, int& key_len,
+				IterCookie*& cookie) const
+	{
+	const DictEntry* entry = NextSlot(cookie);
 
-	if ( ! cookie->ttbl )
-		{
-		// XXX maybe we could update cookie->b from tbl_next_ind here?
-		cookie->ttbl = tbl;
-		cookie->num_buckets_p = &num_buckets;
-		}
+	if ( ! entry )
+		return 0;
 
-	ttbl = cookie->ttbl;
-	num_buckets_p = cookie->num_buckets_p;
+	key = entry->Key();
+	key_len = entry->len;
+	return entry->value;
+	}
 
-	if ( ttbl[b] && ttbl[b]->length() > o )
+const DictEntry* Dictionary::NextSlot(IterCookie*& cookie) const
+	{
+	if ( cookie->pending )
 		{
-		entry = (*ttbl[b])[o];
-		++cookie->offset;
-		if ( return_hash )
-			h = new HashKey(entry->key, entry->len, entry->hash);
-		return entry->value;
-		}
+		// Detached cookie: return whatever of its remaining keys
+		// is still around.
+		while ( cookie->pending->length() )
+			{
+			DictKey* k = cookie->pending->remove_nth(
+					cookie->pending->length() - 1);
+			const DictEntry* entry = FindEntry(k->key, k->len, k->hash);
+			delete k;
 
-	++b;	// Move on to next non-empty bucket.
-	while ( b < *num_buckets_p && (! ttbl[b] || ttbl[b]->length() == 0) )
-		++b;
+			if ( entry )
+				return entry;
+			}
+		}
 
-	if ( b >= *num_buckets_p )
+	else
 		{
-		// If we're resizing, we need to search the 2nd table too.
-		if ( ttbl == tbl && tbl2 )
+		// If there are any inserted entries, return them first.
+		// That keeps the list small and helps avoiding searching
+		// a large list when deleting an entry.
+		const DictEntry* ttbl = cookie->second_table ? tbl2 : tbl;
+		int n = cookie->second_table ? num_slots2 : num_slots;
+
+		while ( cookie->inserted.size() )
 			{
-			cookie->ttbl = tbl2;
-			cookie->num_buckets_p = &num_buckets2;
-			cookie->bucket = 0;
-			cookie->offset = 0;
-			return Dictionary::NextEntry(h, cookie, return_hash);
+			// Return the last one. Order doesn't matter,
+			// and removing from the tail is cheaper.
+			int slot = cookie->inserted.back();
+			cookie->inserted.pop_back();
+
+			if ( ttbl && slot < n && ttbl[slot].IsUsed() )
+				return &ttbl[slot];
 			}
 
-		// All done.
+		for ( ; ; )
+			{
+			while ( ttbl && cookie->slot < n )
+				{
+				const DictEntry* entry = &ttbl[cookie->slot++];
 
-		// FIXME: I don't like removing the const here. But is there
-		// a better way?
-		const_cast<PList(IterCookie)*>(&cookies)->remove(cookie);
-		delete cookie;
-		cookie = 0;
-		return 0;
+				if ( entry->IsUsed() )
+					return entry;
+				}
+
+			// If we're resizing, we need to search the 2nd
+			// table too.
+			if ( cookie->second_table || ! tbl2 )
+				break;
+
+			cookie->second_table = 1;
+			cookie->slot = 0;
+			ttbl = tbl2;
+			n = num_slots2;
+			}
 		}
 
-	entry = (*ttbl[b])[0];
-	if ( return_hash )
-		h = new HashKey(entry->key, entry->len, entry->hash);
+	// All done.
 
-	cookie->bucket = b;
-	cookie->offset = 1;
+	// FIXME: I don't like removing the const here. But is there
+	// a better way?
+	const_cast<PList(IterCookie)*>(&cookies)->remove(cookie);
+	delete cookie;
+	cookie = 0;
+	return 0;
+	}
 
-	return entry->value;
+bool Dictionary::HaveBlockingCookies() const
+	{
+	loop_over_list(cookies, i)
+		if ( ! cookies[i]->pending )
+			return true;
+
+	return false;
 	}
 
-void Dictionary::Init(int size)
+void Dictionary::DetachCookies()
 	{
-	num_buckets = NextPrime(size);
-	tbl = new PList(DictEntry)*[num_buckets];
+	loop_over_list(cookies, i)
+		{
+		IterCookie* c = cookies[i];
+
+		if ( c->pending )
+			continue;
+
+		c->pending = new PList(DictKey);
+
+		// Collect everything NextSlot() would still have returned.
+		const DictEntry* ttbl = c->second_table ? tbl2 : tbl;
+		int n = c->second_table ? num_slots2 : num_slots;
+
+		for ( unsigned int j = 0; j < c->inserted.size(); ++j )
+			{
+			const DictEntry* e = &ttbl[c->inserted[j]];
+			c->pending->append(new DictKey(e->Key(), e->len,
+							e->hash));
+			}
 
-	for ( int i = 0; i < num_buckets; ++i )
-		tbl[i] = 0;
+		c->inserted.clear();
 
-	max_num_entries = num_entries = 0;
+		for ( int j = c->slot; ttbl && j < n; ++j )
+			if ( ttbl[j].IsUsed() )
+				c->pending->append(new DictKey(ttbl[j].Key(),
+						ttbl[j].len, ttbl[j].hash));
+
+		if ( ! c->second_table )
+			for ( int j = 0; j < num_slots2; ++j )
+				if ( tbl2[j].IsUsed() )
+					c->pending->append(new DictKey(
+						tbl2[j].Key(), tbl2[j].len,
+						tbl2[j].hash));
+		}
 	}
 
-void Dictionary::Init2(int size)
+void Dictionary::Init(int size)
 	{
-	num_buckets2 = NextPrime(size);
-	tbl2 = new PList(DictEntry)*[num_buckets2];
+	for ( num_slots = DICT_MIN_SLOTS, slot_bits = 3; num_slots < size;
+	      num_slots <<= 1 )
+		++slot_bits;
 
-	for ( int i = 0; i < num_buckets2; ++i )
-		tbl2[i] = 0;
+	tbl = new_table(num_slots);
 
-	max_num_entries2 = num_entries2 = 0;
+	num_entries = num_deleted = 0;
+	thresh_entries = int(num_slots * DICT_MAX_LOAD);
+	force_entries = int(num_slots * DICT_FORCE_LOAD);
 	}
 
-// private
-void* Dictionary::Insert(DictEntry* new_entry, int copy_key)
+void Dictionary::Init2(int size)
 	{
-	PList(DictEntry)** ttbl;
-	int* num_entries_ptr;
-	int* max_num_entries_ptr;
-	hash_t h = new_entry->hash % num_buckets;
+	for ( num_slots2 = DICT_MIN_SLOTS, slot_bits2 = 3; num_slots2 < size;
+	      num_slots2 <<= 1 )
+		++slot_bits2;
+
+	tbl2 = new_table(num_slots2);
 
-	// We must be careful when we are in the middle of resizing.
-	// If the new entry hashes to a bucket in the old table we
-	// haven't moved yet, we need to put it in the old table. If
-	// we didn't do it this way, we would sometimes have to
-	// search both tables which is probably more expensive.
+	num_entries2 = num_deleted2 = 0;
+	thresh_entries2 = int(num_slots2 * DICT_MAX_LOAD);
+	force_entries2 = int(num_slots2 * DICT_FORCE_LOAD);
+	}
 
-	if ( ! tbl2 || h >= tbl_next_ind )
+void Dictionary::MakeRoom()
+	{
+	if ( ! tbl )
 		{
-		ttbl = tbl;
-		num_entries_ptr = &num_entries;
-		max_num_entries_ptr = &max_num_entries;
+		Init(init_size);
+		return;
 		}
-	else
+
+	if ( tbl2 )
 		{
-		ttbl = tbl2;
-		h = new_entry->hash % num_buckets2;
-		num_entries_ptr = &num_entries2;
-		max_num_entries_ptr = &max_num_entries2;
-		}
+		if ( num_entries2 + num_deleted2 < force_entries2 )
+			return;
 
-	PList(DictEntry)* chain = ttbl[h];
+		// Robust cookies have kept MoveChains() from making
+		// progress for too long, so tbl2 may not have room for the
+		// rest of tbl anymore.  Move everything into a fresh table
+		// large enough for both right away.
+		DetachCookies();
 
-	int n = new_entry->len;
+		DictEntry* old_tbl2 = tbl2;
+		int old_num_slots2 = num_slots2;
 
-	if ( chain )
-		{
-		for ( int i = 0; i < chain->length(); ++i )
-			{
-			DictEntry* entry = (*chain)[i];
+		Init2(2 * Length());
 
-			if ( entry->hash == new_entry->hash &&
-			     entry->len == n &&
-			     ! memcmp(entry->key, new_entry->key, n) )
+		for ( int i = 0; i < old_num_slots2; ++i )
+			if ( old_tbl2[i].IsUsed() )
 				{
-				void* old_value = entry->value;
-				entry->value = new_entry->value;
-				return old_value;
+				tbl2[free_slot(tbl2, slot_bits2,
+						old_tbl2[i].hash)] = old_tbl2[i];
+				++num_entries2;
 				}
-			}
-		}
-	else
-		// Create new chain.
-		chain = ttbl[h] = new PList(DictEntry);
-
-	// If we got this far, then we couldn't use an existing copy
-	// of the key, so make a new one if necessary.
-	if ( copy_key )
-		{
-		void* old_key = new_entry->key;
-		new_entry->key = (void*) new char[n];
-		memcpy(new_entry->key, old_key, n);
-		delete (char*) old_key;
-		}
 
-	// We happen to know (:-() that appending is more efficient
-	// on lists than prepending.
-	chain->append(new_entry);
+		delete [] old_tbl2;
 
-	if ( *max_num_entries_ptr < ++*num_entries_ptr )
-		*max_num_entries_ptr = *num_entries_ptr;
+		while ( tbl2 )
+			MoveChains();
 
-	// For ongoing iterations: If we already passed the bucket where this
-	// entry was put, add it to the cookie's list of inserted entries.
-	loop_over_list(cookies, i)
-		{
-		IterCookie* c = cookies[i];
-		if ( h < (unsigned int) c->bucket )
-			c->inserted.append(new_entry);
+		return;
 		}
 
-	return 0;
-	}
-
-int Dictionary::NextPrime(int n) const
-	{
-	if ( (n & 0x1) == 0 )
-		// Even.
-		++n;
-
-	if ( n > PRIME_THRESH )
-		// Too expensive to test for primality, just stick with it.
-		return n;
-
-	while ( ! IsPrime(n) )
-		n += 2;
+	if ( num_entries + num_deleted < force_entries )
+		return;
 
-	return n;
+	DetachCookies();
+	StartChangeSize(NewSize());
 	}
 
-int Dictionary::IsPrime(int n) const
+int Dictionary::NewSize() const
 	{
-	for ( int j = 3; j * j <= n; ++j )
-		if ( n % j == 0 )
-			return 0;
+	// If most of the used slots are tombstones, it's enough to
+	// rebuild the table at its current size.
+	if ( num_entries < thresh_entries / 2 )
+		return num_slots;
 
-	return 1;
+	return num_slots * 2;
 	}
 
 void Dictionary::StartChangeSize(int new_size)
 	{
 	// Only start resizing if there isn't any iteration in progress.
-	if ( cookies.length() > 0 )
+	if ( HaveBlockingCookies() )
 		return;
 
 	if ( tbl2 )
@@ -496,41 +730,36 @@ void Dictionary::StartChangeSize(int new_size)
 	Init2(new_size);
 
 	tbl_next_ind = 0;
-
-	// Preserve threshold density
-	SetDensityThresh2(DensityThresh());
 	}
 
 void Dictionary::MoveChains()
 	{
 	// Do not change current distribution if there an ongoing iteration.
-	if ( cookies.length() > 0 )
+	if ( HaveBlockingCookies() )
 		return;
 
-	// Attempt to move this many entries (must do at least 2)
-	int num = 8;
+	// Attempt to move this many entries.  Everything below
+	// tbl_next_ind is marked as deleted, so that lookups in tbl still
+	// find the entries further along their probe sequence.
+	int num = DICT_MOVE_ENTRIES;
+	int max_slots = DICT_MOVE_SLOTS;
 
-	do
+	while ( num > 0 && --max_slots >= 0 && tbl_next_ind < num_slots )
 		{
-		PList(DictEntry)* chain = tbl[tbl_next_ind++];
+		DictEntry* entry = &tbl[tbl_next_ind++];
 
-		if ( ! chain )
-			continue;
-
-		tbl[tbl_next_ind - 1] = 0;
-
-		for ( int j = 0; j < chain->length(); ++j )
+		if ( entry->IsUsed() )
 			{
-			Insert((*chain)[j], 0);
+			tbl2[free_slot(tbl2, slot_bits2, entry->hash)] = *entry;
+			++num_entries2;
 			--num_entries;
 			--num;
 			}
 
-		delete chain;
+		entry->len = DICT_DELETED;
 		}
-	while ( num > 0 && int(tbl_next_ind) < num_buckets );
 
-	if ( int(tbl_next_ind) >= num_buckets )
+	if ( tbl_next_ind >= num_slots )
 		FinishChangeSize();
 	}
 
@@ -542,56 +771,53 @@ void Dictionary::FinishChangeSize()
 		    "Dictionary::FinishChangeSize: num_entries is %d\n",
 		    num_entries);
 
-	for ( int i = 0; i < num_buckets; ++i )
-		delete tbl[i];
 	delete [] tbl;
 
 	tbl = tbl2;
 	tbl2 = 0;
 
-	num_buckets = num_buckets2;
+	num_slots = num_slots2;
+	slot_bits = slot_bits2;
 	num_entries = num_entries2;
-	max_num_entries = max_num_entries2;
-	den_thresh = den_thresh2;
+	num_deleted = num_deleted2;
 	thresh_entries = thresh_entries2;
+	force_entries = force_entries2;
 
-	num_buckets2 = 0;
+	num_slots2 = 0;
+	slot_bits2 = 0;
 	num_entries2 = 0;
-	max_num_entries2 = 0;
-	den_thresh2 = 0;
+	num_deleted2 = 0;
 	thresh_entries2 = 0;
+	force_entries2 = 0;
+	tbl_next_ind = 0;
 	}
 
 unsigned int Dictionary::MemoryAllocation() const
 	{
 	int size = padded_sizeof(*this);
 
-	for ( int i = 0; i < num_buckets; ++i )
-		if ( tbl[i] )
-			{
-			PList(DictEntry)* chain = tbl[i];
-			loop_over_list(*chain, j)
-				size += padded_sizeof(DictEntry) + pad_size((*chain)[j]->len);
-			size += chain->MemoryAllocation();
-			}
+	for ( int i = 0; i < num_slots; ++i )
+		if ( tbl[i].IsUsed() && ! tbl[i].HasInlineKey() )
+			size += pad_size(tbl[i].len);
 
-	size += pad_size(num_buckets * sizeof(PList(DictEntry)*));
+	size += pad_size(num_slots * sizeof(DictEntry));
 
 	if ( order )
+		{
 		size += order->MemoryAllocation();
 
+		loop_over_list(*order, i)
+			size += padded_sizeof(DictKey) +
+				pad_size((*order)[i]->len);
+		}
+
 	if ( tbl2 )
 		{
-		for ( int i = 0; i < num_buckets2; ++i )
-			if ( tbl2[i] )
-				{
-				PList(DictEntry)* chain = tbl2[i];
-				loop_over_list(*chain, j)
-					size += padded_sizeof(DictEntry) + pad_size((*chain)[j]->len);
-				size += chain->MemoryAllocation();
-				}
+		for ( int i = 0; i < num_slots2; ++i )
+			if ( tbl2[i].IsUsed() && ! tbl2[i].HasInlineKey() )
+				size += pad_size(tbl2[i].len);
 
-		size += pad_size(num_buckets2 * sizeof(PList(DictEntry)*));
+		size += pad_size(num_slots2 * sizeof(DictEntry));
 		}
 
 	return size;
@@ -8,14 +8,15 @@
 
 class Dictionary;
 class DictEntry;
+class DictKey;
 class IterCookie;
 
-declare(PList,DictEntry);
+declare(PList,DictKey);
 declare(PList,IterCookie);
 
-// Default number of hash buckets in dictionary.  The dictionary will
-// increase the size of the hash table as needed.
-#define DEFAULT_DICT_SIZE 16
+// Default number of slots in a dictionary's hash table.  The table is
+// only allocated upon the first insertion, and grows as needed.
+#define DEFAULT_DICT_SIZE 8
 
 // Type indicating whether the dictionary should keep track of the order
 // of insertions.
@@ -42,10 +43,8 @@ public:
 	void* Lookup(const void* key, int key_size, hash_t hash) const;
 
 	// Returns previous value, or 0 if none.
-	void* Insert(HashKey* key, void* val)
-		{
-		return Insert(key->TakeKey(), key->Size(), key->Hash(), val, 0);
-		}
+	void* Insert(HashKey* key, void* val);
+
 	// If copy_key is true, then the key is copied, otherwise it's assumed
 	// that it's a heap pointer that now belongs to the Dictionary to
 	// manage as needed.
@@ -65,11 +64,7 @@ public:
 		{ return tbl2 ? num_entries + num_entries2 : num_entries; }
 
 	// Largest it's ever been.
-	int MaxLength() const
-		{
-		return tbl2 ?
-			max_num_entries + max_num_entries2 : max_num_entries;
-		}
+	int MaxLength() const	{ return max_num_entries; }
 
 	// True if the dictionary is ordered, false otherwise.
 	int IsOrdered() const		{ return order != 0; }
@@ -100,7 +95,9 @@ public:
 	// first calling InitForIteration().
 	//
 	// If return_hash is true, a HashKey for the entry is returned in h,
-	// which should be delete'd when no longer needed.
+	// which should be delete'd when no longer needed.  The raw key
+	// returned by the second version is only valid until the
+	// dictionary is next modified.
 	IterCookie* InitForIteration() const;
 	void* NextEntry(HashKey*& h, IterCookie*& cookie, int return_hash) const;
 	void* NextEntry(const void*& key, int& key_len, IterCookie*& cookie)
@@ -115,6 +112,12 @@ public:
 	// and (ii) we won't visit any still-unseen entries which are getting
 	// removed. (We don't get this for free, so only use it if
 	// necessary.)
+	//
+	// While a robust cookie is active, the table avoids moving entries
+	// around.  If it fills up regardless, the cookie switches to
+	// remembering the keys it still has to visit, in which case an
+	// entry that gets removed and then re-inserted during the iteration
+	// may be returned twice.
 	void MakeRobustCookie(IterCookie* cookie)
 		{ cookies.append(cookie); }
 
@@ -128,58 +131,68 @@ private:
 	void Init2(int size);	// initialize second table for resizing
 	void DeInit();
 
-	// Internal version of Insert().
-	void* Insert(DictEntry* entry, int copy_key);
+	// Returns the slot holding the given key, or -1 if there is none.
+	// "second" is set to true if the slot is in tbl2, false if in tbl.
+	int Locate(const void* key, int key_size, hash_t hash,
+			bool& second) const;
+	DictEntry* FindEntry(const void* key, int key_size, hash_t hash) const;
 
-	void* DoRemove(DictEntry* entry, hash_t h,
-			PList(DictEntry)* chain, int chain_offset);
+	// Returns the next entry for the given cookie, or nil (after
+	// deleting the cookie) when the iteration is done.
+	const DictEntry* NextSlot(IterCookie*& cookie) const;
 
-	int NextPrime(int n) const;
-	int IsPrime(int n) const;
-	void StartChangeSize(int new_size);
-	void FinishChangeSize(void);
-	void MoveChains(void);
+	// Makes sure that the table Insert() places new entries into has
+	// room for one more.
+	void MakeRoom();
 
-	// The following get and set the "density" threshold - if the
-	// average hash chain length exceeds this threshold, the
-	// table will be resized.  The default value is 3.0.
-	double DensityThresh() const	{ return den_thresh; }
+	// Vacates the given slot, either by turning it into a tombstone or
+	// by shifting the following entries of its probe sequence back.
+	void ClearSlot(bool second, int slot);
 
-	void SetDensityThresh(double thresh)
-		{
-		den_thresh = thresh;
-		thresh_entries = int(thresh * double(num_buckets));
-		}
+	// True if there are robust cookies whose position depends on the
+	// current table layout, in which case entries must not move.
+	bool HaveBlockingCookies() const;
 
-	// Same for the second table, when resizing.
-	void SetDensityThresh2(double thresh)
-		{
-		den_thresh2 = thresh;
-		thresh_entries2 = int(thresh * double(num_buckets2));
-		}
+	// Switches all robust cookies over to tracking the keys they still
+	// have to visit explicitly, so that entries may move again.
+	void DetachCookies();
+
+	int NewSize() const;
+	void StartChangeSize(int new_size);
+	void FinishChangeSize(void);
+	void MoveChains(void);
 
-	// Normally we only have tbl.
-	// When we're resizing, we'll have tbl (old) and tbl2 (new)
-	// tbl_next_ind keeps track of how much we've moved to tbl2
-	// (it's the next index we're going to move).
-	PList(DictEntry)** tbl;
-	int num_buckets;
+	// Normally we only have tbl, an open-addressing table with
+	// linear probing whose size is a power of two.  Slots hold the
+	// full hash as a fingerprint and store short keys inline.
+	//
+	// When we're resizing, we'll have tbl (old) and tbl2 (new).  New
+	// entries always go into tbl2, and tbl_next_ind keeps track of
+	// how much of tbl we've moved over to tbl2 (it's the next slot
+	// we're going to move).
+	DictEntry* tbl;
+	int num_slots;
+	int slot_bits;
 	int num_entries;
-	int max_num_entries;
-	double den_thresh;
+	int num_deleted;	// tombstones
 	int thresh_entries;
+	int force_entries;
 
 	// Resizing table (replicates tbl above).
-	PList(DictEntry)** tbl2;
-	int num_buckets2;
+	DictEntry* tbl2;
+	int num_slots2;
+	int slot_bits2;
 	int num_entries2;
-	int max_num_entries2;
-	double den_thresh2;
+	int num_deleted2;
 	int thresh_entries2;
+	int force_entries2;
 
-	hash_t tbl_next_ind;
+	int tbl_next_ind;
+
+	int init_size;
+	int max_num_entries;
 
-	PList(DictEntry)* order;
+	PList(DictKey)* order;
 	dict_delete_func delete_func;
 
 	PList(IterCookie) cookies;
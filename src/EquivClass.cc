@@ -82,6 +82,18 @@ int EquivClass::BuildECs()
 	return num_ecs;
 	}
 
+void EquivClass::SetECs(int arg_num_ecs, const int* arg_equiv_class,
+			const int* arg_rep)
+	{
+	num_ecs = arg_num_ecs;
+
+	for ( int i = 0; i < size; ++i )
+		{
+		equiv_class[i] = arg_equiv_class[i];
+		rep[i] = arg_rep[i];
+		}
+	}
+
 void EquivClass::CCL_Use(CCL* ccl)
 	{
 	// Note that it doesn't matter whether or not the character class is
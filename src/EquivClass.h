@@ -21,10 +21,14 @@ public:
 
 	void ConvertCCL(CCL* ccl);
 
+	// Installs classes built earlier, as saved by the DFA cache.
+	void SetECs(int num_ecs, const int* equiv_class, const int* rep);
+
 	int IsRep(int sym) const		{ return rep[sym] == sym; }
 	int EquivRep(int sym) const		{ return rep[sym]; }
 	int SymEquivClass(int sym) const	{ return equiv_class[sym]; }
 	int* EquivClasses() const		{ return equiv_class; }
+	const int* Reps() const			{ return rep; }
 
 	int NumSyms() const	{ return size; }
 	int NumClasses() const	{ return num_ecs; }
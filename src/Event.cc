@@ -13,6 +13,8 @@ EventMgr mgr;
 int num_events_queued = 0;
 int num_events_dispatched = 0;
 
+IMPLEMENT_SLAB_ALLOCATION(Event, "Event")
+
 Event::Event(EventHandlerPtr arg_handler, val_list* arg_args,
 		SourceID arg_src, analyzer::ID arg_aid, TimerMgr* arg_mgr,
 		BroObj* arg_obj)
@@ -158,10 +160,10 @@ RecordVal* EventMgr::GetLocalPeerVal()
 	if ( ! src_val )
 		{
 		src_val = new RecordVal(peer);
-		src_val->Assign(0, new Val(0, TYPE_COUNT));
+		src_val->Assign(0, val_mgr->GetCount(0));
 		src_val->Assign(1, new AddrVal("127.0.0.1"));
-		src_val->Assign(2, new PortVal(0));
-		src_val->Assign(3, new Val(true, TYPE_BOOL));
+		src_val->Assign(2, val_mgr->GetPort(0));
+		src_val->Assign(3, val_mgr->GetBool(true));
 
 		Ref(peer_description);
 		src_val->Assign(4, peer_description);
@@ -18,6 +18,8 @@ public:
 		TimerMgr* mgr = 0, BroObj* obj = 0);
 	~Event();
 
+	DECLARE_SLAB_ALLOCATION()
+
 	void SetNext(Event* n)		{ next_event = n; }
 	Event* NextEvent() const	{ return next_event; }
 
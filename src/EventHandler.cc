@@ -14,6 +14,7 @@ EventHandler::EventHandler(const char* arg_name)
 	error_handler = false;
 	enabled = true;
 	generate_always = false;
+	dead = false;
 	}
 
 EventHandler::~EventHandler()
@@ -24,7 +25,7 @@ EventHandler::~EventHandler()
 
 EventHandler::operator bool() const
 	{
-	return enabled && ((local && local->HasBodies())
+	return enabled && ((local && local->HasBodies() && ! dead)
 			   || receivers.length()
 			   || generate_always);
 	}
@@ -43,6 +43,12 @@ public:
 
 	void SetEnable(bool arg_enable)	{ enabled = arg_enable; }
 
+	// Flags the local handler as having no effect (because all of its
+	// bodies are empty), so that the event is generated only if there
+	// are other consumers.
+	void SetDead(bool arg_dead)	{ dead = arg_dead; }
+	bool Dead()	{ return dead; }
+
 	// Flags the event as interesting even if there is no body defined. In
 	// particular, this will then still pass the event on to plugins.
 	void SetGenerateAlways()	{ generate_always = true; }
@@ -61,6 +67,7 @@ private:
 	FuncType* type;
 	bool used;		// this handler is indeed used somewhere
 	bool enabled;
+	bool dead;		// the local handler doesn't do anything
 	bool error_handler;	// this handler reports error messages.
 	bool generate_always;
 
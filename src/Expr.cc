@@ -853,8 +853,14 @@ Val* BinaryExpr::Fold(Val* v1, Val* v2) const
 		return new IntervalVal(d3, 1.0);
 	else if ( ret_type->InternalType() == TYPE_INTERNAL_DOUBLE )
 		return new Val(d3, ret_type->Tag());
+	else if ( ret_type->Tag() == TYPE_COUNT )
+		return val_mgr->GetCount(u3);
 	else if ( ret_type->InternalType() == TYPE_INTERNAL_UNSIGNED )
 		return new Val(u3, ret_type->Tag());
+	else if ( ret_type->Tag() == TYPE_BOOL )
+		return val_mgr->GetBool(i3);
+	else if ( ret_type->Tag() == TYPE_INT )
+		return val_mgr->GetInt(i3);
 	else
 		return new Val(i3, ret_type->Tag());
 	}
@@ -890,7 +896,7 @@ Val* BinaryExpr::StringFold(Val* v1, Val* v2) const
 		BadTag("BinaryExpr::StringFold", expr_name(tag));
 	}
 
-	return new Val(result, TYPE_BOOL);
+	return val_mgr->GetBool(result);
 	}
 
 Val* BinaryExpr::AddrFold(Val* v1, Val* v2) const
@@ -924,7 +930,7 @@ Val* BinaryExpr::AddrFold(Val* v1, Val* v2) const
 		BadTag("BinaryExpr::AddrFold", expr_name(tag));
 	}
 
-	return new Val(result, TYPE_BOOL);
+	return val_mgr->GetBool(result);
 	}
 
 Val* BinaryExpr::SubNetFold(Val* v1, Val* v2) const
@@ -937,7 +943,7 @@ Val* BinaryExpr::SubNetFold(Val* v1, Val* v2) const
 	if ( tag == EXPR_NE )
 		result = ! result;
 
-	return new Val(result, TYPE_BOOL);
+	return val_mgr->GetBool(result);
 	}
 
 void BinaryExpr::SwapOps()
@@ -1077,7 +1083,12 @@ Val* IncrExpr::DoSingleEval(Frame* f, Val* v) const
 	 if ( IsVector(ret_type->Tag()) )
 		 ret_type = Type()->YieldType();
 
-	 return new Val(k, ret_type->Tag());
+	 if ( ret_type->Tag() == TYPE_COUNT )
+		 return val_mgr->GetCount(k);
+	 else if ( ret_type->Tag() == TYPE_INT )
+		 return val_mgr->GetInt(k);
+	 else
+		 return new Val(k, ret_type->Tag());
 	 }
 
 
@@ -1164,7 +1175,7 @@ Expr* NotExpr::DoSimplify()
 
 Val* NotExpr::Fold(Val* v) const
 	{
-	return new Val(! v->InternalInt(), type->Tag());
+	return val_mgr->GetBool(! v->InternalInt());
 	}
 
 IMPLEMENT_SERIAL(NotExpr, SER_NOT_EXPR);
@@ -1301,7 +1312,7 @@ Val* NegExpr::Fold(Val* v) const
 	else if ( v->Type()->Tag() == TYPE_INTERVAL )
 		return new IntervalVal(- v->InternalDouble(), 1.0);
 	else
-		return new Val(- v->CoerceToInt(), TYPE_INT);
+		return val_mgr->GetInt(- v->CoerceToInt());
 	}
 
 
@@ -1999,7 +2010,7 @@ Val* BoolExpr::Eval(Frame* f) const
 				(! op1->IsZero() && ! op2->IsZero()) :
 				(! op1->IsZero() || ! op2->IsZero());
 
-			result->Assign(i, new Val(local_result, TYPE_BOOL));
+			result->Assign(i, val_mgr->GetBool(local_result));
 			}
 		else
 			result->Assign(i, 0);
@@ -2151,9 +2162,9 @@ Val* EqExpr::Fold(Val* v1, Val* v2) const
 		RE_Matcher* re = v1->AsPattern();
 		const BroString* s = v2->AsString();
 		if ( tag == EXPR_EQ )
-			return new Val(re->MatchExactly(s), TYPE_BOOL);
+			return val_mgr->GetBool(re->MatchExactly(s));
 		else
-			return new Val(! re->MatchExactly(s), TYPE_BOOL);
+			return val_mgr->GetBool(! re->MatchExactly(s));
 		}
 
 	else
@@ -3350,10 +3361,10 @@ Val* HasFieldExpr::Fold(Val* v) const
 	rec_to_look_at = v->AsRecordVal();
 
 	if ( ! rec_to_look_at )
-		return new Val(0, TYPE_BOOL);
+		return val_mgr->GetBool(0);
 
 	RecordVal* r = rec_to_look_at->Ref()->AsRecordVal();
-	Val* ret = new Val(r->Lookup(field) != 0, TYPE_BOOL);
+	Val* ret = val_mgr->GetBool(r->Lookup(field) != 0);
 	Unref(r);
 
 	return ret;
@@ -4029,10 +4040,10 @@ Val* ArithCoerceExpr::FoldSingleVal(Val* v, InternalTypeTag t) const
 		return new Val(v->CoerceToDouble(), TYPE_DOUBLE);
 
 	case TYPE_INTERNAL_INT:
-		return new Val(v->CoerceToInt(), TYPE_INT);
+		return val_mgr->GetInt(v->CoerceToInt());
 
 	case TYPE_INTERNAL_UNSIGNED:
-		return new Val(v->CoerceToUnsigned(), TYPE_COUNT);
+		return val_mgr->GetCount(v->CoerceToUnsigned());
 
 	default:
 		Internal("bad type in CoerceExpr::Fold");
@@ -4686,7 +4697,7 @@ Val* InExpr::Fold(Val* v1, Val* v2) const
 		{
 		RE_Matcher* re = v1->AsPattern();
 		const BroString* s = v2->AsString();
-		return new Val(re->MatchAnywhere(s) != 0, TYPE_BOOL);
+		return val_mgr->GetBool(re->MatchAnywhere(s) != 0);
 		}
 
 	if ( v2->Type()->Tag() == TYPE_STRING )
@@ -4696,12 +4707,12 @@ Val* InExpr::Fold(Val* v1, Val* v2) const
 
 		// Could do better here - either roll our own, to deal with
 		// NULs, and/or Boyer-Moore if done repeatedly.
-		return new Val(strstr(s2->CheckString(), s1->CheckString()) != 0, TYPE_BOOL);
+		return val_mgr->GetBool(strstr(s2->CheckString(), s1->CheckString()) != 0);
 		}
 
 	if ( v1->Type()->Tag() == TYPE_ADDR &&
 	     v2->Type()->Tag() == TYPE_SUBNET )
-		return new Val(v2->AsSubNetVal()->Contains(v1->AsAddr()), TYPE_BOOL);
+		return val_mgr->GetBool(v2->AsSubNetVal()->Contains(v1->AsAddr()));
 
 	Val* res;
 
@@ -4711,9 +4722,9 @@ Val* InExpr::Fold(Val* v1, Val* v2) const
 		res = v2->AsTableVal()->Lookup(v1, false);
 
 	if ( res )
-		return new Val(1, TYPE_BOOL);
+		return val_mgr->GetBool(1);
 	else
-		return new Val(0, TYPE_BOOL);
+		return val_mgr->GetBool(0);
 	}
 
 IMPLEMENT_SERIAL(InExpr, SER_IN_EXPR);
@@ -660,6 +660,9 @@ public:
 	Val* InitVal(const BroType* t, Val* aggr) const;
 	int IsPure() const;
 
+	int IsInit() const	{ return is_init; }
+	Val* AssignVal() const	{ return val; }
+
 protected:
 	friend class Expr;
 	AssignExpr()	{ }
@@ -300,12 +300,7 @@ void FragReassembler::BlockInserted(DataBlock* /* start_block */)
 
 void FragReassembler::Expire(double t)
 	{
-	while ( blocks )
-		{
-		DataBlock* b = blocks->next;
-		delete blocks;
-		blocks = b;
-		}
+	ClearBlocks();
 
 	expire_timer->ClearReassembler();
 	expire_timer = 0;	// timer manager will delete it
@@ -9,10 +9,42 @@
 
 vector<Frame*> g_frame_stack;
 
+IMPLEMENT_SLAB_ALLOCATION(Frame, "Frame")
+
+Val** Frame::free_slots[MAX_POOLED_SIZE + 1];
+Frame::PoolStats Frame::pool_stats;
+
+Val** Frame::AllocSlots(int size)
+	{
+	if ( size > 0 && size <= MAX_POOLED_SIZE && free_slots[size] )
+		{
+		// Free arrays are chained through their first element.
+		Val** slots = free_slots[size];
+		free_slots[size] = (Val**) slots[0];
+		++pool_stats.hits;
+		return slots;
+		}
+
+	++pool_stats.misses;
+	return new Val*[size];
+	}
+
+void Frame::FreeSlots(Val** slots, int size)
+	{
+	if ( size > 0 && size <= MAX_POOLED_SIZE )
+		{
+		slots[0] = (Val*) free_slots[size];
+		free_slots[size] = slots;
+		return;
+		}
+
+	delete [] slots;
+	}
+
 Frame::Frame(int arg_size, const BroFunc* func, const val_list* fn_args)
 	{
 	size = arg_size;
-	frame = new Val*[size];
+	frame = AllocSlots(size);
 	function = func;
 	func_args = fn_args;
 
@@ -38,7 +70,7 @@ void Frame::Release()
 	for ( int i = 0; i < size; ++i )
 		Unref(frame[i]);
 
-	delete [] frame;
+	FreeSlots(frame, size);
 	}
 
 void Frame::Describe(ODesc* d) const
@@ -17,6 +17,16 @@ public:
 	Frame(int size, const BroFunc* func, const val_list *fn_args);
 	~Frame();
 
+	DECLARE_SLAB_ALLOCATION()
+
+	// Statistics about recycling the arrays holding frames' values.
+	struct PoolStats {
+		uint64 hits;	// arrays taken from the pool
+		uint64 misses;	// arrays allocated
+	};
+
+	static void GetPoolStats(PoolStats* s)	{ *s = pool_stats; }
+
 	Val* NthElement(int n)		{ return frame[n]; }
 	void SetElement(int n, Val* v)
 		{
@@ -66,6 +76,17 @@ public:
 protected:
 	void Clear();
 
+	// Frames of up to this size recycle their value arrays through
+	// per-size free lists, so that calling a function doesn't need to
+	// allocate in the steady state.
+	static const int MAX_POOLED_SIZE = 64;
+
+	static Val** AllocSlots(int size);
+	static void FreeSlots(Val** slots, int size);
+
+	static Val** free_slots[MAX_POOLED_SIZE + 1];
+	static PoolStats pool_stats;
+
 	Val** frame;
 	int size;
 
@@ -36,6 +36,7 @@
 #include "NetVar.h"
 #include "File.h"
 #include "Func.h"
+#include "ByteCode.h"
 #include "Frame.h"
 #include "Var.h"
 #include "analyzer/protocol/login/Login.h"
@@ -160,6 +161,8 @@ bool Func::DoUnserialize(UnserialInfo* info)
 		if ( ! UNSERIALIZE(&b.priority) )
 			return false;
 
+		b.code = use_bytecode ? ByteCode::Compile(b.stmts) : 0;
+
 		bodies.push_back(b);
 		}
 
@@ -300,6 +303,7 @@ BroFunc::BroFunc(ID* arg_id, Stmt* arg_body, id_list* aggr_inits,
 		{
 		Body b;
 		b.stmts = AddInits(arg_body, aggr_inits);
+		b.code = use_bytecode ? ByteCode::Compile(b.stmts) : 0;
 		b.priority = priority;
 		bodies.push_back(b);
 		}
@@ -308,7 +312,10 @@ BroFunc::BroFunc(ID* arg_id, Stmt* arg_body, id_list* aggr_inits,
 BroFunc::~BroFunc()
 	{
 	for ( unsigned int i = 0; i < bodies.size(); ++i )
+		{
 		Unref(bodies[i].stmts);
+		delete bodies[i].code;
+		}
 	}
 
 int BroFunc::IsPure() const
@@ -343,7 +350,7 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 		loop_over_list(*args, i)
 			Unref((*args)[i]);
 
-		return Flavor() == FUNC_FLAVOR_HOOK ? new Val(true, TYPE_BOOL) : 0;
+		return Flavor() == FUNC_FLAVOR_HOOK ? val_mgr->GetBool(true) : 0;
 		}
 
 	Frame* f = new Frame(frame_size, this, args);
@@ -383,7 +390,10 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 
 		try
 			{
-			result = bodies[i].stmts->Exec(f, flow);
+			if ( bodies[i].code )
+				result = bodies[i].code->Exec(f, flow);
+			else
+				result = bodies[i].stmts->Exec(f, flow);
 			}
 
 		catch ( InterpreterException& e )
@@ -410,7 +420,7 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 			if ( flow == FLOW_BREAK )
 				{
 				// Short-circuit execution of remaining hook handler bodies.
-				result = new Val(false, TYPE_BOOL);
+				result = val_mgr->GetBool(false);
 				break;
 				}
 			}
@@ -419,7 +429,7 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 	if ( Flavor() == FUNC_FLAVOR_HOOK )
 		{
 		if ( ! result )
-			result = new Val(true, TYPE_BOOL);
+			result = val_mgr->GetBool(true);
 		}
 
 	// Warn if the function returns something, but we returned from
@@ -458,12 +468,17 @@ void BroFunc::AddBody(Stmt* new_body, id_list* new_inits, int new_frame_size,
 		// For functions, we replace the old body with the new one.
 		assert(bodies.size() <= 1);
 		for ( unsigned int i = 0; i < bodies.size(); ++i )
+			{
 			Unref(bodies[i].stmts);
+			delete bodies[i].code;
+			}
+
 		bodies.clear();
 		}
 
 	Body b;
 	b.stmts = new_body;
+	b.code = use_bytecode ? ByteCode::Compile(new_body) : 0;
 	b.priority = priority;
 
 	bodies.push_back(b);
@@ -621,6 +636,11 @@ void init_builtin_funcs()
 	bro_resources = internal_type("bro_resources")->AsRecordType();
 	net_stats = internal_type("NetStats")->AsRecordType();
 	matcher_stats = internal_type("matcher_stats")->AsRecordType();
+	rule_stats = internal_type("rule_stats")->AsRecordType();
+	rule_stats_table = internal_type("rule_stats_table")->AsTableType();
+	slab_stats = internal_type("slab_stats")->AsRecordType();
+	slab_stats_table = internal_type("slab_stats_table")->AsTableType();
+	frame_pool_stats = internal_type("frame_pool_stats")->AsRecordType();
 	var_sizes = internal_type("var_sizes")->AsTableType();
 	gap_info = internal_type("gap_info")->AsRecordType();
 
@@ -14,6 +14,7 @@ class Stmt;
 class Frame;
 class ID;
 class CallExpr;
+class ByteCode;
 
 class Func : public BroObj {
 public:
@@ -29,6 +30,7 @@ public:
 
 	struct Body {
 		Stmt* stmts;
+		ByteCode* code;	// compiled stmts, if any
 		int priority;
 		bool operator<(const Body& other) const
 			{ return priority > other.priority; } // reverse sort
@@ -22,6 +22,8 @@
 #include "H3.h"
 const H3<hash_t, UHASH_KEY_SIZE>* h3;
 
+IMPLEMENT_SLAB_ALLOCATION(HashKey, "HashKey")
+
 void init_hash_function()
 	{
 	// Make sure we have already called init_random_seed().
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 
 #include "BroString.h"
+#include "SlabPool.h"
 
 #define UHASH_KEY_SIZE 36
 
@@ -34,6 +35,8 @@ public:
 			delete [] (char *) key;
 		}
 
+	DECLARE_SLAB_ALLOCATION()
+
 	// Create a HashKey given all of its components.  "key" is assumed
 	// to be dynamically allocated and to now belong to this HashKey
 	// (to delete upon destruct'ing).  If "copy_key" is true, it's
@@ -8,6 +8,93 @@
 
 static const int DEFAULT_CHUNK_SIZE = 10;
 
+// Lists get created and deleted at a high rate -- e.g., every event comes
+// with a new argument list -- and most of them never grow beyond their
+// initial chunk. We recycle the list objects and their initial entry
+// arrays through free lists, chained through their first word. Threads
+// use lists, too, so each thread has its own free lists. We keep only a
+// limited number of free objects around.
+static const int MAX_FREE = 1024;
+
+struct ListPool {
+	void* lists;
+	ent* entries;
+	int num_lists;
+	int num_entries;
+	BaseList::PoolStats stats;
+};
+
+static __thread ListPool list_pool;
+
+static ent* alloc_entries()
+	{
+	ListPool& p = list_pool;
+
+	if ( p.entries )
+		{
+		ent* e = p.entries;
+		p.entries = (ent*) e[0];
+		--p.num_entries;
+		++p.stats.hits;
+		return e;
+		}
+
+	++p.stats.misses;
+	return (ent*) safe_malloc(DEFAULT_CHUNK_SIZE * sizeof(ent));
+	}
+
+static void free_entries(ent* e, int max_entries)
+	{
+	ListPool& p = list_pool;
+
+	// Anything at least as large as the initial chunk will do.
+	if ( max_entries >= DEFAULT_CHUNK_SIZE && p.num_entries < MAX_FREE )
+		{
+		e[0] = (ent) p.entries;
+		p.entries = e;
+		++p.num_entries;
+		return;
+		}
+
+	free(e);
+	}
+
+void* BaseList::operator new(size_t n)
+	{
+	ListPool& p = list_pool;
+
+	if ( n != sizeof(BaseList) || ! p.lists )
+		return ::operator new(n);
+
+	void* l = p.lists;
+	p.lists = *(void**) l;
+	--p.num_lists;
+	return l;
+	}
+
+void BaseList::operator delete(void* l, size_t n)
+	{
+	ListPool& p = list_pool;
+
+	if ( ! l )
+		return;
+
+	if ( n != sizeof(BaseList) || p.num_lists >= MAX_FREE )
+		{
+		::operator delete(l);
+		return;
+		}
+
+	*(void**) l = p.lists;
+	p.lists = l;
+	++p.num_lists;
+	}
+
+void BaseList::GetPoolStats(PoolStats* s)
+	{
+	*s = list_pool.stats;
+	}
+
 BaseList::BaseList(int size)
 	{
 	chunk_size = DEFAULT_CHUNK_SIZE;
@@ -23,8 +110,12 @@ BaseList::BaseList(int size)
 			chunk_size = size;
 
 		num_entries = 0;
-		entry = (ent *) safe_malloc(chunk_size * sizeof(ent));
 		max_entries = chunk_size;
+
+		if ( chunk_size == DEFAULT_CHUNK_SIZE )
+			entry = alloc_entries();
+		else
+			entry = (ent *) safe_malloc(chunk_size * sizeof(ent));
 		}
 	}
 
@@ -163,7 +254,7 @@ void BaseList::clear()
 	{
 	if ( entry )
 		{
-		free(entry);
+		free_entries(entry, max_entries);
 		entry = 0;
 		}
 
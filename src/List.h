@@ -30,6 +30,19 @@ class BaseList {
 public:
 	~BaseList()		{ clear(); }
 
+	// Lists get recycled; see List.cc.
+	static void* operator new(size_t n);
+	static void operator delete(void* p, size_t n);
+
+	// Statistics about recycling the entry arrays of lists.
+	struct PoolStats {
+		uint64 hits;	// arrays taken from the pool
+		uint64 misses;	// arrays allocated
+	};
+
+	// Returns the statistics of the calling thread.
+	static void GetPoolStats(PoolStats* s);
+
 	void clear();		// remove all entries
 	int length() const	{ return num_entries; }
 	int chunk() const	{ return chunk_size; }
@@ -0,0 +1,614 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "config.h"
+
+#include <algorithm>
+
+#include "LiteralMatcher.h"
+#include "RE.h"
+
+Literal_Matcher::Literal_Matcher()
+	{
+	trie.push_back(TrieNode());
+	num_literals = 0;
+	num_states = 0;
+	num_ecs = 0;
+	xtions = 0;
+	accepting = 0;
+
+	for ( int i = 0; i < 256; ++i )
+		ecs[i] = 0;
+	}
+
+Literal_Matcher::~Literal_Matcher()
+	{
+	delete [] xtions;
+	delete [] accepting;
+	}
+
+void Literal_Matcher::Add(const std::string& literal, int id)
+	{
+	int n = 0;
+	int len = min(int(literal.size()), MAX_PREFILTER_LITERAL_LEN);
+
+	for ( int i = 0; i < len; ++i )
+		{
+		u_char c = literal[i];
+		std::map<u_char, int>::const_iterator j = trie[n].next.find(c);
+
+		if ( j != trie[n].next.end() )
+			n = j->second;
+		else
+			{
+			int m = trie.size();
+			trie.push_back(TrieNode());
+			trie[n].next[c] = m;
+			n = m;
+			}
+		}
+
+	trie[n].ids.push_back(id);
+	++num_literals;
+	}
+
+void Literal_Matcher::Compile()
+	{
+	// Each byte occurring in a literal gets its own class.
+	u_char reps[256];
+	num_ecs = 1;
+
+	for ( size_t n = 0; n < trie.size(); ++n )
+		for ( std::map<u_char, int>::const_iterator i =
+			trie[n].next.begin(); i != trie[n].next.end(); ++i )
+			if ( ! ecs[i->first] )
+				{
+				reps[num_ecs] = i->first;
+				ecs[i->first] = num_ecs++;
+				}
+
+	num_states = trie.size();
+	xtions = new int32[num_states * num_ecs];
+	accepting = new bool[num_states];
+	outputs.resize(num_states);
+
+	std::vector<int> fail(num_states, 0);
+	std::vector<int> queue;
+
+	// Breadth-first, so that a state's failure state is always done
+	// before the state itself.
+	queue.push_back(0);
+
+	for ( size_t q = 0; q < queue.size(); ++q )
+		{
+		int n = queue[q];
+		int32* x = &xtions[n * num_ecs];
+		const int32* fx = &xtions[fail[n] * num_ecs];
+
+		outputs[n] = trie[n].ids;
+
+		if ( n )
+			outputs[n].insert(outputs[n].end(),
+					  outputs[fail[n]].begin(),
+					  outputs[fail[n]].end());
+
+		std::sort(outputs[n].begin(), outputs[n].end());
+		outputs[n].erase(std::unique(outputs[n].begin(),
+						outputs[n].end()),
+				 outputs[n].end());
+		accepting[n] = ! outputs[n].empty();
+
+		x[0] = n ? fx[0] : 0;
+
+		for ( int ec = 1; ec < num_ecs; ++ec )
+			{
+			std::map<u_char, int>::const_iterator i =
+				trie[n].next.find(reps[ec]);
+
+			if ( i == trie[n].next.end() )
+				{
+				x[ec] = n ? fx[ec] : 0;
+				continue;
+				}
+
+			fail[i->second] = n ? fx[ec] : 0;
+			x[ec] = i->second;
+			queue.push_back(i->second);
+			}
+		}
+
+	// Not needed anymore.
+	std::vector<TrieNode>().swap(trie);
+	}
+
+unsigned int Literal_Matcher::MemoryAllocation() const
+	{
+	unsigned int size = padded_sizeof(*this) +
+		num_states * (num_ecs * sizeof(int32) + sizeof(bool));
+
+	for ( size_t i = 0; i < outputs.size(); ++i )
+		size += outputs[i].capacity() * sizeof(int);
+
+	return size;
+	}
+
+int Literal_Matcher::Scan(int state, const u_char* data, int len,
+				std::vector<int>* hits) const
+	{
+	const u_char* end = data + len;
+
+	while ( data < end )
+		{
+		state = xtions[state * num_ecs + ecs[*data++]];
+
+		if ( accepting[state] )
+			hits->insert(hits->end(), outputs[state].begin(),
+					outputs[state].end());
+		}
+
+	return state;
+	}
+
+// Literal extraction follows the grammar in re-parse.y and the tokens in
+// re-scan.l. Anything we don't recognize makes us give up, which is always
+// safe: the pattern then just doesn't get prefiltered.
+
+namespace {
+
+struct LiteralInfo {
+	LiteralInfo()	{ exact = false; }
+
+	// True if the expression matches exactly str and nothing else.
+	bool exact;
+	std::string str;
+
+	// If not exact, each match contains at least one of these (or,
+	// if empty, we don't know anything).
+	std::vector<std::string> lits;
+};
+
+class LiteralExtractor {
+public:
+	LiteralExtractor(const char* pattern)
+		{ p = pattern; error = false; }
+
+	bool Extract(std::vector<std::string>* literals);
+
+protected:
+	LiteralInfo Alternation();
+	LiteralInfo Series();
+	LiteralInfo Singleton();
+	LiteralInfo Atom();
+
+	bool Escape(int* c);
+	bool Number(int* n);
+	void SkipCCL();
+
+	static LiteralInfo Exact(const std::string& s);
+	static std::vector<std::string> Lits(const LiteralInfo& i);
+	static int Score(const std::vector<std::string>& lits);
+	static void Consider(std::vector<std::string>* best,
+				const std::vector<std::string>& lits);
+
+	bool AtEnd() const	{ return ! *p || *p == '\n'; }
+
+	const char* p;
+	bool error;
+};
+
+LiteralInfo LiteralExtractor::Exact(const std::string& s)
+	{
+	LiteralInfo i;
+
+	if ( s.size() <= MAX_PREFILTER_LITERAL_LEN )
+		{
+		i.exact = true;
+		i.str = s;
+		}
+	else
+		i.lits.push_back(s.substr(0, MAX_PREFILTER_LITERAL_LEN));
+
+	return i;
+	}
+
+std::vector<std::string> LiteralExtractor::Lits(const LiteralInfo& i)
+	{
+	if ( ! i.exact )
+		return i.lits;
+
+	std::vector<std::string> lits;
+
+	if ( ! i.str.empty() )
+		lits.push_back(i.str);
+
+	return lits;
+	}
+
+int LiteralExtractor::Score(const std::vector<std::string>& lits)
+	{
+	// The shortest literal determines how often we'll see any of them.
+	int score = lits.empty() ? 0 : MAX_PREFILTER_LITERAL_LEN;
+
+	for ( size_t i = 0; i < lits.size(); ++i )
+		score = min(score, int(lits[i].size()));
+
+	return score;
+	}
+
+void LiteralExtractor::Consider(std::vector<std::string>* best,
+				const std::vector<std::string>& lits)
+	{
+	int score = Score(lits);
+	int best_score = Score(*best);
+
+	if ( score > best_score ||
+	     (score && score == best_score && lits.size() < best->size()) )
+		*best = lits;
+	}
+
+bool LiteralExtractor::Extract(std::vector<std::string>* literals)
+	{
+	LiteralInfo i = Alternation();
+
+	if ( error || ! AtEnd() )
+		return false;
+
+	*literals = Lits(i);
+	return ! literals->empty();
+	}
+
+LiteralInfo LiteralExtractor::Alternation()
+	{
+	LiteralInfo i = Series();
+
+	while ( ! error && *p == '|' )
+		{
+		++p;
+		LiteralInfo alt = Series();
+
+		std::vector<std::string> lits = Lits(i);
+		std::vector<std::string> alt_lits = Lits(alt);
+
+		i = LiteralInfo();
+
+		// Each alternative needs to contribute a literal.
+		if ( ! lits.empty() && ! alt_lits.empty() )
+			{
+			i.lits = lits;
+			i.lits.insert(i.lits.end(), alt_lits.begin(),
+					alt_lits.end());
+			}
+		}
+
+	return i;
+	}
+
+LiteralInfo LiteralExtractor::Series()
+	{
+	// We track the current run of adjacent exact singletons, and keep
+	// the best of all runs and other singletons as the candidate.
+	std::string run;
+	std::string all;
+	bool all_exact = true;
+	std::vector<std::string> best;
+
+	while ( ! error && ! AtEnd() && *p != '|' && *p != ')' )
+		{
+		LiteralInfo i = Singleton();
+
+		if ( i.exact )
+			{
+			run += i.str;
+			all += i.str;
+
+			if ( run.size() >= MAX_PREFILTER_LITERAL_LEN )
+				{
+				Consider(&best, Lits(Exact(run)));
+				run.clear();
+				}
+
+			continue;
+			}
+
+		all_exact = false;
+
+		Consider(&best, Lits(Exact(run)));
+		run.clear();
+
+		Consider(&best, i.lits);
+		}
+
+	if ( all_exact )
+		return Exact(all);
+
+	Consider(&best, Lits(Exact(run)));
+
+	LiteralInfo i;
+	i.lits = best;
+	return i;
+	}
+
+LiteralInfo LiteralExtractor::Singleton()
+	{
+	LiteralInfo i = Atom();
+
+	while ( ! error )
+		{
+		if ( *p == '*' || *p == '?' )
+			{
+			++p;
+			i = LiteralInfo();
+			}
+
+		else if ( *p == '+' )
+			{
+			++p;
+			LiteralInfo rep;
+			rep.lits = Lits(i);
+			i = rep;
+			}
+
+		else if ( *p == '{' && isdigit((u_char) p[1]) )
+			{
+			++p;
+
+			int lo, hi = -1;
+			bool bounded = true;
+
+			if ( ! Number(&lo) )
+				break;
+
+			if ( *p == ',' )
+				{
+				++p;
+
+				if ( isdigit((u_char) *p) )
+					{
+					if ( ! Number(&hi) )
+						break;
+					}
+				else
+					bounded = false;
+				}
+			else
+				hi = lo;
+
+			if ( *p != '}' || (bounded && hi < lo) )
+				{
+				error = true;
+				break;
+				}
+
+			++p;
+
+			if ( lo == 0 )
+				i = LiteralInfo();
+
+			else if ( i.exact && bounded && hi == lo )
+				{
+				std::string s;
+
+				for ( int j = 0; j < lo &&
+				      s.size() <= MAX_PREFILTER_LITERAL_LEN; ++j )
+					s += i.str;
+
+				i = Exact(s);
+				}
+
+			else
+				{
+				LiteralInfo rep;
+				rep.lits = Lits(i);
+				i = rep;
+				}
+			}
+
+		else
+			break;
+		}
+
+	return i;
+	}
+
+LiteralInfo LiteralExtractor::Atom()
+	{
+	switch ( *p ) {
+	case '(':
+		{
+		++p;
+		LiteralInfo i = Alternation();
+
+		if ( *p != ')' )
+			error = true;
+		else
+			++p;
+
+		return i;
+		}
+
+	case '"':
+		{
+		std::string s;
+
+		for ( ++p; ! error && *p != '"'; )
+			{
+			int c;
+
+			if ( AtEnd() )
+				error = true;
+
+			else if ( *p == '\\' )
+				{
+				if ( Escape(&c) )
+					s += char(c);
+				}
+
+			else
+				s += *p++;
+			}
+
+		if ( ! error )
+			++p;
+
+		return Exact(s);
+		}
+
+	case '[':
+		SkipCCL();
+		return LiteralInfo();
+
+	case '.':
+		++p;
+		return LiteralInfo();
+
+	case '^':
+	case '$':
+		// Zero-width, so they don't break up a run.
+		++p;
+		return Exact("");
+
+	case '{':
+		{
+		// A named definition; we don't look these up.
+		const char* close = strchr(p, '}');
+
+		if ( ! close || ! (isalpha((u_char) p[1]) || p[1] == '_') )
+			error = true;
+		else
+			p = close + 1;
+
+		return LiteralInfo();
+		}
+
+	case '\\':
+		{
+		int c;
+
+		if ( Escape(&c) )
+			return Exact(std::string(1, char(c)));
+
+		return LiteralInfo();
+		}
+
+	case '*':
+	case '+':
+	case '?':
+	case '}':
+		error = true;
+		return LiteralInfo();
+
+	default:
+		return Exact(std::string(1, *p++));
+	}
+	}
+
+bool LiteralExtractor::Escape(int* c)
+	{
+	// Mirrors ESCSEQ in re-scan.l.
+	const char* s = ++p;
+
+	if ( *s >= '0' && *s <= '7' )
+		{
+		*c = expand_escape(s);
+
+		while ( *p >= '0' && *p <= '7' )
+			++p;
+
+		return true;
+		}
+
+	if ( *s == 'x' || *s == 'X' )
+		{
+		// The scanner is caseless, so it takes \X41 as an escape
+		// but expand_escape() doesn't.
+		if ( *s == 'X' ||
+		     ! isxdigit((u_char) s[1]) || ! isxdigit((u_char) s[2]) )
+			{
+			error = true;
+			return false;
+			}
+
+		*c = expand_escape(s);
+		p += 3;
+		return true;
+		}
+
+	if ( AtEnd() )
+		{
+		error = true;
+		return false;
+		}
+
+	*c = expand_escape(s);
+	++p;
+	return true;
+	}
+
+bool LiteralExtractor::Number(int* n)
+	{
+	*n = 0;
+
+	while ( isdigit((u_char) *p) )
+		{
+		*n = *n * 10 + (*p++ - '0');
+
+		if ( *n > 10000 )
+			{
+			error = true;
+			return false;
+			}
+		}
+
+	return true;
+	}
+
+void LiteralExtractor::SkipCCL()
+	{
+	// Mirrors SC_FIRST_CCL and SC_CCL in re-scan.l.
+	++p;
+
+	if ( *p == '^' )
+		++p;
+
+	bool first = true;
+
+	while ( ! error && (first || *p != ']') )
+		{
+		int c;
+
+		if ( AtEnd() )
+			error = true;
+
+		else if ( *p == '[' && p[1] == ':' )
+			{
+			const char* close = strstr(p, ":]");
+
+			if ( ! close )
+				error = true;
+			else
+				p = close + 2;
+			}
+
+		else if ( *p == '\\' )
+			Escape(&c);
+
+		else
+			++p;
+
+		first = false;
+		}
+
+	if ( ! error )
+		++p;
+	}
+
+}
+
+bool Literal_Matcher::RequiredLiterals(const char* pattern,
+					std::vector<std::string>* literals)
+	{
+	if ( case_insensitive )
+		return false;
+
+	LiteralExtractor e(pattern);
+	return e.Extract(literals);
+	}
@@ -0,0 +1,74 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// A multi-literal matcher (Aho-Corasick) used as a prefilter for signature
+// matching. Each literal carries an ID, and scanning reports the IDs of all
+// literals ending in the scanned input. The scan state carries over from
+// one chunk of input to the next, so literals spanning chunks are found.
+
+#ifndef literalmatcher_h
+#define literalmatcher_h
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+// Literals longer than this get truncated: their prefixes are just as
+// required, and keeping them short bounds the size of the automaton.
+#define MAX_PREFILTER_LITERAL_LEN 8
+
+class Literal_Matcher {
+public:
+	Literal_Matcher();
+	~Literal_Matcher();
+
+	// Adds a literal whose occurrence reports the given ID.
+	void Add(const std::string& literal, int id);
+
+	// Builds the automaton. Must be called once after all literals
+	// have been added and before scanning.
+	void Compile();
+
+	int NumLiterals() const	{ return num_literals; }
+	int NumStates() const	{ return num_states; }
+	unsigned int MemoryAllocation() const;
+
+	// The state to start scanning a new stream from.
+	int StartState() const	{ return 0; }
+
+	// Scans the given data, starting from the given state, and appends
+	// the IDs of literals ending in it to hits (possibly more than once).
+	// Returns the new state.
+	int Scan(int state, const u_char* data, int len,
+			std::vector<int>* hits) const;
+
+	// Extracts literals from a regular expression such that each match
+	// of the expression contains at least one of them. Returns false if
+	// there are no such literals, or if we don't understand the
+	// expression well enough to tell.
+	static bool RequiredLiterals(const char* pattern,
+					std::vector<std::string>* literals);
+
+protected:
+	// Used while adding literals.
+	struct TrieNode {
+		std::map<u_char, int> next;
+		std::vector<int> ids;
+	};
+
+	std::vector<TrieNode> trie;
+
+	int num_literals;
+	int num_states;
+
+	// Bytes not occurring in any literal share class 0.
+	int ecs[256];
+	int num_ecs;
+
+	int32* xtions;	// num_states x num_ecs
+	bool* accepting;
+	std::vector<std::vector<int> > outputs;
+};
+
+#endif
@@ -0,0 +1,628 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define MULTIHASH_X86
+#endif
+
+#include "MultiHash.h"
+
+// The lanes are GCC/clang vector extensions, which compile to SSE2 with
+// 4 lanes per vector, or to AVX2 with 8 lanes in the functions targeting
+// that.  On other architectures, the compiler picks whatever the CPU has.
+typedef uint32_t vec4 __attribute__((vector_size(16)));
+
+#ifdef MULTIHASH_X86
+typedef uint32_t vec8 __attribute__((vector_size(32)));
+#endif
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static inline uint32_t load_le32(const u_char* p)
+	{
+	return uint32_t(p[0]) | (uint32_t(p[1]) << 8) |
+	       (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+	}
+
+static inline uint32_t load_be32(const u_char* p)
+	{
+	return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+	       (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+	}
+
+// Lanes without a stream hash this.
+static const u_char zero_block[64] = { 0 };
+
+// Each algorithm provides access to its context's chaining state, a
+// single-block fallback, and the block function across lanes.
+
+struct MD5Alg {
+	typedef MD5_CTX Ctx;
+	static const int STATE = 4;
+
+	static uint32_t Get(const Ctx* c, int i)
+		{
+		switch ( i ) {
+		case 0: return c->A;
+		case 1: return c->B;
+		case 2: return c->C;
+		default: return c->D;
+		}
+		}
+
+	static void Set(Ctx* c, int i, uint32_t v)
+		{
+		switch ( i ) {
+		case 0: c->A = v; break;
+		case 1: c->B = v; break;
+		case 2: c->C = v; break;
+		default: c->D = v; break;
+		}
+		}
+
+	static void Transform(Ctx* c, const u_char* b)	{ MD5_Transform(c, b); }
+	static void Update(Ctx* c, const u_char* d, uint64 n)	{ MD5_Update(c, d, n); }
+
+	template<typename V, int N>
+	static inline __attribute__((always_inline))
+	void Blocks(V* st, const u_char* const* blocks)
+		{
+		V x[16];
+
+		for ( int j = 0; j < 16; ++j )
+			for ( int l = 0; l < N; ++l )
+				x[j][l] = load_le32(blocks[l] + 4 * j);
+
+		V a = st[0], b = st[1], c = st[2], d = st[3];
+
+#define MD5_STEP(f, a, b, c, d, k, t, s) \
+		a += f(b, c, d) + x[k] + (uint32_t) t; \
+		a = ROTL(a, s) + b;
+#define MD5_F(b, c, d) ((d) ^ ((b) & ((c) ^ (d))))
+#define MD5_G(b, c, d) ((c) ^ ((d) & ((b) ^ (c))))
+#define MD5_H(b, c, d) ((b) ^ (c) ^ (d))
+#define MD5_I(b, c, d) ((c) ^ ((b) | ~(d)))
+
+		MD5_STEP(MD5_F, a, b, c, d,  0, 0xd76aa478,  7)
+		MD5_STEP(MD5_F, d, a, b, c,  1, 0xe8c7b756, 12)
+		MD5_STEP(MD5_F, c, d, a, b,  2, 0x242070db, 17)
+		MD5_STEP(MD5_F, b, c, d, a,  3, 0xc1bdceee, 22)
+		MD5_STEP(MD5_F, a, b, c, d,  4, 0xf57c0faf,  7)
+		MD5_STEP(MD5_F, d, a, b, c,  5, 0x4787c62a, 12)
+		MD5_STEP(MD5_F, c, d, a, b,  6, 0xa8304613, 17)
+		MD5_STEP(MD5_F, b, c, d, a,  7, 0xfd469501, 22)
+		MD5_STEP(MD5_F, a, b, c, d,  8, 0x698098d8,  7)
+		MD5_STEP(MD5_F, d, a, b, c,  9, 0x8b44f7af, 12)
+		MD5_STEP(MD5_F, c, d, a, b, 10, 0xffff5bb1, 17)
+		MD5_STEP(MD5_F, b, c, d, a, 11, 0x895cd7be, 22)
+		MD5_STEP(MD5_F, a, b, c, d, 12, 0x6b901122,  7)
+		MD5_STEP(MD5_F, d, a, b, c, 13, 0xfd987193, 12)
+		MD5_STEP(MD5_F, c, d, a, b, 14, 0xa679438e, 17)
+		MD5_STEP(MD5_F, b, c, d, a, 15, 0x49b40821, 22)
+
+		MD5_STEP(MD5_G, a, b, c, d,  1, 0xf61e2562,  5)
+		MD5_STEP(MD5_G, d, a, b, c,  6, 0xc040b340,  9)
+		MD5_STEP(MD5_G, c, d, a, b, 11, 0x265e5a51, 14)
+		MD5_STEP(MD5_G, b, c, d, a,  0, 0xe9b6c7aa, 20)
+		MD5_STEP(MD5_G, a, b, c, d,  5, 0xd62f105d,  5)
+		MD5_STEP(MD5_G, d, a, b, c, 10, 0x02441453,  9)
+		MD5_STEP(MD5_G, c, d, a, b, 15, 0xd8a1e681, 14)
+		MD5_STEP(MD5_G, b, c, d, a,  4, 0xe7d3fbc8, 20)
+		MD5_STEP(MD5_G, a, b, c, d,  9, 0x21e1cde6,  5)
+		MD5_STEP(MD5_G, d, a, b, c, 14, 0xc33707d6,  9)
+		MD5_STEP(MD5_G, c, d, a, b,  3, 0xf4d50d87, 14)
+		MD5_STEP(MD5_G, b, c, d, a,  8, 0x455a14ed, 20)
+		MD5_STEP(MD5_G, a, b, c, d, 13, 0xa9e3e905,  5)
+		MD5_STEP(MD5_G, d, a, b, c,  2, 0xfcefa3f8,  9)
+		MD5_STEP(MD5_G, c, d, a, b,  7, 0x676f02d9, 14)
+		MD5_STEP(MD5_G, b, c, d, a, 12, 0x8d2a4c8a, 20)
+
+		MD5_STEP(MD5_H, a, b, c, d,  5, 0xfffa3942,  4)
+		MD5_STEP(MD5_H, d, a, b, c,  8, 0x8771f681, 11)
+		MD5_STEP(MD5_H, c, d, a, b, 11, 0x6d9d6122, 16)
+		MD5_STEP(MD5_H, b, c, d, a, 14, 0xfde5380c, 23)
+		MD5_STEP(MD5_H, a, b, c, d,  1, 0xa4beea44,  4)
+		MD5_STEP(MD5_H, d, a, b, c,  4, 0x4bdecfa9, 11)
+		MD5_STEP(MD5_H, c, d, a, b,  7, 0xf6bb4b60, 16)
+		MD5_STEP(MD5_H, b, c, d, a, 10, 0xbebfbc70, 23)
+		MD5_STEP(MD5_H, a, b, c, d, 13, 0x289b7ec6,  4)
+		MD5_STEP(MD5_H, d, a, b, c,  0, 0xeaa127fa, 11)
+		MD5_STEP(MD5_H, c, d, a, b,  3, 0xd4ef3085, 16)
+		MD5_STEP(MD5_H, b, c, d, a,  6, 0x04881d05, 23)
+		MD5_STEP(MD5_H, a, b, c, d,  9, 0xd9d4d039,  4)
+		MD5_STEP(MD5_H, d, a, b, c, 12, 0xe6db99e5, 11)
+		MD5_STEP(MD5_H, c, d, a, b, 15, 0x1fa27cf8, 16)
+		MD5_STEP(MD5_H, b, c, d, a,  2, 0xc4ac5665, 23)
+
+		MD5_STEP(MD5_I, a, b, c, d,  0, 0xf4292244,  6)
+		MD5_STEP(MD5_I, d, a, b, c,  7, 0x432aff97, 10)
+		MD5_STEP(MD5_I, c, d, a, b, 14, 0xab9423a7, 15)
+		MD5_STEP(MD5_I, b, c, d, a,  5, 0xfc93a039, 21)
+		MD5_STEP(MD5_I, a, b, c, d, 12, 0x655b59c3,  6)
+		MD5_STEP(MD5_I, d, a, b, c,  3, 0x8f0ccc92, 10)
+		MD5_STEP(MD5_I, c, d, a, b, 10, 0xffeff47d, 15)
+		MD5_STEP(MD5_I, b, c, d, a,  1, 0x85845dd1, 21)
+		MD5_STEP(MD5_I, a, b, c, d,  8, 0x6fa87e4f,  6)
+		MD5_STEP(MD5_I, d, a, b, c, 15, 0xfe2ce6e0, 10)
+		MD5_STEP(MD5_I, c, d, a, b,  6, 0xa3014314, 15)
+		MD5_STEP(MD5_I, b, c, d, a, 13, 0x4e0811a1, 21)
+		MD5_STEP(MD5_I, a, b, c, d,  4, 0xf7537e82,  6)
+		MD5_STEP(MD5_I, d, a, b, c, 11, 0xbd3af235, 10)
+		MD5_STEP(MD5_I, c, d, a, b,  2, 0x2ad7d2bb, 15)
+		MD5_STEP(MD5_I, b, c, d, a,  9, 0xeb86d391, 21)
+
+#undef MD5_STEP
+#undef MD5_F
+#undef MD5_G
+#undef MD5_H
+#undef MD5_I
+
+		st[0] += a;
+		st[1] += b;
+		st[2] += c;
+		st[3] += d;
+		}
+};
+
+struct SHA1Alg {
+	typedef SHA_CTX Ctx;
+	static const int STATE = 5;
+
+	static uint32_t Get(const Ctx* c, int i)
+		{
+		switch ( i ) {
+		case 0: return c->h0;
+		case 1: return c->h1;
+		case 2: return c->h2;
+		case 3: return c->h3;
+		default: return c->h4;
+		}
+		}
+
+	static void Set(Ctx* c, int i, uint32_t v)
+		{
+		switch ( i ) {
+		case 0: c->h0 = v; break;
+		case 1: c->h1 = v; break;
+		case 2: c->h2 = v; break;
+		case 3: c->h3 = v; break;
+		default: c->h4 = v; break;
+		}
+		}
+
+	static void Transform(Ctx* c, const u_char* b)	{ SHA1_Transform(c, b); }
+	static void Update(Ctx* c, const u_char* d, uint64 n)	{ SHA1_Update(c, d, n); }
+
+	template<typename V, int N>
+	static inline __attribute__((always_inline))
+	void Blocks(V* st, const u_char* const* blocks)
+		{
+		V w[16];
+
+		for ( int j = 0; j < 16; ++j )
+			for ( int l = 0; l < N; ++l )
+				w[j][l] = load_be32(blocks[l] + 4 * j);
+
+		V a = st[0], b = st[1], c = st[2], d = st[3], e = st[4];
+
+		for ( int t = 0; t < 80; ++t )
+			{
+			if ( t >= 16 )
+				{
+				V x = w[(t + 13) & 15] ^ w[(t + 8) & 15] ^
+				      w[(t + 2) & 15] ^ w[t & 15];
+				w[t & 15] = ROTL(x, 1);
+				}
+
+			V f;
+			uint32_t k;
+
+			if ( t < 20 )
+				{
+				f = d ^ (b & (c ^ d));
+				k = 0x5a827999;
+				}
+			else if ( t < 40 )
+				{
+				f = b ^ c ^ d;
+				k = 0x6ed9eba1;
+				}
+			else if ( t < 60 )
+				{
+				f = (b & c) | (d & (b | c));
+				k = 0x8f1bbcdc;
+				}
+			else
+				{
+				f = b ^ c ^ d;
+				k = 0xca62c1d6;
+				}
+
+			V tmp = ROTL(a, 5) + f + e + k + w[t & 15];
+			e = d;
+			d = c;
+			c = ROTL(b, 30);
+			b = a;
+			a = tmp;
+			}
+
+		st[0] += a;
+		st[1] += b;
+		st[2] += c;
+		st[3] += d;
+		st[4] += e;
+		}
+};
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+	0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+	0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+	0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+	0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+	0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+struct SHA256Alg {
+	typedef SHA256_CTX Ctx;
+	static const int STATE = 8;
+
+	static uint32_t Get(const Ctx* c, int i)	{ return c->h[i]; }
+	static void Set(Ctx* c, int i, uint32_t v)	{ c->h[i] = v; }
+
+	static void Transform(Ctx* c, const u_char* b)	{ SHA256_Transform(c, b); }
+	static void Update(Ctx* c, const u_char* d, uint64 n)	{ SHA256_Update(c, d, n); }
+
+	template<typename V, int N>
+	static inline __attribute__((always_inline))
+	void Blocks(V* st, const u_char* const* blocks)
+		{
+		V w[16];
+
+		for ( int j = 0; j < 16; ++j )
+			for ( int l = 0; l < N; ++l )
+				w[j][l] = load_be32(blocks[l] + 4 * j);
+
+		V a = st[0], b = st[1], c = st[2], d = st[3];
+		V e = st[4], f = st[5], g = st[6], h = st[7];
+
+		for ( int t = 0; t < 64; ++t )
+			{
+			if ( t >= 16 )
+				{
+				V w15 = w[(t + 1) & 15];
+				V w2 = w[(t + 14) & 15];
+				V s0 = ROTL(w15, 25) ^ ROTL(w15, 14) ^ (w15 >> 3);
+				V s1 = ROTL(w2, 15) ^ ROTL(w2, 13) ^ (w2 >> 10);
+				w[t & 15] += s0 + w[(t + 9) & 15] + s1;
+				}
+
+			V S1 = ROTL(e, 26) ^ ROTL(e, 21) ^ ROTL(e, 7);
+			V ch = g ^ (e & (f ^ g));
+			V t1 = h + S1 + ch + sha256_k[t] + w[t & 15];
+			V S0 = ROTL(a, 30) ^ ROTL(a, 19) ^ ROTL(a, 10);
+			V maj = (a & b) | (c & (a | b));
+			V t2 = S0 + maj;
+
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+			}
+
+		st[0] += a;
+		st[1] += b;
+		st[2] += c;
+		st[3] += d;
+		st[4] += e;
+		st[5] += f;
+		st[6] += g;
+		st[7] += h;
+		}
+};
+
+// A stream of whole blocks still to be hashed into a context.
+template<typename A>
+struct Stream {
+	typename A::Ctx* ctx;
+	const u_char* data;
+	uint64 blocks;
+};
+
+// Hashes the streams' blocks N lanes at a time, moving the next stream into
+// a lane as soon as the one in it runs out.  Once fewer than two streams
+// are left, the rest is cheaper to do one by one.
+template<typename A, typename V, int N>
+static inline __attribute__((always_inline))
+void hash_lanes(Stream<A>* streams, int num_streams)
+	{
+	V st[A::STATE];
+	int lane_stream[N];
+	const u_char* blocks[N];
+	int next = 0;
+	int active = 0;
+
+	for ( int l = 0; l < N; ++l )
+		lane_stream[l] = -1;
+
+	for ( ; ; )
+		{
+		for ( int l = 0; l < N; ++l )
+			{
+			if ( lane_stream[l] >= 0 || next >= num_streams )
+				continue;
+
+			lane_stream[l] = next;
+
+			for ( int i = 0; i < A::STATE; ++i )
+				st[i][l] = A::Get(streams[next].ctx, i);
+
+			++next;
+			++active;
+			}
+
+		if ( active < 2 )
+			break;
+
+		for ( int l = 0; l < N; ++l )
+			blocks[l] = lane_stream[l] >= 0 ?
+				streams[lane_stream[l]].data : zero_block;
+
+		A::template Blocks<V, N>(st, blocks);
+
+		for ( int l = 0; l < N; ++l )
+			{
+			if ( lane_stream[l] < 0 )
+				continue;
+
+			Stream<A>* s = &streams[lane_stream[l]];
+			s->data += 64;
+
+			if ( --s->blocks > 0 )
+				continue;
+
+			for ( int i = 0; i < A::STATE; ++i )
+				A::Set(s->ctx, i, st[i][l]);
+
+			lane_stream[l] = -1;
+			--active;
+			}
+		}
+
+	// Whatever's left, possibly still in a lane.
+	for ( int l = 0; l < N; ++l )
+		{
+		if ( lane_stream[l] < 0 )
+			continue;
+
+		Stream<A>* s = &streams[lane_stream[l]];
+
+		for ( int i = 0; i < A::STATE; ++i )
+			A::Set(s->ctx, i, st[i][l]);
+		}
+
+	for ( int i = 0; i < num_streams; ++i )
+		for ( ; streams[i].blocks > 0; --streams[i].blocks )
+			{
+			A::Transform(streams[i].ctx, streams[i].data);
+			streams[i].data += 64;
+			}
+	}
+
+template<typename A>
+static void hash_lanes4(Stream<A>* streams, int num_streams)
+	{
+	hash_lanes<A, vec4, 4>(streams, num_streams);
+	}
+
+#ifdef MULTIHASH_X86
+template<typename A>
+__attribute__((target("avx2")))
+static void hash_lanes8(Stream<A>* streams, int num_streams)
+	{
+	hash_lanes<A, vec8, 8>(streams, num_streams);
+	}
+#endif
+
+static bool cpu_has_avx2()
+	{
+#ifdef MULTIHASH_X86
+	static int avx2 = -1;
+
+	if ( avx2 < 0 )
+		{
+		__builtin_cpu_init();
+		avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+		}
+
+	return avx2;
+#else
+	return false;
+#endif
+	}
+
+static bool cpu_has_sha()
+	{
+#ifdef MULTIHASH_X86
+	static int sha = -1;
+
+	if ( sha < 0 )
+		{
+		unsigned int eax, ebx, ecx, edx;
+		sha = __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) &&
+		      (ebx & (1 << 29)) ? 1 : 0;
+		}
+
+	return sha;
+#else
+	return false;
+#endif
+	}
+
+static void add_bits(uint32_t* nl, uint32_t* nh, uint64 bytes)
+	{
+	uint64 bits = ((uint64(*nh) << 32) | *nl) + (bytes << 3);
+	*nl = uint32_t(bits);
+	*nh = uint32_t(bits >> 32);
+	}
+
+// Applies queued updates to their contexts.  Each update first fills up a
+// partial block buffered in its context, then its whole blocks go into the
+// lanes, and the remainder gets buffered in the context again.
+template<typename A, typename U>
+static void flush_updates(std::vector<U>& updates, bool use_lanes)
+	{
+	if ( updates.empty() )
+		return;
+
+	for ( size_t i = 0; i < updates.size(); ++i )
+		{
+		if ( updates[i].queued )
+			*updates[i].queued = 0;
+		}
+
+	if ( ! use_lanes )
+		{
+		for ( size_t i = 0; i < updates.size(); ++i )
+			A::Update(updates[i].ctx, updates[i].data, updates[i].len);
+
+		updates.clear();
+		return;
+		}
+
+	std::vector<Stream<A> > streams;
+	streams.reserve(updates.size());
+
+	for ( size_t i = 0; i < updates.size(); ++i )
+		{
+		U& u = updates[i];
+
+		if ( u.ctx->num )
+			{
+			uint64 n = 64 - u.ctx->num;
+
+			if ( n > u.len )
+				n = u.len;
+
+			A::Update(u.ctx, u.data, n);
+			u.data += n;
+			u.len -= n;
+			}
+
+		uint64 blocks = u.len / 64;
+
+		if ( ! blocks )
+			continue;
+
+		add_bits(&u.ctx->Nl, &u.ctx->Nh, blocks * 64);
+
+		Stream<A> s = { u.ctx, u.data, blocks };
+		streams.push_back(s);
+
+		u.data += blocks * 64;
+		u.len -= blocks * 64;
+		}
+
+	if ( ! streams.empty() )
+		{
+#ifdef MULTIHASH_X86
+		if ( cpu_has_avx2() )
+			hash_lanes8<A>(&streams[0], streams.size());
+		else
+#endif
+			hash_lanes4<A>(&streams[0], streams.size());
+		}
+
+	for ( size_t i = 0; i < updates.size(); ++i )
+		{
+		if ( updates[i].len )
+			A::Update(updates[i].ctx, updates[i].data, updates[i].len);
+		}
+
+	updates.clear();
+	}
+
+MultiHash::MultiHash()
+	{
+	bytes = 0;
+	}
+
+MultiHash::~MultiHash()
+	{
+	Flush();
+	}
+
+template<typename CTX>
+void MultiHash::Queue(std::vector<Update<CTX> >& v, CTX* c,
+                      const u_char* data, uint64 len, MultiHash** queued)
+	{
+	for ( size_t i = 0; i < v.size(); ++i )
+		{
+		if ( v[i].ctx == c )
+			{
+			Flush();
+			break;
+			}
+		}
+
+	Update<CTX> u = { c, data, len, queued };
+	v.push_back(u);
+	bytes += len;
+
+	if ( queued )
+		*queued = this;
+	}
+
+void MultiHash::Add(MD5_CTX* c, const u_char* data, uint64 len,
+                    MultiHash** queued)
+	{
+	Queue(md5, c, data, len, queued);
+	}
+
+void MultiHash::Add(SHA_CTX* c, const u_char* data, uint64 len,
+                    MultiHash** queued)
+	{
+	Queue(sha1, c, data, len, queued);
+	}
+
+void MultiHash::Add(SHA256_CTX* c, const u_char* data, uint64 len,
+                    MultiHash** queued)
+	{
+	Queue(sha256, c, data, len, queued);
+	}
+
+// OpenSSL's SHA1/SHA256 code is about as fast as 4 lanes, and faster than
+// 8 lanes with the CPU's SHA instructions.
+static bool use_sha_lanes()
+	{
+	return cpu_has_avx2() && ! cpu_has_sha();
+	}
+
+void MultiHash::Flush()
+	{
+	flush_updates<MD5Alg>(md5, true);
+	flush_updates<SHA1Alg>(sha1, use_sha_lanes());
+	flush_updates<SHA256Alg>(sha256, use_sha_lanes());
+	bytes = 0;
+	}
+
+const char* MultiHash::Engine()
+	{
+	if ( use_sha_lanes() )
+		return "MD5/SHA1/SHA256: 8 lanes";
+
+	return cpu_has_avx2() ? "MD5: 8 lanes, SHA1/SHA256: OpenSSL" :
+	                        "MD5: 4 lanes, SHA1/SHA256: OpenSSL";
+	}
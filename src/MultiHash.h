@@ -0,0 +1,106 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef multihash_h
+#define multihash_h
+
+#include <vector>
+
+#include <openssl/md5.h>
+#include <openssl/sha.h>
+
+#include "util.h"
+
+/**
+ * Computes MD5, SHA1, and SHA256 digests of many independent streams at
+ * once.  Updates to the streams' OpenSSL contexts get queued with Add(),
+ * and Flush() then processes the whole blocks of all queued updates
+ * across SIMD lanes, one block of up to 8 different streams per step
+ * (depending on the CPU).  Partial blocks go through OpenSSL, so that the
+ * contexts can be used with the normal OpenSSL functions before and after
+ * each flush.
+ *
+ * SHA1/SHA256 only use lanes with AVX2 on CPUs without SHA instructions;
+ * otherwise OpenSSL's own code is at least as fast, so those updates just
+ * go to OpenSSL.
+ *
+ * An instance isn't thread-safe, but different threads can use different
+ * instances.
+ */
+class MultiHash {
+public:
+	/**
+	 * Constructor.
+	 */
+	MultiHash();
+
+	/**
+	 * Destructor.  Anything still queued is flushed.
+	 */
+	~MultiHash();
+
+	/**
+	 * Queues an update of an MD5 context. If the context already has an
+	 * update queued, the queue gets flushed first.
+	 * @param c the context, which must not be used otherwise until the
+	 *        next Flush().
+	 * @param data the data, which must remain valid until the next Flush().
+	 * @param len the number of bytes in \a data.
+	 * @param queued if given, gets set to this instance, and back to null
+	 *        once the update has been applied.
+	 */
+	void Add(MD5_CTX* c, const u_char* data, uint64 len,
+	         MultiHash** queued = 0);
+
+	/**
+	 * Queues an update of a SHA1 context, just like the MD5 version.
+	 */
+	void Add(SHA_CTX* c, const u_char* data, uint64 len,
+	         MultiHash** queued = 0);
+
+	/**
+	 * Queues an update of a SHA256 context, just like the MD5 version.
+	 */
+	void Add(SHA256_CTX* c, const u_char* data, uint64 len,
+	         MultiHash** queued = 0);
+
+	/**
+	 * @return the number of updates queued.
+	 */
+	int Size() const	{ return md5.size() + sha1.size() + sha256.size(); }
+
+	/**
+	 * @return the number of bytes queued.
+	 */
+	uint64 Bytes() const	{ return bytes; }
+
+	/**
+	 * Applies all queued updates to their contexts and empties the queue.
+	 */
+	void Flush();
+
+	/**
+	 * @return a description of the lane implementations used on this
+	 *         CPU, for debugging output.
+	 */
+	static const char* Engine();
+
+private:
+	template<typename CTX>
+	struct Update {
+		CTX* ctx;
+		const u_char* data;
+		uint64 len;
+		MultiHash** queued;
+	};
+
+	template<typename CTX>
+	void Queue(std::vector<Update<CTX> >& v, CTX* c, const u_char* data,
+	           uint64 len, MultiHash** queued);
+
+	std::vector<Update<MD5_CTX> > md5;
+	std::vector<Update<SHA_CTX> > sha1;
+	std::vector<Update<SHA256_CTX> > sha256;
+	uint64 bytes;
+};
+
+#endif
@@ -236,6 +236,17 @@ void expire_timers(iosource::PktSrc* src_ps)
 				max_timer_expires - current_dispatched);
 	}
 
+// Number of packets whose events we are holding back, and the time of the
+// first one.
+static bro_uint_t deferred_packets = 0;
+static double first_deferred_time = 0.0;
+
+static void drain_event_queue()
+	{
+	mgr.Drain();
+	deferred_packets = 0;
+	}
+
 void net_packet_dispatch(double t, const struct pcap_pkthdr* hdr,
 			 const u_char* pkt, int hdr_size,
 			 iosource::PktSrc* src_ps)
@@ -267,7 +278,7 @@ void net_packet_dispatch(double t, const struct pcap_pkthdr* hdr,
 			{
 			// Drain the queued timer events so they're not
 			// charged against this sample.
-			mgr.Drain();
+			drain_event_queue();
 
 			sample_logger = new SampleLogger();
 			sp = new SegmentProfiler(sample_logger, "load-samp");
@@ -275,7 +286,14 @@ void net_packet_dispatch(double t, const struct pcap_pkthdr* hdr,
 		}
 
 	sessions->DispatchPacket(t, hdr, pkt, hdr_size, src_ps);
-	mgr.Drain();
+
+	if ( deferred_packets++ == 0 )
+		first_deferred_time = t;
+
+	if ( deferred_packets >= BifConst::event_drain_packets ||
+	     t - first_deferred_time >= BifConst::event_drain_max_delay ||
+	     sp )
+		drain_event_queue();
 
 	if ( sp )
 		{
@@ -362,7 +380,11 @@ void net_run()
 			// Use nanosleep(2) or setitimer(2) instead.
 			}
 
-		mgr.Drain();
+		// Unless net_packet_dispatch() has decided to hold back the
+		// events of the packets the source just delivered, dispatch
+		// everything queued so far.
+		if ( ! (deferred_packets && dynamic_cast<iosource::PktSrc*>(src)) )
+			drain_event_queue();
 
 		processing_start_time = 0.0;	// = "we're not processing now"
 		current_dispatched = 0;
@@ -422,7 +444,7 @@ void net_finish(int drain_events)
 		if ( sessions )
 			sessions->Drain();
 
-		mgr.Drain();
+		drain_event_queue();
 
 		if ( sessions )
 			sessions->Done();
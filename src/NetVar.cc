@@ -199,6 +199,7 @@ RecordType* gap_info;
 int packet_filter_default;
 
 int sig_max_group_size;
+int sig_prefilter_buffer;
 
 int enable_syslog;
 
@@ -284,6 +285,7 @@ void init_general_global_var()
 	packet_filter_default = opt_internal_int("packet_filter_default");
 
 	sig_max_group_size = opt_internal_int("sig_max_group_size");
+	sig_prefilter_buffer = opt_internal_int("sig_prefilter_buffer");
 	enable_syslog = opt_internal_int("enable_syslog");
 
 	check_for_unused_event_handlers =
@@ -203,6 +203,7 @@ extern RecordType* gap_info;
 extern int packet_filter_default;
 
 extern int sig_max_group_size;
+extern int sig_prefilter_buffer;
 
 extern int enable_syslog;
 
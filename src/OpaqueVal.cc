@@ -1,12 +1,39 @@
 // See the file "COPYING" in the main distribution directory for copyright.
 
 #include "OpaqueVal.h"
+#include "MultiHash.h"
 #include "NetVar.h"
 #include "Reporter.h"
 #include "Serializer.h"
 #include "probabilistic/BloomFilter.h"
 #include "probabilistic/CardinalityCounter.h"
 
+// Hash updates coming from scripts get collected here, so that the updates
+// of different hashes can be computed together.  The batch keeps the
+// strings referenced until it has been flushed.
+static const int SCRIPT_BATCH_UPDATES = 16;
+static const uint64 SCRIPT_BATCH_BYTES = 1024 * 1024;
+
+static MultiHash* script_batch = 0;
+static vector<StringVal*> script_batch_data;
+
+static void flush_script_batch()
+	{
+	script_batch->Flush();
+
+	for ( size_t i = 0; i < script_batch_data.size(); ++i )
+		Unref(script_batch_data[i]);
+
+	script_batch_data.clear();
+	}
+
+HashVal::~HashVal()
+	{
+	// Derived classes complete pending updates in their destructors,
+	// while the contexts the updates go into still exist.
+	assert(! pending);
+	}
+
 bool HashVal::IsValid() const
 	{
 	return valid;
@@ -23,6 +50,8 @@ bool HashVal::Init()
 
 StringVal* HashVal::Get()
 	{
+	Sync();
+
 	if ( ! valid )
 		return new StringVal("");
 
@@ -33,6 +62,8 @@ StringVal* HashVal::Get()
 
 bool HashVal::Feed(const void* data, size_t size)
 	{
+	Sync();
+
 	if ( valid )
 		return DoFeed(data, size);
 
@@ -40,6 +71,47 @@ bool HashVal::Feed(const void* data, size_t size)
 	return false;
 	}
 
+bool HashVal::Feed(MultiHash* mh, const void* data, size_t size)
+	{
+	// A batch can only hold one update per hash.
+	Sync();
+
+	if ( valid )
+		return DoQueue(mh, data, size);
+
+	Error("attempt to update an invalid opaque hash value");
+	return false;
+	}
+
+bool HashVal::Feed(StringVal* data)
+	{
+	if ( ! script_batch )
+		script_batch = new MultiHash();
+
+	if ( ! Feed(script_batch, data->Bytes(), data->Len()) )
+		return false;
+
+	Ref(data);
+	script_batch_data.push_back(data);
+
+	if ( script_batch->Size() >= SCRIPT_BATCH_UPDATES ||
+	     script_batch->Bytes() >= SCRIPT_BATCH_BYTES )
+		flush_script_batch();
+
+	return true;
+	}
+
+void HashVal::Sync() const
+	{
+	if ( ! pending )
+		return;
+
+	if ( pending == script_batch )
+		flush_script_batch();
+	else
+		pending->Flush();
+	}
+
 bool HashVal::DoInit()
 	{
 	assert(! "missing implementation of DoInit()");
@@ -52,6 +124,11 @@ bool HashVal::DoFeed(const void*, size_t)
 	return false;
 	}
 
+bool HashVal::DoQueue(MultiHash*, const void* data, size_t size)
+	{
+	return DoFeed(data, size);
+	}
+
 StringVal* HashVal::DoGet()
 	{
 	assert(! "missing implementation of DoGet()");
@@ -61,12 +138,15 @@ StringVal* HashVal::DoGet()
 HashVal::HashVal(OpaqueType* t) : OpaqueVal(t)
 	{
 	valid = false;
+	pending = 0;
 	}
 
 IMPLEMENT_SERIAL(HashVal, SER_HASH_VAL);
 
 bool HashVal::DoSerialize(SerialInfo* info) const
 	{
+	Sync();
+
 	DO_SERIALIZE(SER_HASH_VAL, OpaqueVal);
 	return SERIALIZE(valid);
 	}
@@ -81,6 +161,11 @@ MD5Val::MD5Val() : HashVal(md5_type)
 	{
 	}
 
+MD5Val::~MD5Val()
+	{
+	Sync();
+	}
+
 void MD5Val::digest(val_list& vlist, u_char result[MD5_DIGEST_LENGTH])
 	{
 	MD5_CTX h;
@@ -132,6 +217,15 @@ bool MD5Val::DoFeed(const void* data, size_t size)
 	return true;
 	}
 
+bool MD5Val::DoQueue(MultiHash* mh, const void* data, size_t size)
+	{
+	if ( ! IsValid() )
+		return false;
+
+	mh->Add(&ctx, (const u_char*) data, size, &pending);
+	return true;
+	}
+
 StringVal* MD5Val::DoGet()
 	{
 	if ( ! IsValid() )
@@ -202,6 +296,11 @@ SHA1Val::SHA1Val() : HashVal(sha1_type)
 	{
 	}
 
+SHA1Val::~SHA1Val()
+	{
+	Sync();
+	}
+
 void SHA1Val::digest(val_list& vlist, u_char result[SHA_DIGEST_LENGTH])
 	{
 	SHA_CTX h;
@@ -242,6 +341,15 @@ bool SHA1Val::DoFeed(const void* data, size_t size)
 	return true;
 	}
 
+bool SHA1Val::DoQueue(MultiHash* mh, const void* data, size_t size)
+	{
+	if ( ! IsValid() )
+		return false;
+
+	mh->Add(&ctx, (const u_char*) data, size, &pending);
+	return true;
+	}
+
 StringVal* SHA1Val::DoGet()
 	{
 	if ( ! IsValid() )
@@ -314,6 +422,11 @@ SHA256Val::SHA256Val() : HashVal(sha256_type)
 	{
 	}
 
+SHA256Val::~SHA256Val()
+	{
+	Sync();
+	}
+
 void SHA256Val::digest(val_list& vlist, u_char result[SHA256_DIGEST_LENGTH])
 	{
 	SHA256_CTX h;
@@ -354,6 +467,15 @@ bool SHA256Val::DoFeed(const void* data, size_t size)
 	return true;
 	}
 
+bool SHA256Val::DoQueue(MultiHash* mh, const void* data, size_t size)
+	{
+	if ( ! IsValid() )
+		return false;
+
+	mh->Add(&ctx, (const u_char*) data, size, &pending);
+	return true;
+	}
+
 StringVal* SHA256Val::DoGet()
 	{
 	if ( ! IsValid() )
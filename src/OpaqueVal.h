@@ -14,22 +14,59 @@ namespace probabilistic {
 	class CardinalityCounter;
 }
 
+class MultiHash;
+
 class HashVal : public OpaqueVal {
 public:
+	virtual ~HashVal();
+
 	virtual bool IsValid() const;
 	virtual bool Init();
 	virtual bool Feed(const void* data, size_t size);
 	virtual StringVal* Get();
 
+	/**
+	 * Queues data for hashing together with other hashes' updates. The
+	 * update completes when \a mh gets flushed, or once this value gets
+	 * read, fed directly, serialized, or deleted.
+	 * @param mh the batch of updates to queue into.
+	 * @param data the data, which must remain valid until the update
+	 *        completes.
+	 * @param size the number of bytes in \a data.
+	 * @return false if the value isn't valid.
+	 */
+	bool Feed(MultiHash* mh, const void* data, size_t size);
+
+	/**
+	 * Feeds a string coming from a script.  Updates from scripts get
+	 * batched across all hash values, keeping the strings referenced
+	 * until they've been hashed.
+	 * @param data the string.
+	 * @return false if the value isn't valid.
+	 */
+	bool Feed(StringVal* data);
+
+	/**
+	 * Completes an update still queued with one of the batching Feed()
+	 * versions, if any.  This happens automatically as needed on the
+	 * thread that queued it, and otherwise needs to be called there.
+	 */
+	void Sync() const;
+
 protected:
-	HashVal() { };
+	HashVal() { pending = 0; };
 	HashVal(OpaqueType* t);
 	virtual bool DoInit();
 	virtual bool DoFeed(const void* data, size_t size);
+	virtual bool DoQueue(MultiHash* mh, const void* data, size_t size);
 	virtual StringVal* DoGet();
 
 	DECLARE_SERIAL(HashVal);
 
+	// The batch holding an update of the hash, if any. MultiHash resets
+	// this when it applies the update.
+	mutable MultiHash* pending;
+
 private:
 	// This flag exists because Get() can only be called once.
 	bool valid;
@@ -44,12 +81,14 @@ public:
 			 u_char result[MD5_DIGEST_LENGTH]);
 
 	MD5Val();
+	virtual ~MD5Val();
 
 protected:
 	friend class Val;
 
 	virtual bool DoInit() /* override */;
 	virtual bool DoFeed(const void* data, size_t size) /* override */;
+	virtual bool DoQueue(MultiHash* mh, const void* data, size_t size) /* override */;
 	virtual StringVal* DoGet() /* override */;
 
 	DECLARE_SERIAL(MD5Val);
@@ -63,12 +102,14 @@ public:
 	static void digest(val_list& vlist, u_char result[SHA_DIGEST_LENGTH]);
 
 	SHA1Val();
+	virtual ~SHA1Val();
 
 protected:
 	friend class Val;
 
 	virtual bool DoInit() /* override */;
 	virtual bool DoFeed(const void* data, size_t size) /* override */;
+	virtual bool DoQueue(MultiHash* mh, const void* data, size_t size) /* override */;
 	virtual StringVal* DoGet() /* override */;
 
 	DECLARE_SERIAL(SHA1Val);
@@ -82,12 +123,14 @@ public:
 	static void digest(val_list& vlist, u_char result[SHA256_DIGEST_LENGTH]);
 
 	SHA256Val();
+	virtual ~SHA256Val();
 
 protected:
 	friend class Val;
 
 	virtual bool DoInit() /* override */;
 	virtual bool DoFeed(const void* data, size_t size) /* override */;
+	virtual bool DoQueue(MultiHash* mh, const void* data, size_t size) /* override */;
 	virtual StringVal* DoGet() /* override */;
 
 	DECLARE_SERIAL(SHA256Val);
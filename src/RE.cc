@@ -7,6 +7,7 @@
 
 #include "RE.h"
 #include "DFA.h"
+#include "DFACache.h"
 #include "CCL.h"
 #include "EquivClass.h"
 #include "Serializer.h"
@@ -109,6 +110,20 @@ int Specific_RE_Matcher::Compile(int lazy)
 	if ( ! pattern_text )
 		return 0;
 
+	string key;
+
+	if ( dfa_cache )
+		{
+		key = fmt("%d %d ", mt, multiline);
+		key += pattern_text;
+
+		if ( (dfa = dfa_cache->Lookup(key, EC())) )
+			{
+			ecs = EC()->EquivClasses();
+			return 1;
+			}
+		}
+
 	rem = this;
 	RE_set_input(pattern_text);
 	if ( RE_parse() )
@@ -127,6 +142,9 @@ int Specific_RE_Matcher::Compile(int lazy)
 
 	ecs = EC()->EquivClasses();
 
+	if ( dfa_cache )
+		dfa_cache->Insert(key, dfa, EC());
+
 	return 1;
 	}
 
@@ -135,6 +153,25 @@ int Specific_RE_Matcher::CompileSet(const string_list& set, const int_list& idx)
 	if ( set.length() != idx.length() )
 		reporter->InternalError("compileset: lengths of sets differ");
 
+	string key;
+
+	if ( dfa_cache )
+		{
+		key = "set";
+
+		loop_over_list(set, j)
+			{
+			key += fmt(" %d ", idx[j]);
+			key.append(set[j], strlen(set[j]) + 1);
+			}
+
+		if ( (dfa = dfa_cache->Lookup(key, EC())) )
+			{
+			ecs = EC()->EquivClasses();
+			return 1;
+			}
+		}
+
 	rem = this;
 
 	NFA_Machine* set_nfa = 0;
@@ -164,6 +201,9 @@ int Specific_RE_Matcher::CompileSet(const string_list& set, const int_list& idx)
 	dfa = new DFA_Machine(nfa, EC());
 	ecs = EC()->EquivClasses();
 
+	if ( dfa_cache )
+		dfa_cache->Insert(key, dfa, EC());
+
 	return 1;
 	}
 
@@ -210,22 +250,23 @@ int Specific_RE_Matcher::MatchAll(const u_char* bv, int n)
 		// matched is empty.
 		return n == 0;
 
-	DFA_State* d = dfa->StartState();
-	d = d->Xtion(ecs[SYM_BOL], dfa);
+	int d = dfa->StartStateNum();
+
+	if ( d != DFA_JAM_STATE )
+		d = dfa->Xtion(d, ecs[SYM_BOL]);
 
-	while ( d )
+	while ( d != DFA_JAM_STATE )
 		{
 		if ( --n < 0 )
 			break;
 
-		int ec = ecs[*(bv++)];
-		d = d->Xtion(ec, dfa);
+		d = dfa->Xtion(d, ecs[*(bv++)]);
 		}
 
-	if ( d )
-		d = d->Xtion(ecs[SYM_EOL], dfa);
+	if ( d != DFA_JAM_STATE )
+		d = dfa->Xtion(d, ecs[SYM_EOL]);
 
-	return d && d->Accept() != 0;
+	return d != DFA_JAM_STATE && dfa->Accept(d) != 0;
 	}
 
 
@@ -235,26 +276,28 @@ int Specific_RE_Matcher::Match(const u_char* bv, int n)
 		// An empty pattern matches anything.
 		return 1;
 
-	DFA_State* d = dfa->StartState();
+	int d = dfa->StartStateNum();
 
-	d = d->Xtion(ecs[SYM_BOL], dfa);
-	if ( ! d ) return 0;
+	if ( d == DFA_JAM_STATE )
+		return 0;
+
+	d = dfa->Xtion(d, ecs[SYM_BOL]);
+	if ( d == DFA_JAM_STATE ) return 0;
 
 	for ( int i = 0; i < n; ++i )
 		{
-		int ec = ecs[bv[i]];
-		d = d->Xtion(ec, dfa);
-		if ( ! d )
+		d = dfa->Xtion(d, ecs[bv[i]]);
+		if ( d == DFA_JAM_STATE )
 			break;
 
-		if ( d->Accept() )
+		if ( dfa->Accept(d) )
 			return i + 1;
 		}
 
-	if ( d )
+	if ( d != DFA_JAM_STATE )
 		{
-		d = d->Xtion(ecs[SYM_EOL], dfa);
-		if ( d && d->Accept() )
+		d = dfa->Xtion(d, ecs[SYM_EOL]);
+		if ( d != DFA_JAM_STATE && dfa->Accept(d) )
 			return n > 0 ? n : 1;	// we can't return 0 here for match...
 		}
 
@@ -290,18 +333,21 @@ bool RE_Match_State::Match(const u_char* bv, int n,
 
 		// Initialize state and copy the accepting states of the start
 		// state into the acceptance set.
-		current_state = dfa->StartState();
+		current_state = dfa->StartStateNum();
+
+		if ( current_state == DFA_JAM_STATE )
+			return false;
 
-		const AcceptingSet* ac = current_state->Accept();
+		const AcceptingSet* ac = dfa->Accept(current_state);
 
 		if ( ac )
 			AddMatches(*ac, 0);
 		}
 
 	else if ( clear )
-		current_state = dfa->StartState();
+		current_state = dfa->StartStateNum();
 
-	if ( ! current_state )
+	if ( current_state == DFA_JAM_STATE )
 		return false;
 
 	current_pos = 0;
@@ -321,15 +367,15 @@ bool RE_Match_State::Match(const u_char* bv, int n,
 		else
 			ec = ecs[*(bv++)];
 
-		DFA_State* next_state = current_state->Xtion(ec,dfa);
+		int next_state = dfa->Xtion(current_state, ec);
 
-		if ( ! next_state )
+		if ( next_state == DFA_JAM_STATE )
 			{
-			current_state = 0;
+			current_state = DFA_JAM_STATE;
 			break;
 			}
 
-		const AcceptingSet* ac = next_state->Accept();
+		const AcceptingSet* ac = dfa->Accept(next_state);
 
 		if ( ac )
 			AddMatches(*ac, current_pos);
@@ -350,31 +396,33 @@ int Specific_RE_Matcher::LongestMatch(const u_char* bv, int n)
 
 	// Use -1 to indicate no match.
 	int last_accept = -1;
-	DFA_State* d = dfa->StartState();
+	int d = dfa->StartStateNum();
+
+	if ( d == DFA_JAM_STATE )
+		return -1;
 
-	d = d->Xtion(ecs[SYM_BOL], dfa);
-	if ( ! d )
+	d = dfa->Xtion(d, ecs[SYM_BOL]);
+	if ( d == DFA_JAM_STATE )
 		return -1;
 
-	if ( d->Accept() )
+	if ( dfa->Accept(d) )
 		last_accept = 0;
 
 	for ( int i = 0; i < n; ++i )
 		{
-		int ec = ecs[bv[i]];
-		d = d->Xtion(ec, dfa);
+		d = dfa->Xtion(d, ecs[bv[i]]);
 
-		if ( ! d )
+		if ( d == DFA_JAM_STATE )
 			break;
 
-		if ( d->Accept() )
+		if ( dfa->Accept(d) )
 			last_accept = i + 1;
 		}
 
-	if ( d )
+	if ( d != DFA_JAM_STATE )
 		{
-		d = d->Xtion(ecs[SYM_EOL], dfa);
-		if ( d && d->Accept() )
+		d = dfa->Xtion(d, ecs[SYM_EOL]);
+		if ( d != DFA_JAM_STATE && dfa->Accept(d) )
 			return n;
 		}
 
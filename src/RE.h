@@ -138,7 +138,7 @@ public:
 		dfa = matcher->DFA() ? matcher->DFA() : 0;
 		ecs = matcher->EC()->EquivClasses();
 		current_pos = -1;
-		current_state = 0;
+		current_state = -1;
 		}
 
 	const AcceptingMatchSet& AcceptedMatches() const
@@ -154,7 +154,7 @@ public:
 	void Clear()
 		{
 		current_pos = -1;
-		current_state = 0;
+		current_state = -1;
 		accepted_matches.clear();
 		}
 
@@ -165,7 +165,7 @@ protected:
 	int* ecs;
 
 	AcceptingMatchSet accepted_matches;
-	DFA_State* current_state;
+	int current_state;	// state number in dfa, or jam
 	int current_pos;
 };
 
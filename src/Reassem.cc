@@ -1,6 +1,7 @@
 // See the file "COPYING" in the main distribution directory for copyright.
 
 #include <algorithm>
+#include <limits.h>
 
 #include "config.h"
 
@@ -9,12 +10,32 @@
 
 static const bool DEBUG_reassem = false;
 
+// Once a reassembler holds this many blocks, we index them rather than
+// walking the list for each out-of-order block. Only the benchmark
+// changes this.
+static int block_index_threshold = 16;
+
+void* DataBlock::operator new(size_t n, uint64 size)
+	{
+	return safe_malloc(n + size);
+	}
+
+void DataBlock::operator delete(void* p, uint64 size)
+	{
+	free(p);
+	}
+
+void DataBlock::operator delete(void* p)
+	{
+	free(p);
+	}
+
 DataBlock::DataBlock(const u_char* data, uint64 size, uint64 arg_seq,
 			DataBlock* arg_prev, DataBlock* arg_next)
 	{
 	seq = arg_seq;
 	upper = seq + size;
-	block = new u_char[size];
+	block = (u_char*) (this + 1);
 
 	memcpy((void*) block, (const void*) data, size);
 
@@ -35,6 +56,8 @@ Reassembler::Reassembler(uint64 init_seq, ReassemblerType arg_type)
 	{
 	blocks = last_block = 0;
 	trim_seq = last_reassem_seq = init_seq;
+	block_map = 0;
+	num_blocks = 0;
 	}
 
 Reassembler::~Reassembler()
@@ -66,7 +89,7 @@ void Reassembler::NewBlock(double t, uint64 seq, uint64 len, const u_char* data)
 
 	if ( ! blocks )
 		blocks = last_block = start_block =
-			new DataBlock(data, len, seq, 0, 0);
+			NewDataBlock(data, len, seq, 0, 0);
 	else
 		start_block = AddAndCheck(blocks, seq, upper_seq, data);
 
@@ -119,7 +142,7 @@ uint64 Reassembler::TrimToSeq(uint64 seq)
 				num_missing += seq - blocks->upper;
 			}
 
-		delete blocks;
+		DeleteBlock(blocks);
 
 		blocks = b;
 		}
@@ -149,7 +172,7 @@ void Reassembler::ClearBlocks()
 	while ( blocks )
 		{
 		DataBlock* b = blocks->next;
-		delete blocks;
+		DeleteBlock(blocks);
 		blocks = b;
 		}
 
@@ -177,6 +200,81 @@ void Reassembler::Undelivered(uint64 up_to_seq)
 	last_reassem_seq = up_to_seq;
 	}
 
+DataBlock* Reassembler::NewDataBlock(const u_char* data, uint64 size,
+					uint64 seq, DataBlock* prev,
+					DataBlock* next)
+	{
+	DataBlock* b = new (size) DataBlock(data, size, seq, prev, next);
+
+	if ( block_map )
+		block_map->insert(BlockMap::value_type(seq, b));
+
+	else if ( ++num_blocks >= block_index_threshold )
+		{
+		// Enough blocks that it's worth indexing them. Note that b
+		// isn't necessarily linked into the list yet if it's going
+		// to become the new head.
+		block_map = new BlockMap;
+
+		for ( DataBlock* i = blocks; i; i = i->next )
+			block_map->insert(BlockMap::value_type(i->seq, i));
+
+		block_map->insert(BlockMap::value_type(seq, b));
+		}
+
+	return b;
+	}
+
+void Reassembler::DeleteBlock(DataBlock* b)
+	{
+	if ( block_map )
+		{
+		block_map->erase(b->seq);
+
+		if ( block_map->empty() )
+			{
+			delete block_map;
+			block_map = 0;
+			num_blocks = 0;
+			}
+		}
+	else
+		--num_blocks;
+
+	delete b;
+	}
+
+DataBlock* Reassembler::FindBlock(DataBlock* b, uint64 seq) const
+	{
+	if ( ! block_map )
+		{
+		while ( b->next && b->upper <= seq )
+			b = b->next;
+
+		return b;
+		}
+
+	// The blocks don't overlap, so the only one before seq that may
+	// reach beyond it is the last one starting at or before seq.
+	// Everything up to b ends at or before seq anyway, so we can't
+	// end up in front of b.
+	BlockMap::const_iterator i = block_map->upper_bound(seq);
+
+	if ( i != block_map->begin() )
+		{
+		BlockMap::const_iterator j = i;
+		--j;
+
+		if ( j->second->upper > seq )
+			return j->second;
+		}
+
+	if ( i == block_map->end() )
+		return last_block;
+
+	return i->second;
+	}
+
 DataBlock* Reassembler::AddAndCheck(DataBlock* b, uint64 seq, uint64 upper,
 					const u_char* data)
 	{
@@ -189,21 +287,20 @@ DataBlock* Reassembler::AddAndCheck(DataBlock* b, uint64 seq, uint64 upper,
 	// Special check for the common case of appending to the end.
 	if ( last_block && seq == last_block->upper )
 		{
-		last_block = new DataBlock(data, upper - seq, seq,
+		last_block = NewDataBlock(data, upper - seq, seq,
 						last_block, 0);
 		return last_block;
 		}
 
 	// Find the first block that doesn't come completely before the
 	// new data.
-	while ( b->next && b->upper <= seq )
-		b = b->next;
+	b = FindBlock(b, seq);
 
 	if ( b->upper <= seq )
 		{
 		// b is the last block, and it comes completely before
 		// the new block.
-		last_block = new DataBlock(data, upper - seq, seq, b, 0);
+		last_block = NewDataBlock(data, upper - seq, seq, b, 0);
 		return last_block;
 		}
 
@@ -212,7 +309,7 @@ DataBlock* Reassembler::AddAndCheck(DataBlock* b, uint64 seq, uint64 upper,
 	if ( upper <= b->seq )
 		{
 		// The new block comes completely before b.
-		new_b = new DataBlock(data, upper - seq, seq, b->prev, b);
+		new_b = NewDataBlock(data, upper - seq, seq, b->prev, b);
 		if ( b == blocks )
 			blocks = new_b;
 		return new_b;
@@ -223,7 +320,7 @@ DataBlock* Reassembler::AddAndCheck(DataBlock* b, uint64 seq, uint64 upper,
 		{
 		// The new block has a prefix that comes before b.
 		uint64 prefix_len = b->seq - seq;
-		new_b = new DataBlock(data, prefix_len, seq, b->prev, b);
+		new_b = NewDataBlock(data, prefix_len, seq, b->prev, b);
 		if ( b == blocks )
 			blocks = new_b;
 
@@ -284,6 +381,8 @@ bool Reassembler::DoUnserialize(UnserialInfo* info)
 	DO_UNSERIALIZE(BroObj);
 
 	blocks = last_block = 0;
+	block_map = 0;
+	num_blocks = 0;
 
 	int dummy; // For backwards compatibility.
 	if ( ! UNSERIALIZE(&trim_seq) || ! UNSERIALIZE(&dummy) )
@@ -293,3 +392,147 @@ bool Reassembler::DoUnserialize(UnserialInfo* info)
 
 	return  true;
 	}
+
+// A reassembler that delivers in-order data the same way TCP does, and
+// then throws it away.
+class BenchmarkReassembler : public Reassembler {
+public:
+	BenchmarkReassembler() : Reassembler(0, REASSEM_TCP)
+		{ delivered = overlaps = 0; }
+
+	uint64 delivered;
+	uint64 overlaps;
+
+protected:
+	void BlockInserted(DataBlock* start_block)
+		{
+		if ( start_block->seq > last_reassem_seq ||
+		     start_block->upper <= last_reassem_seq )
+			return;
+
+		for ( DataBlock* b = start_block;
+		      b && b->seq <= last_reassem_seq; b = b->next )
+			{
+			if ( b->upper > last_reassem_seq )
+				{
+				delivered += b->upper - last_reassem_seq;
+				last_reassem_seq = b->upper;
+				}
+			}
+
+		TrimToSeq(last_reassem_seq);
+		}
+
+	void Overlap(const u_char* b1, const u_char* b2, uint64 n)
+		{
+		++overlaps;
+		}
+};
+
+enum BenchmarkOrder {
+	ORDER_SEQUENTIAL,	// in order
+	ORDER_HOLES,		// every other segment first, then the rest
+	ORDER_REVERSE,		// backwards
+	ORDER_RANDOM,		// shuffled
+	ORDER_OVERLAP		// shuffled, each overlapping its successor
+};
+
+static double run_reassembler_benchmark(BenchmarkOrder order,
+					int num_segments, uint64* delivered)
+	{
+	const int seg_len = 100;
+	int* segs = new int[num_segments];
+	u_char* data = new u_char[(num_segments + 1) * seg_len];
+	memset(data, 0, (num_segments + 1) * seg_len);
+
+	int n = 0;
+
+	switch ( order ) {
+	case ORDER_SEQUENTIAL:
+	case ORDER_RANDOM:
+	case ORDER_OVERLAP:
+		for ( int i = 0; i < num_segments; ++i )
+			segs[n++] = i;
+		break;
+
+	case ORDER_HOLES:
+		for ( int i = 1; i < num_segments; i += 2 )
+			segs[n++] = i;
+		for ( int i = 0; i < num_segments; i += 2 )
+			segs[n++] = i;
+		break;
+
+	case ORDER_REVERSE:
+		for ( int i = num_segments - 1; i >= 0; --i )
+			segs[n++] = i;
+		break;
+	}
+
+	if ( order == ORDER_RANDOM || order == ORDER_OVERLAP )
+		{
+		// Fixed-seed xorshift, so that all runs see the same order.
+		uint32 r = 2463534242U;
+
+		for ( int i = num_segments - 1; i > 0; --i )
+			{
+			r ^= r << 13;
+			r ^= r >> 17;
+			r ^= r << 5;
+
+			int j = r % (i + 1);
+			int tmp = segs[i];
+			segs[i] = segs[j];
+			segs[j] = tmp;
+			}
+		}
+
+	int len = order == ORDER_OVERLAP ? 2 * seg_len : seg_len;
+
+	BenchmarkReassembler* r = new BenchmarkReassembler();
+	double start = current_time(true);
+
+	for ( int i = 0; i < num_segments; ++i )
+		{
+		uint64 seq = uint64(segs[i]) * seg_len;
+		r->NewBlock(0.0, seq, len, data + seq);
+		}
+
+	double elapsed = current_time(true) - start;
+
+	*delivered = r->delivered;
+
+	Unref(r);
+	delete [] data;
+	delete [] segs;
+
+	return elapsed;
+	}
+
+void reassembler_benchmark(int num_segments)
+	{
+	const char* names[] = {
+		"sequential", "holes", "reverse", "random", "overlap",
+	};
+
+	int threshold = block_index_threshold;
+
+	printf("%d segments\n", num_segments);
+
+	for ( int i = ORDER_SEQUENTIAL; i <= ORDER_OVERLAP; ++i )
+		{
+		uint64 delivered;
+		double elapsed[2];
+
+		// First walking the block list, then with the index.
+		block_index_threshold = INT_MAX;
+		elapsed[0] = run_reassembler_benchmark(BenchmarkOrder(i),
+							num_segments, &delivered);
+
+		block_index_threshold = threshold;
+		elapsed[1] = run_reassembler_benchmark(BenchmarkOrder(i),
+							num_segments, &delivered);
+
+		printf("%-10s  list %8.3fs  indexed %8.3fs  (%" PRIu64 " bytes)\n",
+			names[i], elapsed[0], elapsed[1], delivered);
+		}
+	}
@@ -3,6 +3,8 @@
 #ifndef reassem_h
 #define reassem_h
 
+#include <map>
+
 #include "Obj.h"
 #include "IPAddr.h"
 
@@ -13,6 +15,12 @@ public:
 
 	~DataBlock();
 
+	// A block's data lives right behind it in the same allocation;
+	// create blocks with "new (size) DataBlock(...)".
+	static void* operator new(size_t n, uint64 size);
+	static void operator delete(void* p, uint64 size);
+	static void operator delete(void* p);
+
 	uint64 Size() const	{ return upper - seq; }
 
 	DataBlock* next;	// next block with higher seq #
@@ -22,7 +30,7 @@ public:
 };
 
 
-enum ReassemblerType { REASSEM_IP, REASSEM_TCP };
+enum ReassemblerType { REASSEM_IP, REASSEM_TCP, REASSEM_FILE };
 
 class Reassembler : public BroObj {
 public:
@@ -52,7 +60,7 @@ public:
 	static uint64 TotalMemoryAllocation()	{ return total_size; }
 
 protected:
-	Reassembler()	{ }
+	Reassembler()	{ block_map = 0; num_blocks = 0; }
 
 	DECLARE_ABSTRACT_SERIAL(Reassembler);
 
@@ -66,18 +74,39 @@ protected:
 	DataBlock* AddAndCheck(DataBlock* b, uint64 seq,
 				uint64 upper, const u_char* data);
 
+	// Create a new block linked in between prev and next, and delete
+	// one that the caller has taken care of unlinking. These keep the
+	// block index up to date, so all blocks need to go through them.
+	DataBlock* NewDataBlock(const u_char* data, uint64 size, uint64 seq,
+				DataBlock* prev, DataBlock* next);
+	void DeleteBlock(DataBlock* b);
+
+	// Returns the first block starting at b that doesn't come
+	// completely before seq, or the last block if they all do.
+	DataBlock* FindBlock(DataBlock* b, uint64 seq) const;
+
 	DataBlock* blocks;
 	DataBlock* last_block;
 	uint64 last_reassem_seq;
 	uint64 trim_seq;	// how far we've trimmed
 
+	// The blocks by their starting sequence numbers, so that out-of-order
+	// data doesn't need a walk over the list to find its place. Only set
+	// up once there are enough blocks for that walk to get expensive.
+	typedef std::map<uint64, DataBlock*> BlockMap;
+	BlockMap* block_map;
+	int num_blocks;
+
 	static uint64 total_size;
 };
 
+// Runs pathological orders of segments through a reassembler and prints
+// how long each took.
+extern void reassembler_benchmark(int num_segments);
+
 inline DataBlock::~DataBlock()
 	{
 	Reassembler::total_size -= pad_size(upper - seq) + padded_sizeof(DataBlock);
-	delete [] block;
 	}
 
 #endif
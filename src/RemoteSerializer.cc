@@ -1,7 +1,10 @@
-// Processes involved in the communication:
+// Parties involved in the communication:
 //
 //	 (Local-Parent) <-> (Local-Child) <-> (Remote-Child) <-> (Remote-Parent)
 //
+// The parent is Bro's main thread and the child its communication thread
+// (see SocketComm), exchanging chunks through a pair of ChunkedIOQueues.
+//
 // Message types (for parent<->child communication the CMsg's peer indicates
 // about whom we're talking).
 //
@@ -171,6 +174,8 @@
 # endif
 #endif
 #include <sys/resource.h>
+#include <pthread.h>
+#include <openssl/crypto.h>
 
 #include <algorithm>
 #include <string>
@@ -194,10 +199,6 @@
 #include "logging/Manager.h"
 #include "logging/logging.bif.h"
 
-extern "C" {
-#include "setsignal.h"
-};
-
 // Gets incremented each time there's an incompatible change
 // to the communication internals.
 static const unsigned short PROTOCOL_VERSION = 0x07;
@@ -237,7 +238,10 @@ static const uint32 FINAL_SYNC_POINT = /* UINT32_MAX */ 4294967295U;
 
 // Buffer size for remote-print data
 static const int PRINT_BUFFER_SIZE = 10 * 1024;
-static const int SOCKBUF_SIZE = 1024 * 1024;
+
+// Seconds to wait for the communication thread to stop before giving up
+// on it.
+static const int STOP_TIMEOUT = 10;
 
 // Buffer size for remote-log data.
 static const int LOG_BUFFER_SIZE = 50 * 1024;
@@ -407,11 +411,19 @@ inline void RemoteSerializer::SetupSerialInfo(SerialInfo* info, Peer* peer)
 	info->include_locations = false;
 	}
 
+// The communication thread can't use the reporter. It reports failures
+// itself.
+static void send_warning(const char* msg, const char* err)
+	{
+	if ( ! SocketComm::InThread() )
+		reporter->Warning("%s: %s", msg, err);
+	}
+
 static bool sendToIO(ChunkedIO* io, ChunkedIO::Chunk* c)
 	{
 	if ( ! io->Write(c) )
 		{
-		reporter->Warning("can't send chunk: %s", io->Error());
+		send_warning("can't send chunk", io->Error());
 		return false;
 		}
 
@@ -423,7 +435,7 @@ static bool sendToIO(ChunkedIO* io, char msg_type, RemoteSerializer::PeerID id,
 	{
 	if ( ! sendCMsg(io, msg_type, id) )
 		{
-		reporter->Warning("can't send message of type %d: %s", msg_type, io->Error());
+		send_warning(fmt("can't send message of type %d", msg_type), io->Error());
 		return false;
 		}
 
@@ -443,7 +455,7 @@ static bool sendToIO(ChunkedIO* io, char msg_type, RemoteSerializer::PeerID id,
 	{
 	if ( ! sendCMsg(io, msg_type, id) )
 		{
-		reporter->Warning("can't send message of type %d: %s", msg_type, io->Error());
+		send_warning(fmt("can't send message of type %d", msg_type), io->Error());
 		return false;
 		}
 
@@ -463,7 +475,7 @@ static bool sendToIO(ChunkedIO* io, char msg_type, RemoteSerializer::PeerID id,
 #ifdef DEBUG
 static inline char* fmt_uint32s(int nargs, va_list ap)
 	{
-	static char buf[512];
+	static __thread char buf[512];
 	char* p = buf;
 	*p = '\0';
 	for ( int i = 0; i < nargs; i++ )
@@ -474,8 +486,6 @@ static inline char* fmt_uint32s(int nargs, va_list ap)
 	}
 #endif
 
-static pid_t child_pid = 0;
-
 // Return true if message type is sent by a peer (rather than the child
 // process itself).
 static inline bool is_peer_msg(int msg)
@@ -542,19 +552,12 @@ RemoteSerializer::RemoteSerializer()
 	current_msgtype = 0;
 	current_args = 0;
 	source_peer = 0;
+	comm = 0;
 	}
 
 RemoteSerializer::~RemoteSerializer()
 	{
-	if ( child_pid )
-		{
-		if ( kill(child_pid, SIGKILL) < 0 )
-			reporter->Warning("warning: cannot kill child (pid %d), %s", child_pid, strerror(errno));
-
-		else if ( waitpid(child_pid, 0, 0) < 0 )
-			reporter->Warning("warning: error encountered during waitpid(%d), %s", child_pid, strerror(errno));
-		}
-
+	// The threading::Manager stops and deletes the thread itself.
 	delete io;
 	}
 
@@ -569,120 +572,74 @@ void RemoteSerializer::Enable()
 		return;
 		}
 
-	Fork();
+	StartComm();
 
 	iosource_mgr->Register(this);
 
-	Log(LogInfo, fmt("communication started, parent pid is %d, child pid is %d", getpid(), child_pid));
+	Log(LogInfo, "communication started");
 	initialized = 1;
 	}
 
-void RemoteSerializer::SetSocketBufferSize(int fd, int opt, const char *what, int size, int verbose)
-	{
-	int defsize = 0;
-	socklen_t len = sizeof(defsize);
-
-	if ( getsockopt(fd, SOL_SOCKET, opt, (void *)&defsize, &len) < 0 )
-		{
-		if ( verbose )
-			Log(LogInfo, fmt("warning: cannot get socket buffer size (%s): %s", what, strerror(errno)));
-		return;
-		}
-
-	for ( int trysize = size; trysize > defsize; trysize -= 1024 )
-		{
-		if ( setsockopt(fd, SOL_SOCKET, opt, &trysize, sizeof(trysize)) >= 0 )
-			{
-			if ( verbose )
-			    {
-			    if ( trysize == size )
-				    Log(LogInfo, fmt("raised pipe's socket buffer size from %dK to %dK", defsize / 1024, trysize / 1024));
-			    else
-				    Log(LogInfo, fmt("raised pipe's socket buffer size from %dK to %dK (%dK was requested)", defsize / 1024, trysize / 1024, size / 1024));
-			    }
-			return;
-			}
-		}
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+// Older OpenSSL versions need these to be used by more than one thread,
+// as both the main thread and the communication thread may call into it.
+static pthread_mutex_t* openssl_locks = 0;
 
-	Log(LogInfo, fmt("warning: cannot increase %s socket buffer size from %dK (%dK was requested)", what, defsize / 1024, size / 1024));
+static void openssl_locking_callback(int mode, int n, const char* file,
+                                     int line)
+	{
+	if ( mode & CRYPTO_LOCK )
+		pthread_mutex_lock(&openssl_locks[n]);
+	else
+		pthread_mutex_unlock(&openssl_locks[n]);
 	}
 
-void RemoteSerializer::Fork()
+static unsigned long openssl_id_callback()
 	{
-	if ( child_pid )
-		return;
-
-	// If we are re-forking, remove old entries
-	loop_over_list(peers, i)
-		RemovePeer(peers[i]);
-
-	// Create pipe for communication between parent and child.
-	int pipe[2];
+	return (unsigned long) pthread_self();
+	}
 
-	if ( socketpair(AF_UNIX, SOCK_STREAM, 0, pipe) < 0 )
-		{
-		Error(fmt("can't create pipe: %s", strerror(errno)));
+static void init_openssl_locks()
+	{
+	if ( openssl_locks || CRYPTO_get_locking_callback() )
 		return;
-		}
 
-	// Try to increase the size of the socket send and receive buffers.
-	SetSocketBufferSize(pipe[0], SO_SNDBUF, "SO_SNDBUF", SOCKBUF_SIZE, 1);
-	SetSocketBufferSize(pipe[0], SO_RCVBUF, "SO_RCVBUF", SOCKBUF_SIZE, 0);
-	SetSocketBufferSize(pipe[1], SO_SNDBUF, "SO_SNDBUF", SOCKBUF_SIZE, 0);
-	SetSocketBufferSize(pipe[1], SO_RCVBUF, "SO_RCVBUF", SOCKBUF_SIZE, 0);
+	openssl_locks = new pthread_mutex_t[CRYPTO_num_locks()];
 
-	child_pid = 0;
+	for ( int i = 0; i < CRYPTO_num_locks(); ++i )
+		pthread_mutex_init(&openssl_locks[i], 0);
 
-	int pid = fork();
+	CRYPTO_set_id_callback(openssl_id_callback);
+	CRYPTO_set_locking_callback(openssl_locking_callback);
+	}
+#endif
 
-	if ( pid < 0 )
-		{
-		Error(fmt("can't fork: %s", strerror(errno)));
+void RemoteSerializer::StartComm()
+	{
+	if ( comm )
 		return;
-		}
-
-	if ( pid > 0 )
-		{
-		// Parent
-		child_pid = pid;
-
-		io = new ChunkedIOFd(pipe[0], "parent->child", child_pid);
-		if ( ! io->Init() )
-			{
-			Error(fmt("can't init child io: %s", io->Error()));
-			exit(1); // FIXME: Better way to handle this?
-			}
-
-		safe_close(pipe[1]);
 
-		return;
-		}
-	else
-		{ // child
-		SocketComm child;
+	// If we are restarting, remove old entries
+	loop_over_list(peers, i)
+		RemovePeer(peers[i]);
 
-		ChunkedIOFd* io =
-			new ChunkedIOFd(pipe[1], "child->parent", getppid());
-		if ( ! io->Init() )
-			{
-			Error(fmt("can't init parent io: %s", io->Error()));
-			exit(1);
-			}
+	delete io;
+	io = 0;
 
-		child.SetParentIO(io);
-		safe_close(pipe[0]);
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+	init_openssl_locks();
+#endif
 
-		// Close file descriptors.
-		safe_close(0);
-		safe_close(1);
-		safe_close(2);
+	comm = new SocketComm();
 
-		// Be nice.
-		setpriority(PRIO_PROCESS, 0, 5);
+	ChunkedIOQueue* parent_io;
+	ChunkedIOQueue* child_io;
+	ChunkedIOQueue::CreatePair("parent<->child", &parent_io, 0,
+	                           &child_io, comm);
 
-		child.Run();
-		reporter->InternalError("cannot be reached");
-		}
+	io = parent_io;
+	comm->SetParentIO(child_io);
+	comm->Start();
 	}
 
 RemoteSerializer::PeerID RemoteSerializer::Connect(const IPAddr& ip,
@@ -695,8 +652,8 @@ RemoteSerializer::PeerID RemoteSerializer::Connect(const IPAddr& ip,
 	if ( ! initialized )
 		reporter->InternalError("remote serializer not initialized");
 
-	if ( ! child_pid )
-		Fork();
+	if ( ! comm )
+		StartComm();
 
 	Peer* p = AddPeer(ip, port);
 	p->orig = true;
@@ -1498,7 +1455,7 @@ void RemoteSerializer::Finish()
 
 bool RemoteSerializer::Poll(bool may_block)
 	{
-	if ( ! child_pid )
+	if ( ! comm )
 		return true;
 
 	// See if there's any peer waiting for initial state synchronization.
@@ -1804,11 +1761,11 @@ void RemoteSerializer::PeerConnected(Peer* peer)
 RecordVal* RemoteSerializer::MakePeerVal(Peer* peer)
 	{
 	RecordVal* v = new RecordVal(::peer);
-	v->Assign(0, new Val(uint32(peer->id), TYPE_COUNT));
+	v->Assign(0, val_mgr->GetCount(uint32(peer->id)));
 	// Sic! Network order for AddrVal, host order for PortVal.
 	v->Assign(1, new AddrVal(peer->ip));
-	v->Assign(2, new PortVal(peer->port, TRANSPORT_TCP));
-	v->Assign(3, new Val(false, TYPE_BOOL));
+	v->Assign(2, val_mgr->GetPort(peer->port, TRANSPORT_TCP));
+	v->Assign(3, val_mgr->GetBool(false));
 	v->Assign(4, new StringVal(""));	// set when received
 	v->Assign(5, peer->peer_class.size() ?
 			new StringVal(peer->peer_class.c_str()) : 0);
@@ -2260,7 +2217,7 @@ bool RemoteSerializer::ProcessPongMsg()
 
 	val_list* vl = new val_list;
 	vl->append(current_peer->val->Ref());
-	vl->append(new Val((unsigned int) ntohl(args->seq), TYPE_COUNT));
+	vl->append(val_mgr->GetCount((unsigned int) ntohl(args->seq)));
 	vl->append(new Val(current_time(true) - ntohd(args->time1),
 				TYPE_INTERVAL));
 	vl->append(new Val(ntohd(args->time2), TYPE_INTERVAL));
@@ -3006,16 +2963,16 @@ void RemoteSerializer::Log(LogLevel level, const char* msg, Peer* peer,
 		{
 		val_list* vl = new val_list();
 		vl->append(peer->val->Ref());
-		vl->append(new Val(level, TYPE_COUNT));
-		vl->append(new Val(src, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(level));
+		vl->append(val_mgr->GetCount(src));
 		vl->append(new StringVal(msg));
 		mgr.QueueEvent(remote_log_peer, vl);
 		}
 	else
 		{
 		val_list* vl = new val_list();
-		vl->append(new Val(level, TYPE_COUNT));
-		vl->append(new Val(src, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(level));
+		vl->append(val_mgr->GetCount(src));
 		vl->append(new StringVal(msg));
 		mgr.QueueEvent(remote_log, vl);
 		}
@@ -3088,7 +3045,7 @@ void RemoteSerializer::ChildDied()
 	{
 	Log(LogError, "child died");
 	SetClosed(true);
-	child_pid = 0;
+	comm = 0;
 
 	// Shut down the main process as well.
 	terminate_processing();
@@ -3110,7 +3067,7 @@ bool RemoteSerializer::SendToChild(char type, Peer* peer, char* str, int len,
 	{
 	DEBUG_COMM(fmt("parent: (->child) %s (#%" PRI_SOURCE_ID ", %s)", msgToStr(type), peer ? peer->id : PEER_NONE, str));
 
-	if ( child_pid && sendToIO(io, type, peer ? peer->id : PEER_NONE, str, len,
+	if ( comm && sendToIO(io, type, peer ? peer->id : PEER_NONE, str, len,
 	                           delete_with_free) )
 		return true;
 
@@ -3119,7 +3076,7 @@ bool RemoteSerializer::SendToChild(char type, Peer* peer, char* str, int len,
 	else
 		delete [] str;
 
-	if ( ! child_pid )
+	if ( ! comm )
 		return false;
 
 	if ( io->Eof() )
@@ -3140,7 +3097,7 @@ bool RemoteSerializer::SendToChild(char type, Peer* peer, int nargs, ...)
 	va_end(ap);
 #endif
 
-	if ( child_pid )
+	if ( comm )
 		{
 		va_start(ap, nargs);
 		bool ret = sendToIO(io, type, peer ? peer->id : PEER_NONE, nargs, ap);
@@ -3150,7 +3107,7 @@ bool RemoteSerializer::SendToChild(char type, Peer* peer, int nargs, ...)
 			return true;
 		}
 
-	if ( ! child_pid )
+	if ( ! comm )
 		return false;
 
 	if ( io->Eof() )
@@ -3164,13 +3121,13 @@ bool RemoteSerializer::SendToChild(ChunkedIO::Chunk* c)
 	{
 	DEBUG_COMM(fmt("parent: (->child) chunk of size %d", c->len));
 
-	if ( child_pid && sendToIO(io, c) )
+	if ( comm && sendToIO(io, c) )
 		return true;
 
 	c->free_func(c->data);
 	c->data = 0;
 
-	if ( ! child_pid )
+	if ( ! comm )
 		return false;
 
 	if ( io->Eof() )
@@ -3188,10 +3145,10 @@ void RemoteSerializer::FatalError(const char* msg)
 
 	SetClosed(true);
 
-	if ( kill(child_pid, SIGQUIT) < 0 )
-		reporter->Warning("warning: cannot kill child pid %d, %s", child_pid, strerror(errno));
+	if ( comm )
+		comm->SignalStop();
 
-	child_pid = 0;
+	comm = 0;
 	using_communication = false;
 	io->Clear();
 
@@ -3291,27 +3248,16 @@ void RemoteSerializer::ReadDumpAsSerialization(const char* file)
 
 ////////////////////////////
 
-// If true (set by signal handler), we will log some stats to parent.
-static bool log_stats = false;
-static bool log_prof = false;
-
 // How often stats are sent (in seconds).
 // Perhaps we should make this configurable...
 const int STATS_INTERVAL = 60;
 
-static RETSIGTYPE sig_handler_log(int signo)
-	{
-	// SIGALRM is the only one we get.
-	log_stats = true;
-	}
-
-static RETSIGTYPE sig_handler_prof(int signo)
-	{
-	log_prof = true;
-	}
+__thread bool SocketComm::in_thread = false;
 
 SocketComm::SocketComm()
 	{
+	SetName("comm");
+
 	io = 0;
 
 	// We start the ID counter high so that IDs assigned by us
@@ -3331,19 +3277,10 @@ SocketComm::SocketComm()
 	enable_ipv6 = false;
 	bind_retry_interval = 0;
 	listen_next_try = 0;
+	next_stats = 0;
 
-	// We don't want to use the signal handlers of our parent.
-	(void) setsignal(SIGTERM, SIG_DFL);
-	(void) setsignal(SIGINT, SIG_DFL);
-	(void) setsignal(SIGUSR1, SIG_DFL);
-	(void) setsignal(SIGUSR2, SIG_DFL);
-	(void) setsignal(SIGCONT, SIG_DFL);
-	(void) setsignal(SIGCHLD, SIG_DFL);
-
-	// Raping SIGPROF for profiling
-	(void) setsignal(SIGPROF, sig_handler_prof);
-	(void) setsignal(SIGALRM, sig_handler_log);
-	alarm(STATS_INTERVAL);
+	stop = false;
+	finished = false;
 	}
 
 SocketComm::~SocketComm()
@@ -3355,6 +3292,34 @@ SocketComm::~SocketComm()
 	CloseListenFDs();
 	}
 
+void SocketComm::OnSignalStop()
+	{
+	__atomic_store_n(&stop, true, __ATOMIC_SEQ_CST);
+
+	// Interrupt the select().
+	stop_flare.Fire();
+	}
+
+void SocketComm::OnWaitForStop()
+	{
+	for ( int i = 0; i < STOP_TIMEOUT * 1000; ++i )
+		{
+		if ( __atomic_load_n(&finished, __ATOMIC_SEQ_CST) )
+			return;
+
+		usleep(1000);
+		}
+
+	reporter->Warning("communication thread did not stop within %d seconds",
+			  STOP_TIMEOUT);
+	Kill();
+	}
+
+void SocketComm::OnKill()
+	{
+	OnSignalStop();
+	}
+
 static unsigned int first_rtime = 0;
 
 static void fd_vector_set(const std::vector<int>& fds, fd_set* set, int* max)
@@ -3368,12 +3333,18 @@ static void fd_vector_set(const std::vector<int>& fds, fd_set* set, int* max)
 
 void SocketComm::Run()
 	{
+	in_thread = true;
 	first_rtime = (unsigned int) current_time(true);
+	next_stats = time(0) + STATS_INTERVAL;
+
+#ifdef HAVE_LINUX
+	// Be nice. On Linux, this applies to just the calling thread.
+	setpriority(PRIO_PROCESS, 0, 5);
+#endif
 
-	while ( true )
+	while ( ! __atomic_load_n(&stop, __ATOMIC_SEQ_CST) )
 		{
-		// Logging signaled?
-		if ( log_stats )
+		if ( time(0) >= next_stats )
 			LogStats();
 
 		// Termination signaled
@@ -3391,6 +3362,13 @@ void SocketComm::Run()
 		FD_SET(io->Fd(), &fd_read);
 		max_fd = std::max(max_fd, io->ExtraReadFDs().Set(&fd_read));
 
+		FD_SET(stop_flare.FD(), &fd_read);
+		max_fd = std::max(max_fd, stop_flare.FD());
+
+		// Wake up for the next stats, or the next retry of a
+		// connection or a bind.
+		time_t next_wakeup = next_stats;
+
 		loop_over_list(peers, i)
 			{
 			if ( peers[i]->connected )
@@ -3407,12 +3385,18 @@ void SocketComm::Run()
 				     time(0) > peers[i]->next_try )
 					// Try reconnect.
 					Connect(peers[i]);
+
+				if ( peers[i]->next_try > 0 )
+					next_wakeup = std::min(next_wakeup, peers[i]->next_try + 1);
 				}
 			}
 
 		if ( listen_next_try && time(0) > listen_next_try  )
 			Listen();
 
+		if ( listen_next_try )
+			next_wakeup = std::min(next_wakeup, listen_next_try + 1);
+
 		for ( size_t i = 0; i < listen_fds.size(); ++i )
 			{
 			FD_SET(listen_fds[i], &fd_read);
@@ -3457,7 +3441,11 @@ void SocketComm::Run()
 		if ( io->CanWrite() )
 			++canwrites;
 
-		int a = select(max_fd + 1, &fd_read, &fd_write, &fd_except, 0);
+		struct timeval timeout;
+		timeout.tv_sec = std::max(next_wakeup - time(0), time_t(0));
+		timeout.tv_usec = 0;
+
+		int a = select(max_fd + 1, &fd_read, &fd_write, &fd_except, &timeout);
 
 		if ( selects % 100000 == 0 )
 			Log(fmt("selects=%ld canwrites=%ld", selects, canwrites));
@@ -3488,19 +3476,21 @@ void SocketComm::Run()
 		for ( size_t i = 0; i < listen_fds.size(); ++i )
 			if ( FD_ISSET(listen_fds[i], &fd_read) )
 				AcceptConnection(listen_fds[i]);
+		}
 
-		// Hack to display CPU usage of the child, triggered via
-		// SIGPROF.
-		static unsigned int first_rtime = 0;
-		if ( first_rtime == 0 )
-			first_rtime = (unsigned int) current_time(true);
-
-		if ( log_prof )
-			{
-			LogProf();
-			log_prof = false;
-			}
+	// Let the parent see EOF once it has read everything we sent.
+	loop_over_list(peers, i)
+		{
+		delete peers[i]->io;
+		peers[i]->io = 0;
 		}
+
+	delete io;
+	io = 0;
+
+	CloseListenFDs();
+
+	__atomic_store_n(&finished, true, __ATOMIC_SEQ_CST);
 	}
 
 bool SocketComm::ProcessParentMessage()
@@ -4018,7 +4008,7 @@ bool SocketComm::Connect(Peer* peer)
 			continue;
 			}
 
-		if ( connect(sockfd, res->ai_addr, res->ai_addrlen) < 0 )
+		if ( ! ConnectSocket(sockfd, res->ai_addr, res->ai_addrlen) )
 			{
 			Error(fmt("connect failed: %s", strerror(errno)), peer);
 			safe_close(sockfd);
@@ -4085,6 +4075,66 @@ bool SocketComm::Connect(Peer* peer)
 	return connected;
 	}
 
+bool SocketComm::ConnectSocket(int fd, const sockaddr* addr, socklen_t len)
+	{
+	// A peer that doesn't answer would block connect() for minutes,
+	// keeping us from noticing that we're supposed to stop. So we
+	// connect in non-blocking mode and wait for the outcome along with
+	// the stop flare.
+	int flags = fcntl(fd, F_GETFL, 0);
+
+	if ( flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0 )
+		return false;
+
+	if ( connect(fd, addr, len) < 0 )
+		{
+		if ( errno != EINPROGRESS )
+			return false;
+
+		while ( true )
+			{
+			if ( __atomic_load_n(&stop, __ATOMIC_SEQ_CST) )
+				{
+				errno = EINTR;
+				return false;
+				}
+
+			fd_set fd_read, fd_write;
+			FD_ZERO(&fd_read);
+			FD_ZERO(&fd_write);
+			FD_SET(stop_flare.FD(), &fd_read);
+			FD_SET(fd, &fd_write);
+
+			int max_fd = std::max(fd, stop_flare.FD());
+
+			if ( select(max_fd + 1, &fd_read, &fd_write, 0, 0) < 0 )
+				{
+				if ( errno == EINTR )
+					continue;
+
+				return false;
+				}
+
+			if ( FD_ISSET(fd, &fd_write) )
+				break;
+			}
+
+		int err = 0;
+		socklen_t errlen = sizeof(err);
+
+		if ( getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errlen) < 0 )
+			return false;
+
+		if ( err )
+			{
+			errno = err;
+			return false;
+			}
+		}
+
+	return fcntl(fd, F_SETFL, flags) >= 0;
+	}
+
 bool SocketComm::CloseConnection(Peer* peer, bool reconnect)
 	{
 	if ( ! SendToParent(MSG_CLOSE, peer, 0) )
@@ -4333,7 +4383,7 @@ void SocketComm::Error(const char* msg, bool kill_me)
 	if ( kill_me )
 		{
 		fprintf(stderr, "fatal error in child: %s\n", msg);
-		Kill();
+		Die();
 		}
 	else
 		{
@@ -4371,10 +4421,10 @@ void SocketComm::Log(const char* msg, Peer* peer)
 void SocketComm::InternalError(const char* msg)
 	{
 	fprintf(stderr, "internal error in child: %s\n", msg);
-	Kill();
+	Die();
 	}
 
-void SocketComm::Kill()
+void SocketComm::Die()
 	{
 	if ( killing )
 		// Ignore recursive calls.
@@ -4387,11 +4437,14 @@ void SocketComm::Kill()
 
 	CloseListenFDs();
 
-	if ( kill(getpid(), SIGTERM) < 0 )
-		Log(fmt("warning: cannot kill SocketComm pid %d, %s", getpid(), strerror(errno)));
+	// Once our end of the queue is gone, the parent sees EOF and shuts
+	// down.
+	delete io;
+	io = 0;
 
-	while ( 1 )
-		; // loop until killed
+	__atomic_store_n(&finished, true, __ATOMIC_SEQ_CST);
+	Done();
+	pthread_exit(0);
 	}
 
 SocketComm::Peer* SocketComm::LookupPeer(RemoteSerializer::PeerID id,
@@ -4407,7 +4460,10 @@ SocketComm::Peer* SocketComm::LookupPeer(RemoteSerializer::PeerID id,
 bool SocketComm::LogStats()
 	{
 	if ( ! peers.length() )
+		{
+		next_stats = time(0) + STATS_INTERVAL;
 		return true;
+		}
 
 	// Concat stats of all peers into single buffer.
 	char* buffer = new char[peers.length() * 512];
@@ -4422,19 +4478,20 @@ bool SocketComm::LogStats()
 		pos += strlen(buffer+pos) + 1;
 		}
 
-	// Send it.
-	if ( ! SendToParent(MSG_STATS, 0, buffer, pos) )
-		return false;
+	next_stats = time(0) + STATS_INTERVAL;
 
-	log_stats = false;
-	alarm(STATS_INTERVAL);
-	return true;
+	// Send it.
+	return SendToParent(MSG_STATS, 0, buffer, pos);
 	}
 
 bool SocketComm::LogProf()
 	{
 	static struct rusage cld_res;
+#ifdef RUSAGE_THREAD
+	getrusage(RUSAGE_THREAD, &cld_res);
+#else
 	getrusage(RUSAGE_SELF, &cld_res);
+#endif
 
 	double Utime = cld_res.ru_utime.tv_sec + cld_res.ru_utime.tv_usec / 1e6;
 	double Stime = cld_res.ru_stime.tv_sec + cld_res.ru_stime.tv_usec / 1e6;
@@ -10,11 +10,15 @@
 #include "Stats.h"
 #include "File.h"
 #include "logging/WriterBackend.h"
+#include "Flare.h"
+#include "threading/BasicThread.h"
 
+#include <sys/socket.h>
 #include <vector>
 #include <string>
 
 class IncrementalSendTimer;
+class SocketComm;
 
 namespace threading {
 	struct Field;
@@ -27,7 +31,8 @@ public:
 	RemoteSerializer();
 	virtual ~RemoteSerializer();
 
-	// Initialize the remote serializer (calling this will fork).
+	// Initialize the remote serializer (calling this will start the
+	// communication thread).
 	void Enable();
 
 	// FIXME: Use SourceID directly (or rename everything to Peer*).
@@ -258,7 +263,8 @@ protected:
 	virtual void GotConnection(Connection* c);
 	virtual void GotPacket(Packet* packet);
 
-	void Fork();
+	// Starts the communication thread.
+	void StartComm();
 
 	bool DoMessage();
 	bool ProcessConnected();
@@ -323,8 +329,6 @@ protected:
 	bool SendToChild(char type, Peer* peer, int nargs, ...); // can send uints32 only
 	bool SendToChild(ChunkedIO::Chunk* c);
 
-	void SetSocketBufferSize(int fd, int opt, const char *what, int size, int verbose);
-
 private:
 	enum { TYPE, ARGS } msgstate;	// current state of reading comm.
 	Peer* current_peer;
@@ -347,6 +351,10 @@ private:
 	uint32 current_sync_point;
 	bool syncing_times;
 
+	// The communication thread, or null if it isn't running. It's owned
+	// by the threading::Manager.
+	SocketComm* comm;
+
 	declare(PList, Peer);
 	typedef PList(Peer) peer_list;
 	peer_list peers;
@@ -393,23 +401,35 @@ private:
 
 };
 
-// This class handles the communication done in the forked child.
-class SocketComm {
+// This class handles the communication done in the child, a thread that
+// exchanges chunks with the main thread through a pair of ChunkedIOQueues.
+// Other than through those, it must not touch any of the main thread's
+// state.
+class SocketComm : public threading::BasicThread {
 public:
 	SocketComm();
-	~SocketComm();
+	virtual ~SocketComm();
 
+	// Must be called before Start(). We take ownership.
 	void SetParentIO(ChunkedIO* arg_io)	{ io = arg_io; }
 
-	void Run();	// does not return
-
-	// Log some statistics (via pipe to parent).
+	// Log some statistics (via queue to parent).
 	bool LogStats();
 
-	// Log CPU usage (again via pipe to parent).
+	// Log CPU usage (again via queue to parent).
 	bool LogProf();
 
+	// True if the caller is running on a communication thread. Code
+	// shared with the main thread must not touch any of Bro's global
+	// state then, like the reporter.
+	static bool InThread()	{ return in_thread; }
+
 protected:
+	virtual void Run();
+	virtual void OnSignalStop();
+	virtual void OnWaitForStop();
+	virtual void OnKill();
+
 	struct Peer {
 		Peer()
 			{
@@ -443,6 +463,7 @@ protected:
 	bool Listen();
 	bool AcceptConnection(int listen_fd);
 	bool Connect(Peer* peer);
+	bool ConnectSocket(int fd, const sockaddr* addr, socklen_t len);
 	bool CloseConnection(Peer* peer, bool reconnect);
 
 	Peer* LookupPeer(RemoteSerializer::PeerID id, bool only_if_connected);
@@ -463,13 +484,13 @@ protected:
 	// If kill is true, this is a fatal error and we kill ourselves.
 	void Error(const char* msg, bool kill = false);
 
-	// Kill the current process.
-	void Kill();
+	// Terminates the thread; does not return.
+	void Die();
 
 	// Check whether everything has been sent out.
 	void CheckFinished();
 
-	// Reports the error and terminates the process.
+	// Reports the error and terminates the thread.
 	void InternalError(const char* msg);
 
 	// Communication helpers.
@@ -518,6 +539,13 @@ protected:
 	bool shutting_conns_down;
 	bool terminating;
 	bool killing;
+	time_t next_stats;	// time at which to send the next stats
+
+	bool stop;	// set by the main thread to make Run() return
+	bool finished;	// set once Run() is done
+	bro::Flare stop_flare;	// fired along with setting stop
+
+	static __thread bool in_thread;
 };
 
 extern RemoteSerializer* remote_serializer;
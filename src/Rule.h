@@ -29,6 +29,7 @@ public:
 		location = arg_location;
 		active = true;
 		next = 0;
+		memset(&profile, 0, sizeof(profile));
 		}
 
 	~Rule();
@@ -110,6 +111,16 @@ private:
 
 	Location location;
 
+	// Counters for profiling (see RuleMatcher::GetRuleStats()).
+	struct Profile {
+		uint64 pattern_matches;	// # endpoints where all patterns matched
+		uint64 matches;		// # times the actions got executed
+		uint64 cond_evals;	// # evaluations of the other conditions
+		double cond_time;	// time spent on those (--rule-profile only)
+	};
+
+	Profile profile;
+
 	// Rules and payloads are numbered individually.
 	static unsigned int rule_counter;
 	static unsigned int pattern_counter;
@@ -5,6 +5,7 @@
 
 #include "analyzer/Analyzer.h"
 #include "RuleMatcher.h"
+#include "LiteralMatcher.h"
 #include "DFA.h"
 #include "NetVar.h"
 #include "Scope.h"
@@ -40,6 +41,7 @@ RuleHdrTest::RuleHdrTest(Prot arg_prot, uint32 arg_offset, uint32 arg_size,
 	ruleset = new IntSet;
 	id = ++idcounter;
 	level = 0;
+	evals = 0;
 	}
 
 RuleHdrTest::RuleHdrTest(Prot arg_prot, Comp arg_comp, vector<IPPrefix> arg_v)
@@ -57,6 +59,7 @@ RuleHdrTest::RuleHdrTest(Prot arg_prot, Comp arg_comp, vector<IPPrefix> arg_v)
 	ruleset = new IntSet;
 	id = ++idcounter;
 	level = 0;
+	evals = 0;
 	}
 
 Val* RuleMatcher::BuildRuleStateValue(const Rule* rule,
@@ -65,8 +68,8 @@ Val* RuleMatcher::BuildRuleStateValue(const Rule* rule,
 	RecordVal* val = new RecordVal(signature_state);
 	val->Assign(0, new StringVal(rule->ID()));
 	val->Assign(1, state->GetAnalyzer()->BuildConnVal());
-	val->Assign(2, new Val(state->is_orig, TYPE_BOOL));
-	val->Assign(3, new Val(state->payload_size, TYPE_COUNT));
+	val->Assign(2, val_mgr->GetBool(state->is_orig));
+	val->Assign(3, val_mgr->GetCount(state->payload_size));
 	return val;
 	}
 
@@ -106,6 +109,7 @@ RuleHdrTest::RuleHdrTest(RuleHdrTest& h)
 	ruleset = new IntSet;
 	id = ++idcounter;
 	level = 0;
+	evals = 0;
 	}
 
 RuleHdrTest::~RuleHdrTest()
@@ -172,6 +176,14 @@ RuleEndpointState::RuleEndpointState(analyzer::Analyzer* arg_analyzer, bool arg_
 		opposite->opposite = this;
 
 	pia = arg_PIA;
+
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		{
+		prefilters[i].state = 0;
+		prefilters[i].dormant = 0;
+		prefilters[i].buffered = false;
+		prefilters[i].bol = false;
+		}
 	}
 
 RuleEndpointState::~RuleEndpointState()
@@ -200,6 +212,12 @@ RuleMatcher::RuleMatcher(int arg_RE_level)
 	root = new RuleHdrTest(RuleHdrTest::NOPROT, 0, 0, RuleHdrTest::EQ,
 				new maskedvalue_list);
 	RE_level = arg_RE_level;
+
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		{
+		literal_matchers[i] = new Literal_Matcher;
+		num_prefiltered[i] = 0;
+		}
 	}
 
 RuleMatcher::~RuleMatcher()
@@ -211,6 +229,9 @@ RuleMatcher::~RuleMatcher()
 
 	loop_over_list(rules, i)
 		delete rules[i];
+
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		delete literal_matchers[i];
 	}
 
 void RuleMatcher::Delete(RuleHdrTest* node)
@@ -258,6 +279,9 @@ bool RuleMatcher::ReadFiles(const name_list& files)
 	int_list ids[Rule::TYPES];
 	BuildRegEx(root, exprs, ids);
 
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		literal_matchers[i]->Compile();
+
 	return ! parse_error;
 	}
 
@@ -358,7 +382,8 @@ void RuleMatcher::BuildRegEx(RuleHdrTest* hdr_test, string_list* exprs,
 		{
 		for ( int i = 0; i < Rule::TYPES; ++i )
 			if ( exprs[i].length() )
-				BuildPatternSets(&hdr_test->psets[i], exprs[i], ids[i]);
+				BuildPatternSets(&hdr_test->psets[i], exprs[i], ids[i],
+						 (Rule::PatternType) i);
 		}
 
 	// Get the patterns on all of our children.
@@ -385,17 +410,79 @@ void RuleMatcher::BuildRegEx(RuleHdrTest* hdr_test, string_list* exprs,
 		{
 		for ( int i = 0; i < Rule::TYPES; ++i )
 			if ( exprs[i].length() )
-				BuildPatternSets(&hdr_test->psets[i], exprs[i], ids[i]);
+				BuildPatternSets(&hdr_test->psets[i], exprs[i], ids[i],
+						 (Rule::PatternType) i);
 		}
 
 	// If we're below the RE_level, the regexprs remains empty.
 	}
 
 void RuleMatcher::BuildPatternSets(RuleHdrTest::pattern_set_list* dst,
-				const string_list& exprs, const int_list& ids)
+				const string_list& exprs, const int_list& ids,
+				Rule::PatternType type)
 	{
 	assert(exprs.length() == ids.length());
 
+	// Patterns requiring a literal go into groups of their own, so
+	// that those groups can be prefiltered. We don't do that for file
+	// magic, which isn't matched per endpoint.
+	string_list prefiltered_exprs;
+	int_list prefiltered_ids;
+	vector<vector<string> > literals;
+
+	string_list other_exprs;
+	int_list other_ids;
+
+	loop_over_list(exprs, i)
+		{
+		vector<string> lits;
+		bool prefilter = sig_prefilter_buffer > 0 &&
+				 type != Rule::FILE_MAGIC &&
+				 Literal_Matcher::RequiredLiterals(exprs[i], &lits);
+
+		// Very short literals wouldn't filter out much.
+		for ( size_t j = 0; j < lits.size(); ++j )
+			if ( lits[j].size() < 2 )
+				prefilter = false;
+
+		if ( prefilter )
+			{
+			prefiltered_exprs.append(exprs[i]);
+			prefiltered_ids.append(ids[i]);
+			literals.push_back(lits);
+			}
+		else
+			{
+			other_exprs.append(exprs[i]);
+			other_ids.append(ids[i]);
+			}
+		}
+
+	int first = dst->length();
+
+	BuildPatternGroups(dst, prefiltered_exprs, prefiltered_ids);
+
+	// Register the literals of the new groups with the prefilter.
+	for ( int i = first, k = 0; i < dst->length(); ++i )
+		{
+		RuleHdrTest::PatternSet* set = (*dst)[i];
+		set->prefilter_id = num_prefiltered[type]++;
+
+		for ( int j = 0; j < set->patterns.length(); ++j, ++k )
+			for ( size_t l = 0; l < literals[k].size(); ++l )
+				literal_matchers[type]->Add(literals[k][l],
+							    set->prefilter_id);
+		}
+
+	BuildPatternGroups(dst, other_exprs, other_ids);
+	}
+
+void RuleMatcher::BuildPatternGroups(RuleHdrTest::pattern_set_list* dst,
+				const string_list& exprs, const int_list& ids)
+	{
+	if ( ! exprs.length() )
+		return;
+
 	// We build groups of at most sig_max_group_size regexps.
 
 	string_list group_exprs;
@@ -754,6 +841,8 @@ RuleEndpointState* RuleMatcher::InitEndpoint(analyzer::Analyzer* analyzer,
 						new RuleEndpointState::Matcher;
 					m->state = new RE_Match_State(set->re);
 					m->type = (Rule::PatternType) i;
+					m->set = set;
+					m->dormant = false;
 					state->matchers.append(m);
 					}
 				}
@@ -767,6 +856,8 @@ RuleEndpointState* RuleMatcher::InitEndpoint(analyzer::Analyzer* analyzer,
 				{
 				bool match = false;
 
+				++h->evals;
+
 				// Evaluate the header test.
 				switch ( h->prot ) {
 				case RuleHdrTest::NEXT:
@@ -816,6 +907,8 @@ RuleEndpointState* RuleMatcher::InitEndpoint(analyzer::Analyzer* analyzer,
 	state->hdr_tests.resize(0);
 	state->matchers.resize(0);
 
+	ResetPrefilters(state);
+
 	// Send BOL to payload matchers.
 	Match(state, Rule::PAYLOAD, (const u_char *) "", 0, true, false, false);
 
@@ -866,14 +959,27 @@ void RuleMatcher::Match(RuleEndpointState* state, Rule::PatternType type,
 			state->payload_size = 0;
 		}
 
+	if ( state->prefilters[type].dormant )
+		RunPrefilter(state, type, data, data_len, bol, clear);
+
 	// Feed data into all relevant matchers.
 	loop_over_list(state->matchers, x)
 		{
 		RuleEndpointState::Matcher* m = state->matchers[x];
-		if ( m->type == type &&
-		     m->state->Match((const u_char*) data, data_len,
+
+		if ( m->type != type || m->dormant )
+			continue;
+
+		double start = rule_profile ? current_time(true) : 0;
+
+		if ( m->state->Match((const u_char*) data, data_len,
 					bol, eol, clear) )
 			newmatch = true;
+
+		m->set->bytes += data_len;
+
+		if ( rule_profile )
+			m->set->time += current_time(true) - start;
 		}
 
 	// If no new match found, we're already done.
@@ -938,6 +1044,7 @@ void RuleMatcher::Match(RuleEndpointState* state, Rule::PatternType type,
 			// Remember that all patterns have matched.
 			if ( ! state->matched_by_patterns.is_member(r) )
 				{
+				++r->profile.pattern_matches;
 				state->matched_by_patterns.append(r);
 				BroString* s = new BroString(data, data_len, 0);
 				state->matched_text.append(s);
@@ -1011,6 +1118,8 @@ bool RuleMatcher::EvalRuleConditions(Rule* r, RuleEndpointState* state,
 	{
 	DBG_LOG(DBG_RULES, "Evaluating conditions for rule %s", r->ID());
 
+	++r->profile.cond_evals;
+
 	// Check for other rules which have to match first.
 	loop_over_list(r->preconds, i)
 		{
@@ -1044,9 +1153,21 @@ bool RuleMatcher::EvalRuleConditions(Rule* r, RuleEndpointState* state,
 			}
 		}
 
+	double start = rule_profile ? current_time(true) : 0;
+	bool match = true;
+
 	loop_over_list(r->conditions, l)
 		if ( ! r->conditions[l]->DoMatch(r, state, data, len) )
-			return false;
+			{
+			match = false;
+			break;
+			}
+
+	if ( rule_profile )
+		r->profile.cond_time += current_time(true) - start;
+
+	if ( ! match )
+		return false;
 
 	DBG_LOG(DBG_RULES, "Conditions met: MATCH! %s", r->ID());
 	return true;
@@ -1061,6 +1182,7 @@ void RuleMatcher::ExecRuleActions(Rule* r, RuleEndpointState* state,
 		return;
 
 	state->matched_rules.append(r->Index());
+	++r->profile.matches;
 
 	loop_over_list(r->actions, i)
 		r->actions[i]->DoAction(r, state, data, len);
@@ -1122,6 +1244,131 @@ void RuleMatcher::ClearEndpointState(RuleEndpointState* state)
 
 	loop_over_list(state->matchers, j)
 		state->matchers[j]->state->Clear();
+
+	ResetPrefilters(state);
+	}
+
+void RuleMatcher::ResetPrefilters(RuleEndpointState* state)
+	{
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		{
+		RuleEndpointState::Prefilter* pf = &state->prefilters[i];
+		pf->state = literal_matchers[i]->StartState();
+		pf->dormant = 0;
+		pf->buffered = false;
+		pf->bol = false;
+		string().swap(pf->buffer);
+		}
+
+	loop_over_list(state->matchers, j)
+		{
+		RuleEndpointState::Matcher* m = state->matchers[j];
+
+		if ( m->set->prefilter_id >= 0 )
+			{
+			m->dormant = true;
+			++state->prefilters[m->type].dormant;
+			}
+		}
+	}
+
+void RuleMatcher::RunPrefilter(RuleEndpointState* state,
+				Rule::PatternType type,
+				const u_char* data, int data_len,
+				bool bol, bool clear)
+	{
+	RuleEndpointState::Prefilter* pf = &state->prefilters[type];
+
+	if ( clear )
+		{
+		// Matching starts over, and so does the search for literals.
+		pf->state = literal_matchers[type]->StartState();
+		pf->buffered = false;
+		pf->buffer.clear();
+		}
+
+	// We can only replay input with a BOL at its beginning.
+	if ( bol && pf->buffered )
+		{
+		WakeAllMatchers(state, type);
+		return;
+		}
+
+	vector<int> hits;
+	pf->state = literal_matchers[type]->Scan(pf->state, data, data_len,
+							&hits);
+
+	for ( size_t i = 0; i < hits.size() && pf->dormant; ++i )
+		{
+		loop_over_list(state->matchers, j)
+			{
+			RuleEndpointState::Matcher* m = state->matchers[j];
+
+			if ( m->dormant && m->type == type &&
+			     m->set->prefilter_id == hits[i] )
+				WakeMatcher(state, m);
+			}
+		}
+
+	if ( ! pf->dormant )
+		return;
+
+	if ( pf->buffer.size() + data_len > unsigned(sig_prefilter_buffer) )
+		{
+		// Stop prefiltering this endpoint rather than buffering
+		// without bounds.
+		WakeAllMatchers(state, type);
+		return;
+		}
+
+	if ( ! pf->buffered )
+		{
+		pf->buffered = true;
+		pf->bol = bol;
+		}
+
+	pf->buffer.append((const char*) data, data_len);
+	}
+
+void RuleMatcher::WakeMatcher(RuleEndpointState* state,
+				RuleEndpointState::Matcher* m)
+	{
+	RuleEndpointState::Prefilter* pf = &state->prefilters[m->type];
+
+	// The replay can't yield any matches, as it doesn't contain any
+	// of the matcher's literals (or else it'd be awake already).
+	if ( pf->buffered )
+		{
+		double start = rule_profile ? current_time(true) : 0;
+
+		m->state->Match((const u_char*) pf->buffer.data(),
+				pf->buffer.size(), pf->bol, false, false);
+
+		m->set->bytes += pf->buffer.size();
+
+		if ( rule_profile )
+			m->set->time += current_time(true) - start;
+		}
+
+	m->dormant = false;
+
+	if ( --pf->dormant == 0 )
+		{
+		pf->buffered = false;
+		string().swap(pf->buffer);
+		}
+	}
+
+void RuleMatcher::WakeAllMatchers(RuleEndpointState* state,
+					Rule::PatternType type)
+	{
+	loop_over_list(state->matchers, i)
+		{
+		RuleEndpointState::Matcher* m = state->matchers[i];
+
+		if ( m->dormant && m->type == type )
+			WakeMatcher(state, m);
+		}
 	}
 
 void RuleMatcher::ClearFileMagicState(RuleFileMagicState* state) const
@@ -1244,6 +1491,20 @@ void RuleMatcher::DumpStats(BroFile* f)
 	f->Write(fmt("%.6f DFA cache hits = %d; misses = %d\n", network_time,
 			stats.hits, stats.misses));
 
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		{
+		if ( ! num_prefiltered[i] )
+			continue;
+
+		f->Write(fmt("%.6f %d %s groups prefiltered by %d literals; "
+				"states = %d; mem = %d\n", network_time,
+				num_prefiltered[i],
+				Rule::TypeToString((Rule::PatternType) i),
+				literal_matchers[i]->NumLiterals(),
+				literal_matchers[i]->NumStates(),
+				literal_matchers[i]->MemoryAllocation()));
+		}
+
 	DumpStateStats(f, root);
 	}
 
@@ -1277,6 +1538,177 @@ void RuleMatcher::DumpStateStats(BroFile* f, RuleHdrTest* hdr_test)
 		DumpStateStats(f, h);
 	}
 
+void RuleMatcher::GetRuleStats(RuleStatsMap* stats)
+	{
+	stats->clear();
+
+	loop_over_list(rules, i)
+		{
+		Rule* r = rules[i];
+
+		if ( ! r->Active() )
+			continue;
+
+		RuleStats& s = (*stats)[r->ID()];
+		memset(&s, 0, sizeof(s));
+
+		s.pattern_matches = r->profile.pattern_matches;
+		s.matches = r->profile.matches;
+		s.cond_evals = r->profile.cond_evals;
+		s.cond_time = r->profile.cond_time;
+		}
+
+	GetRuleStats(stats, root, 0);
+	}
+
+void RuleMatcher::GetRuleStats(RuleStatsMap* stats, RuleHdrTest* hdr_test,
+				uint64 hdr_evals)
+	{
+	hdr_evals += hdr_test->evals;
+
+	for ( Rule* r = hdr_test->pattern_rules; r; r = r->next )
+		(*stats)[r->ID()].hdr_evals = hdr_evals;
+
+	for ( Rule* r = hdr_test->pure_rules; r; r = r->next )
+		(*stats)[r->ID()].hdr_evals = hdr_evals;
+
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		{
+		loop_over_list(hdr_test->psets[i], j)
+			{
+			RuleHdrTest::PatternSet* ps = hdr_test->psets[i][j];
+
+			// A rule may have more than one pattern in the group.
+			set<Rule*> group_rules;
+
+			loop_over_list(ps->ids, k)
+				group_rules.insert(Rule::rule_table[ps->ids[k] - 1]);
+
+			for ( set<Rule*>::const_iterator r = group_rules.begin();
+			      r != group_rules.end(); ++r )
+				{
+				RuleStats& s = (*stats)[(*r)->ID()];
+				s.bytes += ps->bytes;
+				s.dfa_states += ps->re->DFA()->NumStates();
+				s.match_time += ps->time;
+				}
+			}
+		}
+
+	for ( RuleHdrTest* h = hdr_test->child; h; h = h->sibling )
+		GetRuleStats(stats, h, hdr_evals);
+	}
+
+struct RuleMatcher::GroupProfile {
+	Rule::PatternType type;
+	int level;
+	int dfa_states;
+	uint64 bytes;
+	double time;
+	string rules;
+};
+
+typedef pair<string, RuleMatcher::RuleStats> RuleProfile;
+
+static bool rule_profile_cmp(const RuleProfile& a, const RuleProfile& b)
+	{
+	double ta = a.second.match_time + a.second.cond_time;
+	double tb = b.second.match_time + b.second.cond_time;
+
+	if ( ta != tb )
+		return ta > tb;
+
+	if ( a.second.bytes != b.second.bytes )
+		return a.second.bytes > b.second.bytes;
+
+	return a.first < b.first;
+	}
+
+bool RuleMatcher::CompareGroupProfiles(const GroupProfile& a,
+					const GroupProfile& b)
+	{
+	if ( a.time != b.time )
+		return a.time > b.time;
+
+	if ( a.bytes != b.bytes )
+		return a.bytes > b.bytes;
+
+	return a.rules < b.rules;
+	}
+
+void RuleMatcher::DumpProfile(FILE* f)
+	{
+	RuleStatsMap stats;
+	GetRuleStats(&stats);
+
+	vector<RuleProfile> rule_profiles(stats.begin(), stats.end());
+	sort(rule_profiles.begin(), rule_profiles.end(), rule_profile_cmp);
+
+	fprintf(f, "# Signatures by time spent matching and evaluating conditions\n");
+	fprintf(f, "# rule match_time cond_time bytes dfa_states hdr_evals "
+		   "cond_evals pattern_matches matches\n");
+
+	for ( size_t i = 0; i < rule_profiles.size(); ++i )
+		{
+		const RuleStats& s = rule_profiles[i].second;
+
+		fprintf(f, "%s %.6f %.6f %" PRIu64 " %u %" PRIu64 " %" PRIu64
+			   " %" PRIu64 " %" PRIu64 "\n",
+			rule_profiles[i].first.c_str(),
+			s.match_time, s.cond_time, s.bytes, s.dfa_states,
+			s.hdr_evals, s.cond_evals, s.pattern_matches,
+			s.matches);
+		}
+
+	vector<GroupProfile> group_profiles;
+	GetGroupProfiles(&group_profiles, root);
+	sort(group_profiles.begin(), group_profiles.end(), CompareGroupProfiles);
+
+	fprintf(f, "\n# Pattern groups by time spent matching\n");
+	fprintf(f, "# type level time bytes dfa_states rules\n");
+
+	for ( size_t i = 0; i < group_profiles.size(); ++i )
+		{
+		const GroupProfile& g = group_profiles[i];
+
+		fprintf(f, "%s %d %.6f %" PRIu64 " %d %s\n",
+			Rule::TypeToString(g.type), g.level, g.time, g.bytes,
+			g.dfa_states, g.rules.c_str());
+		}
+	}
+
+void RuleMatcher::GetGroupProfiles(vector<GroupProfile>* groups,
+					RuleHdrTest* hdr_test)
+	{
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		{
+		loop_over_list(hdr_test->psets[i], j)
+			{
+			RuleHdrTest::PatternSet* ps = hdr_test->psets[i][j];
+
+			GroupProfile g;
+			g.type = (Rule::PatternType) i;
+			g.level = hdr_test->level;
+			g.dfa_states = ps->re->DFA()->NumStates();
+			g.bytes = ps->bytes;
+			g.time = ps->time;
+
+			loop_over_list(ps->ids, k)
+				{
+				if ( k )
+					g.rules += ",";
+
+				g.rules += Rule::rule_table[ps->ids[k] - 1]->ID();
+				}
+
+			groups->push_back(g);
+			}
+		}
+
+	for ( RuleHdrTest* h = hdr_test->child; h; h = h->sibling )
+		GetGroupProfiles(groups, h);
+	}
+
 static Val* get_bro_val(const char* label)
 	{
 	ID* id = lookup_ID(label, GLOBAL_MODULE_NAME, false);
@@ -23,6 +23,7 @@
 //#define MATCHER_PRINT_STATS
 
 extern int rule_bench;
+extern int rule_profile;
 
 // Parser interface:
 
@@ -39,6 +40,8 @@ extern const char* current_rule_file;
 class RuleMatcher;
 extern RuleMatcher* rule_matcher;
 
+class Literal_Matcher;
+
 namespace analyzer {
 	namespace pia { class PIA; }
 	class Analyzer;
@@ -105,9 +108,10 @@ private:
 
 	// The following are all set by RuleMatcher::BuildRulesTree().
 	friend class RuleMatcher;
+	friend class RuleEndpointState;
 
 	struct PatternSet {
-		PatternSet() : re() {}
+		PatternSet() : re(), prefilter_id(-1), bytes(), time() {}
 
 		// If we're above the 'RE_level' (see RuleMatcher), this
 		// expr contains all patterns on this node. If we're on
@@ -115,6 +119,14 @@ private:
 		// of any of its children.
 		Specific_RE_Matcher* re;
 
+		// If each of the patterns requires a literal, the ID
+		// under which the prefilter reports them; else -1.
+		int prefilter_id;
+
+		// For profiling.
+		uint64 bytes;	// # bytes fed into the matcher
+		double time;	// time spent matching (--rule-profile only)
+
 		// All the patterns and their rule indices.
 		string_list patterns;
 		int_list ids;	// (only needed for debugging)
@@ -135,6 +147,7 @@ private:
 	RuleHdrTest* child;
 
 	int level;	// level within the tree
+	uint64 evals;	// # times the test got evaluated
 };
 
 declare(PList, RuleHdrTest);
@@ -171,17 +184,32 @@ private:
 	struct Matcher {
 		RE_Match_State* state;
 		Rule::PatternType type;
+		RuleHdrTest::PatternSet* set;
+		bool dormant;	// waiting for the prefilter to find a literal
 	};
 
 	declare(PList, Matcher);
 	typedef PList(Matcher) matcher_list;
 
+	// Dormant matchers don't see any input. Until they wake up, we
+	// buffer the input of their pattern type so that we can replay it
+	// to them; none of their patterns can match before the prefilter
+	// has found one of their literals.
+	struct Prefilter {
+		int state;	// of the literal matcher
+		int dormant;	// # dormant matchers
+		bool buffered;	// true if there's input since the last clear
+		bool bol;	// true if the buffered input starts at BOL
+		string buffer;
+	};
+
 	bool is_orig;
 	analyzer::Analyzer* analyzer;
 	RuleEndpointState* opposite;
 	analyzer::pia::PIA* pia;
 
 	matcher_list matchers;
+	Prefilter prefilters[Rule::TYPES];
 	rule_hdr_test_list hdr_tests;
 
 	// The follow tracks which rules for which all patterns have matched,
@@ -312,12 +340,33 @@ public:
 		unsigned int avg_nfa_states;
 	};
 
+	// Per-rule profile. The pattern matching costs are those of the
+	// groups holding the rule's patterns, shared with the other rules
+	// in there.
+	struct RuleStats {
+		uint64 bytes;		// # bytes fed into the groups
+		unsigned int dfa_states;	// # DFA states of the groups
+		double match_time;	// time spent matching the groups
+		uint64 pattern_matches;	// see Rule::Profile
+		uint64 matches;
+		uint64 cond_evals;
+		double cond_time;
+		uint64 hdr_evals;	// # evaluations of tests leading to rule
+	};
+
+	typedef map<string, RuleStats> RuleStatsMap;
+
 	Val* BuildRuleStateValue(const Rule* rule,
 					const RuleEndpointState* state) const;
 
 	void GetStats(Stats* stats, RuleHdrTest* hdr_test = 0);
 	void DumpStats(BroFile* f);
 
+	void GetRuleStats(RuleStatsMap* stats);
+
+	// Prints the rules and pattern groups sorted by their cost.
+	void DumpProfile(FILE* f);
+
 private:
 	// Delete node and all children.
 	void Delete(RuleHdrTest* node);
@@ -334,8 +383,25 @@ private:
 
 	// Build groups of regular epxressions.
 	void BuildPatternSets(RuleHdrTest::pattern_set_list* dst,
+				const string_list& exprs, const int_list& ids,
+				Rule::PatternType type);
+	void BuildPatternGroups(RuleHdrTest::pattern_set_list* dst,
 				const string_list& exprs, const int_list& ids);
 
+	// Put all of an endpoint's prefiltered matchers to sleep.
+	void ResetPrefilters(RuleEndpointState* state);
+
+	// Scan input for literals, waking up the dormant matchers whose
+	// literals are found, and buffer it for those still sleeping.
+	void RunPrefilter(RuleEndpointState* state, Rule::PatternType type,
+				const u_char* data, int data_len,
+				bool bol, bool clear);
+
+	// Replay buffered input to a dormant matcher, and wake it up.
+	void WakeMatcher(RuleEndpointState* state,
+				RuleEndpointState::Matcher* m);
+	void WakeAllMatchers(RuleEndpointState* state, Rule::PatternType type);
+
 	// Check an arbitrary rule if it's satisfied right now.
 	// eos signals end of stream
 	void ExecRule(Rule* rule, RuleEndpointState* state, bool eos);
@@ -361,6 +427,17 @@ private:
 
 	void DumpStateStats(BroFile* f, RuleHdrTest* hdr_test);
 
+	// hdr_evals is the sum of the evaluations of the tests leading
+	// to the node.
+	void GetRuleStats(RuleStatsMap* stats, RuleHdrTest* hdr_test,
+				uint64 hdr_evals);
+
+	struct GroupProfile;
+	void GetGroupProfiles(vector<GroupProfile>* groups,
+				RuleHdrTest* hdr_test);
+	static bool CompareGroupProfiles(const GroupProfile& a,
+						const GroupProfile& b);
+
 	static bool AllRulePatternsMatched(const Rule* r, MatchPos matchpos,
 	                                   const AcceptingMatchSet& ams);
 
@@ -369,6 +446,10 @@ private:
 	RuleHdrTest* root;
 	rule_list rules;
 	rule_dict rules_by_id;
+
+	// Literals required by the pattern sets, per pattern type.
+	Literal_Matcher* literal_matchers[Rule::TYPES];
+	int num_prefiltered[Rule::TYPES];
 };
 
 // Keeps bi-directional matching-state.
@@ -0,0 +1,292 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "config.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "ScriptUsage.h"
+#include "EventRegistry.h"
+#include "Traverse.h"
+#include "NetVar.h"
+#include "input.h"
+#include "plugin/Manager.h"
+
+class ScriptUsageCollector : public TraversalCallback {
+public:
+	ScriptUsageCollector(ScriptUsage* arg_usage)	{ usage = arg_usage; }
+
+	virtual TraversalCode PreExpr(const Expr* e);
+
+protected:
+	void AddField(const Expr* rec, const char* field);
+
+	ScriptUsage* usage;
+};
+
+void ScriptUsageCollector::AddField(const Expr* rec, const char* field)
+	{
+	string name = rec->Type()->GetName();
+
+	if ( name.empty() )
+		return;
+
+	usage->referenced_fields.insert(name + "$" + field);
+	}
+
+TraversalCode ScriptUsageCollector::PreExpr(const Expr* e)
+	{
+	switch ( e->Tag() ) {
+	case EXPR_EVENT:
+		usage->raised_events.insert(((const EventExpr*) e)->Name());
+		break;
+
+	case EXPR_NAME:
+		{
+		// Events can also be passed around as values, e.g. to the
+		// input framework.
+		const ID* id = ((const NameExpr*) e)->Id();
+		const BroType* t = id->Type();
+
+		if ( t && t->Tag() == TYPE_FUNC &&
+		     t->AsFuncType()->Flavor() == FUNC_FLAVOR_EVENT )
+			usage->raised_events.insert(id->Name());
+		break;
+		}
+
+	case EXPR_FIELD:
+		{
+		const FieldExpr* fe = (const FieldExpr*) e;
+		AddField(fe->Op(), fe->FieldName());
+		break;
+		}
+
+	case EXPR_HAS_FIELD:
+		{
+		const HasFieldExpr* hf = (const HasFieldExpr*) e;
+		AddField(hf->Op(), hf->FieldName());
+		break;
+		}
+
+	case EXPR_FIELD_ASSIGN:
+		usage->referenced_fields.insert(string("$") +
+				((const FieldAssignExpr*) e)->FieldName());
+		break;
+
+	default:
+		break;
+	}
+
+	return TC_CONTINUE;
+	}
+
+static bool is_empty_body(const Stmt* s)
+	{
+	switch ( s->Tag() ) {
+	case STMT_NULL:
+		return true;
+
+	case STMT_LIST:
+	case STMT_EVENT_BODY_LIST:
+		{
+		const stmt_list& stmts = ((const StmtList*) s)->Stmts();
+
+		loop_over_list(stmts, i)
+			if ( ! is_empty_body(stmts[i]) )
+				return false;
+
+		return true;
+		}
+
+	default:
+		return false;
+	}
+	}
+
+static bool str_less(const char* a, const char* b)
+	{
+	return strcmp(a, b) < 0;
+	}
+
+static std::vector<EventHandler*> sorted_handlers()
+	{
+	std::vector<const char*> names;
+	EventRegistry::string_list* all = event_registry->AllHandlers();
+
+	loop_over_list(*all, i)
+		names.push_back((*all)[i]);
+
+	delete all;
+
+	std::sort(names.begin(), names.end(), str_less);
+
+	std::vector<EventHandler*> handlers;
+
+	for ( size_t i = 0; i < names.size(); ++i )
+		handlers.push_back(event_registry->Lookup(names[i]));
+
+	return handlers;
+	}
+
+ScriptUsage::ScriptUsage()
+	{
+	}
+
+ScriptUsage::~ScriptUsage()
+	{
+	}
+
+void ScriptUsage::Analyze()
+	{
+	ScriptUsageCollector cb(this);
+
+	if ( global_scope() )
+		{
+		cb.current_scope = global_scope();
+		global_scope()->Traverse(&cb);
+		}
+
+	if ( stmts )
+		stmts->Traverse(&cb);
+	}
+
+bool ScriptUsage::IsDead(EventHandler* h) const
+	{
+	Func* f = h->LocalHandler();
+
+	if ( ! f || ! f->HasBodies() || f->GetKind() != Func::BRO_FUNC )
+		return false;
+
+	const vector<Func::Body>& bodies = f->GetBodies();
+
+	for ( size_t i = 0; i < bodies.size(); ++i )
+		if ( ! is_empty_body(bodies[i].stmts) )
+			return false;
+
+	return true;
+	}
+
+int ScriptUsage::DisableDeadHandlers()
+	{
+	// Empty handlers are still observable when somebody watches all
+	// events going by.
+	if ( new_event ||
+	     plugin_mgr->HavePluginForHook(plugin::HOOK_QUEUE_EVENT) ||
+	     plugin_mgr->HavePluginForHook(plugin::HOOK_CALL_FUNCTION) )
+		return 0;
+
+	std::vector<EventHandler*> handlers = sorted_handlers();
+	int num_dead = 0;
+
+	for ( size_t i = 0; i < handlers.size(); ++i )
+		{
+		if ( IsDead(handlers[i]) )
+			{
+			handlers[i]->SetDead(true);
+			++num_dead;
+			}
+		}
+
+	return num_dead;
+	}
+
+void ScriptUsage::CollectRecordTypes(RecordType* rt,
+					std::set<RecordType*>& types) const
+	{
+	if ( types.find(rt) != types.end() )
+		return;
+
+	types.insert(rt);
+
+	for ( int i = 0; i < rt->NumFields(); ++i )
+		{
+		BroType* ft = rt->FieldType(i);
+
+		if ( ft->Tag() == TYPE_RECORD )
+			CollectRecordTypes(ft->AsRecordType(), types);
+		}
+	}
+
+void ScriptUsage::Describe(FILE* f) const
+	{
+	std::vector<EventHandler*> handlers = sorted_handlers();
+	std::set<RecordType*> types;
+
+	fprintf(f, "# Events without a handler\n");
+
+	for ( size_t i = 0; i < handlers.size(); ++i )
+		{
+		EventHandler* h = handlers[i];
+
+		if ( ! h->LocalHandler() || ! h->LocalHandler()->HasBodies() )
+			fprintf(f, "%s\n", h->Name());
+		}
+
+	fprintf(f, "\n# Events with only empty handlers\n");
+
+	for ( size_t i = 0; i < handlers.size(); ++i )
+		if ( IsDead(handlers[i]) )
+			fprintf(f, "%s\n", handlers[i]->Name());
+
+	fprintf(f, "\n# Handlers for events that are never raised\n");
+
+	for ( size_t i = 0; i < handlers.size(); ++i )
+		{
+		EventHandler* h = handlers[i];
+
+		if ( ! h->LocalHandler() || ! h->LocalHandler()->HasBodies() )
+			continue;
+
+		if ( IsDead(h) )
+			continue;
+
+		// The core marks the events it may generate as used.
+		if ( ! h->Used() &&
+		     raised_events.find(h->Name()) == raised_events.end() )
+			fprintf(f, "%s\n", h->Name());
+		else
+			{
+			RecordType* args = h->FType()->Args();
+
+			for ( int j = 0; j < args->NumFields(); ++j )
+				{
+				BroType* t = args->FieldType(j);
+
+				if ( t->Tag() == TYPE_RECORD )
+					CollectRecordTypes(t->AsRecordType(), types);
+				}
+			}
+		}
+
+	fprintf(f, "\n# Unreferenced fields of records passed to handlers\n");
+
+	std::vector<string> fields;
+
+	for ( std::set<RecordType*>::const_iterator i = types.begin();
+	      i != types.end(); ++i )
+		{
+		RecordType* rt = *i;
+		string name = rt->GetName();
+
+		if ( name.empty() )
+			continue;
+
+		for ( int j = 0; j < rt->NumFields(); ++j )
+			{
+			string field = rt->FieldName(j);
+
+			if ( referenced_fields.find(name + "$" + field) !=
+			     referenced_fields.end() ||
+			     referenced_fields.find("$" + field) !=
+			     referenced_fields.end() )
+				continue;
+
+			fields.push_back(name + "$" + field);
+			}
+		}
+
+	std::sort(fields.begin(), fields.end());
+
+	for ( size_t i = 0; i < fields.size(); ++i )
+		fprintf(f, "%s\n", fields[i].c_str());
+	}
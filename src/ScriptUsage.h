@@ -0,0 +1,55 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Load-time analysis of which events and record fields the loaded scripts
+// actually use.
+//
+// Events whose handlers are all empty get flagged as dead, so that their
+// EventHandlerPtr tests false and the core skips building their arguments
+// just like for events without any handler. The remaining results are
+// informational: they tell which events the core generates for nothing,
+// which handlers can never run, and which fields of records passed to
+// handlers no script ever looks at.
+
+#ifndef scriptusage_h
+#define scriptusage_h
+
+#include <stdio.h>
+
+#include <set>
+#include <string>
+
+class EventHandler;
+class RecordType;
+
+class ScriptUsage {
+public:
+	ScriptUsage();
+	~ScriptUsage();
+
+	// Traverses all loaded script code.
+	void Analyze();
+
+	// Flags the events whose handlers have only empty bodies as dead.
+	// Returns the number of events flagged.
+	int DisableDeadHandlers();
+
+	// Prints a report of unused events and record fields.
+	void Describe(FILE* f) const;
+
+protected:
+	friend class ScriptUsageCollector;
+
+	bool IsDead(EventHandler* h) const;
+	void CollectRecordTypes(RecordType* rt,
+				std::set<RecordType*>& types) const;
+
+	// Events raised or referenced from script code.
+	std::set<std::string> raised_events;
+
+	// Record fields referenced by name, as "<type>$<field>". Fields
+	// referenced through record constructors, for which we don't know
+	// the type yet, are kept as just "$<field>".
+	std::set<std::string> referenced_fields;
+};
+
+#endif
@@ -893,7 +893,7 @@ FragReassembler* NetSessions::NextFragment(double t, const IP_Hdr* ip,
 	ListVal* key = new ListVal(TYPE_ANY);
 	key->Append(new AddrVal(ip->SrcAddr()));
 	key->Append(new AddrVal(ip->DstAddr()));
-	key->Append(new Val(frag_id, TYPE_COUNT));
+	key->Append(val_mgr->GetCount(frag_id));
 
 	HashKey* h = ch->ComputeHash(key, 1);
 	if ( ! h )
@@ -1258,7 +1258,7 @@ Connection* NetSessions::NewConn(HashKey* k, double t, const ConnID* id,
 		{
 		conn->Event(new_connection, 0);
 
-		if ( external )
+		if ( external && connection_external )
 			{
 			val_list* vl = new val_list(2);
 			vl->append(conn->BuildConnVal());
@@ -0,0 +1,65 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "config.h"
+
+#include "SlabPool.h"
+
+// Slabs hold this many bytes worth of objects, but at least
+// MIN_SLAB_OBJECTS of them.
+static const size_t SLAB_SIZE = 64 * 1024;
+static const size_t MIN_SLAB_OBJECTS = 16;
+
+// All objects are aligned to this.
+static const size_t SLAB_ALIGN = 16;
+
+SlabPool* SlabPool::pools = 0;
+
+static size_t slab_stride(size_t size)
+	{
+	return (size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+	}
+
+static size_t slab_objects(size_t size)
+	{
+	size_t n = SLAB_SIZE / slab_stride(size);
+	return n < MIN_SLAB_OBJECTS ? MIN_SLAB_OBJECTS : n;
+	}
+
+void* SlabPool::AllocSlow(size_t n)
+	{
+	if ( n != size )
+		return ::operator new(n);
+
+	if ( ! slabs )
+		{
+		next_pool = pools;
+		pools = this;
+		}
+
+	size_t stride = slab_stride(size);
+	size_t num = slab_objects(size);
+	char* slab = (char*) safe_malloc(stride * num);
+
+	// Chain the new objects in front of the (empty) free list, lowest
+	// address first.
+	for ( size_t i = num; i > 0; --i )
+		{
+		void* p = slab + (i - 1) * stride;
+		*(void**) p = free_list;
+		free_list = p;
+		}
+
+	++slabs;
+
+	return Alloc(n);
+	}
+
+void SlabPool::GetStats(Stats* s) const
+	{
+	s->size = size;
+	s->allocs = allocs;
+	s->in_use = in_use;
+	s->peak_in_use = peak_in_use;
+	s->slabs = slabs;
+	s->bytes = slabs * slab_stride(size) * slab_objects(size);
+	}
@@ -0,0 +1,109 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef slabpool_h
+#define slabpool_h
+
+#include <stddef.h>
+
+#include "util.h"
+
+// Fixed-size memory pools for the classes of which we create and delete
+// a lot of instances per connection (Connection, its timers, the TCP
+// analyzer tree, ...).  Each pool carves its objects out of larger slabs
+// and recycles them through a free list, so that churning through
+// millions of short-lived connections doesn't fragment the heap.  Slabs
+// are never returned to the system; the memory stays with the pool
+// for the next burst.
+//
+// A class opts in by putting DECLARE_SLAB_ALLOCATION() into its public
+// section and IMPLEMENT_SLAB_ALLOCATION() into its source file.  Objects
+// of derived classes with a different size fall through to the global
+// operator new.
+//
+// The pools are not thread-safe; only the main thread must create and
+// delete instances of pooled classes.
+//
+// SlabPool is deliberately a plain aggregate so that pools are
+// initialized statically, before any constructor that might already
+// allocate from them runs.  Don't access its fields directly.
+struct SlabPool {
+	struct Stats {
+		unsigned int size;	// size of the pooled objects
+		uint64 allocs;		// objects handed out so far
+		uint64 in_use;		// objects currently handed out
+		uint64 peak_in_use;	// maximum of in_use
+		uint64 slabs;		// slabs allocated
+		uint64 bytes;		// total size of all slabs
+	};
+
+	void* Alloc(size_t n)
+		{
+		if ( n != size || ! free_list )
+			return AllocSlow(n);
+
+		void* p = free_list;
+		free_list = *(void**) p;
+
+		++allocs;
+		if ( ++in_use > peak_in_use )
+			peak_in_use = in_use;
+
+		return p;
+		}
+
+	void Free(void* p, size_t n)
+		{
+		if ( ! p )
+			return;
+
+		if ( n != size )
+			{
+			::operator delete(p);
+			return;
+			}
+
+		*(void**) p = free_list;
+		free_list = p;
+		--in_use;
+		}
+
+	const char* Name() const	{ return name; }
+	void GetStats(Stats* s) const;
+
+	// Iterates over all pools that have allocated anything so far.
+	static SlabPool* First()	{ return pools; }
+	SlabPool* Next() const		{ return next_pool; }
+
+	void* AllocSlow(size_t n);
+
+	const char* name;
+	size_t size;
+	void* free_list;
+	SlabPool* next_pool;
+	uint64 allocs;
+	uint64 in_use;
+	uint64 peak_in_use;
+	uint64 slabs;
+
+	static SlabPool* pools;
+};
+
+#ifdef USE_PERFTOOLS_DEBUG
+
+// Leave all memory management to the heap checker.
+#define DECLARE_SLAB_ALLOCATION()
+#define IMPLEMENT_SLAB_ALLOCATION(cls, name)
+
+#else
+
+#define DECLARE_SLAB_ALLOCATION() \
+	static void* operator new(size_t n)	{ return slab_pool.Alloc(n); } \
+	static void operator delete(void* p, size_t n)	{ slab_pool.Free(p, n); } \
+	static SlabPool slab_pool;
+
+#define IMPLEMENT_SLAB_ALLOCATION(cls, name) \
+	SlabPool cls::slab_pool = { name, sizeof(cls), 0, 0, 0, 0, 0, 0 };
+
+#endif
+
+#endif
@@ -261,3 +261,391 @@ void CQ_TimerMgr::Remove(Timer* timer)
 		delete timer;
 		}
 	}
+
+TW_TimerMgr::TW_TimerMgr(const Tag& tag, double arg_resolution) : TimerMgr(tag)
+	{
+	resolution = arg_resolution;
+	cur_tick = 0;
+	free_nodes = -1;
+	wheel_size = peak_size = 0;
+
+	for ( int i = 0; i < NUM_SLOTS; ++i )
+		heads[i] = -1;
+
+	for ( int i = 0; i <= LEVELS; ++i )
+		level_size[i] = 0;
+
+	ready = new PriorityQueue;
+	}
+
+TW_TimerMgr::~TW_TimerMgr()
+	{
+	delete ready;
+	}
+
+uint64 TW_TimerMgr::Tick(double t) const
+	{
+	// Clamp so that even bogus times yield a tick we can compute with.
+	static const uint64 max_tick = uint64(1) << 62;
+
+	if ( t <= 0.0 )
+		return 0;
+
+	double tick = t / resolution;
+
+	if ( tick >= double(max_tick) )
+		return max_tick;
+
+	return uint64(tick);
+	}
+
+int TW_TimerMgr::NewNode(Timer* timer)
+	{
+	int n;
+
+	if ( free_nodes >= 0 )
+		{
+		n = free_nodes;
+		free_nodes = nodes[n].next;
+		}
+	else
+		{
+		n = nodes.size();
+		nodes.push_back(Node());
+		}
+
+	nodes[n].timer = timer;
+	nodes[n].prev = nodes[n].next = nodes[n].slot = -1;
+	timer->SetOffset(n);
+
+	return n;
+	}
+
+void TW_TimerMgr::FreeNode(int n)
+	{
+	nodes[n].timer = 0;
+	nodes[n].slot = -1;
+	nodes[n].next = free_nodes;
+	free_nodes = n;
+	}
+
+void TW_TimerMgr::Insert(int n)
+	{
+	Node* node = &nodes[n];
+	uint64 tick = Tick(node->timer->Time());
+
+	if ( tick < cur_tick )
+		{
+		// Already due.
+		if ( ! ready->Add(node->timer) )
+			reporter->InternalError("out of memory");
+
+		FreeNode(n);
+		return;
+		}
+
+	// Find the innermost wheel that reaches far enough.
+	uint64 delta = tick - cur_tick;
+	int level = 0;
+
+	while ( level < LEVELS && delta >> (SLOT_BITS * (level + 1)) )
+		++level;
+
+	int slot = OVERFLOW_SLOT;
+
+	if ( level < LEVELS )
+		slot = level * SLOTS + ((tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+	node->slot = slot;
+	node->prev = -1;
+	node->next = heads[slot];
+
+	if ( node->next >= 0 )
+		nodes[node->next].prev = n;
+
+	heads[slot] = n;
+	++level_size[level];
+	++wheel_size;
+	}
+
+void TW_TimerMgr::Unlink(int n)
+	{
+	Node* node = &nodes[n];
+
+	if ( node->prev >= 0 )
+		nodes[node->prev].next = node->next;
+	else
+		heads[node->slot] = node->next;
+
+	if ( node->next >= 0 )
+		nodes[node->next].prev = node->prev;
+
+	--level_size[node->slot / SLOTS];
+	--wheel_size;
+	}
+
+void TW_TimerMgr::MoveToReady(int slot)
+	{
+	int n = heads[slot];
+
+	while ( n >= 0 )
+		{
+		int next = nodes[n].next;
+
+		if ( ! ready->Add(nodes[n].timer) )
+			reporter->InternalError("out of memory");
+
+		FreeNode(n);
+		--level_size[slot / SLOTS];
+		--wheel_size;
+		n = next;
+		}
+
+	heads[slot] = -1;
+	}
+
+void TW_TimerMgr::Requeue(int slot)
+	{
+	int n = heads[slot];
+	heads[slot] = -1;
+
+	while ( n >= 0 )
+		{
+		int next = nodes[n].next;
+		--level_size[slot / SLOTS];
+		--wheel_size;
+		Insert(n);
+		n = next;
+		}
+	}
+
+void TW_TimerMgr::AdvanceWheel(uint64 tick)
+	{
+	while ( cur_tick <= tick )
+		{
+		// When a wheel completes a turn, the next slot of the wheel
+		// outside of it gets spread out over the inner ones.
+		for ( int level = 1; level <= LEVELS; ++level )
+			{
+			uint64 mask = (uint64(1) << (SLOT_BITS * level)) - 1;
+
+			if ( cur_tick & mask )
+				break;
+
+			if ( level == LEVELS )
+				Requeue(OVERFLOW_SLOT);
+			else
+				Requeue(level * SLOTS +
+					((cur_tick >> (SLOT_BITS * level)) & (SLOTS - 1)));
+			}
+
+		MoveToReady(cur_tick & (SLOTS - 1));
+		++cur_tick;
+
+		// Skip ahead over ticks at which nothing can happen: if the
+		// inner wheels are empty, up to where the next non-empty one
+		// turns next.
+		if ( ! wheel_size )
+			{
+			cur_tick = tick + 1;
+			break;
+			}
+
+		uint64 next = cur_tick;
+
+		for ( int level = 0; level < LEVELS && ! level_size[level]; ++level )
+			{
+			uint64 mask = (uint64(1) << (SLOT_BITS * (level + 1))) - 1;
+			next = (cur_tick + mask) & ~mask;
+			}
+
+		if ( next > tick + 1 )
+			next = tick + 1;
+
+		cur_tick = next;
+		}
+	}
+
+void TW_TimerMgr::Add(Timer* timer)
+	{
+	DBG_LOG(DBG_TM, "Adding timer %s to TimeMgr %p",
+			timer_type_to_string(timer->Type()), this);
+
+	Insert(NewNode(timer));
+
+	++current_timers[timer->Type()];
+
+	if ( Size() > peak_size )
+		peak_size = Size();
+	}
+
+void TW_TimerMgr::Expire()
+	{
+	// Move past all ticks, so that from now on every timer counts as
+	// due, including any that get added while we dispatch.
+	cur_tick = Tick(1e20) + 1;
+
+	for ( int i = 0; i < NUM_SLOTS; ++i )
+		MoveToReady(i);
+
+	Timer* timer;
+	while ( (timer = (Timer*) ready->Remove()) )
+		{
+		DBG_LOG(DBG_TM, "Dispatching timer %s in TimeMgr %p",
+				timer_type_to_string(timer->Type()), this);
+		timer->Dispatch(t, 1);
+		--current_timers[timer->Type()];
+		delete timer;
+		}
+	}
+
+int TW_TimerMgr::DoAdvance(double new_t, int max_expire)
+	{
+	uint64 tick = Tick(new_t);
+
+	if ( tick >= cur_tick )
+		AdvanceWheel(tick);
+
+	Timer* timer = (Timer*) ready->Top();
+	for ( num_expired = 0; (num_expired < max_expire || max_expire == 0) &&
+		     timer && timer->Time() <= new_t; ++num_expired )
+		{
+		last_timestamp = timer->Time();
+		--current_timers[timer->Type()];
+
+		// Remove it before dispatching, since the dispatch
+		// can otherwise delete it, and then we won't know
+		// whether we should delete it too.
+		(void) ready->Remove();
+
+		DBG_LOG(DBG_TM, "Dispatching timer %s in TimeMgr %p",
+				timer_type_to_string(timer->Type()), this);
+		timer->Dispatch(new_t, 0);
+		delete timer;
+
+		timer = (Timer*) ready->Top();
+		}
+
+	return num_expired;
+	}
+
+void TW_TimerMgr::Remove(Timer* timer)
+	{
+	// Timers whose tick we have already processed are in the heap,
+	// all others on the wheel.
+	if ( Tick(timer->Time()) < cur_tick )
+		{
+		if ( ! ready->Remove(timer) )
+			reporter->InternalError("asked to remove a missing timer");
+		}
+	else
+		{
+		int n = timer->Offset();
+
+		if ( n < 0 || n >= int(nodes.size()) || nodes[n].timer != timer )
+			reporter->InternalError("asked to remove a missing timer");
+
+		Unlink(n);
+		FreeNode(n);
+		}
+
+	--current_timers[timer->Type()];
+	delete timer;
+	}
+
+unsigned int TW_TimerMgr::MemoryUsage() const
+	{
+	return padded_sizeof(*this) + pad_size(nodes.capacity() * sizeof(Node));
+	}
+
+// A timer standing in for a connection's inactivity timer. The benchmark
+// keeps one per simulated connection and, like the connection timers,
+// cancels and reschedules it as packets come in.
+class BenchmarkTimer : public Timer {
+public:
+	BenchmarkTimer(double t, Timer** arg_slot)
+		: Timer(t, TIMER_CONN_INACTIVITY)	{ slot = arg_slot; }
+
+	void Dispatch(double t, int is_expire)
+		{
+		if ( slot )
+			*slot = 0;
+		}
+
+protected:
+	Timer** slot;
+};
+
+static double run_timer_benchmark(TimerMgr* mgr, int num_conns,
+					int num_packets)
+	{
+	Timer** conns = new Timer*[num_conns];
+
+	for ( int i = 0; i < num_conns; ++i )
+		conns[i] = 0;
+
+	// Fixed-seed xorshift, so that all managers see the same workload.
+	uint32 r = 2463534242U;
+	double t = 1e9;
+	double start = current_time(true);
+
+	for ( int i = 0; i < num_packets; ++i )
+		{
+		r ^= r << 13;
+		r ^= r >> 17;
+		r ^= r << 5;
+
+		// About 100k packets per second.
+		t += 1e-5 * (r & 0x3) / 1.5;
+
+		Timer** c = &conns[r % num_conns];
+
+		// Most connections go idle for seconds; a few have long
+		// timeouts, as for established TCP.
+		double timeout = ((r >> 24) & 0xf) ? 5.0 + (r >> 28) : 3600.0;
+
+		if ( *c )
+			mgr->Cancel(*c);
+
+		*c = new BenchmarkTimer(t + timeout, c);
+		mgr->Add(*c);
+
+		// Plus a short-lived timer that's never canceled.
+		if ( (r & 0xff) < 32 )
+			mgr->Add(new BenchmarkTimer(t + ((r >> 8) & 0xff) / 100.0, 0));
+
+		mgr->Advance(t, 0);
+		}
+
+	double elapsed = current_time(true) - start;
+
+	for ( int i = 0; i < num_conns; ++i )
+		if ( conns[i] )
+			mgr->Cancel(conns[i]);
+
+	mgr->Expire();
+	delete [] conns;
+
+	return elapsed;
+	}
+
+void timer_benchmark(int num_conns, int num_packets)
+	{
+	TimerMgr* mgrs[3];
+	mgrs[0] = new PQ_TimerMgr("<BENCHMARK>");
+	mgrs[1] = new CQ_TimerMgr("<BENCHMARK>");
+	mgrs[2] = new TW_TimerMgr("<BENCHMARK>");
+	const char* names[3] = { "pq", "cq", "wheel" };
+
+	printf("%d connections, %d packets\n", num_conns, num_packets);
+
+	for ( int i = 0; i < 3; ++i )
+		{
+		double elapsed = run_timer_benchmark(mgrs[i], num_conns,
+							num_packets);
+		printf("%-6s %8.3fs  %8.1f ns/packet  peak %d timers\n",
+			names[i], elapsed, elapsed * 1e9 / num_packets,
+			mgrs[i]->PeakSize());
+		delete mgrs[i];
+		}
+	}
@@ -4,8 +4,8 @@
 #define timer_h
 
 #include <string>
+#include <vector>
 
-#include <string>
 #include "SerialObj.h"
 #include "PriorityQueue.h"
 
@@ -179,6 +179,82 @@ protected:
 	struct cq_handle *cq;
 };
 
+// A hierarchical timing wheel. Adding and canceling a timer take constant
+// time regardless of how many timers are pending. As time advances, all
+// timers of a wheel slot move at once into a small heap of due timers,
+// from which they're dispatched in the order of their exact times.
+class TW_TimerMgr : public TimerMgr {
+public:
+	// The resolution gives the width of a slot on the innermost wheel.
+	TW_TimerMgr(const Tag& arg_tag, double resolution = 0.001);
+	~TW_TimerMgr();
+
+	void Add(Timer* timer);
+	void Expire();
+
+	int Size() const	{ return wheel_size + ready->Size(); }
+	int PeakSize() const	{ return peak_size; }
+	unsigned int MemoryUsage() const;
+
+protected:
+	int DoAdvance(double t, int max_expire);
+	void Remove(Timer* timer);
+
+	// Four wheels of 256 slots each; with the default resolution the
+	// outermost covers about 50 days. Timers further out than that go
+	// into an overflow list that we revisit whenever the outermost
+	// wheel turns.
+	enum { LEVELS = 4, SLOT_BITS = 8, SLOTS = 1 << SLOT_BITS };
+	enum { OVERFLOW_SLOT = LEVELS * SLOTS, NUM_SLOTS };
+
+	// Timers on the wheel are kept in doubly-linked per-slot lists of
+	// nodes. A timer's offset (which the heap uses while the timer is
+	// due) holds the index of its node while it's on the wheel.
+	struct Node {
+		Timer* timer;
+		int prev;
+		int next;	// also links the free list
+		int slot;
+	};
+
+	uint64 Tick(double t) const;
+
+	// Puts a node into the slot appropriate for its timer.
+	void Insert(int n);
+	void Unlink(int n);
+
+	int NewNode(Timer* timer);
+	void FreeNode(int n);
+
+	// Moves all of a slot's timers into the heap of due timers.
+	void MoveToReady(int slot);
+
+	// Reinserts all of a slot's timers, which moves them further in
+	// towards the innermost wheel.
+	void Requeue(int slot);
+
+	// Processes all ticks up to and including the given one.
+	void AdvanceWheel(uint64 tick);
+
+	double resolution;
+	uint64 cur_tick;	// next tick to process
+
+	std::vector<Node> nodes;
+	int free_nodes;
+
+	int heads[NUM_SLOTS];
+	int level_size[LEVELS + 1];	// includes the overflow list
+	int wheel_size;
+	int peak_size;
+
+	// Timers whose tick has passed but that haven't been dispatched yet.
+	PriorityQueue* ready;
+};
+
 extern TimerMgr* timer_mgr;
 
+// Runs a synthetic connection timer workload against each of the timer
+// manager implementations and prints how long each took.
+extern void timer_benchmark(int num_conns, int num_packets);
+
 #endif
@@ -27,6 +27,11 @@
 #include "Reporter.h"
 #include "IPAddr.h"
 
+IMPLEMENT_SLAB_ALLOCATION(Val, "Val")
+IMPLEMENT_SLAB_ALLOCATION(RecordVal, "RecordVal")
+
+ValManager* val_mgr = 0;
+
 Val::Val(Func* f)
 	{
 	val.func_val = f;
@@ -415,19 +420,19 @@ Val* Val::SizeVal() const
 		// Return abs value. However abs() only works on ints and llabs
 		// doesn't work on Mac OS X 10.5. So we do it by hand
 		if ( val.int_val < 0 )
-			return new Val(-val.int_val, TYPE_COUNT);
+			return val_mgr->GetCount(-val.int_val);
 		else
-			return new Val(val.int_val, TYPE_COUNT);
+			return val_mgr->GetCount(val.int_val);
 
 	case TYPE_INTERNAL_UNSIGNED:
-		return new Val(val.uint_val, TYPE_COUNT);
+		return val_mgr->GetCount(val.uint_val);
 
 	case TYPE_INTERNAL_DOUBLE:
 		return new Val(fabs(val.double_val), TYPE_DOUBLE);
 
 	case TYPE_INTERNAL_OTHER:
 		if ( type->Tag() == TYPE_FUNC )
-			return new Val(val.func_val->FType()->ArgTypes()->Types()->length(), TYPE_COUNT);
+			return val_mgr->GetCount(val.func_val->FType()->ArgTypes()->Types()->length());
 
 		if ( type->Tag() == TYPE_FILE )
 			return new Val(val.file_val->Size(), TYPE_DOUBLE);
@@ -437,7 +442,7 @@ Val* Val::SizeVal() const
 		break;
 	}
 
-	return new Val(0, TYPE_COUNT);
+	return val_mgr->GetCount(0);
 	}
 
 unsigned int Val::MemoryAllocation() const
@@ -802,6 +807,11 @@ PortVal::PortVal(uint32 p) : Val(TYPE_PORT)
 	val.uint_val = static_cast<bro_uint_t>(p);
 	}
 
+Val* PortVal::SizeVal() const
+	{
+	return val_mgr->GetInt(val.uint_val);
+	}
+
 uint32 PortVal::Port() const
 	{
 	uint32 p = static_cast<uint32>(val.uint_val);
@@ -885,9 +895,9 @@ unsigned int AddrVal::MemoryAllocation() const
 Val* AddrVal::SizeVal() const
 	{
 	if ( val.addr_val->GetFamily() == IPv4 )
-		return new Val(32, TYPE_COUNT);
+		return val_mgr->GetCount(32);
 	else
-		return new Val(128, TYPE_COUNT);
+		return val_mgr->GetCount(128);
 	}
 
 IMPLEMENT_SERIAL(AddrVal, SER_ADDR_VAL);
@@ -1049,6 +1059,11 @@ StringVal::StringVal(const string& s) : Val(TYPE_STRING)
 	val.string_val = new BroString(s.c_str());
 	}
 
+Val* StringVal::SizeVal() const
+	{
+	return val_mgr->GetCount(val.string_val->Len());
+	}
+
 StringVal* StringVal::ToUpper()
 	{
 	val.string_val->ToUpper();
@@ -1161,6 +1176,11 @@ ListVal::~ListVal()
 	Unref(type);
 	}
 
+Val* ListVal::SizeVal() const
+	{
+	return val_mgr->GetCount(vals.length());
+	}
+
 RE_Matcher* ListVal::BuildRE() const
 	{
 	if ( tag != TYPE_STRING )
@@ -1442,6 +1462,11 @@ int TableVal::Assign(Val* index, Val* new_val, Opcode op)
 	return Assign(index, k, new_val, op);
 	}
 
+Val* TableVal::SizeVal() const
+	{
+	return val_mgr->GetCount(Size());
+	}
+
 int TableVal::Assign(Val* index, HashKey* k, Val* new_val, Opcode op)
 	{
 	int is_set = table_type->IsSet();
@@ -1531,7 +1556,7 @@ int TableVal::Assign(Val* index, HashKey* k, Val* new_val, Opcode op)
 			// A set.
 			if ( old_entry_val && remote_check_sync_consistency )
 				{
-				Val* has_old_val = new Val(1, TYPE_INT);
+				Val* has_old_val = val_mgr->GetInt(1);
 				StateAccess::Log(
 					new StateAccess(OP_ADD, this, index,
 							has_old_val));
@@ -1886,7 +1911,7 @@ Val* TableVal::Delete(const Val* index)
 			else
 				{
 				// A set.
-				Val* has_old_val = new Val(1, TYPE_INT);
+				Val* has_old_val = val_mgr->GetInt(1);
 				StateAccess::Log(
 					new StateAccess(OP_DEL, this, index,
 							has_old_val));
@@ -2552,6 +2577,7 @@ unsigned int TableVal::MemoryAllocation() const
 RecordVal::RecordVal(RecordType* t) : MutableVal(t)
 	{
 	origin = 0;
+	lazy = false;
 	record_type = t;
 	int n = record_type->NumFields();
 	val_list* vl = val.val_list_val = new val_list(n);
@@ -2604,6 +2630,10 @@ RecordVal::~RecordVal()
 
 void RecordVal::Assign(int field, Val* new_val, Opcode op)
 	{
+	if ( lazy )
+		// Make sure a pending update doesn't overwrite the new value.
+		Materialize(field);
+
 	if ( new_val && Lookup(field) &&
 	     record_type->FieldType(field)->Tag() == TYPE_TABLE &&
 	     new_val->AsTableVal()->FindAttr(ATTR_MERGEABLE) )
@@ -2644,13 +2674,24 @@ void RecordVal::Assign(int field, Val* new_val, Opcode op)
 	Modified();
 	}
 
+Val* RecordVal::SizeVal() const
+	{
+	return val_mgr->GetCount(record_type->NumFields());
+	}
+
 Val* RecordVal::Lookup(int field) const
 	{
+	if ( lazy )
+		Materialize(field);
+
 	return (*AsRecord())[field];
 	}
 
 Val* RecordVal::LookupWithDefault(int field) const
 	{
+	if ( lazy )
+		Materialize(field);
+
 	Val* val = (*AsRecord())[field];
 
 	if ( val )
@@ -2669,6 +2710,15 @@ Val* RecordVal::Lookup(const char* field, bool with_default) const
 	return with_default ? LookupWithDefault(idx) : Lookup(idx);
 	}
 
+void RecordVal::MaterializeAll() const
+	{
+	if ( ! lazy )
+		return;
+
+	for ( int i = 0; i < record_type->NumFields(); ++i )
+		Materialize(i);
+	}
+
 RecordVal* RecordVal::CoerceTo(const RecordType* t, Val* aggr, bool allow_orphaning) const
 	{
 	if ( ! record_promotion_compatible(t->AsRecordType(), Type()->AsRecordType()) )
@@ -2744,6 +2794,8 @@ RecordVal* RecordVal::CoerceTo(RecordType* t, bool allow_orphaning)
 
 void RecordVal::Describe(ODesc* d) const
 	{
+	MaterializeAll();
+
 	const val_list* vl = AsRecord();
 	int n = vl->length();
 
@@ -2780,6 +2832,8 @@ void RecordVal::Describe(ODesc* d) const
 
 void RecordVal::DescribeReST(ODesc* d) const
 	{
+	MaterializeAll();
+
 	const val_list* vl = AsRecord();
 	int n = vl->length();
 
@@ -2819,6 +2873,8 @@ bool RecordVal::DoSerialize(SerialInfo* info) const
 	// casted table_type.
 	// FIXME: What about origin?
 
+	MaterializeAll();
+
 	if ( ! SERIALIZE(val.val_list_val->length()) )
 		return false;
 
@@ -2841,6 +2897,7 @@ bool RecordVal::DoUnserialize(UnserialInfo* info)
 
 	record_type = (RecordType*) type;
 	origin = 0;
+	lazy = false;
 
 	int len;
 	if ( ! UNSERIALIZE(&len) )
@@ -2912,6 +2969,11 @@ unsigned int RecordVal::MemoryAllocation() const
 	return size + padded_sizeof(*this) + val.val_list_val->MemoryAllocation();
 	}
 
+Val* EnumVal::SizeVal() const
+	{
+	return val_mgr->GetInt(val.int_val);
+	}
+
 void EnumVal::ValDescribe(ODesc* d) const
 	{
 	const char* ename = type->AsEnumType()->Lookup(val.int_val);
@@ -2972,7 +3034,7 @@ bool VectorVal::Assign(unsigned int index, Val* element, Opcode op)
 			{
 			if ( LoggingAccess() && op != OP_NONE )
 				{
-				Val* ival = new Val(index, TYPE_COUNT);
+				Val* ival = val_mgr->GetCount(index);
 				StateAccess::Log(new StateAccess(OP_ASSIGN_IDX,
 						this, ival, element,
 						(*val.vector_val)[index]));
@@ -2995,7 +3057,7 @@ bool VectorVal::Assign(unsigned int index, Val* element, Opcode op)
 		if ( element->IsMutableVal() )
 			element->AsMutableVal()->AddProperties(GetProperties());
 
-		Val* ival = new Val(index, TYPE_COUNT);
+		Val* ival = val_mgr->GetCount(index);
 
 		StateAccess::Log(new StateAccess(op == OP_INCR ?
 				OP_INCR_IDX : OP_ASSIGN_IDX,
@@ -3025,6 +3087,11 @@ bool VectorVal::AssignRepeat(unsigned int index, unsigned int how_many,
 	}
 
 
+Val* VectorVal::SizeVal() const
+	{
+	return val_mgr->GetCount(val.vector_val->size());
+	}
+
 Val* VectorVal::Lookup(unsigned int index) const
 	{
 	if ( index >= val.vector_val->size() )
@@ -3318,3 +3385,94 @@ void delete_vals(val_list* vals)
 		delete vals;
 		}
 	}
+
+ValManager::ValManager()
+	{
+	b_true = new Val(true, TYPE_BOOL);
+	b_false = new Val(false, TYPE_BOOL);
+
+	int num_ints = PREALLOCATED_INT_HIGHEST - PREALLOCATED_INT_LOWEST + 1;
+	ints = new Val*[num_ints];
+
+	for ( int i = 0; i < num_ints; ++i )
+		ints[i] = new Val(int64(PREALLOCATED_INT_LOWEST + i), TYPE_INT);
+
+	counts = new Val*[PREALLOCATED_COUNTS];
+
+	for ( int i = 0; i < PREALLOCATED_COUNTS; ++i )
+		counts[i] = new Val(uint64(i), TYPE_COUNT);
+
+	for ( int i = 0; i < NUM_PORT_SPACES; ++i )
+		ports[i] = 0;
+	}
+
+ValManager::~ValManager()
+	{
+	Unref(b_true);
+	Unref(b_false);
+
+	int num_ints = PREALLOCATED_INT_HIGHEST - PREALLOCATED_INT_LOWEST + 1;
+
+	for ( int i = 0; i < num_ints; ++i )
+		Unref(ints[i]);
+
+	for ( int i = 0; i < PREALLOCATED_COUNTS; ++i )
+		Unref(counts[i]);
+
+	delete [] ints;
+	delete [] counts;
+
+	for ( int i = 0; i < NUM_PORT_SPACES; ++i )
+		{
+		if ( ! ports[i] )
+			continue;
+
+		for ( int j = 0; j < 65536; ++j )
+			Unref(ports[i][j]);
+
+		delete [] ports[i];
+		}
+	}
+
+PortVal* ValManager::GetPort(uint32 port_num, TransportProto port_type)
+	{
+	if ( port_num >= 65536 )
+		// Let the constructor complain.
+		return new PortVal(port_num, port_type);
+
+	switch ( port_type ) {
+	case TRANSPORT_TCP:
+		return GetPort(port_num | TCP_PORT_MASK);
+
+	case TRANSPORT_UDP:
+		return GetPort(port_num | UDP_PORT_MASK);
+
+	case TRANSPORT_ICMP:
+		return GetPort(port_num | ICMP_PORT_MASK);
+
+	default:
+		return GetPort(port_num);
+	}
+	}
+
+PortVal* ValManager::GetPort(uint32 port_num)
+	{
+	if ( port_num >= 65536 * NUM_PORT_SPACES )
+		return new PortVal(port_num);
+
+	uint32 space = port_num >> 16;
+
+	if ( ! ports[space] )
+		{
+		ports[space] = new PortVal*[65536];
+		memset(ports[space], 0, 65536 * sizeof(PortVal*));
+		}
+
+	PortVal*& p = ports[space][port_num & 0xffff];
+
+	if ( ! p )
+		p = new PortVal(port_num);
+
+	p->Ref();
+	return p;
+	}
@@ -19,6 +19,7 @@
 #include "Scope.h"
 #include "StateAccess.h"
 #include "IPAddr.h"
+#include "SlabPool.h"
 
 class Val;
 class Func;
@@ -155,6 +156,10 @@ public:
 
 	virtual ~Val();
 
+	// Atomic values of derived classes that don't add any members come
+	// from the same pool.
+	DECLARE_SLAB_ALLOCATION()
+
 	Val* Ref()			{ ::Ref(this); return this; }
 	virtual Val* Clone() const;
 
@@ -509,7 +514,7 @@ public:
 	PortVal(uint32 p, TransportProto port_type);
 	PortVal(uint32 p);	// used for already-massaged port value.
 
-	Val* SizeVal() const	{ return new Val(val.uint_val, TYPE_INT); }
+	Val* SizeVal() const;
 
 	// Returns the port number in host order (not including the mask).
 	uint32 Port() const;
@@ -599,8 +604,7 @@ public:
 	StringVal(const string& s);
 	StringVal(int length, const char* s);
 
-	Val* SizeVal() const
-		{ return new Val(val.string_val->Len(), TYPE_COUNT); }
+	Val* SizeVal() const;
 
 	int Len()		{ return AsString()->Len(); }
 	const u_char* Bytes()	{ return AsString()->Bytes(); }
@@ -653,7 +657,7 @@ public:
 
 	TypeTag BaseTag() const		{ return tag; }
 
-	Val* SizeVal() const	{ return new Val(vals.length(), TYPE_COUNT); }
+	Val* SizeVal() const;
 
 	int Length() const		{ return vals.length(); }
 	Val* Index(const int n)		{ return vals[n]; }
@@ -760,7 +764,7 @@ public:
 	int Assign(Val* index, Val* new_val, Opcode op = OP_ASSIGN);
 	int Assign(Val* index, HashKey* k, Val* new_val, Opcode op = OP_ASSIGN);
 
-	Val* SizeVal() const	{ return new Val(Size(), TYPE_COUNT); }
+	Val* SizeVal() const;
 
 	// Add the entire contents of the table to the given value,
 	// which must also be a TableVal.
@@ -871,8 +875,9 @@ public:
 	RecordVal(RecordType* t);
 	~RecordVal();
 
-	Val* SizeVal() const
-		{ return new Val(record_type->NumFields(), TYPE_COUNT); }
+	DECLARE_SLAB_ALLOCATION()
+
+	Val* SizeVal() const;
 
 	void Assign(int field, Val* new_val, Opcode op = OP_ASSIGN);
 	Val* Lookup(int field) const;	// Does not Ref() value.
@@ -920,10 +925,17 @@ protected:
 	bool AddProperties(Properties arg_state);
 	bool RemoveProperties(Properties arg_state);
 
+	// Subclasses that compute some of their fields only on demand set
+	// lazy to true. Materialize() then gets called before a field is
+	// accessed, and needs to Assign() it if it isn't current.
+	virtual void Materialize(int field) const	{ }
+	void MaterializeAll() const;
+
 	DECLARE_SERIAL(RecordVal);
 
 	RecordType* record_type;
 	BroObj* origin;
+	bool lazy;
 };
 
 class EnumVal : public Val {
@@ -934,7 +946,7 @@ public:
 		type = t;
 		}
 
-	Val* SizeVal() const	{ return new Val(val.int_val, TYPE_INT); }
+	Val* SizeVal() const;
 
 protected:
 	friend class Val;
@@ -951,8 +963,7 @@ public:
 	VectorVal(VectorType* t);
 	~VectorVal();
 
-	Val* SizeVal() const
-		{ return new Val(uint32(val.vector_val->size()), TYPE_COUNT); }
+	Val* SizeVal() const;
 
 	// Returns false if the type of the argument was wrong.
 	// The vector will automatically grow to accomodate the index.
@@ -1020,6 +1031,57 @@ protected:
 	DECLARE_SERIAL(OpaqueVal);
 };
 
+// Hands out shared instances of frequently created atomic values, so that
+// we don't allocate (and soon free again) a new Val each time a script
+// yields T or F, a small count, or a port. Values are immutable, so
+// sharing them is transparent as long as callers never modify a Val they
+// didn't create themselves. All methods return a new reference.
+class ValManager {
+public:
+	static const int PREALLOCATED_COUNTS = 4096;
+	static const int PREALLOCATED_INT_LOWEST = -255;
+	static const int PREALLOCATED_INT_HIGHEST = 1023;
+
+	ValManager();
+	~ValManager();
+
+	Val* GetTrue() const	{ return b_true->Ref(); }
+	Val* GetFalse() const	{ return b_false->Ref(); }
+	Val* GetBool(bool b) const	{ return b ? GetTrue() : GetFalse(); }
+
+	Val* GetInt(int64 i) const
+		{
+		if ( i < PREALLOCATED_INT_LOWEST || i > PREALLOCATED_INT_HIGHEST )
+			return new Val(i, TYPE_INT);
+
+		return ints[i - PREALLOCATED_INT_LOWEST]->Ref();
+		}
+
+	Val* GetCount(uint64 u) const
+		{
+		if ( u >= PREALLOCATED_COUNTS )
+			return new Val(u, TYPE_COUNT);
+
+		return counts[u]->Ref();
+		}
+
+	// Takes the port number in host order, like the PortVal
+	// constructors.
+	PortVal* GetPort(uint32 port_num, TransportProto port_type);
+	PortVal* GetPort(uint32 port_num);	// already-massaged value
+
+private:
+	Val* b_true;
+	Val* b_false;
+	Val** ints;
+	Val** counts;
+
+	// Per port space, allocated when first needed, and filled lazily.
+	PortVal** ports[NUM_PORT_SPACES];
+};
+
+extern ValManager* val_mgr;
+
 // Checks the given value for consistency with the given type.  If an
 // exact match, returns it.  If promotable, returns the promoted version,
 // Unref()'ing the original.  If not a match, generates an error message
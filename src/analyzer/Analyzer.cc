@@ -654,7 +654,7 @@ void Analyzer::ProtocolConfirmation(Tag arg_tag)
 	val_list* vl = new val_list;
 	vl->append(BuildConnVal());
 	vl->append(tval);
-	vl->append(new Val(id, TYPE_COUNT));
+	vl->append(val_mgr->GetCount(id));
 
 	// We immediately raise the event so that the analyzer can quickly
 	// react if necessary.
@@ -685,7 +685,7 @@ void Analyzer::ProtocolViolation(const char* reason, const char* data, int len)
 	val_list* vl = new val_list;
 	vl->append(BuildConnVal());
 	vl->append(tval);
-	vl->append(new Val(id, TYPE_COUNT));
+	vl->append(val_mgr->GetCount(id));
 	vl->append(r);
 
 	// We immediately raise the event so that the analyzer can quickly be
@@ -231,7 +231,7 @@ void DCE_RPC_Session::DeliverPDU(int is_orig, int len, const u_char* data)
 		{
 		val_list* vl = new val_list;
 		vl->append(analyzer->BuildConnVal());
-		vl->append(new Val(is_orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(is_orig));
 		vl->append(new EnumVal(data[2], BifType::Enum::dce_rpc_ptype));
 		vl->append(new StringVal(len, (const char*) data));
 
@@ -311,7 +311,7 @@ void DCE_RPC_Session::DeliverRequest(const binpac::DCE_RPC_Simple::DCE_RPC_PDU*
 		{
 		val_list* vl = new val_list;
 		vl->append(analyzer->BuildConnVal());
-		vl->append(new Val(opnum, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(opnum));
 		vl->append(new StringVal(req->stub().length(),
 			(const char*) req->stub().begin()));
 
@@ -336,7 +336,7 @@ void DCE_RPC_Session::DeliverResponse(const binpac::DCE_RPC_Simple::DCE_RPC_PDU*
 		{
 		val_list* vl = new val_list;
 		vl->append(analyzer->BuildConnVal());
-		vl->append(new Val(opnum, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(opnum));
 		vl->append(new StringVal(resp->stub().length(),
 			(const char*) resp->stub().begin()));
 		analyzer->ConnectionEvent(dce_rpc_response, vl);
@@ -432,7 +432,7 @@ void DCE_RPC_Session::DeliverEpmapperMapResponse(
 				val_list* vl = new val_list;
 				vl->append(analyzer->BuildConnVal());
 				vl->append(new StringVal(mapped.uuid.to_string()));
-				vl->append(new PortVal(mapped.addr.port, mapped.addr.proto));
+				vl->append(val_mgr->GetPort(mapped.addr.port, mapped.addr.proto));
 				vl->append(new AddrVal(mapped.addr.addr));
 
 				analyzer->ConnectionEvent(epm_map_response, vl);
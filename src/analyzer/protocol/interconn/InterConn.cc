@@ -127,16 +127,16 @@ RecordVal* InterConnEndpoint::BuildStats()
 	{
 	RecordVal* stats = new RecordVal(interconn_endp_stats);
 
-	stats->Assign(0, new Val(num_pkts, TYPE_COUNT));
-	stats->Assign(1, new Val(num_keystrokes_two_in_a_row, TYPE_COUNT));
-	stats->Assign(2, new Val(num_normal_interarrivals, TYPE_COUNT));
-	stats->Assign(3, new Val(num_8k0_pkts, TYPE_COUNT));
-	stats->Assign(4, new Val(num_8k4_pkts, TYPE_COUNT));
-	stats->Assign(5, new Val(is_partial, TYPE_BOOL));
-	stats->Assign(6, new Val(num_bytes, TYPE_COUNT));
-	stats->Assign(7, new Val(num_7bit_ascii, TYPE_COUNT));
-	stats->Assign(8, new Val(num_lines, TYPE_COUNT));
-	stats->Assign(9, new Val(num_normal_lines, TYPE_COUNT));
+	stats->Assign(0, val_mgr->GetCount(num_pkts));
+	stats->Assign(1, val_mgr->GetCount(num_keystrokes_two_in_a_row));
+	stats->Assign(2, val_mgr->GetCount(num_normal_interarrivals));
+	stats->Assign(3, val_mgr->GetCount(num_8k0_pkts));
+	stats->Assign(4, val_mgr->GetCount(num_8k4_pkts));
+	stats->Assign(5, val_mgr->GetBool(is_partial));
+	stats->Assign(6, val_mgr->GetCount(num_bytes));
+	stats->Assign(7, val_mgr->GetCount(num_7bit_ascii));
+	stats->Assign(8, val_mgr->GetCount(num_lines));
+	stats->Assign(9, val_mgr->GetCount(num_normal_lines));
 
 	return stats;
 	}
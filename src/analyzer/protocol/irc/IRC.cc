@@ -209,10 +209,10 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
-			vl->append(new Val(users, TYPE_INT));
-			vl->append(new Val(services, TYPE_INT));
-			vl->append(new Val(servers, TYPE_INT));
+			vl->append(val_mgr->GetBool(orig));
+			vl->append(val_mgr->GetInt(users));
+			vl->append(val_mgr->GetInt(services));
+			vl->append(val_mgr->GetInt(servers));
 
 			ConnectionEvent(irc_network_info, vl);
 			}
@@ -246,7 +246,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(type.c_str()));
 			vl->append(new StringVal(channel.c_str()));
 
@@ -289,10 +289,10 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
-			vl->append(new Val(users, TYPE_INT));
-			vl->append(new Val(services, TYPE_INT));
-			vl->append(new Val(servers, TYPE_INT));
+			vl->append(val_mgr->GetBool(orig));
+			vl->append(val_mgr->GetInt(users));
+			vl->append(val_mgr->GetInt(services));
+			vl->append(val_mgr->GetInt(servers));
 
 			ConnectionEvent(irc_server_info, vl);
 			}
@@ -312,8 +312,8 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
-			vl->append(new Val(channels, TYPE_INT));
+			vl->append(val_mgr->GetBool(orig));
+			vl->append(val_mgr->GetInt(channels));
 
 			ConnectionEvent(irc_channel_info, vl);
 			}
@@ -345,7 +345,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(eop - prefix, prefix));
 			vl->append(new StringVal(++msg));
 			ConnectionEvent(irc_global_users, vl);
@@ -370,7 +370,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(parts[0].c_str()));
 			vl->append(new StringVal(parts[1].c_str()));
 			vl->append(new StringVal(parts[2].c_str()));
@@ -409,7 +409,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(parts[0].c_str()));
 
 			ConnectionEvent(irc_whois_operator_line, vl);
@@ -440,7 +440,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(nick.c_str()));
 			TableVal* set = new TableVal(string_set);
 			for ( unsigned int i = 0; i < parts.size(); ++i )
@@ -476,7 +476,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 				val_list* vl = new val_list;
 
 				vl->append(BuildConnVal());
-				vl->append(new Val(orig, TYPE_BOOL));
+				vl->append(val_mgr->GetBool(orig));
 				vl->append(new StringVal(parts[1].c_str()));
 
 				const char* t = topic.c_str();
@@ -510,7 +510,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(parts[0].c_str()));
 			vl->append(new StringVal(parts[1].c_str()));
 			if ( parts[2][0] == '~' )
@@ -522,7 +522,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 			vl->append(new StringVal(parts[6].c_str()));
 			if ( parts[7][0] == ':' )
 				parts[7] = parts[7].substr(1);
-			vl->append(new Val(atoi(parts[7].c_str()), TYPE_INT));
+			vl->append(val_mgr->GetInt(atoi(parts[7].c_str())));
 			vl->append(new StringVal(parts[8].c_str()));
 
 			ConnectionEvent(irc_who_line, vl);
@@ -538,7 +538,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 				{
 				val_list* vl = new val_list;
 				vl->append(BuildConnVal());
-				vl->append(new Val(orig, TYPE_BOOL));
+				vl->append(val_mgr->GetBool(orig));
 				ConnectionEvent(irc_invalid_nick, vl);
 				}
 			break;
@@ -550,8 +550,8 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 				{
 				val_list* vl = new val_list;
 				vl->append(BuildConnVal());
-				vl->append(new Val(orig, TYPE_BOOL));
-				vl->append(new Val(code == 381, TYPE_BOOL));
+				vl->append(val_mgr->GetBool(orig));
+				vl->append(val_mgr->GetBool(code == 381));
 				ConnectionEvent(irc_oper_response, vl);
 				}
 			break;
@@ -560,9 +560,9 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 		default:
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(prefix.c_str()));
-			vl->append(new Val(code, TYPE_COUNT));
+			vl->append(val_mgr->GetCount(code));
 			vl->append(new StringVal(params.c_str()));
 
 			ConnectionEvent(irc_reply, vl);
@@ -629,18 +629,17 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(prefix.c_str()));
 			vl->append(new StringVal(target.c_str()));
 			vl->append(new StringVal(parts[1].c_str()));
 			vl->append(new StringVal(parts[2].c_str()));
 			vl->append(new AddrVal(htonl(raw_ip)));
-			vl->append(new Val(atoi(parts[4].c_str()), TYPE_COUNT));
+			vl->append(val_mgr->GetCount(atoi(parts[4].c_str())));
 			if ( parts.size() >= 6 )
-				vl->append(new Val(atoi(parts[5].c_str()),
-							TYPE_COUNT));
+				vl->append(val_mgr->GetCount(atoi(parts[5].c_str())));
 			else
-				vl->append(new Val(0, TYPE_COUNT));
+				vl->append(val_mgr->GetCount(0));
 
 			ConnectionEvent(irc_dcc_message, vl);
 			}
@@ -649,7 +648,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 			{
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(prefix.c_str()));
 			vl->append(new StringVal(target.c_str()));
 			vl->append(new StringVal(message.c_str()));
@@ -674,7 +673,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(prefix.c_str()));
 		vl->append(new StringVal(target.c_str()));
 		vl->append(new StringVal(message.c_str()));
@@ -698,7 +697,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(prefix.c_str()));
 		vl->append(new StringVal(target.c_str()));
 		vl->append(new StringVal(message.c_str()));
@@ -712,7 +711,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 		vector<string> parts = SplitWords(params, ' ');
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 
 		if ( parts.size() > 0 )
 			vl->append(new StringVal(parts[0].c_str()));
@@ -748,7 +747,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 			{
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(parts[0].c_str()));
 			vl->append(new StringVal(parts[1].c_str()));
 
@@ -771,7 +770,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(prefix.c_str()));
 		vl->append(new StringVal(parts[0].c_str()));
 		vl->append(new StringVal(parts[1].c_str()));
@@ -815,7 +814,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 
 		TableVal* list = new TableVal(irc_join_list);
 		vector<string> channels = SplitWords(parts[0], ',');
@@ -862,7 +861,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 
 		TableVal* list = new TableVal(irc_join_list);
 		string empty_string = "";
@@ -940,7 +939,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(nick.c_str()));
 		vl->append(set);
 		vl->append(new StringVal(message.c_str()));
@@ -964,8 +963,8 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(nickname.c_str()));
 		vl->append(new StringVal(message.c_str()));
 
@@ -980,7 +979,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(prefix.c_str()));
 		vl->append(new StringVal(nick.c_str()));
 
@@ -1006,9 +1005,9 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(parts[0].c_str()));
-		vl->append(new Val(oper, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(oper));
 
 		ConnectionEvent(irc_who_message, vl);
 		}
@@ -1035,7 +1034,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(server.c_str()));
 		vl->append(new StringVal(users.c_str()));
 
@@ -1046,7 +1045,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 		{
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(prefix.c_str()));
 		if ( params[0] == ':' )
 			params = params.substr(1);
@@ -1065,7 +1064,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(prefix.c_str()));
 			vl->append(new StringVal(parts[0].c_str()));
 			vl->append(new StringVal(parts[1].c_str()));
@@ -1082,7 +1081,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 			{
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(prefix.c_str()));
 			vl->append(new StringVal(params.c_str()));
 
@@ -1097,7 +1096,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 		{
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(params.c_str()));
 		ConnectionEvent(irc_password_message, vl);
 		}
@@ -1118,7 +1117,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 
 		val_list* vl = new val_list;
 		vl->append(BuildConnVal());
-		vl->append(new Val(orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(orig));
 		vl->append(new StringVal(prefix.c_str()));
 		vl->append(new StringVal(server.c_str()));
 		vl->append(new StringVal(message.c_str()));
@@ -1133,7 +1132,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 			{
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(prefix.c_str()));
 			vl->append(new StringVal(command.c_str()));
 			vl->append(new StringVal(params.c_str()));
@@ -1148,7 +1147,7 @@ void IRC_Analyzer::DeliverStream(int length, const u_char* line, bool orig)
 			{
 			val_list* vl = new val_list;
 			vl->append(BuildConnVal());
-			vl->append(new Val(orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(orig));
 			vl->append(new StringVal(prefix.c_str()));
 			vl->append(new StringVal(command.c_str()));
 			vl->append(new StringVal(params.c_str()));
@@ -170,9 +170,9 @@ void Rsh_Analyzer::DeliverStream(int len, const u_char* data, bool orig)
 		{
 		if ( contents_orig->RshSaveState() == RSH_SERVER_USER_NAME )
 			// First input
-			vl->append(new Val(true, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(true));
 		else
-			vl->append(new Val(false, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(false));
 
 		ConnectionEvent(rsh_request, vl);
 		}
@@ -6,6 +6,8 @@
 
 using namespace analyzer::pia;
 
+IMPLEMENT_SLAB_ALLOCATION(PIA_TCP, "PIA_TCP")
+
 PIA::PIA(analyzer::Analyzer* arg_as_analyzer)
 	: state(INIT), as_analyzer(arg_as_analyzer), conn(), current_packet()
 	{
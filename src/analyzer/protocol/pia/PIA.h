@@ -126,6 +126,8 @@ public:
 
 	virtual ~PIA_TCP();
 
+	DECLARE_SLAB_ALLOCATION()
+
 	virtual void Init();
 
 	// The first packet for each direction of a connection is passed
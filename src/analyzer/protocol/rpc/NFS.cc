@@ -294,10 +294,10 @@ val_list* NFS_Interp::event_common_vl(RPC_CallInfo *c, BifEnum::rpc_status rpc_s
 	info->Assign(1, new EnumVal(nfs_status, BifType::Enum::NFS3::status_t));
 	info->Assign(2, new Val(c->StartTime(), TYPE_TIME));
 	info->Assign(3, new Val(c->LastTime()-c->StartTime(), TYPE_INTERVAL));
-	info->Assign(4, new Val(c->RPCLen(), TYPE_COUNT));
+	info->Assign(4, val_mgr->GetCount(c->RPCLen()));
 	info->Assign(5, new Val(rep_start_time, TYPE_TIME));
 	info->Assign(6, new Val(rep_last_time-rep_start_time, TYPE_INTERVAL));
-	info->Assign(7, new Val(reply_len, TYPE_COUNT));
+	info->Assign(7, val_mgr->GetCount(reply_len));
 
 	vl->append(info);
 	return vl;
@@ -451,7 +451,7 @@ RecordVal* NFS_Interp::nfs3_read_reply(const u_char*& buf, int& n, BifEnum::NFS3
 
 		rep->Assign(0, nfs3_post_op_attr(buf, n));
 		bytes_read = extract_XDR_uint32(buf, n);
-		rep->Assign(1, new Val(bytes_read, TYPE_COUNT));
+		rep->Assign(1, val_mgr->GetCount(bytes_read));
 		rep->Assign(2, ExtractBool(buf, n));
 		rep->Assign(3, nfs3_file_data(buf, n, offset, bytes_read));
 		}
@@ -490,8 +490,8 @@ RecordVal *NFS_Interp::nfs3_writeargs(const u_char*& buf, int& n)
 	bytes = extract_XDR_uint32(buf, n);
 
 	writeargs->Assign(0, nfs3_fh(buf, n));
-	writeargs->Assign(1, new Val(offset, TYPE_COUNT));
-	writeargs->Assign(2, new Val(bytes, TYPE_COUNT));
+	writeargs->Assign(1, val_mgr->GetCount(offset));
+	writeargs->Assign(2, val_mgr->GetCount(bytes));
 	writeargs->Assign(3, nfs3_stable_how(buf, n));
 	writeargs->Assign(4, nfs3_file_data(buf, n, offset, bytes));
 
@@ -562,7 +562,7 @@ RecordVal* NFS_Interp::nfs3_readdirargs(bool isplus, const u_char*& buf, int&n)
 	{
 	RecordVal *args = new RecordVal(BifType::Record::NFS3::readdirargs_t);
 
-	args->Assign(0, new Val(isplus, TYPE_BOOL));
+	args->Assign(0, val_mgr->GetBool(isplus));
 	args->Assign(1, nfs3_fh(buf, n));
 	args->Assign(2, ExtractUint64(buf,n));	// cookie
 	args->Assign(3, ExtractUint64(buf,n));	// cookieverf
@@ -579,7 +579,7 @@ RecordVal* NFS_Interp::nfs3_readdir_reply(bool isplus, const u_char*& buf,
 	{
 	RecordVal *rep = new RecordVal(BifType::Record::NFS3::readdir_reply_t);
 
-	rep->Assign(0, new Val(isplus, TYPE_BOOL));
+	rep->Assign(0, val_mgr->GetBool(isplus));
 
 	if ( status == BifEnum::NFS3::NFS3ERR_OK )
 		{
@@ -621,12 +621,12 @@ RecordVal* NFS_Interp::nfs3_readdir_reply(bool isplus, const u_char*& buf,
 
 Val* NFS_Interp::ExtractUint32(const u_char*& buf, int& n)
 	{
-	return new Val(extract_XDR_uint32(buf, n), TYPE_COUNT);
+	return val_mgr->GetCount(extract_XDR_uint32(buf, n));
 	}
 
 Val* NFS_Interp::ExtractUint64(const u_char*& buf, int& n)
 	{
-	return new Val(extract_XDR_uint64(buf, n), TYPE_COUNT);
+	return val_mgr->GetCount(extract_XDR_uint64(buf, n));
 	}
 
 Val* NFS_Interp::ExtractTime(const u_char*& buf, int& n)
@@ -641,7 +641,7 @@ Val* NFS_Interp::ExtractInterval(const u_char*& buf, int& n)
 
 Val* NFS_Interp::ExtractBool(const u_char*& buf, int& n)
 	{
-	return new Val(extract_XDR_uint32(buf, n), TYPE_BOOL);
+	return val_mgr->GetBool(extract_XDR_uint32(buf, n));
 	}
 
 
@@ -299,13 +299,13 @@ void RPC_Interpreter::Event_RPC_Dialogue(RPC_CallInfo* c, BifEnum::rpc_status st
 		{
 		val_list* vl = new val_list;
 		vl->append(analyzer->BuildConnVal());
-		vl->append(new Val(c->Program(), TYPE_COUNT));
-		vl->append(new Val(c->Version(), TYPE_COUNT));
-		vl->append(new Val(c->Proc(), TYPE_COUNT));
+		vl->append(val_mgr->GetCount(c->Program()));
+		vl->append(val_mgr->GetCount(c->Version()));
+		vl->append(val_mgr->GetCount(c->Proc()));
 		vl->append(new EnumVal(status, BifType::Enum::rpc_status));
 		vl->append(new Val(c->StartTime(), TYPE_TIME));
-		vl->append(new Val(c->CallLen(), TYPE_COUNT));
-		vl->append(new Val(reply_len, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(c->CallLen()));
+		vl->append(val_mgr->GetCount(reply_len));
 		analyzer->ConnectionEvent(rpc_dialogue, vl);
 		}
 	}
@@ -316,11 +316,11 @@ void RPC_Interpreter::Event_RPC_Call(RPC_CallInfo* c)
 		{
 		val_list* vl = new val_list;
 		vl->append(analyzer->BuildConnVal());
-		vl->append(new Val(c->XID(), TYPE_COUNT));
-		vl->append(new Val(c->Program(), TYPE_COUNT));
-		vl->append(new Val(c->Version(), TYPE_COUNT));
-		vl->append(new Val(c->Proc(), TYPE_COUNT));
-		vl->append(new Val(c->CallLen(), TYPE_COUNT));
+		vl->append(val_mgr->GetCount(c->XID()));
+		vl->append(val_mgr->GetCount(c->Program()));
+		vl->append(val_mgr->GetCount(c->Version()));
+		vl->append(val_mgr->GetCount(c->Proc()));
+		vl->append(val_mgr->GetCount(c->CallLen()));
 		analyzer->ConnectionEvent(rpc_call, vl);
 		}
 	}
@@ -331,9 +331,9 @@ void RPC_Interpreter::Event_RPC_Reply(uint32_t xid, BifEnum::rpc_status status,
 		{
 		val_list* vl = new val_list;
 		vl->append(analyzer->BuildConnVal());
-		vl->append(new Val(xid, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(xid));
 		vl->append(new EnumVal(status, BifType::Enum::rpc_status));
-		vl->append(new Val(reply_len, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(reply_len));
 		analyzer->ConnectionEvent(rpc_reply, vl);
 		}
 	}
@@ -197,9 +197,9 @@ void SMB_Session::ParseMessage(int is_orig, int cmd,
 
 		vl->append(analyzer->BuildConnVal());
 		vl->append(BuildHeaderVal(hdr));
-		vl->append(new Val(is_orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(is_orig));
 		vl->append(cmd_str);
-		vl->append(new Val(body.length(), TYPE_COUNT));
+		vl->append(val_mgr->GetCount(body.length()));
 		vl->append(new StringVal(body.length(),
 					(const char*) body.data()));
 
@@ -237,7 +237,7 @@ void SMB_Session::ParseMessage(int is_orig, int cmd,
 
 		vl->append(analyzer->BuildConnVal());
 		vl->append(BuildHeaderVal(hdr));
-		vl->append(new Val(cmd, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(cmd));
 		vl->append(cmd_str);
 		vl->append(new StringVal(body.length(),
 					(const char*) body.data()));
@@ -336,7 +336,7 @@ int SMB_Session::ParseNegotiate(binpac::SMB::SMB_header const& hdr,
 			{
 			binpac::SMB::SMB_dialect* d = (*msg.dialects())[i];
 			BroString* tmp = ExtractString(d->dialectname());
-			t->Assign(new Val(i, TYPE_COUNT), new StringVal(tmp));
+			t->Assign(val_mgr->GetCount(i), new StringVal(tmp));
 			}
 
 		val_list* vl = new val_list;
@@ -361,7 +361,7 @@ int SMB_Session::ParseNegotiateResponse(binpac::SMB::SMB_header const& hdr,
 		val_list* vl = new val_list;
 		vl->append(analyzer->BuildConnVal());
 		vl->append(BuildHeaderVal(hdr));
-		vl->append(new Val(msg.dialect_index(), TYPE_COUNT));
+		vl->append(val_mgr->GetCount(msg.dialect_index()));
 
 		analyzer->ConnectionEvent(smb_com_negotiate_response, vl);
 		}
@@ -483,7 +483,7 @@ int SMB_Session::ParseTreeConnectAndx(binpac::SMB::SMB_header const& hdr,
 	norm_path->ToUpper();
 
 	RecordVal* r = new RecordVal(smb_tree_connect);
-	r->Assign(0, new Val(req.flags(), TYPE_COUNT));
+	r->Assign(0, val_mgr->GetCount(req.flags()));
 	r->Assign(1, new StringVal(req.password_length(),
 					(const char*) req.password()));
 	r->Assign(2, new StringVal(path));
@@ -664,7 +664,7 @@ int SMB_Session::TransactionEvent(EventHandlerPtr f, int is_orig,
 		vl->append(BuildHeaderVal(hdr));
 		vl->append(BuildTransactionVal(trans));
 		vl->append(BuildTransactionDataVal(data));
-		vl->append(new Val(is_orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(is_orig));
 
 		analyzer->ConnectionEvent(f, vl);
 		}
@@ -689,7 +689,7 @@ int SMB_Session::TransactionEvent(EventHandlerPtr f, int is_orig,
 		vl->append(BuildHeaderVal(hdr));
 		vl->append(BuildTransactionVal(trans));
 		vl->append(BuildTransactionDataVal(data));
-		vl->append(new Val(is_orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(is_orig));
 
 		analyzer->ConnectionEvent(f, vl);
 		}
@@ -714,7 +714,7 @@ int SMB_Session::TransactionEvent(EventHandlerPtr f, int is_orig,
 		vl->append(BuildHeaderVal(hdr));
 		vl->append(BuildTransactionVal(trans));
 		vl->append(BuildTransactionDataVal(data));
-		vl->append(new Val(is_orig, TYPE_BOOL));
+		vl->append(val_mgr->GetBool(is_orig));
 
 		analyzer->ConnectionEvent(f, vl);
 		}
@@ -900,7 +900,7 @@ int SMB_Session::ParseGetDFSReferral(binpac::SMB::SMB_header const& hdr,
 		val_list* vl = new val_list;
 		vl->append(analyzer->BuildConnVal());
 		vl->append(BuildHeaderVal(hdr));
-		vl->append(new Val(req.max_referral_level(), TYPE_COUNT));
+		vl->append(val_mgr->GetCount(req.max_referral_level()));
 		vl->append(new StringVal(ExtractString(req.file_name())));
 
 		analyzer->ConnectionEvent(smb_get_dfs_referral, vl);
@@ -1006,14 +1006,14 @@ Val* SMB_Session::BuildHeaderVal(binpac::SMB::SMB_header const& hdr)
 		{ // do nothing
 		}
 
-	r->Assign(0, new Val(hdr.command(), TYPE_COUNT));
-	r->Assign(1, new Val(status, TYPE_COUNT));
-	r->Assign(2, new Val(hdr.flags(), TYPE_COUNT));
-	r->Assign(3, new Val(hdr.flags2(), TYPE_COUNT));
-	r->Assign(4, new Val(hdr.tid(), TYPE_COUNT));
-	r->Assign(5, new Val(hdr.pid(), TYPE_COUNT));
-	r->Assign(6, new Val(hdr.uid(), TYPE_COUNT));
-	r->Assign(7, new Val(hdr.mid(), TYPE_COUNT));
+	r->Assign(0, val_mgr->GetCount(hdr.command()));
+	r->Assign(1, val_mgr->GetCount(status));
+	r->Assign(2, val_mgr->GetCount(hdr.flags()));
+	r->Assign(3, val_mgr->GetCount(hdr.flags2()));
+	r->Assign(4, val_mgr->GetCount(hdr.tid()));
+	r->Assign(5, val_mgr->GetCount(hdr.pid()));
+	r->Assign(6, val_mgr->GetCount(hdr.uid()));
+	r->Assign(7, val_mgr->GetCount(hdr.mid()));
 
 	return r;
 	}
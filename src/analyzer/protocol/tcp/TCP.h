@@ -43,6 +43,8 @@ public:
 	TCP_Analyzer(Connection* conn);
 	virtual ~TCP_Analyzer();
 
+	DECLARE_SLAB_ALLOCATION()
+
 	void EnableReassembly();
 
 	// Add a child analyzer that will always get the packets,
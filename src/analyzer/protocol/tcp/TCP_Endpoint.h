@@ -4,6 +4,7 @@
 #define ANALYZER_PROTOCOL_TCP_TCP_ENDPOINT_H
 
 #include "IPAddr.h"
+#include "SlabPool.h"
 
 class Connection;
 class IP_Hdr;
@@ -30,6 +31,8 @@ public:
 	TCP_Endpoint(TCP_Analyzer* analyzer, int is_orig);
 	~TCP_Endpoint();
 
+	DECLARE_SLAB_ALLOCATION()
+
 	void Done();
 
 	TCP_Analyzer* TCP()	{ return tcp_analyzer; }
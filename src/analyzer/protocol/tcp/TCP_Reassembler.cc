@@ -12,6 +12,8 @@
 
 using namespace analyzer::tcp;
 
+IMPLEMENT_SLAB_ALLOCATION(TCP_Reassembler, "TCP_Reassembler")
+
 // Note, sequence numbers are relative. I.e., they start with 1.
 
 const bool DEBUG_tcp_contents = false;
@@ -143,9 +145,9 @@ void TCP_Reassembler::Gap(uint64 seq, uint64 len)
 		{
 		val_list* vl = new val_list;
 		vl->append(dst_analyzer->BuildConnVal());
-		vl->append(new Val(IsOrig(), TYPE_BOOL));
-		vl->append(new Val(seq, TYPE_COUNT));
-		vl->append(new Val(len, TYPE_COUNT));
+		vl->append(val_mgr->GetBool(IsOrig()));
+		vl->append(val_mgr->GetCount(seq));
+		vl->append(val_mgr->GetCount(len));
 		dst_analyzer->ConnectionEvent(content_gap, vl);
 		}
 
@@ -342,7 +344,7 @@ void TCP_Reassembler::RecordBlock(DataBlock* b, BroFile* f)
 		{
 		val_list* vl = new val_list();
 		vl->append(Endpoint()->Conn()->BuildConnVal());
-		vl->append(new Val(IsOrig(), TYPE_BOOL));
+		vl->append(val_mgr->GetBool(IsOrig()));
 		vl->append(new StringVal("TCP reassembler content write failure"));
 		tcp_analyzer->ConnectionEvent(contents_file_write_failure, vl);
 		}
@@ -359,7 +361,7 @@ void TCP_Reassembler::RecordGap(uint64 start_seq, uint64 upper_seq, BroFile* f)
 		{
 		val_list* vl = new val_list();
 		vl->append(Endpoint()->Conn()->BuildConnVal());
-		vl->append(new Val(IsOrig(), TYPE_BOOL));
+		vl->append(val_mgr->GetBool(IsOrig()));
 		vl->append(new StringVal("TCP reassembler gap write failure"));
 		tcp_analyzer->ConnectionEvent(contents_file_write_failure, vl);
 		}
@@ -550,10 +552,10 @@ void TCP_Reassembler::AckReceived(uint64 seq)
 			uint64 dgap_bytes = tot_gap_bytes - last_gap_bytes;
 
 			RecordVal* r = new RecordVal(gap_info);
-			r->Assign(0, new Val(devents, TYPE_COUNT));
-			r->Assign(1, new Val(dbytes, TYPE_COUNT));
-			r->Assign(2, new Val(dgaps, TYPE_COUNT));
-			r->Assign(3, new Val(dgap_bytes, TYPE_COUNT));
+			r->Assign(0, val_mgr->GetCount(devents));
+			r->Assign(1, val_mgr->GetCount(dbytes));
+			r->Assign(2, val_mgr->GetCount(dgaps));
+			r->Assign(3, val_mgr->GetCount(dgap_bytes));
 
 			val_list* vl = new val_list;
 			vl->append(new IntervalVal(dt, Seconds));
@@ -627,8 +629,8 @@ void TCP_Reassembler::DeliverBlock(uint64 seq, int len, const u_char* data)
 		{
 		val_list* vl = new val_list();
 		vl->append(tcp_analyzer->BuildConnVal());
-		vl->append(new Val(IsOrig(), TYPE_BOOL));
-		vl->append(new Val(seq, TYPE_COUNT));
+		vl->append(val_mgr->GetBool(IsOrig()));
+		vl->append(val_mgr->GetCount(seq));
 		vl->append(new StringVal(len, (const char*) data));
 
 		tcp_analyzer->ConnectionEvent(tcp_contents, vl);
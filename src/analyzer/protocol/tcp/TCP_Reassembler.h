@@ -26,6 +26,8 @@ public:
 
 	virtual ~TCP_Reassembler();
 
+	DECLARE_SLAB_ALLOCATION()
+
 	void Done();
 
 	void SetDstAnalyzer(Analyzer* analyzer)	{ dst_analyzer = analyzer; }
@@ -81,3 +81,10 @@ void BuiltinFuncArg::PrintBroValConstructor(FILE* fp)
 	{
 	fprintf(fp, builtin_func_arg_type[type].constructor, name);
 	}
+
+void BuiltinFuncArg::PrintBroValUnref(FILE* fp)
+	{
+	// Arguments passed in as Vals are owned by the generate function.
+	if ( ! strcmp(builtin_func_arg_type[type].constructor, "%s") )
+		fprintf(fp, "\t\tUnref(%s);\n", name);
+	}
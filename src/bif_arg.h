@@ -40,6 +40,7 @@ public:
 	void PrintCDef(FILE* fp, int n);
 	void PrintCArg(FILE* fp, int n);
 	void PrintBroValConstructor(FILE* fp);
+	void PrintBroValUnref(FILE* fp);
 
 protected:
 	const char* name;
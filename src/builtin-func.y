@@ -222,12 +222,20 @@ void print_event_c_prototype(FILE *fp, bool is_header)
 void print_event_c_body(FILE *fp)
 	{
 	fprintf(fp, "\t{\n");
-	fprintf(fp, "\t// Note that it is intentional that here we do not\n");
-	fprintf(fp, "\t// check if %s is NULL, which should happen *before*\n",
+	fprintf(fp, "\t// Callers should check if %s is NULL\n",
 		decl.c_fullname.c_str());
-	fprintf(fp, "\t// %s is called to avoid unnecessary Val\n",
+	fprintf(fp, "\t// *before* %s is called to avoid\n",
 		decl.generate_c_fullname.c_str());
-	fprintf(fp, "\t// allocation.\n");
+	fprintf(fp, "\t// unnecessary Val allocation. For those that don't,\n");
+	fprintf(fp, "\t// we still skip building the connection record.\n");
+	fprintf(fp, "\tif ( ! %s )\n", decl.c_fullname.c_str());
+	fprintf(fp, "\t\t{\n");
+
+	for ( int i = 0; i < (int) args.size(); ++i )
+		args[i]->PrintBroValUnref(fp);
+
+	fprintf(fp, "\t\treturn;\n");
+	fprintf(fp, "\t\t}\n");
 	fprintf(fp, "\n");
 
 	fprintf(fp, "\tval_list* vl = new val_list;\n\n");
@@ -0,0 +1,306 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include <string.h>
+#include <poll.h>
+
+#include "AsyncJob.h"
+#include "File.h"
+#include "Manager.h"
+#include "Reporter.h"
+#include "Hash.h"
+
+using namespace file_analysis;
+
+namespace file_analysis {
+
+// Passes a chunk of file data to a job.
+class FeedMessage : public threading::InputMessage<AsyncThread> {
+public:
+	FeedMessage(AsyncThread* thread, AsyncJob* arg_job, DataChunk* arg_chunk,
+	            uint64 arg_len, uint64 arg_offset)
+		: threading::InputMessage<AsyncThread>("Feed", thread),
+		  job(arg_job), chunk(arg_chunk), len(arg_len), offset(arg_offset)
+		{ chunk->Ref(); }
+
+	virtual ~FeedMessage()	{ chunk->Unref(); }
+
+	virtual bool Process()
+		{
+		// Jobs may defer hashing the data until the end of the batch.
+		Object()->Hold(chunk);
+		job->Feed(chunk->Data(), len, offset);
+		Object()->RemoveQueuedBytes(len);
+		return true;
+		}
+
+private:
+	AsyncJob* job;
+	DataChunk* chunk;
+	uint64 len;
+	uint64 offset;
+};
+
+// Passes the end of a file's data to a job.
+class FinishJobMessage : public threading::InputMessage<AsyncThread> {
+public:
+	FinishJobMessage(AsyncThread* thread, AsyncJob* arg_job)
+		: threading::InputMessage<AsyncThread>("FinishJob", thread),
+		  job(arg_job)
+		{ }
+
+	virtual bool Process();
+
+private:
+	AsyncJob* job;
+};
+
+// Hands a finished job back to the main thread.
+class JobFinishedMessage : public threading::OutputMessage<AsyncThread> {
+public:
+	JobFinishedMessage(AsyncThread* thread, AsyncJob* arg_job)
+		: threading::OutputMessage<AsyncThread>("JobFinished", thread),
+		  job(arg_job)
+		{ }
+
+	virtual bool Process()
+		{
+		--Object()->pending_jobs;
+		file_mgr->AsyncThreads()->JobFinished(job);
+		return true;
+		}
+
+private:
+	AsyncJob* job;
+};
+
+bool FinishJobMessage::Process()
+	{
+	job->Finish();
+	Object()->SendOut(new JobFinishedMessage(Object(), job));
+	return true;
+	}
+
+}
+
+DataChunk::DataChunk(const u_char* arg_data, uint64 arg_len)
+	{
+	len = arg_len;
+	data = new u_char[len];
+	memcpy(data, arg_data, len);
+	ref_cnt = 1;
+	}
+
+AsyncJob::AsyncJob(File* arg_file)
+	{
+	file = arg_file;
+	thread = file_mgr->AsyncThreads()->ThreadFor(file);
+	aborted = false;
+	overrun = false;
+	}
+
+AsyncJob::~AsyncJob()
+	{
+	}
+
+AsyncThread::AsyncThread(int num) : MsgThread()
+	{
+	queued_bytes = 0;
+	pending_jobs = 0;
+	SetName(fmt("file-analysis-%d", num));
+	}
+
+AsyncThread::~AsyncThread()
+	{
+	FlushHashes();
+	}
+
+bool AsyncThread::OnFinish(double network_time)
+	{
+	FlushHashes();
+	return true;
+	}
+
+void AsyncThread::OnBatchProcessed()
+	{
+	FlushHashes();
+	}
+
+void AsyncThread::FlushHashes()
+	{
+	hashes.Flush();
+
+	for ( size_t i = 0; i < held.size(); ++i )
+		held[i]->Unref();
+
+	held.clear();
+	}
+
+void AsyncThread::WaitForJobs()
+	{
+	while ( pending_jobs > 0 && ! Killed() )
+		{
+		if ( ! HasOut() )
+			{
+			// Sleep until the thread queues its next message.
+			struct pollfd pfd;
+			pfd.fd = OutFD();
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+			poll(&pfd, 1, 100);
+			continue;
+			}
+
+		threading::BasicOutputMessage* msg = RetrieveOut();
+
+		if ( ! msg )
+			continue;
+
+		if ( ! msg->Process() )
+			reporter->Error("%s failed", msg->Name());
+
+		delete msg;
+		}
+	}
+
+AsyncThreadPool::AsyncThreadPool()
+	{
+	max_queued = 0;
+	cur_data = 0;
+	cur_chunk = 0;
+	}
+
+AsyncThreadPool::~AsyncThreadPool()
+	{
+	EndOfData();
+	}
+
+void AsyncThreadPool::Start(int num_threads, uint64 arg_max_queued)
+	{
+	max_queued = arg_max_queued;
+
+	for ( int i = 0; i < num_threads; ++i )
+		{
+		AsyncThread* t = new AsyncThread(i);
+		t->Start();
+		threads.push_back(t);
+		}
+	}
+
+void AsyncThreadPool::Terminate()
+	{
+	EndOfData();
+
+	for ( size_t i = 0; i < threads.size(); ++i )
+		{
+		threads[i]->WaitForJobs();
+
+		if ( threads[i]->pending_jobs > 0 )
+			reporter->InternalWarning("%s: %d file analysis jobs lost",
+			                          threads[i]->Name(),
+			                          threads[i]->pending_jobs);
+		}
+
+	// The threading::Manager stops and deletes the threads themselves.
+	threads.clear();
+	}
+
+AsyncThread* AsyncThreadPool::ThreadFor(const File* file) const
+	{
+	if ( threads.empty() )
+		return 0;
+
+	const string& id = file->GetID();
+	hash_t h = HashKey::HashBytes(id.data(), id.size());
+	return threads[h % threads.size()];
+	}
+
+void AsyncThreadPool::Feed(AsyncJob* job, const u_char* data, uint64 len,
+                           uint64 offset)
+	{
+	if ( ! job->thread || threads.empty() )
+		{
+		job->thread = 0;
+		job->Feed(data, len, offset);
+		return;
+		}
+
+	if ( job->overrun )
+		return;
+
+	AsyncThread* t = job->thread;
+
+	// Don't let a thread that can't keep up pile up data without bounds,
+	// nor hold up packet processing waiting for it. Instead, the job
+	// gives up on the rest of its data.
+	if ( max_queued && t->QueuedBytes() > max_queued )
+		{
+		job->overrun = true;
+		reporter->Weird("file_analysis_thread_overrun");
+		return;
+		}
+
+	// Jobs may be fed just a prefix of the data, like when extraction
+	// hits its limit.
+	if ( ! cur_chunk || cur_data != data || len > cur_chunk->Len() )
+		{
+		EndOfData();
+		cur_data = data;
+		cur_chunk = new DataChunk(data, len);
+		}
+
+	t->AddQueuedBytes(len);
+	t->SendIn(new FeedMessage(t, job, cur_chunk, len, offset));
+	}
+
+void AsyncThreadPool::EndOfData()
+	{
+	if ( ! cur_chunk )
+		return;
+
+	cur_chunk->Unref();
+	cur_chunk = 0;
+	cur_data = 0;
+	}
+
+void AsyncThreadPool::Finish(AsyncJob* job, bool abort)
+	{
+	job->aborted = abort;
+
+	if ( ! job->thread || threads.empty() )
+		{
+		// Either jobs execute inline, or we're past Terminate() and
+		// the job's thread may not be around anymore, having
+		// processed all of the job's data before stopping.
+		job->thread = 0;
+		job->Finish();
+		JobFinished(job);
+		return;
+		}
+
+	if ( ! abort )
+		job->file->AsyncJobStarted();
+
+	++job->thread->pending_jobs;
+	job->thread->SendIn(new FinishJobMessage(job->thread, job));
+	}
+
+void AsyncThreadPool::JobFinished(AsyncJob* job)
+	{
+	if ( job->aborted )
+		{
+		delete job;
+		return;
+		}
+
+	File* f = job->file;
+	bool threaded = job->thread != 0;
+
+	// An overrun job's result would be based on partial data.
+	if ( ! job->overrun )
+		job->Done();
+
+	delete job;
+
+	if ( threaded )
+		file_mgr->AsyncJobDone(f);
+	}
@@ -0,0 +1,303 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef FILE_ANALYSIS_ASYNCJOB_H
+#define FILE_ANALYSIS_ASYNCJOB_H
+
+#include <vector>
+
+#include "util.h"
+#include "MultiHash.h"
+#include "threading/MsgThread.h"
+
+namespace file_analysis {
+
+class File;
+class AsyncThread;
+
+/**
+ * A reference-counted copy of a chunk of file data.  One copy gets
+ * shared by all the jobs of a file that need to see the chunk, no matter
+ * how many of them there are.  References may be released from any
+ * thread.
+ */
+class DataChunk {
+public:
+	/**
+	 * Constructor.  Copies the data, with a reference count of one.
+	 * @param data pointer to a chunk of file data.
+	 * @param len number of bytes in the data chunk.
+	 */
+	DataChunk(const u_char* data, uint64 len);
+
+	/**
+	 * @return pointer to the start of the data.
+	 */
+	const u_char* Data() const	{ return data; }
+
+	/**
+	 * @return number of bytes in the data.
+	 */
+	uint64 Len() const	{ return len; }
+
+	/**
+	 * Adds a reference.
+	 */
+	void Ref()	{ __atomic_add_fetch(&ref_cnt, 1, __ATOMIC_RELAXED); }
+
+	/**
+	 * Releases a reference, deleting the chunk once the last one is gone.
+	 */
+	void Unref()
+		{
+		if ( __atomic_sub_fetch(&ref_cnt, 1, __ATOMIC_ACQ_REL) == 0 )
+			delete this;
+		}
+
+private:
+	~DataChunk()	{ delete [] data; }
+
+	u_char* data;
+	uint64 len;
+	int ref_cnt;
+};
+
+/**
+ * The part of a file analyzer's work that doesn't need any of Bro's
+ * script-level state, like computing a digest or writing data to disk.
+ * When Files::analysis_threads is non-zero, Feed() and Finish() execute
+ * on one of file analysis' threads, otherwise they execute inline.
+ * All jobs of the same file go to the same thread, in the order they
+ * were submitted.
+ *
+ * A job is handed over with AsyncThreadPool::Feed() and Finish(). Once
+ * finished, it's owned by the pool and gets deleted on the main thread
+ * after Done() has run there.  A file's state removal waits until Done()
+ * has run for all its jobs finished without being aborted.
+ */
+class AsyncJob {
+public:
+	/**
+	 * Constructor.
+	 * @param file the file whose data the job works on.
+	 */
+	AsyncJob(File* file);
+
+	/**
+	 * Destructor.
+	 */
+	virtual ~AsyncJob();
+
+	/**
+	 * @return the file whose data the job works on.
+	 */
+	File* GetFile() const	{ return file; }
+
+	/**
+	 * @return whether the job was finished without its result being
+	 *         wanted anymore.
+	 */
+	bool Aborted() const	{ return aborted; }
+
+	/**
+	 * @return whether the job's thread fell too far behind for the job
+	 *         to get all of its data, in which case it doesn't report
+	 *         a result.
+	 */
+	bool Overrun() const	{ return overrun; }
+
+	/**
+	 * Processes the next chunk of file data.  May run on a thread other
+	 * than the main one and so must not touch any Bro state.
+	 * @param data pointer to a chunk of file data.
+	 * @param len number of bytes in the data chunk.
+	 * @param offset number of bytes from start of file at which chunk
+	 *        occurs.
+	 */
+	virtual void Feed(const u_char* data, uint64 len, uint64 offset) = 0;
+
+	/**
+	 * Called after the last chunk has been fed, even if the job has been
+	 * aborted.  Same restrictions as Feed().
+	 */
+	virtual void Finish()	{ }
+
+	/**
+	 * Called on the main thread once Finish() has returned, unless the
+	 * job has been aborted.  This is where the job raises its events.
+	 */
+	virtual void Done()	{ }
+
+protected:
+	friend class AsyncThreadPool;
+
+	File* file;
+	AsyncThread* thread;
+	bool aborted;
+	bool overrun;
+};
+
+/**
+ * One of the threads executing file analysis jobs.
+ */
+class AsyncThread : public threading::MsgThread {
+public:
+	/**
+	 * Constructor.
+	 * @param num the thread's number, used for its name.
+	 */
+	AsyncThread(int num);
+
+	/**
+	 * Destructor.
+	 */
+	virtual ~AsyncThread();
+
+	/**
+	 * @return the batch that jobs running on the thread can queue hash
+	 *         updates into.  It gets flushed after each batch of
+	 *         messages the thread processes, and the data fed with them
+	 *         stays around until then.
+	 */
+	MultiHash* Hashes()	{ return &hashes; }
+
+	/**
+	 * @return the number of bytes fed to jobs of this thread that it
+	 *         hasn't processed yet.
+	 */
+	uint64 QueuedBytes() const
+		{ return __atomic_load_n(&queued_bytes, __ATOMIC_ACQUIRE); }
+
+	/**
+	 * Processes the messages the thread sends to the main thread, without
+	 * waiting for the threading::Manager to get to them, until all jobs
+	 * finished on the thread are done.  Must only be called by the main
+	 * thread.
+	 */
+	void WaitForJobs();
+
+protected:
+	friend class AsyncThreadPool;
+	friend class FeedMessage;
+	friend class JobFinishedMessage;
+
+	virtual bool OnHeartbeat(double network_time, double current_time)
+		{ return true; }
+
+	virtual bool OnFinish(double network_time);
+	virtual void OnBatchProcessed();
+
+	/**
+	 * Keeps a chunk of data referenced until the next flush of the
+	 * thread's hash updates.
+	 */
+	void Hold(DataChunk* chunk)	{ chunk->Ref(); held.push_back(chunk); }
+
+	/**
+	 * Applies the queued hash updates and releases the data they used.
+	 */
+	void FlushHashes();
+
+	void AddQueuedBytes(uint64 n)
+		{ __atomic_add_fetch(&queued_bytes, n, __ATOMIC_RELEASE); }
+
+	void RemoveQueuedBytes(uint64 n)
+		{ __atomic_sub_fetch(&queued_bytes, n, __ATOMIC_RELEASE); }
+
+private:
+	uint64 queued_bytes;	// Accessed by both threads.
+	int pending_jobs;	// Finished jobs that aren't done yet.
+	MultiHash hashes;
+	std::vector<DataChunk*> held;
+};
+
+/**
+ * The set of threads that file analysis jobs are spread across.  Without
+ * any threads, jobs execute inline.  All methods must only be called by
+ * the main thread.
+ */
+class AsyncThreadPool {
+public:
+	/**
+	 * Constructor.  No threads get created until Start() is called.
+	 */
+	AsyncThreadPool();
+
+	/**
+	 * Destructor.  The threads themselves get deleted by the
+	 * threading::Manager.
+	 */
+	~AsyncThreadPool();
+
+	/**
+	 * Creates and starts the threads.
+	 * @param num_threads the number of threads to use; zero means that
+	 *        jobs execute inline.
+	 * @param max_queued the number of bytes that may be queued for a
+	 *        thread. Jobs fed while their thread is over the limit get
+	 *        no more data and don't report a result.
+	 */
+	void Start(int num_threads, uint64 max_queued);
+
+	/**
+	 * Waits for all jobs finished so far to be done and then stops using
+	 * the threads, so that any further jobs execute inline.
+	 */
+	void Terminate();
+
+	/**
+	 * Hands the next chunk of a file's data to a job.  With threads, the
+	 * data is copied once per delivery, no matter how many jobs it's fed
+	 * to, until EndOfData() is called.
+	 * @param job the job to feed.
+	 * @param data pointer to a chunk of file data.
+	 * @param len number of bytes in the data chunk.
+	 * @param offset number of bytes from start of file at which chunk
+	 *        occurs.
+	 */
+	void Feed(AsyncJob* job, const u_char* data, uint64 len, uint64 offset);
+
+	/**
+	 * Signals that the data last passed to Feed() won't be fed to any
+	 * further jobs.  Must be called before the data's memory can be
+	 * reused.
+	 */
+	void EndOfData();
+
+	/**
+	 * Tells a job that there's no more data and passes its ownership to
+	 * the pool.
+	 * @param job the job to finish.
+	 * @param abort true if the job's result isn't wanted; Done() will
+	 *        not be called then.
+	 */
+	void Finish(AsyncJob* job, bool abort = false);
+
+	/**
+	 * Runs the main thread part of a job that has finished and deletes
+	 * the job.
+	 * @param job the job.
+	 */
+	void JobFinished(AsyncJob* job);
+
+protected:
+	friend class AsyncJob;
+
+	/**
+	 * @param file a file.
+	 * @return the thread that jobs for \a file go to, or null if jobs
+	 *         execute inline.
+	 */
+	AsyncThread* ThreadFor(const File* file) const;
+
+private:
+	std::vector<AsyncThread*> threads;
+	uint64 max_queued;	// Limit on bytes queued per thread.
+
+	// The copy of the data currently being delivered.
+	const u_char* cur_data;
+	DataChunk* cur_chunk;
+};
+
+} // namespace file_analysis
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "File.h"
 #include "FileTimer.h"
+#include "FileReassembler.h"
 #include "Analyzer.h"
 #include "Manager.h"
 #include "Reporter.h"
@@ -34,9 +35,9 @@ static RecordVal* get_conn_id_val(const Connection* conn)
 	{
 	RecordVal* v = new RecordVal(conn_id);
 	v->Assign(0, new AddrVal(conn->OrigAddr()));
-	v->Assign(1, new PortVal(ntohs(conn->OrigPort()), conn->ConnTransport()));
+	v->Assign(1, val_mgr->GetPort(ntohs(conn->OrigPort()), conn->ConnTransport()));
 	v->Assign(2, new AddrVal(conn->RespAddr()));
-	v->Assign(3, new PortVal(ntohs(conn->RespPort()), conn->ConnTransport()));
+	v->Assign(3, val_mgr->GetPort(ntohs(conn->RespPort()), conn->ConnTransport()));
 	return v;
 	}
 
@@ -52,6 +53,7 @@ int File::missing_bytes_idx = -1;
 int File::overflow_bytes_idx = -1;
 int File::timeout_interval_idx = -1;
 int File::bof_buffer_size_idx = -1;
+int File::reassembly_buffer_size_idx = -1;
 int File::bof_buffer_idx = -1;
 int File::mime_type_idx = -1;
 int File::mime_types_idx = -1;
@@ -73,6 +75,7 @@ void File::StaticInit()
 	overflow_bytes_idx = Idx("overflow_bytes");
 	timeout_interval_idx = Idx("timeout_interval");
 	bof_buffer_size_idx = Idx("bof_buffer_size");
+	reassembly_buffer_size_idx = Idx("reassembly_buffer_size");
 	bof_buffer_idx = Idx("bof_buffer");
 	mime_type_idx = Idx("mime_type");
 	mime_types_idx = Idx("mime_types");
@@ -81,8 +84,9 @@ void File::StaticInit()
 File::File(const string& file_id, Connection* conn, analyzer::Tag tag,
            bool is_orig)
 	: id(file_id), val(0), postpone_timeout(false), first_chunk(true),
-	  missed_bof(false), need_reassembly(false), done(false),
-	  did_file_new_event(false), analyzers(this)
+	  missed_bof(false), done(false), did_file_new_event(false),
+	  analyzers(this), stream_offset(0), file_reassembler(0), async_jobs(0),
+	  state_remove_pending(false)
 	{
 	StaticInit();
 
@@ -95,7 +99,7 @@ File::File(const string& file_id, Connection* conn, analyzer::Tag tag,
 		{
 		// add source, connection, is_orig fields
 		SetSource(analyzer_mgr->GetComponentName(tag));
-		val->Assign(is_orig_idx, new Val(is_orig, TYPE_BOOL));
+		val->Assign(is_orig_idx, val_mgr->GetBool(is_orig));
 		UpdateConnectionFields(conn, is_orig);
 		}
 
@@ -106,6 +110,7 @@ File::~File()
 	{
 	DBG_LOG(DBG_FILE_ANALYSIS, "[%s] Destroying File object", id.c_str());
 	Unref(val);
+	Unref(file_reassembler);
 
 	while ( ! fonc_queue.empty() )
 		{
@@ -148,7 +153,7 @@ void File::UpdateConnectionFields(Connection* conn, bool is_orig)
 			val_list* vl = new val_list();
 			vl->append(val->Ref());
 			vl->append(conn_val->Ref());
-			vl->append(new Val(is_orig, TYPE_BOOL));
+			vl->append(val_mgr->GetBool(is_orig));
 
 			if ( did_file_new_event )
 				FileEvent(file_over_new_connection, vl);
@@ -227,13 +232,13 @@ bool File::SetExtractionLimit(RecordVal* args, uint64 bytes)
 void File::IncrementByteCount(uint64 size, int field_idx)
 	{
 	uint64 old = LookupFieldDefaultCount(field_idx);
-	val->Assign(field_idx, new Val(old + size, TYPE_COUNT));
+	val->Assign(field_idx, val_mgr->GetCount(old + size));
 	}
 
 void File::SetTotalBytes(uint64 size)
 	{
 	DBG_LOG(DBG_FILE_ANALYSIS, "[%s] Total bytes %" PRIu64, id.c_str(), size);
-	val->Assign(total_bytes_idx, new Val(size, TYPE_COUNT));
+	val->Assign(total_bytes_idx, val_mgr->GetCount(size));
 	}
 
 bool File::IsComplete() const
@@ -325,26 +330,63 @@ void File::ReplayBOF()
 	FileEvent(file_new);
 
 	for ( size_t i = 0; i < bof_buffer.chunks.size(); ++i )
-		DataIn(bof_buffer.chunks[i]->Bytes(), bof_buffer.chunks[i]->Len());
+		DeliverStream(bof_buffer.chunks[i]->Bytes(), bof_buffer.chunks[i]->Len());
 	}
 
 void File::DataIn(const u_char* data, uint64 len, uint64 offset)
+	{
+	DBG_LOG(DBG_FILE_ANALYSIS, "[%s] %" PRIu64 " bytes in at offset %" PRIu64 "; %s [%s%s]",
+		id.c_str(), len, offset,
+		IsComplete() ? "complete" : "incomplete",
+		fmt_bytes((const char*) data, min((uint64)40, len)), len > 40 ? "..." : "");
+
+	if ( ! file_reassembler &&
+	     LookupFieldDefaultCount(reassembly_buffer_size_idx) == 0 )
+		{
+		// Reassembly is disabled, so analyzers get to see the data
+		// only as chunks.
+		DeliverChunk(data, len, offset);
+		return;
+		}
+
+	if ( offset < stream_offset )
+		{
+		// We've delivered (or given up on) at least a part of this
+		// already, so just keep the new stuff.
+		if ( offset + len <= stream_offset )
+			return;
+
+		data += stream_offset - offset;
+		len -= stream_offset - offset;
+		offset = stream_offset;
+		}
+
+	if ( offset == stream_offset &&
+	     ! (file_reassembler && file_reassembler->HasBlocks()) )
+		{
+		// In sequence, so no need to copy it anywhere.
+		DataIn(data, len);
+
+		if ( file_reassembler )
+			file_reassembler->SkipTo(stream_offset);
+
+		return;
+		}
+
+	Reassemble(data, len, offset);
+	}
+
+void File::DeliverChunk(const u_char* data, uint64 len, uint64 offset)
 	{
 	analyzers.DrainModifications();
 
 	if ( first_chunk )
 		{
-		// TODO: this should all really be delayed until we attempt reassembly
 		DetectMIME(data, len);
 		FileEvent(file_new);
 		first_chunk = false;
 		}
 
-	DBG_LOG(DBG_FILE_ANALYSIS, "[%s] %" PRIu64 " bytes in at offset" PRIu64 "; %s [%s]",
-		id.c_str(), len, offset,
-		IsComplete() ? "complete" : "incomplete",
-		fmt_bytes((const char*) data, min((uint64)40, len)), len > 40 ? "..." : "");
-
 	file_analysis::Analyzer* a = 0;
 	IterCookie* c = analyzers.InitForIteration();
 
@@ -354,18 +396,46 @@ void File::DataIn(const u_char* data, uint64 len, uint64 offset)
 			analyzers.QueueRemove(a->Tag(), a->Args());
 		}
 
+	file_mgr->AsyncThreads()->EndOfData();
 	analyzers.DrainModifications();
+	IncrementByteCount(len, seen_bytes_idx);
+	}
 
-	// TODO: check reassembly requirement based on buffer size in record
-	if ( need_reassembly )
-		reporter->InternalError("file_analyzer::File TODO: reassembly not yet supported");
+void File::Reassemble(const u_char* data, uint64 len, uint64 offset)
+	{
+	if ( ! file_reassembler )
+		file_reassembler = new FileReassembler(this, stream_offset);
 
-	// TODO: reassembly overflow stuff, increment overflow count, eval trigger
+	file_reassembler->NewBlock(network_time, offset, len, data);
 
-	IncrementByteCount(len, seen_bytes_idx);
+	uint64 span = file_reassembler->BufferedSpan();
+
+	if ( span <= LookupFieldDefaultCount(reassembly_buffer_size_idx) )
+		return;
+
+	DBG_LOG(DBG_FILE_ANALYSIS, "[%s] Reassembly buffer overflow at offset %" PRIu64
+		", %" PRIu64 " bytes buffered", id.c_str(), stream_offset, span);
+
+	if ( FileEventAvailable(file_reassembly_overflow) )
+		{
+		val_list* vl = new val_list();
+		vl->append(val->Ref());
+		vl->append(val_mgr->GetCount(stream_offset));
+		vl->append(val_mgr->GetCount(span));
+		FileEvent(file_reassembly_overflow, vl);
+		}
+
+	// Give up on the holes and deliver what we have.
+	IncrementByteCount(file_reassembler->Flush(), overflow_bytes_idx);
 	}
 
 void File::DataIn(const u_char* data, uint64 len)
+	{
+	stream_offset += len;
+	DeliverStream(data, len);
+	}
+
+void File::DeliverStream(const u_char* data, uint64 len)
 	{
 	analyzers.DrainModifications();
 
@@ -402,6 +472,7 @@ void File::DataIn(const u_char* data, uint64 len)
 			analyzers.QueueRemove(a->Tag(), a->Args());
 		}
 
+	file_mgr->AsyncThreads()->EndOfData();
 	analyzers.DrainModifications();
 	IncrementByteCount(len, seen_bytes_idx);
 	}
@@ -416,6 +487,9 @@ void File::EndOfFile()
 	analyzers.DrainModifications();
 
 	// Send along anything that's been buffered, but never flushed.
+	if ( file_reassembler )
+		file_reassembler->Flush();
+
 	ReplayBOF();
 
 	done = true;
@@ -429,13 +503,55 @@ void File::EndOfFile()
 			analyzers.QueueRemove(a->Tag(), a->Args());
 		}
 
+	if ( async_jobs > 0 )
+		{
+		DBG_LOG(DBG_FILE_ANALYSIS, "[%s] Waiting for %d analyzer jobs",
+		        id.c_str(), async_jobs);
+		state_remove_pending = true;
+		analyzers.DrainModifications();
+		return;
+		}
+
 	FileEvent(file_state_remove);
 
 	analyzers.DrainModifications();
 	}
 
+bool File::AsyncJobDone()
+	{
+	if ( --async_jobs > 0 || ! state_remove_pending )
+		return false;
+
+	state_remove_pending = false;
+	FileEvent(file_state_remove);
+	analyzers.DrainModifications();
+	return true;
+	}
+
 void File::Gap(uint64 offset, uint64 len)
 	{
+	if ( file_reassembler ||
+	     LookupFieldDefaultCount(reassembly_buffer_size_idx) > 0 )
+		{
+		if ( offset + len <= stream_offset )
+			// We're past it already.
+			return;
+
+		if ( offset > stream_offset )
+			{
+			// A gap only matters once the stream gets to it, as
+			// data in front of it may still arrive out of order.
+			if ( ! file_reassembler )
+				file_reassembler = new FileReassembler(this, stream_offset);
+
+			file_reassembler->AddGap(offset, len);
+			return;
+			}
+
+		len -= stream_offset - offset;
+		offset = stream_offset;
+		}
+
 	DBG_LOG(DBG_FILE_ANALYSIS, "[%s] Gap of size %" PRIu64 " at offset %" PRIu64,
 		id.c_str(), len, offset);
 
@@ -458,13 +574,18 @@ void File::Gap(uint64 offset, uint64 len)
 		{
 		val_list* vl = new val_list();
 		vl->append(val->Ref());
-		vl->append(new Val(offset, TYPE_COUNT));
-		vl->append(new Val(len, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(offset));
+		vl->append(val_mgr->GetCount(len));
 		FileEvent(file_gap, vl);
 		}
 
 	analyzers.DrainModifications();
 	IncrementByteCount(len, missing_bytes_idx);
+
+	stream_offset += len;
+
+	if ( file_reassembler )
+		file_reassembler->SkipTo(stream_offset);
 	}
 
 bool File::FileEventAvailable(EventHandlerPtr h)
@@ -16,6 +16,8 @@
 
 namespace file_analysis {
 
+class FileReassembler;
+
 /**
  * Wrapper class around \c fa_file record values from script layer.
  */
@@ -119,6 +121,9 @@ public:
 
 	/**
 	 * Pass in non-sequential data and deliver to attached analyzers.
+	 * Data arriving out of order is buffered until it's in sequence, up to
+	 * the "reassembly_buffer_size" field of #val.  If that's zero,
+	 * reassembly is disabled and analyzers only see the data as chunks.
 	 * @param data pointer to start of a chunk of file data.
 	 * @param len number of bytes in the data chunk.
 	 * @param offset number of bytes from start of file at which chunk occurs.
@@ -133,7 +138,9 @@ public:
 	void DataIn(const u_char* data, uint64 len);
 
 	/**
-	 * Inform attached analyzers about end of file being seen.
+	 * Inform attached analyzers about end of file being seen.  If any of
+	 * them still have jobs running on file analysis threads, raising the
+	 * \c file_state_remove event is postponed until those are done.
 	 */
 	void EndOfFile();
 
@@ -150,6 +157,17 @@ public:
 	 */
 	bool FileEventAvailable(EventHandlerPtr h);
 
+	/**
+	 * Notes that an analyzer has finished a job on a file analysis thread,
+	 * the result of which is still to come.
+	 */
+	void AsyncJobStarted()	{ ++async_jobs; }
+
+	/**
+	 * @return true if the results of some analyzer jobs are still to come.
+	 */
+	bool HasAsyncJobs() const	{ return async_jobs > 0; }
+
 	/**
 	 * Raises an event related to the file's life-cycle, the only parameter
 	 * to that event is the \c fa_file record..
@@ -188,6 +206,14 @@ protected:
 	 */
 	void UpdateConnectionFields(Connection* conn, bool is_orig);
 
+	/**
+	 * Notes that the result of an analyzer job has come in.  If that's the
+	 * last one and EndOfFile() has been waiting for it, raises the
+	 * \c file_state_remove event.
+	 * @return true if the file's state removal is complete.
+	 */
+	bool AsyncJobDone();
+
 	/**
 	 * Increment a byte count field of #val record by \a size.
 	 * @param size number of bytes by which to increment.
@@ -211,6 +237,33 @@ protected:
 	 */
 	double LookupFieldDefaultInterval(int idx) const;
 
+	/**
+	 * Deliver sequential data to attached analyzers, buffering it first if
+	 * it's at the beginning of the file.
+	 * @param data pointer to start of a chunk of file data.
+	 * @param len number of bytes in the data chunk.
+	 */
+	void DeliverStream(const u_char* data, uint64 len);
+
+	/**
+	 * Deliver non-sequential data to attached analyzers as is, without
+	 * reassembling it.
+	 * @param data pointer to start of a chunk of file data.
+	 * @param len number of bytes in the data chunk.
+	 * @param offset number of bytes from start of file at which chunk occurs.
+	 */
+	void DeliverChunk(const u_char* data, uint64 len, uint64 offset);
+
+	/**
+	 * Passes out-of-order data to the file's reassembler, creating that
+	 * if necessary, and flushes the reassembler if it has grown beyond
+	 * the file's reassembly buffer size.
+	 * @param data pointer to start of a chunk of file data.
+	 * @param len number of bytes in the data chunk.
+	 * @param offset number of bytes from start of file at which chunk occurs.
+	 */
+	void Reassemble(const u_char* data, uint64 len, uint64 offset);
+
 	/**
 	 * Buffers incoming data at the beginning of a file.
 	 * @param data pointer to a data chunk to buffer.
@@ -252,10 +305,13 @@ private:
 	bool postpone_timeout;     /**< Whether postponing timeout is requested. */
 	bool first_chunk;          /**< Track first non-linear chunk. */
 	bool missed_bof;           /**< Flags that we missed start of file. */
-	bool need_reassembly;      /**< Whether file stream reassembly is needed. */
 	bool done;                 /**< If this object is about to be deleted. */
 	bool did_file_new_event;   /**< Whether the file_new event has been done. */
 	AnalyzerSet analyzers;     /**< A set of attached file analyzer. */
+	uint64 stream_offset;      /**< Offset up to which data is in sequence. */
+	FileReassembler* file_reassembler; /**< Set once data is out of order. */
+	int async_jobs;            /**< Analyzer jobs whose results are to come. */
+	bool state_remove_pending; /**< EndOfFile() waits for #async_jobs. */
 	queue<pair<EventHandlerPtr, val_list*> > fonc_queue;
 
 	struct BOF_Buffer {
@@ -281,6 +337,7 @@ private:
 	static int overflow_bytes_idx;
 	static int timeout_interval_idx;
 	static int bof_buffer_size_idx;
+	static int reassembly_buffer_size_idx;
 	static int bof_buffer_idx;
 	static int mime_type_idx;
 	static int mime_types_idx;
@@ -0,0 +1,120 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include <algorithm>
+
+#include "FileReassembler.h"
+#include "File.h"
+
+using namespace file_analysis;
+
+FileReassembler::FileReassembler(File* f, uint64 starting_offset)
+	: Reassembler(starting_offset, REASSEM_FILE), the_file(f)
+	{
+	delivered = 0;
+	}
+
+FileReassembler::~FileReassembler()
+	{
+	}
+
+uint64 FileReassembler::Flush()
+	{
+	uint64 start = delivered;
+
+	// Each block left is preceded by a hole, since we'd have delivered
+	// it otherwise. Skipping the hole delivers the block along with
+	// whatever directly follows it.
+	while ( blocks )
+		{
+		uint64 hole_end = blocks->seq;
+		the_file->Gap(last_reassem_seq, hole_end - last_reassem_seq);
+		}
+
+	// There's no data behind the gaps still recorded, so everything up
+	// to the last of them is missing.
+	uint64 end = 0;
+
+	for ( std::map<uint64, uint64>::const_iterator i = gaps.begin();
+	      i != gaps.end(); ++i )
+		end = std::max(end, i->second);
+
+	gaps.clear();
+
+	if ( end > last_reassem_seq )
+		the_file->Gap(last_reassem_seq, end - last_reassem_seq);
+
+	return delivered - start;
+	}
+
+void FileReassembler::AddGap(uint64 offset, uint64 len)
+	{
+	uint64& end = gaps[offset];
+	end = std::max(end, offset + len);
+	}
+
+void FileReassembler::SkipTo(uint64 offset)
+	{
+	TrimToSeq(offset);
+
+	// TrimToSeq() only delivers a block starting right at the new
+	// offset, not one reaching across it.
+	if ( blocks && blocks->seq <= last_reassem_seq )
+		BlockInserted(blocks);
+
+	CheckGaps();
+	}
+
+void FileReassembler::CheckGaps()
+	{
+	while ( ! gaps.empty() )
+		{
+		std::map<uint64, uint64>::iterator i = gaps.begin();
+
+		if ( i->first > last_reassem_seq )
+			return;
+
+		uint64 end = i->second;
+		gaps.erase(i);
+
+		if ( end <= last_reassem_seq )
+			// Data showed up for it after all.
+			continue;
+
+		// The file skips us over the gap, which brings us back here
+		// for the next one.
+		the_file->Gap(last_reassem_seq, end - last_reassem_seq);
+		return;
+		}
+	}
+
+void FileReassembler::BlockInserted(DataBlock* start_block)
+	{
+	if ( start_block->seq > last_reassem_seq ||
+	     start_block->upper <= last_reassem_seq )
+		return;
+
+	// Blocks may start in front of what we've delivered already if
+	// they arrived before we skipped over parts of them.
+	for ( DataBlock* b = start_block;
+	      b && b->seq <= last_reassem_seq; b = b->next )
+		{
+		if ( b->upper <= last_reassem_seq )
+			continue;
+
+		uint64 skip = last_reassem_seq - b->seq;
+		last_reassem_seq = b->upper;
+		delivered += b->Size() - skip;
+		the_file->DataIn(b->block + skip, b->Size() - skip);
+		}
+
+	// Throw away what we've delivered.
+	TrimToSeq(last_reassem_seq);
+
+	CheckGaps();
+	}
+
+void FileReassembler::Overlap(const u_char* b1, const u_char* b2, uint64 n)
+	{
+	// Nothing to do: unlike for TCP, there's no notion of an
+	// inconsistent retransmission of file data worth reporting.
+	}
@@ -0,0 +1,83 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef FILE_ANALYSIS_FILEREASSEMBLER_H
+#define FILE_ANALYSIS_FILEREASSEMBLER_H
+
+#include <map>
+
+#include "Reassem.h"
+
+namespace file_analysis {
+
+class File;
+
+/**
+ * Puts chunks of a file that arrive out of order (e.g. from HTTP range
+ * requests) back in sequence before they reach the file's stream analyzers.
+ */
+class FileReassembler : public Reassembler {
+public:
+
+	/**
+	 * Constructor.
+	 * @param f the file to deliver reassembled data to.
+	 * @param starting_offset the offset in the file up to which data has
+	 *        already been delivered in sequence.
+	 */
+	FileReassembler(File* f, uint64 starting_offset);
+
+	/**
+	 * Destructor.  Any data still buffered is discarded.
+	 */
+	virtual ~FileReassembler();
+
+	/**
+	 * Delivers all buffered data, reporting any holes in front of it as
+	 * gaps in the file, along with any gaps recorded past the end of it.
+	 * @return the number of bytes of data delivered.
+	 */
+	uint64 Flush();
+
+	/**
+	 * Records a gap ahead of the in-sequence offset.  It gets reported to
+	 * the file once the stream gets to it, skipping over the missing data.
+	 * @param offset the offset in the file at which the gap starts.
+	 * @param len the number of bytes missing.
+	 */
+	void AddGap(uint64 offset, uint64 len);
+
+	/**
+	 * Informs the reassembler that the file's stream has advanced to
+	 * \a offset without it, discarding everything buffered in front of
+	 * that and delivering whatever has become in sequence.
+	 * @param offset the new in-sequence offset of the file.
+	 */
+	void SkipTo(uint64 offset);
+
+	/**
+	 * @return the number of bytes between the in-sequence offset and the
+	 *         end of the last buffered block.  This bounds the amount of
+	 *         data buffered, including the holes in between.
+	 */
+	uint64 BufferedSpan() const
+		{ return last_block ? last_block->upper - last_reassem_seq : 0; }
+
+protected:
+	FileReassembler()	{ }
+
+	void BlockInserted(DataBlock* b);
+	void Overlap(const u_char* b1, const u_char* b2, uint64 n);
+
+	/**
+	 * Reports the first recorded gap if the stream has gotten to it.
+	 */
+	void CheckGaps();
+
+	File* the_file;
+	std::map<uint64, uint64> gaps;	// Recorded gaps, start -> end offset.
+	uint64 delivered;	// Bytes delivered so far.
+};
+
+} // namespace file_analysis
+
+#endif
@@ -43,6 +43,9 @@ Manager::~Manager()
 	while ( (f = id_map.NextEntry(it)) )
 		delete f;
 
+	for ( set<File*>::iterator i = finishing.begin(); i != finishing.end(); ++i )
+		delete *i;
+
 	it = ignored.InitForIteration();
 
 	while( (b = ignored.NextEntry(it)) )
@@ -57,6 +60,8 @@ void Manager::InitPreScript()
 
 void Manager::InitPostScript()
 	{
+	async_threads.Start(BifConst::Files::analysis_threads,
+	                    BifConst::Files::analysis_thread_buffer);
 	}
 
 void Manager::InitMagic()
@@ -82,6 +87,7 @@ void Manager::Terminate()
 	for ( size_t i = 0; i < keys.size(); ++i )
 		Timeout(keys[i], true);
 
+	async_threads.Terminate();
 	mgr.Drain();
 	}
 
@@ -374,12 +380,30 @@ bool Manager::RemoveFile(const string& file_id)
 	DBG_LOG(DBG_FILE_ANALYSIS, "Remove FileID %s", file_id.c_str());
 
 	f->EndOfFile();
-	delete f;
 	id_map.Remove(&key);
 	delete static_cast<bool*>(ignored.Remove(&key));
+
+	if ( f->HasAsyncJobs() )
+		// Gets deleted once its analyzers' threads are done with it.
+		finishing.insert(f);
+	else
+		delete f;
+
 	return true;
 	}
 
+void Manager::AsyncJobDone(File* f)
+	{
+	if ( ! f->AsyncJobDone() )
+		return;
+
+	DBG_LOG(DBG_FILE_ANALYSIS, "Finished removing FileID %s",
+	        f->GetID().c_str());
+
+	finishing.erase(f);
+	delete f;
+	}
+
 bool Manager::IsIgnored(const string& file_id)
 	{
 	return ignored.Lookup(file_id.c_str()) != 0;
@@ -404,7 +428,7 @@ string Manager::GetFileID(analyzer::Tag tag, Connection* c, bool is_orig)
 	val_list* vl = new val_list();
 	vl->append(tagval);
 	vl->append(c->BuildConnVal());
-	vl->append(new Val(is_orig, TYPE_BOOL));
+	vl->append(val_mgr->GetBool(is_orig));
 
 	mgr.QueueEvent(get_file_handle, vl);
 	mgr.Drain(); // need file handle immediately so we don't have to buffer data
@@ -416,7 +440,7 @@ bool Manager::IsDisabled(analyzer::Tag tag)
 	if ( ! disabled )
 		disabled = internal_const_val("Files::disable")->AsTableVal();
 
-	Val* index = new Val(tag, TYPE_COUNT);
+	Val* index = val_mgr->GetCount(tag);
 	Val* yield = disabled->Lookup(index);
 	Unref(index);
 
@@ -552,7 +576,7 @@ VectorVal* file_analysis::GenMIMEMatchesVal(const RuleMatcher::MIME_Matches& m)
 		for ( set<string>::const_iterator it2 = it->second.begin();
 		      it2 != it->second.end(); ++it2 )
 			{
-			element->Assign(0, new Val(it->first, TYPE_INT));
+			element->Assign(0, val_mgr->GetInt(it->first));
 			element->Assign(1, new StringVal(*it2));
 			}
 
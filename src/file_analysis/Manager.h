@@ -17,6 +17,7 @@
 
 #include "File.h"
 #include "FileTimer.h"
+#include "AsyncJob.h"
 #include "Component.h"
 #include "Tag.h"
 #include "plugin/ComponentManager.h"
@@ -64,10 +65,24 @@ public:
 	void InitMagic();
 
 	/**
-	 * Times out any active file analysis to prepare for shutdown.
+	 * Times out any active file analysis to prepare for shutdown, waiting
+	 * for file analysis threads to finish their jobs.
 	 */
 	void Terminate();
 
+	/**
+	 * @return the threads that file analyzers hand their jobs to.
+	 */
+	AsyncThreadPool* AsyncThreads()	{ return &async_threads; }
+
+	/**
+	 * Called once a job that a file's analyzers handed to a thread is
+	 * done.  If the file's state removal was waiting only for that, it
+	 * gets completed and the file deleted.
+	 * @param f the file the job belonged to.
+	 */
+	void AsyncJobDone(File* f);
+
 	/**
 	 * Creates a file identifier from a unique file handle string.
 	 * @param handle a unique string which identifies a single file.
@@ -437,6 +452,8 @@ private:
 
 	PDict(File) id_map;  /**< Map file ID to file_analysis::File records. */
 	PDict(bool) ignored; /**< Ignored files.  Will be finally removed on EOF. */
+	set<File*> finishing; /**< Removed files still waiting for async jobs. */
+	AsyncThreadPool async_threads; /**< Threads executing analyzer jobs. */
 	string current_file_id;	/**< Hash of what get_file_handle event sets. */
 	RuleFileMagicState* magic_state;	/**< File magic signature match state. */
 	MIMEMap mime_types;/**< Mapping of MIME types to analyzers. */
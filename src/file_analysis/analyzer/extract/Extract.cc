@@ -9,26 +9,43 @@
 
 using namespace file_analysis;
 
+ExtractJob::ExtractJob(File* file, int arg_fd)
+	: AsyncJob(file), fd(arg_fd)
+	{
+	}
+
+void ExtractJob::Feed(const u_char* data, uint64 len, uint64 offset)
+	{
+	safe_pwrite(fd, data, len, offset);
+	}
+
+void ExtractJob::Finish()
+	{
+	safe_close(fd);
+	}
+
 Extract::Extract(RecordVal* args, File* file, const string& arg_filename,
                  uint64 arg_limit)
     : file_analysis::Analyzer(file_mgr->GetComponentTag("EXTRACT"), args, file),
-      filename(arg_filename), limit(arg_limit)
+      filename(arg_filename), job(0), limit(arg_limit)
 	{
-	fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
 
 	if ( fd < 0 )
 		{
-		fd = 0;
 		char buf[128];
 		strerror_r(errno, buf, sizeof(buf));
 		reporter->Error("cannot open %s: %s", filename.c_str(), buf);
+		return;
 		}
+
+	job = new ExtractJob(file, fd);
 	}
 
 Extract::~Extract()
 	{
-	if ( fd )
-		safe_close(fd);
+	if ( job )
+		file_mgr->AsyncThreads()->Finish(job, true);
 	}
 
 static Val* get_extract_field_val(RecordVal* args, const char* name)
@@ -79,7 +96,7 @@ static bool check_limit_exceeded(uint64 lim, uint64 off, uint64 len, uint64* n)
 
 bool Extract::DeliverChunk(const u_char* data, uint64 len, uint64 offset)
 	{
-	if ( ! fd )
+	if ( ! job )
 		return false;
 
 	uint64 towrite = 0;
@@ -91,9 +108,9 @@ bool Extract::DeliverChunk(const u_char* data, uint64 len, uint64 offset)
 		val_list* vl = new val_list();
 		vl->append(f->GetVal()->Ref());
 		vl->append(Args()->Ref());
-		vl->append(new Val(limit, TYPE_COUNT));
-		vl->append(new Val(offset, TYPE_COUNT));
-		vl->append(new Val(len, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(limit));
+		vl->append(val_mgr->GetCount(offset));
+		vl->append(val_mgr->GetCount(len));
 		f->FileEvent(file_extraction_limit, vl);
 
 		// Limit may have been modified by BIF, re-check it.
@@ -101,7 +118,18 @@ bool Extract::DeliverChunk(const u_char* data, uint64 len, uint64 offset)
 		}
 
 	if ( towrite > 0 )
-		safe_pwrite(fd, data, towrite, offset);
+		file_mgr->AsyncThreads()->Feed(job, data, towrite, offset);
 
 	return ( ! limit_exceeded );
 	}
+
+bool Extract::EndOfFile()
+	{
+	if ( job )
+		{
+		file_mgr->AsyncThreads()->Finish(job);
+		job = 0;
+		}
+
+	return false;
+	}
@@ -8,19 +8,50 @@
 #include "Val.h"
 #include "File.h"
 #include "Analyzer.h"
+#include "AsyncJob.h"
 
 #include "analyzer/extract/events.bif.h"
 
 namespace file_analysis {
 
 /**
- * An analyzer to extract content of files to local disk.
+ * The job writing data for an Extract analyzer to disk, possibly on a file
+ * analysis thread.
+ */
+class ExtractJob : public AsyncJob {
+public:
+	/**
+	 * Constructor.
+	 * @param file the file to extract.
+	 * @param fd the file descriptor to write to, which the job takes
+	 *        ownership of.
+	 */
+	ExtractJob(File* file, int fd);
+
+	/**
+	 * Writes a chunk of data at its offset.
+	 */
+	virtual void Feed(const u_char* data, uint64 len, uint64 offset);
+
+	/**
+	 * Closes the file descriptor.
+	 */
+	virtual void Finish();
+
+private:
+	int fd;
+};
+
+/**
+ * An analyzer to extract content of files to local disk.  The writing
+ * itself is done by an ExtractJob.
  */
 class Extract : public file_analysis::Analyzer {
 public:
 
 	/**
-	 * Destructor.  Will close the file that was used for data extraction.
+	 * Destructor.  Will close the file that was used for data extraction,
+	 * if EndOfFile() hasn't already.
 	 */
 	virtual ~Extract();
 
@@ -34,6 +65,13 @@ public:
 	 */
 	virtual bool DeliverChunk(const u_char* data, uint64 len, uint64 offset);
 
+	/**
+	 * Closes the file that was used for data extraction once all data has
+	 * been written to it.
+	 * @return always false so analyzer will be detached from file.
+	 */
+	virtual bool EndOfFile();
+
 	/**
 	 * Create a new instance of an Extract analyzer.
 	 * @param args the \c AnalyzerArgs value which represents the analyzer.
@@ -65,7 +103,7 @@ protected:
 
 private:
 	string filename;
-	int fd;
+	ExtractJob* job;
 	uint64 limit;
 };
 
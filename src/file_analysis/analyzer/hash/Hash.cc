@@ -9,26 +9,65 @@
 
 using namespace file_analysis;
 
+HashJob::HashJob(File* file, HashVal* hv, const char* arg_kind)
+	: AsyncJob(file), hash(hv), kind(arg_kind)
+	{
+	}
+
+HashJob::~HashJob()
+	{
+	Unref(hash);
+	}
+
+void HashJob::Feed(const u_char* data, uint64 len, uint64 offset)
+	{
+	// On a thread, the digests of the files it's working on are
+	// computed together at the end of each batch of data.
+	if ( thread )
+		hash->Feed(thread->Hashes(), data, len);
+	else
+		hash->Feed(data, len);
+	}
+
+void HashJob::Finish()
+	{
+	hash->Sync();
+	}
+
+void HashJob::Done()
+	{
+	val_list* vl = new val_list();
+	vl->append(GetFile()->GetVal()->Ref());
+	vl->append(new StringVal(kind));
+	vl->append(hash->Get());
+
+	mgr.QueueEvent(file_hash, vl);
+	}
+
 Hash::Hash(RecordVal* args, File* file, HashVal* hv, const char* arg_kind)
-	: file_analysis::Analyzer(file_mgr->GetComponentTag(to_upper(arg_kind).c_str()), args, file), hash(hv), fed(false), kind(arg_kind)
+	: file_analysis::Analyzer(file_mgr->GetComponentTag(to_upper(arg_kind).c_str()), args, file), job(0), fed(false)
 	{
-	hash->Init();
+	if ( hv->Init() )
+		job = new HashJob(file, hv, arg_kind);
+	else
+		Unref(hv);
 	}
 
 Hash::~Hash()
 	{
-	Unref(hash);
+	if ( job )
+		file_mgr->AsyncThreads()->Finish(job, true);
 	}
 
 bool Hash::DeliverStream(const u_char* data, uint64 len)
 	{
-	if ( ! hash->IsValid() )
+	if ( ! job )
 		return false;
 
 	if ( ! fed )
 		fed = len > 0;
 
-	hash->Feed(data, len);
+	file_mgr->AsyncThreads()->Feed(job, data, len, 0);
 	return true;
 	}
 
@@ -45,13 +84,9 @@ bool Hash::Undelivered(uint64 offset, uint64 len)
 
 void Hash::Finalize()
 	{
-	if ( ! hash->IsValid() || ! fed )
+	if ( ! job )
 		return;
 
-	val_list* vl = new val_list();
-	vl->append(GetFile()->GetVal()->Ref());
-	vl->append(new StringVal(kind));
-	vl->append(hash->Get());
-
-	mgr.QueueEvent(file_hash, vl);
+	file_mgr->AsyncThreads()->Finish(job, ! fed);
+	job = 0;
 	}
@@ -9,13 +9,52 @@
 #include "OpaqueVal.h"
 #include "File.h"
 #include "Analyzer.h"
+#include "AsyncJob.h"
 
 #include "events.bif.h"
 
 namespace file_analysis {
 
 /**
- * An analyzer to produce a hash of file contents.
+ * The job computing a hash for a Hash analyzer, possibly on a file
+ * analysis thread.
+ */
+class HashJob : public AsyncJob {
+public:
+	/**
+	 * Constructor.
+	 * @param file the file to hash.
+	 * @param hv an initialized hash calculator object, which the job
+	 *        takes ownership of.
+	 * @param kind human readable name of the hash algorithm.
+	 */
+	HashJob(File* file, HashVal* hv, const char* kind);
+
+	/**
+	 * Destructor.
+	 */
+	virtual ~HashJob();
+
+	virtual void Feed(const u_char* data, uint64 len, uint64 offset);
+
+	/**
+	 * Completes any hash update still queued on the job's thread.
+	 */
+	virtual void Finish();
+
+	/**
+	 * Finalizes the hash and raises the "file_hash" event with the result.
+	 */
+	virtual void Done();
+
+private:
+	HashVal* hash;
+	const char* kind;
+};
+
+/**
+ * An analyzer to produce a hash of file contents.  The hashing itself is
+ * done by a HashJob.
  */
 class Hash : public file_analysis::Analyzer {
 public:
@@ -60,15 +99,15 @@ protected:
 	Hash(RecordVal* args, File* file, HashVal* hv, const char* kind);
 
 	/**
-	 * If some file contents have been seen, finalizes the hash of them and
-	 * raises the "file_hash" event with the results.
+	 * If some file contents have been seen, has the job finalize the hash
+	 * of them and raise the "file_hash" event with the results.  Without
+	 * contents, the job is aborted.
 	 */
 	void Finalize();
 
 private:
-	HashVal* hash;
+	HashJob* job;
 	bool fed;
-	const char* kind;
 };
 
 /**
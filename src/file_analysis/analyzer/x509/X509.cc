@@ -1,15 +1,19 @@
 // See the file "COPYING" in the main distribution directory for copyright.
 
 #include <string>
+#include <list>
+#include <map>
 
 #include "X509.h"
 #include "Event.h"
 
 #include "events.bif.h"
 #include "types.bif.h"
+#include "consts.bif.h"
 
 #include "file_analysis/Manager.h"
 
+#include <openssl/sha.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
 #include <openssl/asn1.h>
@@ -19,6 +23,48 @@ using namespace file_analysis;
 
 IMPLEMENT_SERIAL(X509Val, SER_X509_VAL);
 
+// The cache of parsed certificates, keyed by the SHA1 of their DER
+// encoding, with the most recently seen ones at the front of the list.
+typedef std::list<std::pair<std::string, ParsedCertificate*> > cache_list;
+typedef std::map<std::string, cache_list::iterator> cache_map;
+
+static cache_list cache_lru;
+static cache_map cache_index;
+static file_analysis::X509::CacheStats cache_stats;
+
+static ParsedCertificate* cache_lookup(const std::string& key)
+	{
+	cache_map::iterator i = cache_index.find(key);
+
+	if ( i == cache_index.end() )
+		return 0;
+
+	cache_lru.splice(cache_lru.begin(), cache_lru, i->second);
+	return i->second->second;
+	}
+
+// Returns false if the cache is disabled, in which case ownership stays
+// with the caller.
+static bool cache_insert(const std::string& key, ParsedCertificate* parsed)
+	{
+	uint64 max = BifConst::X509::cache_size;
+
+	if ( max == 0 )
+		return false;
+
+	while ( cache_lru.size() >= max )
+		{
+		cache_index.erase(cache_lru.back().first);
+		delete cache_lru.back().second;
+		cache_lru.pop_back();
+		++cache_stats.evictions;
+		}
+
+	cache_lru.push_front(std::make_pair(key, parsed));
+	cache_index[key] = cache_lru.begin();
+	return true;
+	}
+
 file_analysis::X509::X509(RecordVal* args, file_analysis::File* file)
 	: file_analysis::Analyzer(file_mgr->GetComponentTag("X509"), args, file)
 	{
@@ -38,6 +84,38 @@ bool file_analysis::X509::Undelivered(uint64 offset, uint64 len)
 	}
 
 bool file_analysis::X509::EndOfFile()
+	{
+	// The same certificates show up over and over again; for those we
+	// just raise the events we got from parsing them the first time.
+	u_char digest[SHA_DIGEST_LENGTH];
+	SHA1(reinterpret_cast<const u_char*>(cert_data.data()), cert_data.size(), digest);
+	std::string key(reinterpret_cast<const char*>(digest), sizeof(digest));
+
+	ParsedCertificate* parsed = cache_lookup(key);
+
+	if ( parsed )
+		{
+		++cache_stats.hits;
+		RaiseEvents(parsed);
+		return false;
+		}
+
+	++cache_stats.misses;
+
+	parsed = Parse();
+
+	if ( ! parsed )
+		return false;
+
+	RaiseEvents(parsed);
+
+	if ( ! (parsed->cacheable && cache_insert(key, parsed)) )
+		delete parsed;
+
+	return false;
+	}
+
+file_analysis::ParsedCertificate* file_analysis::X509::Parse()
 	{
 	// ok, now we can try to parse the certificate with openssl. Should
 	// be rather straightforward...
@@ -47,19 +125,17 @@ bool file_analysis::X509::EndOfFile()
 	if ( ! ssl_cert )
 		{
 		reporter->Weird(fmt("Could not parse X509 certificate (fuid %s)", GetFile()->GetID().c_str()));
-		return false;
+		return 0;
 		}
 
+	// X509_free(ssl_cert); We do _not_ free the certificate here. It is refcounted
+	// inside the X509Val that is sent on in the cert record to scriptland.
+	//
+	// The certificate will be freed when the last X509Val is Unref'd.
 	X509Val* cert_val = new X509Val(ssl_cert); // cert_val takes ownership of ssl_cert
+	ParsedCertificate* parsed = new ParsedCertificate(cert_val);
 
-	RecordVal* cert_record = ParseCertificate(cert_val); // parse basic information into record
-
-	// and send the record on to scriptland
-	val_list* vl = new val_list();
-	vl->append(GetFile()->GetVal()->Ref());
-	vl->append(cert_val->Ref());
-	vl->append(cert_record->Ref()); // we Ref it here, because we want to keep a copy around for now...
-	mgr.QueueEvent(x509_certificate, vl);
+	parsed->cert_record = ParseCertificate(cert_val); // parse basic information into record
 
 	// after parsing the certificate - parse the extensions...
 
@@ -70,18 +146,94 @@ bool file_analysis::X509::EndOfFile()
 		if ( ! ex )
 			continue;
 
-		ParseExtension(ex);
+		ParseExtension(ex, parsed);
 		}
 
-	// X509_free(ssl_cert); We do _not_ free the certificate here. It is refcounted
-	// inside the X509Val that is sent on in the cert record to scriptland.
-	//
-	// The certificate will be freed when the last X509Val is Unref'd.
+	return parsed;
+	}
 
-	Unref(cert_record); // Unref the RecordVal that we kept around from ParseCertificate
-	Unref(cert_val); // Same for cert_val
+// Scripts may modify the records they get, so each certificate gets its
+// own copies of the cached ones.  Their fields are all atomic values or
+// vectors of such.
+static RecordVal* copy_record(RecordVal* rec)
+	{
+	RecordType* rt = rec->Type()->AsRecordType();
+	RecordVal* copy = new RecordVal(rt);
 
-	return false;
+	for ( int i = 0; i < rt->NumFields(); ++i )
+		{
+		Val* v = rec->Lookup(i);
+
+		if ( ! v )
+			continue;
+
+		if ( v->Type()->Tag() != TYPE_VECTOR )
+			{
+			copy->Assign(i, v->Ref());
+			continue;
+			}
+
+		VectorVal* vv = v->AsVectorVal();
+		VectorVal* vcopy = new VectorVal(vv->Type()->AsVectorType());
+
+		for ( unsigned int j = 0; j < vv->Size(); ++j )
+			{
+			Val* e = vv->Lookup(j);
+
+			if ( e )
+				vcopy->Assign(j, e->Ref());
+			}
+
+		copy->Assign(i, vcopy);
+		}
+
+	return copy;
+	}
+
+void file_analysis::X509::RaiseEvents(const ParsedCertificate* parsed)
+	{
+	// and send the record on to scriptland
+	val_list* vl = new val_list();
+	vl->append(GetFile()->GetVal()->Ref());
+	vl->append(parsed->cert_val->Ref());
+	vl->append(copy_record(parsed->cert_record));
+	mgr.QueueEvent(x509_certificate, vl);
+
+	for ( size_t i = 0; i < parsed->extensions.size(); ++i )
+		{
+		vl = new val_list();
+		vl->append(GetFile()->GetVal()->Ref());
+		vl->append(copy_record(parsed->extensions[i].second));
+		mgr.QueueEvent(parsed->extensions[i].first, vl);
+		}
+	}
+
+void file_analysis::X509::GetCacheStats(CacheStats* stats)
+	{
+	*stats = cache_stats;
+	stats->entries = cache_lru.size();
+	}
+
+file_analysis::ParsedCertificate::ParsedCertificate(X509Val* arg_cert_val)
+	{
+	cert_val = arg_cert_val;
+	cert_record = 0;
+	cacheable = true;
+	}
+
+file_analysis::ParsedCertificate::~ParsedCertificate()
+	{
+	Unref(cert_val);
+	Unref(cert_record);
+
+	for ( size_t i = 0; i < extensions.size(); ++i )
+		Unref(extensions[i].second);
+	}
+
+void file_analysis::ParsedCertificate::AddExtension(EventHandlerPtr handler,
+                                                     RecordVal* rec)
+	{
+	extensions.push_back(std::make_pair(handler, rec));
 	}
 
 RecordVal* file_analysis::X509::ParseCertificate(X509Val* cert_val)
@@ -94,7 +246,7 @@ RecordVal* file_analysis::X509::ParseCertificate(X509Val* cert_val)
 	RecordVal* pX509Cert = new RecordVal(BifType::Record::X509::Certificate);
 	BIO *bio = BIO_new(BIO_s_mem());
 
-	pX509Cert->Assign(0, new Val((uint64) X509_get_version(ssl_cert) + 1, TYPE_COUNT));
+	pX509Cert->Assign(0, val_mgr->GetCount((uint64) X509_get_version(ssl_cert) + 1));
 	i2a_ASN1_INTEGER(bio, X509_get_serialNumber(ssl_cert));
 	int len = BIO_read(bio, buf, sizeof(buf));
 	pX509Cert->Assign(1, new StringVal(len, buf));
@@ -154,7 +306,7 @@ RecordVal* file_analysis::X509::ParseCertificate(X509Val* cert_val)
 
 		unsigned int length = KeyLength(pkey);
 		if ( length > 0 )
-			pX509Cert->Assign(9, new Val(length, TYPE_COUNT));
+			pX509Cert->Assign(9, val_mgr->GetCount(length));
 
 		EVP_PKEY_free(pkey);
 		}
@@ -204,7 +356,7 @@ StringVal* file_analysis::X509::GetExtensionFromBIO(BIO* bio)
 	return ext_val;
 	}
 
-void file_analysis::X509::ParseExtension(X509_EXTENSION* ex)
+void file_analysis::X509::ParseExtension(X509_EXTENSION* ex, ParsedCertificate* parsed)
 	{
 	char name[256];
 	char oid[256];
@@ -226,7 +378,10 @@ void file_analysis::X509::ParseExtension(X509_EXTENSION* ex)
 	StringVal* ext_val = GetExtensionFromBIO(bio);
 
 	if ( ! ext_val )
+		{
 		ext_val = new StringVal(0, "");
+		parsed->cacheable = false;
+		}
 
 	RecordVal* pX509Ext = new RecordVal(BifType::Record::X509::Extension);
 	pX509Ext->Assign(0, new StringVal(name));
@@ -235,7 +390,7 @@ void file_analysis::X509::ParseExtension(X509_EXTENSION* ex)
 		pX509Ext->Assign(1, new StringVal(short_name));
 
 	pX509Ext->Assign(2, new StringVal(oid));
-	pX509Ext->Assign(3, new Val(critical, TYPE_BOOL));
+	pX509Ext->Assign(3, val_mgr->GetBool(critical));
 	pX509Ext->Assign(4, ext_val);
 
 	// send off generic extension event
@@ -244,21 +399,17 @@ void file_analysis::X509::ParseExtension(X509_EXTENSION* ex)
 	// parsed. And if we have it, we send the specialized event on top of the
 	// generic event that we just had. I know, that is... kind of not nice,
 	// but I am not sure if there is a better way to do it...
-	val_list* vl = new val_list();
-	vl->append(GetFile()->GetVal()->Ref());
-	vl->append(pX509Ext);
-
-	mgr.QueueEvent(x509_extension, vl);
+	parsed->AddExtension(x509_extension, pX509Ext);
 
 	// look if we have a specialized handler for this event...
 	if ( OBJ_obj2nid(ext_asn) == NID_basic_constraints )
-		ParseBasicConstraints(ex);
+		ParseBasicConstraints(ex, parsed);
 
 	else if ( OBJ_obj2nid(ext_asn) == NID_subject_alt_name )
-		ParseSAN(ex);
+		ParseSAN(ex, parsed);
 	}
 
-void file_analysis::X509::ParseBasicConstraints(X509_EXTENSION* ex)
+void file_analysis::X509::ParseBasicConstraints(X509_EXTENSION* ex, ParsedCertificate* parsed)
 	{
 	assert(OBJ_obj2nid(X509_EXTENSION_get_object(ex)) == NID_basic_constraints);
 
@@ -267,24 +418,23 @@ void file_analysis::X509::ParseBasicConstraints(X509_EXTENSION* ex)
 	if ( constr )
 		{
 		RecordVal* pBasicConstraint = new RecordVal(BifType::Record::X509::BasicConstraints);
-		pBasicConstraint->Assign(0, new Val(constr->ca ? 1 : 0, TYPE_BOOL));
+		pBasicConstraint->Assign(0, val_mgr->GetBool(constr->ca ? 1 : 0));
 
 		if ( constr->pathlen )
-			pBasicConstraint->Assign(1, new Val((int32_t) ASN1_INTEGER_get(constr->pathlen), TYPE_COUNT));
-
-		val_list* vl = new val_list();
-		vl->append(GetFile()->GetVal()->Ref());
-		vl->append(pBasicConstraint);
+			pBasicConstraint->Assign(1, val_mgr->GetCount((int32_t) ASN1_INTEGER_get(constr->pathlen)));
 
-		mgr.QueueEvent(x509_ext_basic_constraints, vl);
+		parsed->AddExtension(x509_ext_basic_constraints, pBasicConstraint);
 		BASIC_CONSTRAINTS_free(constr);
 		}
 
 	else
+		{
 		reporter->Weird(fmt("Certificate with invalid BasicConstraint. fuid %s", GetFile()->GetID().c_str()));
+		parsed->cacheable = false;
+		}
 	}
 
-void file_analysis::X509::ParseSAN(X509_EXTENSION* ext)
+void file_analysis::X509::ParseSAN(X509_EXTENSION* ext, ParsedCertificate* parsed)
 	{
 	assert(OBJ_obj2nid(X509_EXTENSION_get_object(ext)) == NID_subject_alt_name);
 
@@ -292,6 +442,7 @@ void file_analysis::X509::ParseSAN(X509_EXTENSION* ext)
 	if ( ! altname )
 		{
 		reporter->Weird(fmt("Could not parse subject alternative names. fuid %s", GetFile()->GetID().c_str()));
+		parsed->cacheable = false;
 		return;
 		}
 
@@ -312,6 +463,7 @@ void file_analysis::X509::ParseSAN(X509_EXTENSION* ext)
 			if ( ASN1_STRING_type(gen->d.ia5) != V_ASN1_IA5STRING )
 				{
 				reporter->Weird(fmt("DNS-field does not contain an IA5String. fuid %s", GetFile()->GetID().c_str()));
+				parsed->cacheable = false;
 				continue;
 				}
 
@@ -359,6 +511,7 @@ void file_analysis::X509::ParseSAN(X509_EXTENSION* ext)
 				else
 					{
 					reporter->Weird(fmt("Weird IP address length %d in subject alternative name. fuid %s", gen->d.ip->length, GetFile()->GetID().c_str()));
+					parsed->cacheable = false;
 					continue;
 					}
 			}
@@ -386,12 +539,9 @@ void file_analysis::X509::ParseSAN(X509_EXTENSION* ext)
 		if ( ips != 0 )
 			sanExt->Assign(3, ips);
 
-		sanExt->Assign(4, new Val(otherfields, TYPE_BOOL));
+		sanExt->Assign(4, val_mgr->GetBool(otherfields));
 
-		val_list* vl = new val_list();
-		vl->append(GetFile()->GetVal()->Ref());
-		vl->append(sanExt);
-		mgr.QueueEvent(x509_ext_subject_alternative_name, vl);
+		parsed->AddExtension(x509_ext_subject_alternative_name, sanExt);
 	GENERAL_NAMES_free(altname);
 	}
 
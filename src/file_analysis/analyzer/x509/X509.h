@@ -4,6 +4,7 @@
 #define FILE_ANALYSIS_X509_H
 
 #include <string>
+#include <vector>
 
 #include "Val.h"
 #include "../File.h"
@@ -16,8 +17,52 @@ namespace file_analysis {
 
 class X509Val;
 
+/**
+ * What parsing a certificate yields: the values of the events it raises,
+ * except for the file they're raised for.  Certificates seen again reuse
+ * this from the analyzer's cache, instead of being parsed anew.
+ */
+struct ParsedCertificate {
+	/**
+	 * Constructor.
+	 * @param cert_val the certificate, which the new instance takes
+	 *        ownership of.
+	 */
+	ParsedCertificate(X509Val* cert_val);
+
+	/**
+	 * Destructor.
+	 */
+	~ParsedCertificate();
+
+	/**
+	 * Adds an extension event.
+	 * @param handler the event.
+	 * @param rec the event's record argument; ownership is taken.
+	 */
+	void AddExtension(EventHandlerPtr handler, RecordVal* rec);
+
+	X509Val* cert_val;
+	RecordVal* cert_record;
+	std::vector<std::pair<EventHandlerPtr, RecordVal*> > extensions;
+
+	// False if parsing reported a problem, which would go unreported
+	// if the result were reused.
+	bool cacheable;
+};
+
 class X509 : public file_analysis::Analyzer {
 public:
+	/**
+	 * Statistics about the cache of parsed certificates.
+	 */
+	struct CacheStats {
+		uint64 hits;	// Certificates found in the cache.
+		uint64 misses;	// Certificates parsed.
+		uint64 evictions;	// Entries dropped to make room.
+		uint64 entries;	// Certificates currently cached.
+	};
+
 	virtual bool DeliverStream(const u_char* data, uint64 len);
 	virtual bool Undelivered(uint64 offset, uint64 len);
 	virtual bool EndOfFile();
@@ -48,13 +93,25 @@ public:
 	 */
 	static StringVal* GetExtensionFromBIO(BIO* bio);
 
+	/**
+	 * Returns statistics about the cache of parsed certificates, which
+	 * holds up to \c X509::cache_size certificates, keyed by the SHA1
+	 * of their DER encoding, and drops the least recently seen first.
+	 *
+	 * @param stats the statistics to fill in.
+	 */
+	static void GetCacheStats(CacheStats* stats);
+
 protected:
 	X509(RecordVal* args, File* file);
 
 private:
-	void ParseExtension(X509_EXTENSION* ex);
-	void ParseBasicConstraints(X509_EXTENSION* ex);
-	void ParseSAN(X509_EXTENSION* ex);
+	ParsedCertificate* Parse();
+	void RaiseEvents(const ParsedCertificate* parsed);
+
+	void ParseExtension(X509_EXTENSION* ex, ParsedCertificate* parsed);
+	void ParseBasicConstraints(X509_EXTENSION* ex, ParsedCertificate* parsed);
+	void ParseSAN(X509_EXTENSION* ex, ParsedCertificate* parsed);
 
 	std::string cert_data;
 
@@ -2137,7 +2137,7 @@ Val* Manager::ValueToVal(const Value* val, BroType* request_type)
 		}
 
 	case TYPE_PORT:
-		return new PortVal(val->val.port_val.port, val->val.port_val.proto);
+		return val_mgr->GetPort(val->val.port_val.port, val->val.port_val.proto);
 
 	case TYPE_ADDR:
 		{
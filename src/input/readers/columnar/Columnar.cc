@@ -0,0 +1,442 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Columnar.h"
+
+#include "threading/SerialTypes.h"
+
+using namespace input::reader;
+using namespace logging::writer::columnar;
+using threading::Value;
+using threading::Field;
+
+Columnar::Columnar(ReaderFrontend *frontend)
+	: ReaderBackend(frontend), mtime(0), firstrun(true), offset(0)
+	{
+	}
+
+Columnar::~Columnar()
+	{
+	}
+
+void Columnar::DoClose()
+	{
+	// Nothing to do, we don't keep the file open.
+	}
+
+bool Columnar::DoInit(const ReaderInfo& info, int num_fields,
+                      const Field* const* fields)
+	{
+	mtime = 0;
+	firstrun = true;
+	offset = 0;
+
+	if ( ! info.source || strlen(info.source) == 0 )
+		{
+		Error("No source path provided");
+		return false;
+		}
+
+	fname = info.source;
+
+	if ( UpdateModificationTime() == -1 )
+		return false;
+
+	return DoUpdate();
+	}
+
+int Columnar::UpdateModificationTime()
+	{
+	struct stat sb;
+
+	if ( stat(fname.c_str(), &sb) == -1 )
+		{
+		Error(Fmt("Could not get stat for %s", fname.c_str()));
+		return -1;
+		}
+
+	if ( sb.st_mtime <= mtime )
+		// no change
+		return 0;
+
+	mtime = sb.st_mtime;
+	return 1;
+	}
+
+// Reads the file starting at the current offset.
+bool Columnar::ReadFile(string* data)
+	{
+	int fd = open(fname.c_str(), O_RDONLY);
+
+	if ( fd < 0 )
+		{
+		Error(Fmt("cannot open %s: %s", fname.c_str(), Strerror(errno)));
+		return false;
+		}
+
+	struct stat sb;
+
+	if ( fstat(fd, &sb) < 0 )
+		{
+		Error(Fmt("Could not get stat for %s", fname.c_str()));
+		close(fd);
+		return false;
+		}
+
+	if ( size_t(sb.st_size) < offset )
+		// The file got replaced with a shorter one; start over.
+		offset = 0;
+
+	data->clear();
+
+	char buf[65536];
+	off_t pos = offset;
+
+	for ( ;; )
+		{
+		ssize_t n = pread(fd, buf, sizeof(buf), pos);
+
+		if ( n < 0 && errno == EINTR )
+			continue;
+
+		if ( n < 0 )
+			{
+			Error(Fmt("error reading %s: %s", fname.c_str(), Strerror(errno)));
+			close(fd);
+			return false;
+			}
+
+		if ( n == 0 )
+			break;
+
+		data->append(buf, n);
+		pos += n;
+		}
+
+	close(fd);
+	return true;
+	}
+
+Columnar::ParseResult Columnar::ReadHeader(InBuffer* in)
+	{
+	const u_char* magic;
+
+	if ( ! in->Bytes(&magic, MAGIC_LEN) )
+		return PARSE_INCOMPLETE;
+
+	if ( memcmp(magic, MAGIC, MAGIC_LEN) != 0 )
+		{
+		Error(Fmt("%s is not a columnar log file", fname.c_str()));
+		return PARSE_ERROR;
+		}
+
+	uint64 num_columns;
+
+	if ( ! in->Varint(&num_columns) )
+		return PARSE_INCOMPLETE;
+
+	columns.clear();
+
+	for ( uint64 i = 0; i < num_columns; ++i )
+		{
+		const char* name;
+		size_t len;
+		uint8 type, subtype, optional;
+
+		if ( ! (in->String(&name, &len) && in->Byte(&type) &&
+			in->Byte(&subtype) && in->Byte(&optional)) )
+			return PARSE_INCOMPLETE;
+
+		Column c;
+		c.name.assign(name, len);
+		c.type = TypeTag(type);
+		c.subtype = TypeTag(subtype);
+		columns.push_back(c);
+		}
+
+	uint64 num_meta;
+
+	if ( ! in->Varint(&num_meta) )
+		return PARSE_INCOMPLETE;
+
+	for ( uint64 i = 0; i < num_meta; ++i )
+		{
+		// We don't have any use for the meta data currently.
+		const char* s;
+		size_t len;
+
+		if ( ! (in->String(&s, &len) && in->String(&s, &len)) )
+			return PARSE_INCOMPLETE;
+		}
+
+	return MapColumns() ? PARSE_OK : PARSE_ERROR;
+	}
+
+static bool compatible(TypeTag t1, TypeTag t2)
+	{
+	if ( t1 == TYPE_COUNTER )
+		t1 = TYPE_COUNT;
+
+	if ( t2 == TYPE_COUNTER )
+		t2 = TYPE_COUNT;
+
+	return t1 == t2;
+	}
+
+bool Columnar::MapColumns()
+	{
+	field_map.clear();
+
+	for ( int i = 0; i < NumFields(); ++i )
+		{
+		const Field* f = Fields()[i];
+		int col = -1;
+
+		for ( size_t j = 0; j < columns.size(); ++j )
+			{
+			if ( columns[j].name == f->name )
+				{
+				col = j;
+				break;
+				}
+			}
+
+		if ( col < 0 && ! f->optional )
+			{
+			Error(Fmt("Did not find requested field %s in %s",
+				  f->name, fname.c_str()));
+			return false;
+			}
+
+		if ( col >= 0 &&
+		     ! (compatible(columns[col].type, f->type) &&
+			((f->type != TYPE_TABLE && f->type != TYPE_VECTOR) ||
+			 compatible(columns[col].subtype, f->subtype))) )
+			{
+			Error(Fmt("Field %s has type %s in %s, but %s is requested",
+				  f->name, type_name(columns[col].type),
+				  fname.c_str(), type_name(f->type)));
+			return false;
+			}
+
+		field_map.push_back(col);
+		}
+
+	return true;
+	}
+
+Columnar::ParseResult Columnar::ReadRowGroup(InBuffer* in, bool* end)
+	{
+	uint64 num_rows;
+
+	*end = false;
+
+	if ( ! in->Varint(&num_rows) )
+		return PARSE_INCOMPLETE;
+
+	if ( num_rows == 0 )
+		{
+		*end = true;
+		return PARSE_OK;
+		}
+
+	// Each row takes at least one bit.
+	if ( num_rows > in->Left() * 8 )
+		return PARSE_INCOMPLETE;
+
+	std::vector<Value**> vals(columns.size());
+	ParseResult result = PARSE_OK;
+	size_t decoded = 0;
+
+	for ( ; decoded < columns.size(); ++decoded )
+		{
+		vals[decoded] = new Value*[num_rows];
+
+		if ( ! DecodeColumn(in, num_rows, columns[decoded].type,
+				    columns[decoded].subtype, vals[decoded]) )
+			{
+			delete [] vals[decoded];
+			result = PARSE_INCOMPLETE;
+			break;
+			}
+		}
+
+	if ( result == PARSE_OK )
+		{
+		for ( uint64 r = 0; r < num_rows; ++r )
+			{
+			Value** fields = new Value*[NumFields()];
+			bool skip = false;
+
+			for ( int i = 0; i < NumFields(); ++i )
+				{
+				const Field* f = Fields()[i];
+				int col = field_map[i];
+
+				if ( col < 0 )
+					{
+					fields[i] = new Value(f->type, false);
+					continue;
+					}
+
+				// Take over the value.
+				fields[i] = vals[col][r];
+				vals[col][r] = 0;
+				fields[i]->type = f->type;
+
+				if ( ! fields[i]->present && ! f->optional )
+					{
+					Warning(Fmt("Field %s is not optional, but unset in %s. Skipping entry",
+						    f->name, fname.c_str()));
+					skip = true;
+					}
+				}
+
+			if ( skip )
+				{
+				for ( int i = 0; i < NumFields(); ++i )
+					delete fields[i];
+
+				delete [] fields;
+				continue;
+				}
+
+			if ( Info().mode == MODE_STREAM )
+				Put(fields);
+			else
+				SendEntry(fields);
+			}
+		}
+
+	// Release the values of columns we didn't forward, or all if we
+	// couldn't decode the group.
+	for ( size_t c = 0; c < decoded; ++c )
+		{
+		for ( uint64 r = 0; r < num_rows; ++r )
+			delete vals[c][r];
+
+		delete [] vals[c];
+		}
+
+	return result;
+	}
+
+bool Columnar::DoUpdate()
+	{
+	if ( firstrun )
+		firstrun = false;
+
+	else
+		{
+		switch ( Info().mode  ) {
+		case MODE_REREAD:
+			{
+			switch ( UpdateModificationTime() ) {
+			case -1:
+				return false; // error
+			case 0:
+				return true; // no change
+			case 1:
+				break; // file changed. reread.
+			default:
+				assert(false);
+			}
+			// fallthrough
+			}
+
+		case MODE_MANUAL:
+			offset = 0;
+			break;
+
+		case MODE_STREAM:
+			break;
+
+		default:
+			assert(false);
+		}
+		}
+
+	string data;
+
+	if ( ! ReadFile(&data) )
+		return false;
+
+	InBuffer in((const u_char*) data.data(), data.size());
+	size_t start = offset;
+	bool ok = true;
+	bool end = false;
+
+	// In stream mode, we may see a partially written file; we then
+	// continue from the last complete row group next time. Otherwise
+	// that means the file is truncated or corrupt.
+	if ( offset == 0 )
+		{
+		switch ( ReadHeader(&in) ) {
+		case PARSE_OK:
+			offset = start + in.Offset();
+			break;
+
+		case PARSE_INCOMPLETE:
+			if ( Info().mode != MODE_STREAM )
+				{
+				Error(Fmt("%s is truncated", fname.c_str()));
+				return false;
+				}
+
+			return true;
+
+		case PARSE_ERROR:
+			return false;
+		}
+		}
+
+	// The writer may not have closed the file yet, so we don't insist on
+	// the end marker.
+	while ( ! end && in.Left() > 0 )
+		{
+		ParseResult r = ReadRowGroup(&in, &end);
+
+		if ( r != PARSE_OK )
+			{
+			if ( Info().mode != MODE_STREAM )
+				{
+				Error(Fmt("%s is truncated or corrupt", fname.c_str()));
+				ok = false;
+				}
+
+			break;
+			}
+
+		if ( ! end )
+			offset = start + in.Offset();
+		}
+
+	if ( Info().mode != MODE_STREAM )
+		EndCurrentSend();
+
+	return ok;
+	}
+
+bool Columnar::DoHeartbeat(double network_time, double current_time)
+	{
+	switch ( Info().mode ) {
+		case MODE_MANUAL:
+			// yay, we do nothing :)
+			break;
+
+		case MODE_REREAD:
+		case MODE_STREAM:
+			Update();	// call update and not DoUpdate, because update
+					// checks disabled.
+			break;
+
+		default:
+			assert(false);
+	}
+
+	return true;
+	}
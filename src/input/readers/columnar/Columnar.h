@@ -0,0 +1,65 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef INPUT_READERS_COLUMNAR_H
+#define INPUT_READERS_COLUMNAR_H
+
+#include <vector>
+
+#include "input/ReaderBackend.h"
+#include "logging/writers/columnar/Format.h"
+
+namespace input { namespace reader {
+
+/**
+ * Reader for files written by the columnar log writer.
+ */
+class Columnar : public ReaderBackend {
+public:
+	Columnar(ReaderFrontend* frontend);
+	~Columnar();
+
+	static ReaderBackend* Instantiate(ReaderFrontend* frontend)
+		{ return new Columnar(frontend); }
+
+protected:
+	virtual bool DoInit(const ReaderInfo& info, int arg_num_fields,
+	                    const threading::Field* const* fields);
+	virtual void DoClose();
+	virtual bool DoUpdate();
+	virtual bool DoHeartbeat(double network_time, double current_time);
+
+private:
+	struct Column {
+		string name;
+		TypeTag type;
+		TypeTag subtype;
+	};
+
+	// Return values of the parsing methods.
+	enum ParseResult { PARSE_OK, PARSE_INCOMPLETE, PARSE_ERROR };
+
+	bool ReadFile(string* data);
+	ParseResult ReadHeader(logging::writer::columnar::InBuffer* in);
+	ParseResult ReadRowGroup(logging::writer::columnar::InBuffer* in,
+				 bool* end);
+	bool MapColumns();
+	int UpdateModificationTime();
+
+	string fname;
+	time_t mtime;
+	bool firstrun;
+
+	// The columns found in the file, and the index of the column each
+	// of our fields comes from, or -1 if the file doesn't have it.
+	std::vector<Column> columns;
+	std::vector<int> field_map;
+
+	// In stream mode, the offset of the first row group not yet
+	// forwarded; zero if we haven't read the header yet.
+	size_t offset;
+};
+
+}
+}
+
+#endif /* INPUT_READERS_COLUMNAR_H */
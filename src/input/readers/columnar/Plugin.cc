@@ -0,0 +1,24 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "plugin/Plugin.h"
+
+#include "Columnar.h"
+
+namespace plugin {
+namespace Bro_ColumnarReader {
+
+class Plugin : public plugin::Plugin {
+public:
+	plugin::Configuration Configure()
+		{
+		AddComponent(new ::input::Component("Columnar", ::input::reader::Columnar::Instantiate));
+
+		plugin::Configuration config;
+		config.name = "Bro::ColumnarReader";
+		config.description = "Columnar log file input reader";
+		return config;
+		}
+} plugin;
+
+}
+}
@@ -9,6 +9,7 @@
 #include "PktSrc.h"
 #include "Hash.h"
 #include "Net.h"
+#include "NetVar.h"
 #include "Sessions.h"
 
 using namespace iosource;
@@ -19,6 +20,9 @@ PktSrc::PktSrc()
 	errbuf = "";
 	SetClosed(true);
 
+	batch = 0;
+	batch_size = batch_len = batch_next = 0;
+
 	next_sync_point = 0;
 	first_timestamp = 0.0;
 	first_wallclock = current_wallclock = 0;
@@ -30,6 +34,8 @@ PktSrc::~PktSrc()
 	IterCookie* cookie = filters.InitForIteration();
 	while ( (code = filters.NextEntry(cookie)) )
 		delete code;
+
+	delete [] batch;
 	}
 
 const std::string& PktSrc::Path() const
@@ -102,6 +108,23 @@ void PktSrc::Opened(const Properties& arg_props)
 	props = arg_props;
 	SetClosed(false);
 
+	// We only batch live input. In pseudo-realtime mode, each packet
+	// has to wait for its time to come individually.
+	int new_batch_size = 1;
+
+	if ( props.is_live && ! pseudo_realtime &&
+	     BifConst::packet_batch_size > 1 )
+		new_batch_size = BifConst::packet_batch_size;
+
+	if ( new_batch_size != batch_size )
+		{
+		delete [] batch;
+		batch = new Packet[new_batch_size];
+		batch_size = new_batch_size;
+		}
+
+	batch_len = batch_next = 0;
+
 	if ( ! PrecompileFilter(0, "") || ! SetFilter(0) )
 		{
 		Close();
@@ -257,11 +280,30 @@ double PktSrc::NextTimestamp(double* local_network_time)
 
 void PktSrc::Process()
 	{
-	if ( ! IsOpen() )
-		return;
+	// Work through all packets of the current batch before returning
+	// to the main loop.
+	do
+		{
+		if ( ! IsOpen() )
+			return;
 
-	if ( ! ExtractNextPacketInternal() )
-		return;
+		if ( ! ExtractNextPacketInternal() )
+			return;
+
+		ProcessPacket();
+		}
+	while ( batch_next < batch_len );
+	}
+
+void PktSrc::ProcessPacket()
+	{
+	if ( batch_next < batch_len )
+		{
+		// Get the next packet's link-layer header into the cache
+		// while we're busy with the current one.
+		__builtin_prefetch(batch[batch_next].data);
+		__builtin_prefetch(batch[batch_next].hdr);
+		}
 
 	int pkt_hdr_size = props.hdr_size;
 
@@ -403,7 +445,12 @@ void PktSrc::Process()
 
 done:
 	have_packet = 0;
-	DoneWithPacket();
+
+	if ( batch_next >= batch_len )
+		{
+		batch_len = batch_next = 0;
+		DoneWithBatch();
+		}
 	}
 
 const char* PktSrc::Tag()
@@ -429,8 +476,22 @@ bool PktSrc::ExtractNextPacketInternal()
 	if ( pseudo_realtime )
 		current_wallclock = current_time(true);
 
-	if ( ExtractNextPacket(&current_packet) )
+	if ( batch_next < batch_len )
+		{
+		// Still have packets left from the current batch.
+		current_packet = batch[batch_next++];
+		SetIdle(false);
+		have_packet = true;
+		return 1;
+		}
+
+	batch_len = ExtractNextBatch(batch, batch_size);
+
+	if ( batch_len > 0 )
 		{
+		current_packet = batch[0];
+		batch_next = 1;
+
 		if ( ! first_timestamp )
 			first_timestamp = current_packet.ts;
 
@@ -439,6 +500,8 @@ bool PktSrc::ExtractNextPacketInternal()
 		return 1;
 		}
 
+	batch_len = 0;
+
 	if ( pseudo_realtime && using_communication && ! IsOpen() )
 		{
 		// Source has gone dry, we're done.
@@ -452,6 +515,16 @@ bool PktSrc::ExtractNextPacketInternal()
 	return 0;
 	}
 
+int PktSrc::ExtractNextBatch(Packet* pkts, int max)
+	{
+	return ExtractNextPacket(&pkts[0]) ? 1 : 0;
+	}
+
+void PktSrc::DoneWithBatch()
+	{
+	DoneWithPacket();
+	}
+
 bool PktSrc::PrecompileBPFFilter(int index, const std::string& filter)
 	{
 	if ( index < 0 )
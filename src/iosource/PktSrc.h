@@ -381,6 +381,41 @@ protected:
 	 */
 	virtual void DoneWithPacket() = 0;
 
+	/**
+	 * Provides a batch of packets from the source at once, which the
+	 * base class then processes without returning to the main loop in
+	 * between. This avoids the main loop's per-packet overhead of
+	 * finding the next source to process at high packet rates.
+	 *
+	 * Derived classes may override this method if they can deliver
+	 * more than one packet per call efficiently, ideally by pointing
+	 * directly into memory they already own (such as a capture ring)
+	 * rather than copying the packets. The default implementation
+	 * returns at most a single packet via \a ExtractNextPacket().
+	 *
+	 * @param pkts An array of packet structures to fill in. The callee
+	 * keeps ownership of the data of all the packets returned but must
+	 * guarantee that it stays available at least until \a
+	 * DoneWithBatch() is called. It is guaranteed that no two calls to
+	 * this method will happen without \a DoneWithBatch() in between.
+	 *
+	 * @param max The maximum number of packets to return, which is the
+	 * size of *pkts*. Will be one if batching isn't enabled for this
+	 * source (see the script-level \c packet_batch_size option).
+	 *
+	 * @return The number of packets filled in, which may be zero if no
+	 * packet is available or an error occured (which must be flagged
+	 * via Error()).
+	 */
+	virtual int ExtractNextBatch(Packet* pkts, int max);
+
+	/**
+	 * Signals that the data of all the packets of a batch previously
+	 * extracted with \a ExtractNextBatch() will no longer be needed.
+	 * The default implementation calls \a DoneWithPacket().
+	 */
+	virtual void DoneWithBatch();
+
 private:
 	// Checks if the current packet has a pseudo-time <= current_time. If
 	// yes, returns pseudo-time, otherwise 0.
@@ -389,6 +424,9 @@ private:
 	// Internal helper for ExtractNextPacket().
 	bool ExtractNextPacketInternal();
 
+	// Processes the current packet.
+	void ProcessPacket();
+
 	// IOSource interface implementation.
 	virtual void Init();
 	virtual void Done();
@@ -403,6 +441,13 @@ private:
 	bool have_packet;
 	Packet current_packet;
 
+	// The most recent batch of packets from ExtractNextBatch(), of
+	// which we have handed out the first batch_next ones so far.
+	Packet* batch;
+	int batch_size;
+	int batch_len;
+	int batch_next;
+
 	// For BPF filtering support.
 	PDict(BPF_Program) filters;
 
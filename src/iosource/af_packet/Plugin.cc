@@ -0,0 +1,24 @@
+// See the file  in the main distribution directory for copyright.
+
+#include "plugin/Plugin.h"
+
+#include "Source.h"
+
+namespace plugin {
+namespace Bro_AF_Packet {
+
+class Plugin : public plugin::Plugin {
+public:
+	plugin::Configuration Configure()
+		{
+		AddComponent(new ::iosource::PktSrcComponent("AF_PacketReader", "af_packet", ::iosource::PktSrcComponent::LIVE, ::iosource::af_packet::AF_PacketSource::Instantiate));
+
+		plugin::Configuration config;
+		config.name = "Bro::AF_Packet";
+		config.description = "Packet acquisition via Linux AF_PACKET sockets with TPACKET_V3 rings";
+		return config;
+		}
+} plugin;
+
+}
+}
@@ -0,0 +1,433 @@
+// See the file  in the main distribution directory for copyright.
+
+#include "config.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <net/ethernet.h>
+#include <netinet/in.h>
+
+extern "C" {
+#include <linux/filter.h>
+}
+
+#include "Source.h"
+#include "af_packet.bif.h"
+
+using namespace iosource::af_packet;
+
+// The kernel strips VLAN tags off the frames and reports them in the
+// packet header instead. We ask it to leave this much room in front of
+// each frame so that we can put the tag back in place.
+static const int VLAN_TAG_LEN = 4;
+
+AF_PacketSource::~AF_PacketSource()
+	{
+	Close();
+
+	delete [] hdrs;
+	}
+
+AF_PacketSource::AF_PacketSource(const std::string& path, bool is_live)
+	{
+	props.path = path;
+	props.is_live = is_live;
+	fd = -1;
+	ring = 0;
+	ring_size = 0;
+	memset(&req, 0, sizeof(req));
+	current_block = 0;
+	next_hdr = 0;
+	packets_left = 0;
+	hdrs = 0;
+	hdrs_size = 0;
+	kernel_packets = kernel_drops = 0;
+	}
+
+void AF_PacketSource::Open()
+	{
+	fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+
+	if ( fd < 0 )
+		{
+		Error(fmt("AF_PACKET socket: %s", strerror(errno)));
+		return;
+		}
+
+	struct ifreq ifr;
+	memset(&ifr, 0, sizeof(ifr));
+	safe_strncpy(ifr.ifr_name, props.path.c_str(), sizeof(ifr.ifr_name));
+
+	if ( ioctl(fd, SIOCGIFINDEX, &ifr) < 0 )
+		{
+		SocketError("SIOCGIFINDEX");
+		return;
+		}
+
+	int ifindex = ifr.ifr_ifindex;
+
+	if ( ioctl(fd, SIOCGIFHWADDR, &ifr) < 0 )
+		{
+		SocketError("SIOCGIFHWADDR");
+		return;
+		}
+
+	switch ( ifr.ifr_hwaddr.sa_family ) {
+	case ARPHRD_ETHER:
+	case ARPHRD_LOOPBACK:
+		props.link_type = DLT_EN10MB;
+		break;
+
+	default:
+		Error(fmt("%s: unsupported hardware type %d", props.path.c_str(),
+			  ifr.ifr_hwaddr.sa_family));
+		Close();
+		return;
+	}
+
+	if ( ioctl(fd, SIOCGIFNETMASK, &ifr) == 0 )
+		props.netmask = ((struct sockaddr_in*) &ifr.ifr_netmask)->sin_addr.s_addr;
+	else
+		// Same fallback as for pcap, the interface may not have an
+		// address assigned.
+		props.netmask = 0xffffff00;
+
+	if ( ! ConfigureRing() || ! BindInterface(ifindex) )
+		return;
+
+	if ( BifConst::AF_Packet::enable_fanout && ! JoinFanoutGroup() )
+		return;
+
+	props.selectable_fd = fd;
+	props.hdr_size = GetLinkHeaderSize(props.link_type);
+	props.is_live = true;
+
+	Opened(props);
+	}
+
+bool AF_PacketSource::ConfigureRing()
+	{
+	int version = TPACKET_V3;
+
+	if ( setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0 )
+		{
+		SocketError("PACKET_VERSION");
+		return false;
+		}
+
+	unsigned int reserve = VLAN_TAG_LEN;
+
+	if ( setsockopt(fd, SOL_PACKET, PACKET_RESERVE, &reserve, sizeof(reserve)) < 0 )
+		{
+		SocketError("PACKET_RESERVE");
+		return false;
+		}
+
+	// Blocks need to be a multiple of the page size. Frames are of
+	// variable size with TPACKET_V3, but the kernel still wants a frame
+	// size that divides the block size.
+	unsigned int page_size = getpagesize();
+	unsigned int block_size = BifConst::AF_Packet::block_size;
+	block_size = ((block_size + page_size - 1) / page_size) * page_size;
+
+	if ( block_size < page_size )
+		block_size = page_size;
+
+	unsigned int frame_size = TPACKET_ALIGNMENT << 7;
+	unsigned int block_nr = BifConst::AF_Packet::buffer_size / block_size;
+
+	if ( block_nr < 2 )
+		block_nr = 2;
+
+	unsigned int timeout = BifConst::AF_Packet::block_timeout * 1000;
+
+	if ( timeout < 1 )
+		timeout = 1;
+
+	req.tp_block_size = block_size;
+	req.tp_block_nr = block_nr;
+	req.tp_frame_size = frame_size;
+	req.tp_frame_nr = (block_size / frame_size) * block_nr;
+	req.tp_retire_blk_tov = timeout;
+	req.tp_sizeof_priv = 0;
+	req.tp_feature_req_word = 0;
+
+	if ( setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0 )
+		{
+		SocketError("PACKET_RX_RING");
+		return false;
+		}
+
+	ring_size = size_t(block_size) * block_nr;
+	void* m = mmap(0, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if ( m == MAP_FAILED )
+		{
+		SocketError("mmap");
+		return false;
+		}
+
+	ring = (u_char*) m;
+	current_block = 0;
+	next_hdr = 0;
+	packets_left = 0;
+
+	return true;
+	}
+
+bool AF_PacketSource::BindInterface(int ifindex)
+	{
+	struct sockaddr_ll addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sll_family = AF_PACKET;
+	addr.sll_protocol = htons(ETH_P_ALL);
+	addr.sll_ifindex = ifindex;
+
+	if ( bind(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0 )
+		{
+		SocketError("bind");
+		return false;
+		}
+
+	struct packet_mreq mreq;
+	memset(&mreq, 0, sizeof(mreq));
+	mreq.mr_ifindex = ifindex;
+	mreq.mr_type = PACKET_MR_PROMISC;
+
+	if ( setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0 )
+		{
+		SocketError("PACKET_ADD_MEMBERSHIP");
+		return false;
+		}
+
+	return true;
+	}
+
+bool AF_PacketSource::JoinFanoutGroup()
+	{
+	// Hashing on the flow keeps both directions of a connection with
+	// the same socket. The defrag flag makes the kernel reassemble IP
+	// fragments first so that they hash consistently as well.
+	int mode = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+	int arg = (BifConst::AF_Packet::fanout_id & 0xffff) | (mode << 16);
+
+	if ( setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &arg, sizeof(arg)) < 0 )
+		{
+		SocketError("PACKET_FANOUT");
+		return false;
+		}
+
+	return true;
+	}
+
+void AF_PacketSource::Close()
+	{
+	if ( fd < 0 )
+		return;
+
+	if ( ring )
+		munmap(ring, ring_size);
+
+	close(fd);
+
+	fd = -1;
+	ring = 0;
+	ring_size = 0;
+	next_hdr = 0;
+	packets_left = 0;
+
+	Closed();
+	}
+
+bool AF_PacketSource::ExtractNextPacket(Packet* pkt)
+	{
+	return ExtractNextBatch(pkt, 1) > 0;
+	}
+
+void AF_PacketSource::DoneWithPacket()
+	{
+	DoneWithBatch();
+	}
+
+int AF_PacketSource::ExtractNextBatch(Packet* pkts, int max)
+	{
+	if ( ! ring )
+		return 0;
+
+	if ( ! next_hdr )
+		{
+		// Start on the next block if the kernel has handed it over.
+		struct tpacket_block_desc* bd = (struct tpacket_block_desc*)
+			(ring + size_t(current_block) * req.tp_block_size);
+
+		if ( ! (bd->hdr.bh1.block_status & TP_STATUS_USER) )
+			return 0;
+
+		// Don't read the block's content before its status.
+		__sync_synchronize();
+
+		next_hdr = (struct tpacket3_hdr*)
+			((u_char*) bd + bd->hdr.bh1.offset_to_first_pkt);
+		packets_left = bd->hdr.bh1.num_pkts;
+
+		if ( ! packets_left )
+			{
+			ReleaseBlock();
+			return 0;
+			}
+		}
+
+	if ( max > hdrs_size )
+		{
+		delete [] hdrs;
+		hdrs = new struct pcap_pkthdr[max];
+		hdrs_size = max;
+		}
+
+	int n = 0;
+
+	while ( n < max && packets_left > 0 )
+		{
+		struct tpacket3_hdr* h = next_hdr;
+		u_char* data = (u_char*) h + h->tp_mac;
+		uint32 caplen = h->tp_snaplen;
+		uint32 len = h->tp_len;
+
+		if ( h->tp_status & TP_STATUS_VLAN_VALID )
+			{
+			// Move the MAC addresses into the reserved room in
+			// front and put the tag back in between.
+			uint16 tpid = ETH_P_8021Q;
+#ifdef TP_STATUS_VLAN_TPID_VALID
+			if ( h->tp_status & TP_STATUS_VLAN_TPID_VALID )
+				tpid = h->hv1.tp_vlan_tpid;
+#endif
+			uint16 tag[2];
+			tag[0] = htons(tpid);
+			tag[1] = htons(h->hv1.tp_vlan_tci);
+
+			data -= VLAN_TAG_LEN;
+			memmove(data, data + VLAN_TAG_LEN, 2 * ETHER_ADDR_LEN);
+			memcpy(data + 2 * ETHER_ADDR_LEN, tag, sizeof(tag));
+			caplen += VLAN_TAG_LEN;
+			len += VLAN_TAG_LEN;
+			}
+
+		if ( caplen > (uint32) SnapLen() )
+			caplen = SnapLen();
+
+		struct pcap_pkthdr* hdr = &hdrs[n];
+		hdr->ts.tv_sec = h->tp_sec;
+		hdr->ts.tv_usec = h->tp_nsec / 1000;
+		hdr->caplen = caplen;
+		hdr->len = len;
+
+		Packet* pkt = &pkts[n];
+		pkt->ts = h->tp_sec + double(h->tp_nsec) / 1e9;
+		pkt->hdr = hdr;
+		pkt->data = data;
+
+		next_hdr = (struct tpacket3_hdr*) ((u_char*) h + h->tp_next_offset);
+		--packets_left;
+		++n;
+		++stats.received;
+		}
+
+	return n;
+	}
+
+void AF_PacketSource::DoneWithBatch()
+	{
+	// The block stays ours until the last of its packets is done.
+	if ( next_hdr && ! packets_left )
+		ReleaseBlock();
+	}
+
+void AF_PacketSource::ReleaseBlock()
+	{
+	struct tpacket_block_desc* bd = (struct tpacket_block_desc*)
+		(ring + size_t(current_block) * req.tp_block_size);
+
+	// Make sure we're done with the content before the kernel may
+	// overwrite it.
+	__sync_synchronize();
+	bd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+
+	current_block = (current_block + 1) % req.tp_block_nr;
+	next_hdr = 0;
+	packets_left = 0;
+	}
+
+bool AF_PacketSource::PrecompileFilter(int index, const std::string& filter)
+	{
+	return PktSrc::PrecompileBPFFilter(index, filter);
+	}
+
+bool AF_PacketSource::SetFilter(int index)
+	{
+	if ( fd < 0 )
+		return true; // Prevent error message
+
+	BPF_Program* code = GetBPFFilter(index);
+
+	if ( ! code )
+		{
+		Error(fmt("No precompiled pcap filter for index %d", index));
+		return false;
+		}
+
+	// Classic BPF as compiled by libpcap is what the kernel's socket
+	// filter runs, so we can push the filter down and never see the
+	// packets it rejects.
+	struct bpf_program* prog = code->GetProgram();
+	struct sock_fprog fprog;
+	fprog.len = prog->bf_len;
+	fprog.filter = (struct sock_filter*) prog->bf_insns;
+
+	if ( setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0 )
+		{
+		Error(fmt("SO_ATTACH_FILTER: %s", strerror(errno)));
+		return false;
+		}
+
+	return true;
+	}
+
+void AF_PacketSource::Statistics(Stats* s)
+	{
+	if ( fd < 0 )
+		{
+		s->received = s->dropped = s->link = 0;
+		return;
+		}
+
+	struct tpacket_stats_v3 kstats;
+	socklen_t len = sizeof(kstats);
+
+	if ( getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &kstats, &len) == 0 )
+		{
+		// tp_packets includes the drops.
+		kernel_packets += kstats.tp_packets;
+		kernel_drops += kstats.tp_drops;
+		}
+
+	s->received = stats.received;
+	s->dropped = kernel_drops;
+	s->link = kernel_packets;
+	}
+
+void AF_PacketSource::SocketError(const char* what)
+	{
+	Error(fmt("%s on %s: %s", what, props.path.c_str(), strerror(errno)));
+	Close();
+	}
+
+iosource::PktSrc* AF_PacketSource::Instantiate(const std::string& path, bool is_live)
+	{
+	return new AF_PacketSource(path, is_live);
+	}
@@ -0,0 +1,82 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef IOSOURCE_PKTSRC_AF_PACKET_SOURCE_H
+#define IOSOURCE_PKTSRC_AF_PACKET_SOURCE_H
+
+extern "C" {
+#include <linux/if_packet.h>
+}
+
+#include "../PktSrc.h"
+
+namespace iosource {
+namespace af_packet {
+
+/**
+ * A live packet source reading directly from a Linux AF_PACKET socket
+ * through a memory-mapped TPACKET_V3 receive ring. The kernel fills
+ * whole blocks of packets that we then hand out without copying; a block
+ * goes back to the kernel once all of its packets have been processed.
+ *
+ * With AF_Packet::enable_fanout, several Bro processes opening the same
+ * interface join a common fanout group and the kernel load-balances
+ * between them by flow hash.
+ */
+class AF_PacketSource : public iosource::PktSrc {
+public:
+	AF_PacketSource(const std::string& path, bool is_live);
+	virtual ~AF_PacketSource();
+
+	static PktSrc* Instantiate(const std::string& path, bool is_live);
+
+protected:
+	// PktSrc interface.
+	virtual void Open();
+	virtual void Close();
+	virtual bool ExtractNextPacket(Packet* pkt);
+	virtual void DoneWithPacket();
+	virtual int ExtractNextBatch(Packet* pkts, int max);
+	virtual void DoneWithBatch();
+	virtual bool PrecompileFilter(int index, const std::string& filter);
+	virtual bool SetFilter(int index);
+	virtual void Statistics(Stats* stats);
+
+private:
+	bool ConfigureRing();
+	bool BindInterface(int ifindex);
+	bool JoinFanoutGroup();
+	void ReleaseBlock();
+	void SocketError(const char* what);
+
+	Properties props;
+	Stats stats;
+
+	int fd;
+
+	// The mmap'ed ring.
+	u_char* ring;
+	size_t ring_size;
+	struct tpacket_req3 req;
+
+	// The block we're currently working through, the next packet within
+	// it, and how many packets of it we haven't handed out yet. A null
+	// next_hdr means we're waiting for the kernel to hand current_block
+	// over to us.
+	int current_block;
+	struct tpacket3_hdr* next_hdr;
+	unsigned int packets_left;
+
+	// Headers for the packets we have handed out from the current block.
+	struct pcap_pkthdr* hdrs;
+	int hdrs_size;
+
+	// Counters accumulated from PACKET_STATISTICS, which resets them
+	// with each query.
+	uint64 kernel_packets;
+	uint64 kernel_drops;
+};
+
+}
+}
+
+#endif
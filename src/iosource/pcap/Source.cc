@@ -15,6 +15,9 @@ using namespace iosource::pcap;
 PcapSource::~PcapSource()
 	{
 	Close();
+
+	delete [] batch_hdrs;
+	delete [] batch_data;
 	}
 
 PcapSource::PcapSource(const std::string& path, bool is_live)
@@ -25,6 +28,12 @@ PcapSource::PcapSource(const std::string& path, bool is_live)
 	memset(&current_hdr, 0, sizeof(current_hdr));
 	memset(&last_hdr, 0, sizeof(last_hdr));
 	last_data = 0;
+
+	batch = 0;
+	batch_max = batch_len = 0;
+	batch_hdrs = 0;
+	batch_data = 0;
+	batch_data_len = batch_data_size = 0;
 	}
 
 void PcapSource::Open()
@@ -182,6 +191,73 @@ void PcapSource::DoneWithPacket()
 	// Nothing to do.
 	}
 
+int PcapSource::ExtractNextBatch(Packet* pkts, int max)
+	{
+	if ( max <= 1 || ! props.is_live )
+		return PktSrc::ExtractNextBatch(pkts, max);
+
+	if ( ! pd )
+		return 0;
+
+	int data_size = max * SnapLen();
+
+	if ( max > batch_max || data_size > batch_data_size )
+		{
+		delete [] batch_hdrs;
+		delete [] batch_data;
+		batch_hdrs = new struct pcap_pkthdr[max];
+		batch_data = new u_char[data_size];
+		batch_data_size = data_size;
+		}
+
+	batch = pkts;
+	batch_max = max;
+	batch_len = 0;
+	batch_data_len = 0;
+
+	// Returns after at most one buffer's worth of packets.
+	if ( pcap_dispatch(pd, max, BatchCallback, (u_char*) this) < 0 )
+		{
+		PcapError();
+		return 0;
+		}
+
+	return batch_len;
+	}
+
+void PcapSource::BatchCallback(u_char* user, const struct pcap_pkthdr* hdr,
+				const u_char* data)
+	{
+	PcapSource* src = (PcapSource*) user;
+
+	if ( src->batch_len >= src->batch_max )
+		return;
+
+	Packet* pkt = &src->batch[src->batch_len];
+	struct pcap_pkthdr* pkt_hdr = &src->batch_hdrs[src->batch_len];
+
+	*pkt_hdr = *hdr;
+	pkt->ts = hdr->ts.tv_sec + double(hdr->ts.tv_usec) / 1e6;
+	pkt->hdr = pkt_hdr;
+	pkt->data = src->batch_data + src->batch_data_len;
+
+	if ( hdr->len == 0 || hdr->caplen == 0 )
+		{
+		src->Weird("empty_pcap_header", pkt);
+		return;
+		}
+
+	if ( src->batch_data_len + int(hdr->caplen) > src->batch_data_size )
+		// Can't happen as long as libpcap honors the snaplen.
+		pkt_hdr->caplen = src->batch_data_size - src->batch_data_len;
+
+	memcpy(src->batch_data + src->batch_data_len, data, pkt_hdr->caplen);
+	src->batch_data_len += pkt_hdr->caplen;
+
+	++src->batch_len;
+	++src->stats.received;
+	}
+
 bool PcapSource::PrecompileFilter(int index, const std::string& filter)
 	{
 	return PktSrc::PrecompileBPFFilter(index, filter);
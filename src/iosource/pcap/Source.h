@@ -21,6 +21,7 @@ protected:
 	virtual void Close();
 	virtual bool ExtractNextPacket(Packet* pkt);
 	virtual void DoneWithPacket();
+	virtual int ExtractNextBatch(Packet* pkts, int max);
 	virtual bool PrecompileFilter(int index, const std::string& filter);
 	virtual bool SetFilter(int index);
 	virtual void Statistics(Stats* stats);
@@ -31,6 +32,9 @@ private:
 	void PcapError();
 	void SetHdrSize();
 
+	static void BatchCallback(u_char* user, const struct pcap_pkthdr* hdr,
+				  const u_char* data);
+
 	Properties props;
 	Stats stats;
 
@@ -39,6 +43,17 @@ private:
 	struct pcap_pkthdr current_hdr;
 	struct pcap_pkthdr last_hdr;
 	const u_char* last_data;
+
+	// State for filling a batch from within BatchCallback(). libpcap
+	// may reuse its buffer once the callback returns, so we copy the
+	// packets back to back into batch_data.
+	Packet* batch;
+	int batch_max;
+	int batch_len;
+	struct pcap_pkthdr* batch_hdrs;
+	u_char* batch_data;
+	int batch_data_len;
+	int batch_data_size;
 };
 
 }
@@ -263,7 +263,7 @@ bool Manager::CreateStream(EnumVal* id, RecordVal* sval)
 		if ( ! same_type((*args)[0], columns) )
 			{
 			reporter->Error("stream event's argument type does not match column record type");
-			return new Val(0, TYPE_BOOL);
+			return val_mgr->GetBool(0);
 			}
 		}
 
@@ -814,13 +814,16 @@ bool Manager::Write(EnumVal* id, RecordVal* columns)
 				}
 			}
 
-		// Alright, can do the write now.
-
-		threading::Value** vals = RecordToFilterVals(stream, filter, columns);
-
-		// Write takes ownership of vals.
+		// Alright, can do the write now. We build the record right
+		// inside the writer's current batch.
 		assert(writer);
-		writer->Write(filter->num_fields, vals);
+		WriteBatch* batch = writer->CurrentBatch();
+
+		if ( batch )
+			{
+			RecordToFilterVals(stream, filter, columns, batch);
+			writer->WriteRow();
+			}
 
 #ifdef DEBUG
 		DBG_LOG(DBG_LOGGING, "Wrote record to filter '%s' on stream '%s'",
@@ -836,15 +839,16 @@ bool Manager::Write(EnumVal* id, RecordVal* columns)
 	return true;
 	}
 
-threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
+threading::Value* Manager::ValToLogVal(Val* val, WriteBatch* batch,
+					BroType* ty)
 	{
 	if ( ! ty )
 		ty = val->Type();
 
 	if ( ! val )
-		return new threading::Value(ty->Tag(), false);
+		return batch->NewValue(ty->Tag(), false);
 
-	threading::Value* lval = new threading::Value(ty->Tag());
+	threading::Value* lval = batch->NewValue(ty->Tag());
 
 	switch ( lval->type ) {
 	case TYPE_BOOL:
@@ -859,14 +863,15 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 
 		if ( s )
 			{
-			lval->val.string_val.data = copy_string(s);
 			lval->val.string_val.length = strlen(s);
+			lval->val.string_val.data =
+				batch->NewString(s, lval->val.string_val.length);
 			}
 
 		else
 			{
 			val->Type()->Error("enum type does not contain value", val);
-			lval->val.string_val.data = copy_string("");
+			lval->val.string_val.data = batch->NewString("", 0);
 			lval->val.string_val.length = 0;
 			}
 		break;
@@ -899,10 +904,8 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 	case TYPE_STRING:
 		{
 		const BroString* s = val->AsString();
-		char* buf = new char[s->Len()];
-		memcpy(buf, s->Bytes(), s->Len());
-
-		lval->val.string_val.data = buf;
+		lval->val.string_val.data =
+			batch->NewString((const char*) s->Bytes(), s->Len());
 		lval->val.string_val.length = s->Len();
 		break;
 		}
@@ -911,7 +914,7 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 		{
 		const BroFile* f = val->AsFile();
 		string s = f->Name();
-		lval->val.string_val.data = copy_string(s.c_str());
+		lval->val.string_val.data = batch->NewString(s.data(), s.size());
 		lval->val.string_val.length = s.size();
 		break;
 		}
@@ -922,8 +925,9 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 		const Func* f = val->AsFunc();
 		f->Describe(&d);
 		const char* s = d.Description();
-		lval->val.string_val.data = copy_string(s);
 		lval->val.string_val.length = strlen(s);
+		lval->val.string_val.data =
+			batch->NewString(s, lval->val.string_val.length);
 		break;
 		}
 
@@ -936,10 +940,10 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 			set = new ListVal(TYPE_INT);
 
 		lval->val.set_val.size = set->Length();
-		lval->val.set_val.vals = new threading::Value* [lval->val.set_val.size];
+		lval->val.set_val.vals = batch->NewValues(lval->val.set_val.size);
 
 		for ( int i = 0; i < lval->val.set_val.size; i++ )
-			lval->val.set_val.vals[i] = ValToLogVal(set->Index(i));
+			lval->val.set_val.vals[i] = ValToLogVal(set->Index(i), batch);
 
 		Unref(set);
 		break;
@@ -950,12 +954,12 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 		VectorVal* vec = val->AsVectorVal();
 		lval->val.vector_val.size = vec->Size();
 		lval->val.vector_val.vals =
-			new threading::Value* [lval->val.vector_val.size];
+			batch->NewValues(lval->val.vector_val.size);
 
 		for ( int i = 0; i < lval->val.vector_val.size; i++ )
 			{
 			lval->val.vector_val.vals[i] =
-				ValToLogVal(vec->Lookup(i),
+				ValToLogVal(vec->Lookup(i), batch,
 					    vec->Type()->YieldType());
 			}
 
@@ -970,9 +974,9 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 	}
 
 threading::Value** Manager::RecordToFilterVals(Stream* stream, Filter* filter,
-				    RecordVal* columns)
+				    RecordVal* columns, WriteBatch* batch)
 	{
-	threading::Value** vals = new threading::Value*[filter->num_fields];
+	threading::Value** vals = batch->AddRow();
 
 	for ( int i = 0; i < filter->num_fields; ++i )
 		{
@@ -991,13 +995,13 @@ threading::Value** Manager::RecordToFilterVals(Stream* stream, Filter* filter,
 			if ( ! val )
 				{
 				// Value, or any of its parents, is not set.
-				vals[i] = new threading::Value(filter->fields[i]->type, false);
+				vals[i] = batch->NewValue(filter->fields[i]->type, false);
 				break;
 				}
 			}
 
 		if ( val )
-			vals[i] = ValToLogVal(val);
+			vals[i] = ValToLogVal(val, batch);
 		}
 
 	return vals;
@@ -1080,7 +1084,7 @@ WriterFrontend* Manager::CreateWriter(EnumVal* id, EnumVal* writer, WriterBacken
 
 void Manager::DeleteVals(int num_fields, threading::Value** vals)
 	{
-	// Note this code is duplicated in WriterBackend::DeleteVals().
+	// Note this code is duplicated in WriterFrontend::DeleteVals().
 	for ( int i = 0; i < num_fields; i++ )
 		delete vals[i];
 
@@ -1337,7 +1341,7 @@ bool Manager::FinishedRotation(WriterFrontend* writer, const char* new_name, con
 	info->Assign(2, new StringVal(winfo->writer->Info().path));
 	info->Assign(3, new Val(open, TYPE_TIME));
 	info->Assign(4, new Val(close, TYPE_TIME));
-	info->Assign(5, new Val(terminating, TYPE_BOOL));
+	info->Assign(5, val_mgr->GetBool(terminating));
 
 	Func* func = winfo->postprocessor;
 	if ( ! func )
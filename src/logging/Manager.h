@@ -21,6 +21,7 @@ class RotationTimer;
 namespace logging {
 
 class WriterFrontend;
+class WriteBatch;
 class RotationFinishedMessage;
 
 /**
@@ -198,9 +199,10 @@ private:
 			    TableVal* include, TableVal* exclude, string path, list<int> indices);
 
 	threading::Value** RecordToFilterVals(Stream* stream, Filter* filter,
-				    RecordVal* columns);
+				    RecordVal* columns, WriteBatch* batch);
 
-	threading::Value* ValToLogVal(Val* val, BroType* ty = 0);
+	threading::Value* ValToLogVal(Val* val, WriteBatch* batch,
+				      BroType* ty = 0);
 	Stream* FindStream(EnumVal* id);
 	void RemoveDisabledWriters(Stream* stream);
 	void InstallRotationTimer(WriterInfo* winfo);
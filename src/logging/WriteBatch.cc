@@ -0,0 +1,120 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include <new>
+
+#include "util.h"
+
+#include "WriteBatch.h"
+
+using namespace logging;
+using threading::Value;
+
+WriteBatch::WriteBatch(int arg_num_fields, int arg_max_writes, size_t size_hint)
+	{
+	num_fields = arg_num_fields;
+	num_writes = 0;
+	max_writes = arg_max_writes;
+
+	blocks = next = 0;
+	avail = size = 0;
+	first_block_size = size_hint > BLOCK_SIZE ? size_hint : BLOCK_SIZE;
+
+	rows = (Value***) Alloc(max_writes * sizeof(Value**));
+	}
+
+WriteBatch::~WriteBatch()
+	{
+	// The values' destructors would try to free what they point to, so
+	// we don't run them.
+	while ( blocks )
+		{
+		char* b = blocks;
+		blocks = *(char**) b;
+		free(b);
+		}
+	}
+
+void* WriteBatch::AllocSlow(size_t n)
+	{
+	size_t bsize = blocks ? BLOCK_SIZE : first_block_size;
+
+	if ( bsize < n )
+		bsize = n;
+
+	char* b = (char*) safe_malloc(ALIGN + bsize);
+	*(char**) b = blocks;
+	blocks = b;
+
+	next = b + ALIGN;
+	avail = bsize;
+
+	return Alloc(n);
+	}
+
+Value** WriteBatch::AddRow()
+	{
+	assert(num_writes < max_writes);
+
+	Value** row = NewValues(num_fields);
+	rows[num_writes++] = row;
+	return row;
+	}
+
+Value* WriteBatch::NewValue(TypeTag type, bool present)
+	{
+	return new (Alloc(sizeof(Value))) Value(type, present);
+	}
+
+Value** WriteBatch::NewValues(int n)
+	{
+	return (Value**) Alloc(n * sizeof(Value*));
+	}
+
+char* WriteBatch::NewString(const char* data, int len)
+	{
+	char* s = (char*) Alloc(len + 1);
+	memcpy(s, data, len);
+	s[len] = '\0';
+	return s;
+	}
+
+Value* WriteBatch::CopyValue(const Value* val)
+	{
+	Value* v = NewValue(val->type, val->present);
+
+	if ( ! val->present )
+		return v;
+
+	v->val = val->val;
+
+	switch ( val->type ) {
+	case TYPE_ENUM:
+	case TYPE_STRING:
+	case TYPE_FILE:
+	case TYPE_FUNC:
+		v->val.string_val.data = NewString(val->val.string_val.data,
+						   val->val.string_val.length);
+		break;
+
+	case TYPE_TABLE:
+		v->val.set_val.vals = NewValues(val->val.set_val.size);
+
+		for ( int i = 0; i < val->val.set_val.size; i++ )
+			v->val.set_val.vals[i] = CopyValue(val->val.set_val.vals[i]);
+
+		break;
+
+	case TYPE_VECTOR:
+		v->val.vector_val.vals = NewValues(val->val.vector_val.size);
+
+		for ( int i = 0; i < val->val.vector_val.size; i++ )
+			v->val.vector_val.vals[i] = CopyValue(val->val.vector_val.vals[i]);
+
+		break;
+
+	default:
+		break;
+	}
+
+	return v;
+	}
@@ -0,0 +1,131 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef LOGGING_WRITEBATCH_H
+#define LOGGING_WRITEBATCH_H
+
+#include "threading/SerialTypes.h"
+
+namespace logging  {
+
+/**
+ * A batch of log records that a WriterFrontend hands over to its
+ * WriterBackend in a single message.
+ *
+ * All memory for the records, i.e., the row arrays, the threading::Value
+ * instances, and the strings and set/vector elements they point to, is
+ * carved out of a few large blocks owned by the batch. Deleting the batch
+ * releases everything at once, so values allocated from a batch must never
+ * be deleted individually.
+ */
+class WriteBatch {
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param num_fields The number of fields of each record.
+	 *
+	 * @param max_writes The maximum number of records the batch can hold.
+	 *
+	 * @param size_hint The number of bytes to reserve upfront. Choosing
+	 * this large enough for all records means a single allocation for
+	 * the whole batch.
+	 */
+	WriteBatch(int num_fields, int max_writes, size_t size_hint);
+
+	/**
+	 * Destructor. Releases all records.
+	 */
+	~WriteBatch();
+
+	/**
+	 * Returns the number of fields of each record.
+	 */
+	int NumFields() const	{ return num_fields; }
+
+	/**
+	 * Returns the number of records in the batch.
+	 */
+	int NumWrites() const	{ return num_writes; }
+
+	/**
+	 * Returns true if the batch can't take any further records.
+	 */
+	bool Full() const	{ return num_writes >= max_writes; }
+
+	/**
+	 * Returns the records, an array of NumWrites() rows of NumFields()
+	 * values each.
+	 */
+	threading::Value*** Rows() const	{ return rows; }
+
+	/**
+	 * Returns the number of bytes the records take up.
+	 */
+	size_t Size() const	{ return size; }
+
+	/**
+	 * Adds a record. The caller must fill in all of its values,
+	 * allocating them with the methods below. Must not be called if
+	 * the batch is Full().
+	 *
+	 * @return The array of the new record's NumFields() values.
+	 */
+	threading::Value** AddRow();
+
+	/**
+	 * Allocates a value.
+	 */
+	threading::Value* NewValue(TypeTag type, bool present = true);
+
+	/**
+	 * Allocates an array of value pointers, as needed for sets and
+	 * vectors.
+	 */
+	threading::Value** NewValues(int n);
+
+	/**
+	 * Allocates a copy of a string, with a terminating null byte added.
+	 */
+	char* NewString(const char* data, int len);
+
+	/**
+	 * Allocates a deep copy of a value.
+	 */
+	threading::Value* CopyValue(const threading::Value* val);
+
+private:
+	void* Alloc(size_t n)
+		{
+		n = (n + ALIGN - 1) & ~(ALIGN - 1);
+
+		if ( n > avail )
+			return AllocSlow(n);
+
+		void* p = next;
+		next += n;
+		avail -= n;
+		size += n;
+		return p;
+		}
+
+	void* AllocSlow(size_t n);
+
+	static const size_t ALIGN = 8;
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	int num_fields;
+	int num_writes;
+	int max_writes;
+	threading::Value*** rows;
+
+	// The blocks are chained through their first word.
+	char* blocks;
+	char* next;	// Where the next allocation goes in the current block
+	size_t avail;	// Bytes left in the current block
+	size_t size;	// Bytes allocated so far
+	size_t first_block_size;
+};
+
+}
+
+#endif
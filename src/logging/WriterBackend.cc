@@ -144,20 +144,6 @@ WriterBackend::~WriterBackend()
 	delete info;
 	}
 
-void WriterBackend::DeleteVals(int num_writes, Value*** vals)
-	{
-	for ( int j = 0; j < num_writes; ++j )
-		{
-		// Note this code is duplicated in Manager::DeleteVals().
-		for ( int i = 0; i < num_fields; i++ )
-			delete vals[j][i];
-
-		delete [] vals[j];
-		}
-
-	delete [] vals;
-	}
-
 bool WriterBackend::FinishedRotation(const char* new_name, const char* old_name,
 				     double open, double close, bool terminating)
 	{
@@ -209,7 +195,6 @@ bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
 		Debug(DBG_LOGGING, msg);
 #endif
 
-		DeleteVals(num_writes, vals);
 		DisableFrontend();
 		return false;
 		}
@@ -227,7 +212,6 @@ bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
 				Debug(DBG_LOGGING, msg);
 #endif
 				DisableFrontend();
-				DeleteVals(num_writes, vals);
 				return false;
 				}
 			}
@@ -236,17 +220,7 @@ bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
 	bool success = true;
 
 	if ( ! Failed() )
-		{
-		for ( int j = 0; j < num_writes; j++ )
-			{
-			success = DoWrite(num_fields, fields, vals[j]);
-
-			if ( ! success )
-				break;
-			}
-		}
-
-	DeleteVals(num_writes, vals);
+		success = DoWriteBatch(num_fields, fields, num_writes, vals);
 
 	if ( ! success )
 		DisableFrontend();
@@ -254,6 +228,18 @@ bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
 	return success;
 	}
 
+bool WriterBackend::DoWriteBatch(int num_fields, const Field* const* fields,
+				 int num_writes, Value*** vals)
+	{
+	for ( int j = 0; j < num_writes; j++ )
+		{
+		if ( ! DoWrite(num_fields, fields, vals[j]) )
+			return false;
+		}
+
+	return true;
+	}
+
 bool WriterBackend::SetBuf(bool enabled)
 	{
 	if ( enabled == buffering )
@@ -136,14 +136,17 @@ public:
 	bool Init(int num_fields, const threading::Field* const* fields);
 
 	/**
-	 * Writes one log entry.
+	 * Writes a batch of log entries.
 	 *
 	 * @param num_fields: The number of log fields for this stream. The
 	 * value must match what was passed to Init().
 	 *
-	 * @param An array of size \a num_fields with the log values. Their
-	 * types musst match with the field passed to Init(). The method
-	 * takes ownership of \a vals..
+	 * @param num_writes: The number of log entries.
+	 *
+	 * @param An array of size \a num_writes of arrays of size \a
+	 * num_fields with the log values. Their types musst match with the
+	 * field passed to Init(). The values remain owned by the caller (in
+	 * practice, a WriteBatch).
 	 *
 	 * Returns false if an error occured, in which case the writer must
 	 * not be used any further.
@@ -279,6 +282,18 @@ protected:
 	virtual bool DoWrite(int num_fields, const threading::Field* const*  fields,
 			     threading::Value** vals) = 0;
 
+	/**
+	 * Writer-specific output method implementing recording of a whole
+	 * batch of log entries at once.
+	 *
+	 * A writer may override this method if it can take advantage of
+	 * getting many entries together. The default implementation calls
+	 * DoWrite() for each of them. The return value has the same meaning
+	 * as for DoWrite().
+	 */
+	virtual bool DoWriteBatch(int num_fields, const threading::Field* const* fields,
+				  int num_writes, threading::Value*** vals);
+
 	/**
 	 * Writer-specific method implementing a change of fthe buffering
 	 * state.  If buffering is disabled, the writer should attempt to
@@ -369,11 +384,6 @@ protected:
 	virtual bool DoHeartbeat(double network_time, double current_time) = 0;
 
 private:
-	/**
-	 * Deletes the values as passed into Write().
-	 */
-	void DeleteVals(int num_writes, threading::Value*** vals);
-
 	// Frontend that instantiated us. This object must not be access from
 	// this class, it's running in a different thread!
 	WriterFrontend* frontend;
@@ -54,16 +54,20 @@ private:
 class WriteMessage : public threading::InputMessage<WriterBackend>
 {
 public:
-	WriteMessage(WriterBackend* backend, int num_fields, int num_writes, Value*** vals)
+	WriteMessage(WriterBackend* backend, WriteBatch* batch)
 		: threading::InputMessage<WriterBackend>("Write", backend),
-		num_fields(num_fields), num_writes(num_writes), vals(vals)	{}
+		batch(batch)	{}
 
-	virtual bool Process() { return Object()->Write(num_fields, num_writes, vals); }
+	virtual ~WriteMessage()	{ delete batch; }
+
+	virtual bool Process()
+		{
+		return Object()->Write(batch->NumFields(), batch->NumWrites(),
+				       batch->Rows());
+		}
 
 private:
-	int num_fields;
-	int num_writes;
-	Value ***vals;
+	WriteBatch* batch;
 };
 
 class SetBufMessage : public threading::InputMessage<WriterBackend>
@@ -108,8 +112,8 @@ WriterFrontend::WriterFrontend(const WriterBackend::WriterInfo& arg_info, EnumVa
 	buf = true;
 	local = arg_local;
 	remote = arg_remote;
-	write_buffer = 0;
-	write_buffer_pos = 0;
+	write_batch = 0;
+	batch_size_hint = 0;
 	info = new WriterBackend::WriterInfo(arg_info);
 
 	num_fields = 0;
@@ -134,6 +138,7 @@ WriterFrontend::~WriterFrontend()
 	{
 	Unref(stream);
 	Unref(writer);
+	delete write_batch;
 	delete info;
 	delete [] name;
 	}
@@ -177,49 +182,75 @@ void WriterFrontend::Init(int arg_num_fields, const Field* const * arg_fields)
 
 void WriterFrontend::Write(int num_fields, Value** vals)
 	{
-	if ( disabled )
-		return;
-
-	if ( remote )
-		remote_serializer->SendLogWrite(stream,
-						writer,
-						info->path,
-						num_fields,
-						vals);
+	WriteBatch* batch = CurrentBatch();
 
-	if ( ! backend )
+	if ( ! batch )
 		{
 		DeleteVals(vals);
 		return;
 		}
 
-	if ( ! write_buffer )
-		{
+	Value** row = batch->AddRow();
+
+	for ( int i = 0; i < num_fields; i++ )
+		row[i] = batch->CopyValue(vals[i]);
+
+	DeleteVals(vals);
+	WriteRow();
+	}
+
+WriteBatch* WriterFrontend::CurrentBatch()
+	{
+	if ( disabled )
+		return 0;
+
+	if ( ! write_batch )
 		// Need new buffer.
-		write_buffer = new Value**[WRITER_BUFFER_SIZE];
-		write_buffer_pos = 0;
-		}
+		write_batch = new WriteBatch(num_fields, WRITER_BUFFER_SIZE,
+					     batch_size_hint);
 
-	write_buffer[write_buffer_pos++] = vals;
+	return write_batch;
+	}
 
-	if ( write_buffer_pos >= WRITER_BUFFER_SIZE || ! buf || terminating )
+void WriterFrontend::WriteRow()
+	{
+	assert(write_batch && write_batch->NumWrites());
+
+	if ( remote )
+		remote_serializer->SendLogWrite(stream,
+						writer,
+						info->path,
+						num_fields,
+						write_batch->Rows()[write_batch->NumWrites() - 1]);
+
+	if ( ! backend || write_batch->Full() || ! buf || terminating )
 		// Buffer full (or no bufferin desired or termiating).
 		FlushWriteBuffer();
-
 	}
 
 void WriterFrontend::FlushWriteBuffer()
 	{
-	if ( ! write_buffer_pos )
+	if ( ! write_batch || ! write_batch->NumWrites() )
 		// Nothing to do.
 		return;
 
+	// The next batch probably needs about as much memory as the recent
+	// ones. Follow growth right away but shrink only gradually, so that
+	// a single burst doesn't leave all later batches oversized.
+	size_t size = write_batch->Size();
+
+	if ( size > batch_size_hint )
+		batch_size_hint = size;
+	else
+		batch_size_hint = (batch_size_hint + size) / 2;
+
 	if ( backend )
-		backend->SendIn(new WriteMessage(backend, num_fields, write_buffer_pos, write_buffer));
+		// Passes ownership to child thread.
+		backend->SendIn(new WriteMessage(backend, write_batch));
+	else
+		delete write_batch;
 
-	// Clear buffer (no delete, we pass ownership to child thread.)
-	write_buffer = 0;
-	write_buffer_pos = 0;
+	write_batch = 0;
 	}
 
 void WriterFrontend::SetBuf(bool enabled)
@@ -4,6 +4,7 @@
 #define LOGGING_WRITERFRONTEND_H
 
 #include "WriterBackend.h"
+#include "WriteBatch.h"
 
 #include "threading/MsgThread.h"
 
@@ -91,12 +92,30 @@ public:
 	 *
 	 * See WriterBackend::Writer() for arguments (except that this method
 	 * takes only a single record, not an array). The method takes
-	 * ownership of \a vals.
+	 * ownership of \a vals, which must have been allocated from the
+	 * heap; it copies them over into the current batch.
 	 *
 	 * This method must only be called from the main thread.
 	 */
 	void Write(int num_fields, threading::Value** vals);
 
+	/**
+	 * Returns the batch that the next record is to be added to, for a
+	 * subsequent WriteRow(). This saves the copy that Write() needs to
+	 * make. Returns null if the writer is disabled.
+	 *
+	 * This method must only be called from the main thread.
+	 */
+	WriteBatch* CurrentBatch();
+
+	/**
+	 * Writes out the record that the caller has just added to
+	 * CurrentBatch(). Otherwise, this is the same as Write().
+	 *
+	 * This method must only be called from the main thread.
+	 */
+	void WriteRow();
+
 	/**
 	 * Sets the buffering state.
 	 *
@@ -222,8 +241,8 @@ protected:
 
 	// Buffer for bulk writes.
 	static const int WRITER_BUFFER_SIZE = 1000;
-	int write_buffer_pos;	// Position of next write in buffer.
-	threading::Value*** write_buffer;	// Buffer of size WRITER_BUFFER_SIZE.
+	WriteBatch* write_batch;	// Records not yet sent to the backend.
+	size_t batch_size_hint;	// Expected size of the next batch.
 };
 
 }
@@ -390,6 +390,62 @@ bool Ascii::DoRotate(const char* rotated_path, double open, double close, bool t
 	return true;
 	}
 
+bool Ascii::DoWriteBatch(int num_fields, const Field* const * fields,
+			 int num_writes, Value*** vals)
+	{
+	if ( ! fd )
+		DoInit(Info(), NumFields(), Fields());
+
+	// Format all the entries into one buffer that we then write out
+	// at once.
+	desc.Clear();
+
+	for ( int j = 0; j < num_writes; j++ )
+		{
+		int start = desc.Len();
+
+		if ( ! formatter->Describe(&desc, num_fields, fields, vals[j]) )
+			{
+			// Still write out the entries before this one.
+			if ( ! safe_write(fd, (const char*)desc.Bytes(), start) )
+				goto write_error;
+
+			return false;
+			}
+
+		desc.AddRaw("\n", 1);
+
+		const char* bytes = (const char*)desc.Bytes() + start;
+
+		if ( strncmp(bytes, meta_prefix.data(), meta_prefix.size()) == 0 )
+			{
+			// Escape the first character like DoWrite() does,
+			// writing out what we have so far.
+			char hex[4] = {'\\', 'x', '0', '0'};
+			bytetohex(bytes[0], hex + 2);
+
+			if ( ! safe_write(fd, (const char*)desc.Bytes(), start) ||
+			     ! safe_write(fd, hex, 4) ||
+			     ! safe_write(fd, bytes + 1, desc.Len() - start - 1) )
+				goto write_error;
+
+			desc.Clear();
+			}
+		}
+
+	if ( ! safe_write(fd, (const char*)desc.Bytes(), desc.Len()) )
+		goto write_error;
+
+	if ( ! IsBuf() )
+		fsync(fd);
+
+	return true;
+
+write_error:
+	Error(Fmt("error writing to %s: %s", fname.c_str(), Strerror(errno)));
+	return false;
+	}
+
 bool Ascii::DoSetBuf(bool enabled)
 	{
 	// Nothing to do.
@@ -26,6 +26,8 @@ protected:
 			    const threading::Field* const* fields);
 	virtual bool DoWrite(int num_fields, const threading::Field* const* fields,
 			     threading::Value** vals);
+	virtual bool DoWriteBatch(int num_fields, const threading::Field* const* fields,
+				  int num_writes, threading::Value*** vals);
 	virtual bool DoSetBuf(bool enabled);
 	virtual bool DoRotate(const char* rotated_path, double open,
 			      double close, bool terminating);
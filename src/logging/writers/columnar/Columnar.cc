@@ -0,0 +1,249 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include <string>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "threading/SerialTypes.h"
+
+#include "Columnar.h"
+#include "columnar.bif.h"
+
+using namespace logging::writer;
+using namespace logging::writer::columnar;
+using threading::Value;
+using threading::Field;
+
+Columnar::Columnar(WriterFrontend* frontend) : WriterBackend(frontend)
+	{
+	fd = 0;
+	done = false;
+	num_rows = 0;
+
+	row_group_size = BifConst::LogColumnar::row_group_size;
+	compression_level = BifConst::LogColumnar::compression_level;
+
+	if ( row_group_size < 1 )
+		row_group_size = 1;
+
+	if ( compression_level > 9 )
+		compression_level = 9;
+	}
+
+Columnar::~Columnar()
+	{
+	if ( ! done )
+		{
+		// Shouldn't normally happen.
+		fprintf(stderr, "internal error: finish missing\n");
+		abort();
+		}
+
+	for ( size_t i = 0; i < columns.size(); ++i )
+		delete columns[i];
+	}
+
+bool Columnar::DoInit(const WriterInfo& info, int num_fields, const Field* const * fields)
+	{
+	for ( int i = 0; i < num_fields; ++i )
+		{
+		switch ( fields[i]->type ) {
+		case TYPE_BOOL:
+		case TYPE_INT:
+		case TYPE_COUNT:
+		case TYPE_COUNTER:
+		case TYPE_PORT:
+		case TYPE_ADDR:
+		case TYPE_SUBNET:
+		case TYPE_DOUBLE:
+		case TYPE_TIME:
+		case TYPE_INTERVAL:
+		case TYPE_ENUM:
+		case TYPE_STRING:
+		case TYPE_FILE:
+		case TYPE_FUNC:
+		case TYPE_TABLE:
+		case TYPE_VECTOR:
+			break;
+
+		default:
+			Error(Fmt("unsupported field type %s for %s",
+				  type_name(fields[i]->type), fields[i]->name));
+			return false;
+		}
+
+		columns.push_back(new ColumnEncoder(fields[i]->type));
+		}
+
+	return OpenFile();
+	}
+
+bool Columnar::OpenFile()
+	{
+	assert(! fd);
+
+	fname = string(Info().path) + "." + LogExt();
+	fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	if ( fd < 0 )
+		{
+		Error(Fmt("cannot open %s: %s", fname.c_str(), Strerror(errno)));
+		fd = 0;
+		return false;
+		}
+
+	return WriteHeader();
+	}
+
+bool Columnar::WriteHeader()
+	{
+	OutBuffer out;
+	out.Bytes(MAGIC, MAGIC_LEN);
+
+	out.Varint(NumFields());
+
+	for ( int i = 0; i < NumFields(); ++i )
+		{
+		const Field* f = Fields()[i];
+		out.String(f->name, strlen(f->name));
+		out.Byte(f->type);
+		out.Byte(f->subtype);
+		out.Byte(f->optional ? 1 : 0);
+		}
+
+	string path = Info().path;
+
+	out.Varint(1);
+	out.String("path", 4);
+	out.String(path.data(), path.size());
+
+	return WriteOut(out);
+	}
+
+bool Columnar::WriteRowGroup()
+	{
+	if ( ! num_rows )
+		return true;
+
+	OutBuffer out;
+	out.Varint(num_rows);
+
+	for ( size_t i = 0; i < columns.size(); ++i )
+		columns[i]->Finish(&out, compression_level);
+
+	num_rows = 0;
+
+	return WriteOut(out);
+	}
+
+bool Columnar::WriteOut(const OutBuffer& out)
+	{
+	if ( ! safe_write(fd, out.data.data(), out.data.size()) )
+		{
+		Error(Fmt("error writing to %s: %s", fname.c_str(), Strerror(errno)));
+		return false;
+		}
+
+	return true;
+	}
+
+bool Columnar::CloseFile()
+	{
+	if ( ! fd )
+		return true;
+
+	bool ok = WriteRowGroup();
+
+	if ( ok )
+		{
+		OutBuffer out;
+		out.Varint(0);
+		ok = WriteOut(out);
+		}
+
+	safe_close(fd);
+	fd = 0;
+	return ok;
+	}
+
+bool Columnar::DoWrite(int num_fields, const Field* const * fields,
+		       Value** vals)
+	{
+	if ( ! fd && ! OpenFile() )
+		return false;
+
+	// The values go away once we return, so encode them right away.
+	for ( int i = 0; i < num_fields; ++i )
+		columns[i]->Add(vals[i]);
+
+	if ( ++num_rows >= row_group_size )
+		return WriteRowGroup();
+
+	return true;
+	}
+
+bool Columnar::DoSetBuf(bool enabled)
+	{
+	// Nothing to do, we always write complete row groups.
+	return true;
+	}
+
+bool Columnar::DoFlush(double network_time)
+	{
+	if ( ! fd )
+		return true;
+
+	bool ok = WriteRowGroup();
+	fsync(fd);
+	return ok;
+	}
+
+bool Columnar::DoRotate(const char* rotated_path, double open, double close, bool terminating)
+	{
+	// Don't rotate if there's not a file currently open.
+	if ( ! fd )
+		{
+		FinishedRotation();
+		return true;
+		}
+
+	CloseFile();
+
+	string nname = string(rotated_path) + "." + LogExt();
+
+	if ( rename(fname.c_str(), nname.c_str()) != 0 )
+		{
+		Error(Fmt("failed to rename %s to %s: %s", fname.c_str(),
+			  nname.c_str(), Strerror(errno)));
+		FinishedRotation();
+		return false;
+		}
+
+	if ( ! FinishedRotation(nname.c_str(), fname.c_str(), open, close, terminating) )
+		{
+		Error(Fmt("error rotating %s to %s", fname.c_str(), nname.c_str()));
+		return false;
+		}
+
+	return true;
+	}
+
+bool Columnar::DoFinish(double network_time)
+	{
+	if ( done )
+		{
+		fprintf(stderr, "internal error: duplicate finish\n");
+		abort();
+		}
+
+	done = true;
+
+	return CloseFile();
+	}
+
+bool Columnar::DoHeartbeat(double network_time, double current_time)
+	{
+	// Nothing to do.
+	return true;
+	}
@@ -0,0 +1,59 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Log writer for a binary columnar format, see Format.h.
+
+#ifndef LOGGING_WRITER_COLUMNAR_H
+#define LOGGING_WRITER_COLUMNAR_H
+
+#include "logging/WriterBackend.h"
+
+#include "Format.h"
+
+namespace logging { namespace writer {
+
+class Columnar : public WriterBackend {
+public:
+	Columnar(WriterFrontend* frontend);
+	~Columnar();
+
+	static string LogExt()	{ return "bcol"; }
+
+	static WriterBackend* Instantiate(WriterFrontend* frontend)
+		{ return new Columnar(frontend); }
+
+protected:
+	virtual bool DoInit(const WriterInfo& info, int num_fields,
+			    const threading::Field* const* fields);
+	virtual bool DoWrite(int num_fields, const threading::Field* const* fields,
+			     threading::Value** vals);
+	virtual bool DoSetBuf(bool enabled);
+	virtual bool DoRotate(const char* rotated_path, double open,
+			      double close, bool terminating);
+	virtual bool DoFlush(double network_time);
+	virtual bool DoFinish(double network_time);
+	virtual bool DoHeartbeat(double network_time, double current_time);
+
+private:
+	bool OpenFile();
+	bool WriteHeader();
+	bool WriteRowGroup();
+	bool CloseFile();
+	bool WriteOut(const columnar::OutBuffer& out);
+
+	int fd;
+	string fname;
+	bool done;
+
+	// The row group under construction.
+	std::vector<columnar::ColumnEncoder*> columns;
+	int num_rows;
+
+	// Options set from the script-level.
+	int row_group_size;
+	int compression_level;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,684 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include <string.h>
+#include <zlib.h>
+
+#include "Reporter.h"
+
+#include "Format.h"
+
+using namespace logging::writer::columnar;
+using threading::Value;
+
+void OutBuffer::Varint(uint64 v)
+	{
+	while ( v >= 0x80 )
+		{
+		Byte(uint8(v | 0x80));
+		v >>= 7;
+		}
+
+	Byte(uint8(v));
+	}
+
+void OutBuffer::Double(double d)
+	{
+	uint64 bits;
+	memcpy(&bits, &d, sizeof(bits));
+
+	for ( int i = 0; i < 8; ++i )
+		Byte(uint8(bits >> (8 * i)));
+	}
+
+bool InBuffer::Byte(uint8* b)
+	{
+	if ( cur >= end )
+		return false;
+
+	*b = *cur++;
+	return true;
+	}
+
+bool InBuffer::Varint(uint64* v)
+	{
+	*v = 0;
+
+	for ( int shift = 0; shift < 64; shift += 7 )
+		{
+		uint8 b;
+
+		if ( ! Byte(&b) )
+			return false;
+
+		*v |= uint64(b & 0x7f) << shift;
+
+		if ( ! (b & 0x80) )
+			return true;
+		}
+
+	return false;
+	}
+
+bool InBuffer::ZigZag(int64* v)
+	{
+	uint64 u;
+
+	if ( ! Varint(&u) )
+		return false;
+
+	*v = int64(u >> 1) ^ -int64(u & 1);
+	return true;
+	}
+
+bool InBuffer::Double(double* d)
+	{
+	const u_char* b;
+
+	if ( ! Bytes(&b, 8) )
+		return false;
+
+	uint64 bits = 0;
+
+	for ( int i = 0; i < 8; ++i )
+		bits |= uint64(b[i]) << (8 * i);
+
+	memcpy(d, &bits, sizeof(bits));
+	return true;
+	}
+
+bool InBuffer::Bytes(const u_char** b, size_t n)
+	{
+	if ( Left() < n )
+		return false;
+
+	*b = cur;
+	cur += n;
+	return true;
+	}
+
+bool InBuffer::String(const char** s, size_t* n)
+	{
+	uint64 len;
+
+	if ( ! Varint(&len) || len > Left() )
+		return false;
+
+	*n = len;
+	return Bytes((const u_char**) s, len);
+	}
+
+static void encode_addr(OutBuffer* out, const Value::addr_t& addr)
+	{
+	if ( addr.family == IPv4 )
+		{
+		out->Byte(4);
+		out->Bytes(&addr.in.in4, sizeof(addr.in.in4));
+		}
+	else
+		{
+		out->Byte(6);
+		out->Bytes(&addr.in.in6, sizeof(addr.in.in6));
+		}
+	}
+
+static bool decode_addr(InBuffer* in, Value::addr_t* addr)
+	{
+	uint8 family;
+	const u_char* b;
+
+	if ( ! in->Byte(&family) )
+		return false;
+
+	switch ( family ) {
+	case 4:
+		if ( ! in->Bytes(&b, sizeof(addr->in.in4)) )
+			return false;
+
+		addr->family = IPv4;
+		memcpy(&addr->in.in4, b, sizeof(addr->in.in4));
+		return true;
+
+	case 6:
+		if ( ! in->Bytes(&b, sizeof(addr->in.in6)) )
+			return false;
+
+		addr->family = IPv6;
+		memcpy(&addr->in.in6, b, sizeof(addr->in.in6));
+		return true;
+
+	default:
+		return false;
+	}
+	}
+
+void logging::writer::columnar::EncodeValue(OutBuffer* out, const Value* val)
+	{
+	switch ( val->type ) {
+	case TYPE_BOOL:
+		out->Byte(val->val.int_val ? 1 : 0);
+		break;
+
+	case TYPE_INT:
+		out->ZigZag(val->val.int_val);
+		break;
+
+	case TYPE_COUNT:
+	case TYPE_COUNTER:
+		out->Varint(val->val.uint_val);
+		break;
+
+	case TYPE_PORT:
+		out->Varint(val->val.port_val.port);
+		out->Byte(val->val.port_val.proto);
+		break;
+
+	case TYPE_ADDR:
+		encode_addr(out, val->val.addr_val);
+		break;
+
+	case TYPE_SUBNET:
+		encode_addr(out, val->val.subnet_val.prefix);
+		out->Byte(val->val.subnet_val.length);
+		break;
+
+	case TYPE_DOUBLE:
+	case TYPE_TIME:
+	case TYPE_INTERVAL:
+		out->Double(val->val.double_val);
+		break;
+
+	case TYPE_ENUM:
+	case TYPE_STRING:
+	case TYPE_FILE:
+	case TYPE_FUNC:
+		out->String(val->val.string_val.data, val->val.string_val.length);
+		break;
+
+	case TYPE_TABLE:
+	case TYPE_VECTOR:
+		{
+		// The set and vector representations are the same.
+		const Value::set_t& s = val->val.set_val;
+		out->Varint(s.size);
+
+		for ( int i = 0; i < s.size; ++i )
+			{
+			out->Byte(s.vals[i]->present ? 1 : 0);
+
+			if ( s.vals[i]->present )
+				EncodeValue(out, s.vals[i]);
+			}
+
+		break;
+		}
+
+	default:
+		reporter->InternalError("unsupported type %s in columnar encoding",
+					type_name(val->type));
+	}
+	}
+
+Value* logging::writer::columnar::DecodeValue(InBuffer* in, TypeTag type,
+						TypeTag subtype)
+	{
+	Value* val = new Value(type, true);
+	bool ok = true;
+
+	switch ( type ) {
+	case TYPE_BOOL:
+		{
+		uint8 b;
+		ok = in->Byte(&b) && b <= 1;
+		val->val.int_val = b;
+		break;
+		}
+
+	case TYPE_INT:
+		{
+		int64 i;
+		ok = in->ZigZag(&i);
+		val->val.int_val = i;
+		break;
+		}
+
+	case TYPE_COUNT:
+	case TYPE_COUNTER:
+		{
+		uint64 u;
+		ok = in->Varint(&u);
+		val->val.uint_val = u;
+		break;
+		}
+
+	case TYPE_PORT:
+		{
+		uint64 port;
+		uint8 proto;
+		ok = in->Varint(&port) && in->Byte(&proto) && port <= 0xffff &&
+		     proto <= TRANSPORT_ICMP;
+		val->val.port_val.port = port;
+		val->val.port_val.proto = TransportProto(proto);
+		break;
+		}
+
+	case TYPE_ADDR:
+		ok = decode_addr(in, &val->val.addr_val);
+		break;
+
+	case TYPE_SUBNET:
+		ok = decode_addr(in, &val->val.subnet_val.prefix) &&
+		     in->Byte(&val->val.subnet_val.length);
+		break;
+
+	case TYPE_DOUBLE:
+	case TYPE_TIME:
+	case TYPE_INTERVAL:
+		ok = in->Double(&val->val.double_val);
+		break;
+
+	case TYPE_ENUM:
+	case TYPE_STRING:
+	case TYPE_FILE:
+	case TYPE_FUNC:
+		{
+		const char* s;
+		size_t n;
+
+		if ( ! in->String(&s, &n) )
+			{
+			// The destructor would free the data otherwise.
+			val->present = false;
+			ok = false;
+			break;
+			}
+
+		val->val.string_val.data = new char[n];
+		val->val.string_val.length = n;
+		memcpy(val->val.string_val.data, s, n);
+		break;
+		}
+
+	case TYPE_TABLE:
+	case TYPE_VECTOR:
+		{
+		Value::set_t& s = val->val.set_val;
+		uint64 n;
+
+		// Each element takes at least a byte.
+		if ( ! in->Varint(&n) || n > in->Left() )
+			{
+			val->present = false;
+			ok = false;
+			break;
+			}
+
+		s.size = n;
+		s.vals = new Value*[n];
+
+		for ( int i = 0; i < s.size; ++i )
+			{
+			uint8 present;
+
+			if ( ! in->Byte(&present) || present > 1 )
+				s.vals[i] = 0;
+
+			else if ( present )
+				s.vals[i] = DecodeValue(in, subtype, TYPE_VOID);
+
+			else
+				s.vals[i] = new Value(subtype, false);
+
+			if ( ! s.vals[i] )
+				{
+				// Clean up only what we have.
+				s.size = i;
+				ok = false;
+				break;
+				}
+			}
+
+		break;
+		}
+
+	default:
+		ok = false;
+		val->present = false;
+	}
+
+	if ( ! ok )
+		{
+		delete val;
+		return 0;
+		}
+
+	return val;
+	}
+
+// Copies a decoded dictionary entry.
+static Value* copy_value(const Value* val)
+	{
+	Value* v = new Value(val->type, true);
+	v->val = val->val;
+
+	switch ( val->type ) {
+	case TYPE_ENUM:
+	case TYPE_STRING:
+	case TYPE_FILE:
+	case TYPE_FUNC:
+		v->val.string_val.data = new char[val->val.string_val.length];
+		memcpy(v->val.string_val.data, val->val.string_val.data,
+		       val->val.string_val.length);
+		break;
+
+	default:
+		break;
+	}
+
+	return v;
+	}
+
+ColumnEncoder::ColumnEncoder(TypeTag arg_type)
+	{
+	type = arg_type;
+	num_rows = 0;
+	}
+
+bool ColumnEncoder::IsDictType() const
+	{
+	switch ( type ) {
+	case TYPE_ENUM:
+	case TYPE_STRING:
+	case TYPE_FILE:
+	case TYPE_FUNC:
+	case TYPE_ADDR:
+	case TYPE_SUBNET:
+	case TYPE_PORT:
+		return true;
+
+	default:
+		return false;
+	}
+	}
+
+void ColumnEncoder::Add(const Value* val)
+	{
+	if ( num_rows % 8 == 0 )
+		present.push_back(0);
+
+	if ( val->present )
+		present[num_rows / 8] |= 1 << (num_rows % 8);
+
+	++num_rows;
+
+	if ( ! val->present )
+		return;
+
+	if ( type == TYPE_TIME )
+		times.push_back(val->val.double_val);
+
+	else if ( IsDictType() )
+		{
+		scratch.data.clear();
+		EncodeValue(&scratch, val);
+
+		std::pair<DictMap::iterator, bool> i =
+			dict.insert(DictMap::value_type(scratch.data, dict.size()));
+
+		if ( i.second )
+			dict_values.push_back(&i.first->first);
+
+		indices.push_back(i.first->second);
+		}
+
+	else
+		EncodeValue(&values, val);
+	}
+
+void ColumnEncoder::Finish(OutBuffer* out, int compression_level)
+	{
+	OutBuffer raw;
+	raw.Bytes(present.data(), present.size());
+
+	Encoding enc = ENC_PLAIN;
+
+	if ( type == TYPE_TIME )
+		{
+		// Timestamps of subsequent entries tend to be close together,
+		// and so are the bit patterns of positive doubles.
+		enc = ENC_DELTA;
+		int64 prev = 0;
+
+		for ( size_t i = 0; i < times.size(); ++i )
+			{
+			int64 bits;
+			memcpy(&bits, &times[i], sizeof(bits));
+			raw.ZigZag(int64(uint64(bits) - uint64(prev)));
+			prev = bits;
+			}
+		}
+
+	else if ( IsDictType() && dict_values.size() * 2 <= indices.size() )
+		{
+		enc = ENC_DICT;
+		raw.Varint(dict_values.size());
+
+		for ( size_t i = 0; i < dict_values.size(); ++i )
+			raw.Bytes(dict_values[i]->data(), dict_values[i]->size());
+
+		for ( size_t i = 0; i < indices.size(); )
+			{
+			size_t j = i + 1;
+
+			while ( j < indices.size() && indices[j] == indices[i] )
+				++j;
+
+			raw.Varint(indices[i]);
+			raw.Varint(j - i);
+			i = j;
+			}
+		}
+
+	else if ( IsDictType() )
+		{
+		for ( size_t i = 0; i < indices.size(); ++i )
+			{
+			const std::string* v = dict_values[indices[i]];
+			raw.Bytes(v->data(), v->size());
+			}
+		}
+
+	else
+		raw.Bytes(values.data.data(), values.data.size());
+
+	out->Byte(enc);
+
+	uLongf clen = 0;
+	std::string cbuf;
+
+	if ( compression_level > 0 )
+		{
+		clen = compressBound(raw.data.size());
+		cbuf.resize(clen);
+
+		if ( compress2((Bytef*) &cbuf[0], &clen,
+			       (const Bytef*) raw.data.data(), raw.data.size(),
+			       compression_level) != Z_OK )
+			clen = 0;
+		}
+
+	if ( clen && clen < raw.data.size() )
+		{
+		out->Byte(COMP_ZLIB);
+		out->Varint(raw.data.size());
+		out->Varint(clen);
+		out->Bytes(cbuf.data(), clen);
+		}
+
+	else
+		{
+		out->Byte(COMP_NONE);
+		out->Varint(raw.data.size());
+		out->Varint(raw.data.size());
+		out->Bytes(raw.data.data(), raw.data.size());
+		}
+
+	Reset();
+	}
+
+void ColumnEncoder::Reset()
+	{
+	num_rows = 0;
+	present.clear();
+	values.data.clear();
+	dict.clear();
+	dict_values.clear();
+	indices.clear();
+	times.clear();
+	}
+
+static bool decode_present_values(InBuffer* in, uint8 enc, int num_rows,
+				  const u_char* bitmap, TypeTag type,
+				  TypeTag subtype, Value** vals)
+	{
+	std::vector<Value*> dict;
+	uint64 run_index = 0;
+	uint64 run_left = 0;
+	int64 prev = 0;
+	bool ok = true;
+
+	if ( enc == ENC_DICT )
+		{
+		uint64 n;
+
+		// Each entry takes at least a byte.
+		if ( ! in->Varint(&n) || n > in->Left() )
+			return false;
+
+		for ( uint64 i = 0; i < n && ok; ++i )
+			{
+			Value* v = DecodeValue(in, type, subtype);
+
+			if ( v )
+				dict.push_back(v);
+			else
+				ok = false;
+			}
+		}
+
+	else if ( enc == ENC_DELTA && type != TYPE_TIME )
+		ok = false;
+
+	else if ( enc != ENC_PLAIN && enc != ENC_DELTA )
+		ok = false;
+
+	for ( int i = 0; i < num_rows && ok; ++i )
+		{
+		if ( ! (bitmap[i / 8] & (1 << (i % 8))) )
+			{
+			vals[i] = new Value(type, false);
+			continue;
+			}
+
+		switch ( enc ) {
+		case ENC_PLAIN:
+			vals[i] = DecodeValue(in, type, subtype);
+			break;
+
+		case ENC_DICT:
+			if ( ! run_left &&
+			     ! (in->Varint(&run_index) && in->Varint(&run_left) &&
+				run_index < dict.size() && run_left > 0) )
+				break;
+
+			--run_left;
+			vals[i] = copy_value(dict[run_index]);
+			break;
+
+		case ENC_DELTA:
+			{
+			int64 delta;
+
+			if ( ! in->ZigZag(&delta) )
+				break;
+
+			prev = int64(uint64(prev) + uint64(delta));
+			vals[i] = new Value(type, true);
+			memcpy(&vals[i]->val.double_val, &prev, sizeof(prev));
+			break;
+			}
+		}
+
+		ok = (vals[i] != 0);
+		}
+
+	for ( size_t i = 0; i < dict.size(); ++i )
+		delete dict[i];
+
+	return ok;
+	}
+
+bool logging::writer::columnar::DecodeColumn(InBuffer* in, int num_rows,
+					     TypeTag type, TypeTag subtype,
+					     Value** vals)
+	{
+	uint8 enc;
+	uint8 comp;
+	uint64 raw_len;
+	uint64 stored_len;
+	const u_char* stored;
+
+	if ( ! (in->Byte(&enc) && in->Byte(&comp) && in->Varint(&raw_len) &&
+		in->Varint(&stored_len) && in->Bytes(&stored, stored_len)) )
+		return false;
+
+	std::string uncompressed;
+	const u_char* raw = stored;
+
+	switch ( comp ) {
+	case COMP_NONE:
+		if ( raw_len != stored_len )
+			return false;
+
+		break;
+
+	case COMP_ZLIB:
+		{
+		// Guard against absurd sizes in a corrupt file. Zlib doesn't
+		// expand data by more than about a factor of 1000.
+		if ( raw_len > stored_len * 1032 + 64 )
+			return false;
+
+		uncompressed.resize(raw_len);
+		uLongf len = raw_len;
+
+		if ( uncompress((Bytef*) &uncompressed[0], &len, stored,
+				stored_len) != Z_OK || len != raw_len )
+			return false;
+
+		raw = (const u_char*) uncompressed.data();
+		break;
+		}
+
+	default:
+		return false;
+	}
+
+	InBuffer column(raw, raw_len);
+	const u_char* bitmap;
+
+	for ( int i = 0; i < num_rows; ++i )
+		vals[i] = 0;
+
+	if ( column.Bytes(&bitmap, (num_rows + 7) / 8) &&
+	     decode_present_values(&column, enc, num_rows, bitmap, type,
+				   subtype, vals) )
+		return true;
+
+	for ( int i = 0; i < num_rows; ++i )
+		{
+		delete vals[i];
+		vals[i] = 0;
+		}
+
+	return false;
+	}
@@ -0,0 +1,168 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Encoding of the columnar log format, shared between the writer and the
+// corresponding input reader.
+//
+// A file starts with the magic bytes "BROCOL1\n" and a header describing
+// the schema:
+//
+//   varint   number of columns
+//            per column: string name, byte type, byte subtype, byte optional
+//   varint   number of meta data entries
+//            per entry: string key, string value
+//
+// It then continues with any number of row groups:
+//
+//   varint   number of rows; zero marks the end of the file
+//            per column: byte encoding, byte compression, varint raw size,
+//            varint stored size, the stored bytes
+//
+// The raw bytes of a column start with a bitmap that has a bit set for
+// each row with a value, followed by the present values in one of these
+// encodings:
+//
+//   ENC_PLAIN   each value as described for EncodeValue()
+//   ENC_DICT    varint number of distinct values, each encoded as with
+//               ENC_PLAIN, followed by runs of (varint index, varint length)
+//   ENC_DELTA   for times: the bit patterns of the IEEE doubles as zigzag
+//               varints, each relative to the previous one
+//
+// With COMP_ZLIB, the raw bytes are stored deflated.
+//
+// Integers are little-endian base-128 varints, with zigzag encoding for
+// signed ones. Strings are a varint length followed by the bytes.
+
+#ifndef LOGGING_WRITER_COLUMNAR_FORMAT_H
+#define LOGGING_WRITER_COLUMNAR_FORMAT_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "threading/SerialTypes.h"
+
+namespace logging { namespace writer { namespace columnar {
+
+static const char MAGIC[] = "BROCOL1\n";
+static const int MAGIC_LEN = 8;
+
+enum Encoding { ENC_PLAIN = 0, ENC_DICT = 1, ENC_DELTA = 2 };
+enum Compression { COMP_NONE = 0, COMP_ZLIB = 1 };
+
+/**
+ * A buffer to encode into.
+ */
+class OutBuffer {
+public:
+	void Byte(uint8 b)	{ data.push_back(char(b)); }
+	void Varint(uint64 v);
+	void ZigZag(int64 v)	{ Varint((uint64(v) << 1) ^ uint64(v >> 63)); }
+	void Double(double d);
+	void Bytes(const void* b, size_t n)	{ data.append((const char*) b, n); }
+	void String(const char* s, size_t n)	{ Varint(n); Bytes(s, n); }
+
+	std::string data;
+};
+
+/**
+ * A buffer to decode from. All methods return false if there's not enough
+ * data left.
+ */
+class InBuffer {
+public:
+	InBuffer(const u_char* data, size_t len)
+		: start(data), cur(data), end(data + len)	{ }
+
+	bool Byte(uint8* b);
+	bool Varint(uint64* v);
+	bool ZigZag(int64* v);
+	bool Double(double* d);
+	bool Bytes(const u_char** b, size_t n);
+	bool String(const char** s, size_t* n);
+
+	size_t Offset() const	{ return cur - start; }
+	size_t Left() const	{ return end - cur; }
+
+private:
+	const u_char* start;
+	const u_char* cur;
+	const u_char* end;
+};
+
+/**
+ * Encodes a present value: bools as a byte, ints and counts as varints,
+ * doubles as 8 little-endian bytes, ports as varint port and protocol
+ * byte, addresses as a family byte (4 or 6) and the address bytes, subnets
+ * as address and prefix length byte, and strings, enums, files and
+ * functions as strings. Sets and vectors are the number of elements
+ * followed by each element as a byte that's zero for unset elements and
+ * then, if it's one, the encoded element.
+ */
+void EncodeValue(OutBuffer* out, const threading::Value* val);
+
+/**
+ * Decodes a value encoded with EncodeValue().
+ *
+ * @return The value, or null if the data is malformed.
+ */
+threading::Value* DecodeValue(InBuffer* in, TypeTag type, TypeTag subtype);
+
+/**
+ * Accumulates the values of one column for a row group.
+ */
+class ColumnEncoder {
+public:
+	ColumnEncoder(TypeTag type);
+
+	/**
+	 * Adds the value of the next row.
+	 */
+	void Add(const threading::Value* val);
+
+	/**
+	 * Appends the column of all the rows added so far to a row group,
+	 * and starts over.
+	 *
+	 * @param compression_level The zlib compression level, zero to not
+	 * compress.
+	 */
+	void Finish(OutBuffer* out, int compression_level);
+
+private:
+	bool IsDictType() const;
+	void Reset();
+
+	TypeTag type;
+	int num_rows;
+	std::string present;	// Bitmap of rows with a value.
+
+	// Plainly encoded values.
+	OutBuffer values;
+
+	// For types we may dictionary-encode: the distinct values, as
+	// encoded by EncodeValue(), and the index of each row's value.
+	typedef std::map<std::string, uint32> DictMap;
+	DictMap dict;
+	std::vector<const std::string*> dict_values;
+	std::vector<uint32> indices;
+	OutBuffer scratch;
+
+	// For times.
+	std::vector<double> times;
+};
+
+/**
+ * Decodes one column of a row group.
+ *
+ * @param vals An array of size \a num_rows to store the values in. Rows
+ * without a value get an unset one.
+ *
+ * @return False if the data is malformed, in which case \a vals is left
+ * empty.
+ */
+bool DecodeColumn(InBuffer* in, int num_rows, TypeTag type, TypeTag subtype,
+		  threading::Value** vals);
+
+} } }
+
+#endif
@@ -0,0 +1,24 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "plugin/Plugin.h"
+
+#include "Columnar.h"
+
+namespace plugin {
+namespace Bro_ColumnarWriter {
+
+class Plugin : public plugin::Plugin {
+public:
+	plugin::Configuration Configure()
+		{
+		AddComponent(new ::logging::Component("Columnar", ::logging::writer::Columnar::Instantiate));
+
+		plugin::Configuration config;
+		config.name = "Bro::ColumnarWriter";
+		config.description = "Binary columnar log writer";
+		return config;
+		}
+} plugin;
+
+}
+}
@@ -35,9 +35,13 @@ extern "C" void OPENSSL_add_all_algorithms_conf(void);
 #include "NetVar.h"
 #include "Var.h"
 #include "Timer.h"
+#include "Reassem.h"
+#include "ByteCode.h"
+#include "ScriptUsage.h"
 #include "Stmt.h"
 #include "Debug.h"
 #include "DFA.h"
+#include "DFACache.h"
 #include "RuleMatcher.h"
 #include "Anon.h"
 #include "Serializer.h"
@@ -110,6 +114,7 @@ int signal_val = 0;
 int optimize = 0;
 int do_notice_analysis = 0;
 int rule_bench = 0;
+int rule_profile = 0;
 extern char version[];
 char* command_line_policy = 0;
 vector<string> params;
@@ -209,6 +214,14 @@ void usage()
 	fprintf(stderr, "    --pseudo-realtime[=<speedup>]  | enable pseudo-realtime for performance evaluation (default 1)\n");
 	fprintf(stderr, "    --load-seeds <file>            | load seeds from given file\n");
 	fprintf(stderr, "    --save-seeds <file>            | save seeds to given file\n");
+	fprintf(stderr, "    --timer-mgr <pq|cq|wheel>      | select timer manager implementation (default pq)\n");
+	fprintf(stderr, "    --timer-benchmark              | compare timer managers on a synthetic workload and exit\n");
+	fprintf(stderr, "    --reassem-benchmark            | time reassembly of pathological segment orders and exit\n");
+	fprintf(stderr, "    --bytecode                     | compile script functions to bytecode\n");
+	fprintf(stderr, "    --bytecode-benchmark           | compare interpreted and compiled script functions and exit\n");
+	fprintf(stderr, "    --print-unused-events          | print events and record fields the scripts don't use and exit\n");
+	fprintf(stderr, "    --dfa-cache-file <file>        | load compiled patterns from file and save new ones there\n");
+	fprintf(stderr, "    --rule-profile                 | time signature matching and print a per-rule profile at exit\n");
 
 #ifdef USE_IDMEF
 	fprintf(stderr, "    -n|--idmef-dtd <idmef-msg.dtd> | specify path to IDMEF DTD file\n");
@@ -377,6 +390,13 @@ void terminate_bro()
 
 	plugin_mgr->FinishPlugins();
 
+	if ( rule_profile && rule_matcher )
+		rule_matcher->DumpProfile(stderr);
+
+	if ( dfa_cache )
+		dfa_cache->Save();
+
+	delete dfa_cache;
 	delete broxygen_mgr;
 	delete timer_mgr;
 	delete persistence_serializer;
@@ -467,6 +487,12 @@ int main(int argc, char** argv)
 	int RE_level = 4;
 	int print_plugins = 0;
 	int time_bro = 0;
+	const char* timer_mgr_type = "pq";
+	int timer_bench = 0;
+	int reassem_bench = 0;
+	int bytecode_bench = 0;
+	int print_unused_events = 0;
+	const char* dfa_cache_file = 0;
 
 	static struct option long_opts[] = {
 		{"parse-only",	no_argument,		0,	'a'},
@@ -518,6 +544,14 @@ int main(int argc, char** argv)
 #endif
 
 		{"pseudo-realtime",	optional_argument, 0,	'E'},
+		{"timer-mgr",		required_argument,	0,	'j'},
+		{"timer-benchmark",	no_argument,		0,	'k'},
+		{"reassem-benchmark",	no_argument,		0,	'o'},
+		{"bytecode",		no_argument,		0,	'q'},
+		{"bytecode-benchmark",	no_argument,		0,	'u'},
+		{"print-unused-events",	no_argument,		0,	'c'},
+		{"dfa-cache-file",	required_argument,	0,	'A'},
+		{"rule-profile",	no_argument,		0,	'V'},
 
 		{0,			0,			0,	0},
 	};
@@ -655,6 +689,38 @@ int main(int argc, char** argv)
 			seed = atoi(optarg);
 			break;
 
+		case 'j':
+			timer_mgr_type = optarg;
+			break;
+
+		case 'k':
+			timer_bench = 1;
+			break;
+
+		case 'o':
+			reassem_bench = 1;
+			break;
+
+		case 'q':
+			use_bytecode = 1;
+			break;
+
+		case 'u':
+			bytecode_bench = 1;
+			break;
+
+		case 'c':
+			print_unused_events = 1;
+			break;
+
+		case 'A':
+			dfa_cache_file = optarg;
+			break;
+
+		case 'V':
+			rule_profile = 1;
+			break;
+
 		case 'K':
 			MD5((const u_char*) optarg, strlen(optarg), shared_hmac_md5_key);
 			hmac_key_set = 1;
@@ -763,6 +829,14 @@ int main(int argc, char** argv)
 	bro_start_time = current_time(true);
 
 	reporter = new Reporter();
+	val_mgr = new ValManager();
+
+	if ( dfa_cache_file )
+		{
+		dfa_cache = new DFA_Cache(dfa_cache_file);
+		dfa_cache->Load();
+		}
+
 	thread_mgr = new threading::Manager();
 	plugin_mgr = new plugin::Manager();
 
@@ -803,8 +877,29 @@ int main(int argc, char** argv)
 	createCurrentDoc("1.0");		// Set a global XML document
 #endif
 
-	timer_mgr = new PQ_TimerMgr("<GLOBAL>");
-	// timer_mgr = new CQ_TimerMgr();
+	if ( streq(timer_mgr_type, "pq") )
+		timer_mgr = new PQ_TimerMgr("<GLOBAL>");
+	else if ( streq(timer_mgr_type, "cq") )
+		timer_mgr = new CQ_TimerMgr("<GLOBAL>");
+	else if ( streq(timer_mgr_type, "wheel") )
+		timer_mgr = new TW_TimerMgr("<GLOBAL>");
+	else
+		{
+		fprintf(stderr, "unknown timer manager '%s'\n", timer_mgr_type);
+		exit(1);
+		}
+
+	if ( timer_bench )
+		{
+		timer_benchmark(1000000, 5000000);
+		exit(0);
+		}
+
+	if ( reassem_bench )
+		{
+		reassembler_benchmark(50000);
+		exit(0);
+		}
 
 	broxygen_mgr = new broxygen::Manager(broxygen_config, bro_argv[0]);
 
@@ -979,6 +1074,11 @@ int main(int argc, char** argv)
 
 	delete [] script_rule_files;
 
+	if ( dfa_cache )
+		// Scripts and signatures have compiled their patterns by now;
+		// later ones get saved on termination.
+		dfa_cache->Save();
+
 	if ( g_policy_debug )
 		// ### Add support for debug command file.
 		dbg_init_debugger(0);
@@ -1083,6 +1183,22 @@ int main(int argc, char** argv)
 		exit(0);
 		}
 
+	if ( bytecode_bench )
+		{
+		bytecode_benchmark(10000);
+		exit(0);
+		}
+
+	ScriptUsage script_usage;
+	script_usage.DisableDeadHandlers();
+
+	if ( print_unused_events )
+		{
+		script_usage.Analyze();
+		script_usage.Describe(stdout);
+		exit(0);
+		}
+
 	if ( profiling_interval > 0 )
 		{
 		profiling_logger = new ProfileLogger(profiling_file->AsFile(),
@@ -1147,7 +1263,7 @@ int main(int argc, char** argv)
 
 		val_list* vl = new val_list;
 		vl->append(new StringVal(i->name.c_str()));
-		vl->append(new Val(i->include_level, TYPE_COUNT));
+		vl->append(val_mgr->GetCount(i->include_level));
 		mgr.QueueEvent(bro_script_loaded, vl);
 		}
 
@@ -68,6 +68,8 @@ void Manager::AddMsgThread(MsgThread* thread)
 void Manager::GetFds(iosource::FD_Set* read, iosource::FD_Set* write,
                      iosource::FD_Set* except)
 	{
+	for ( msg_thread_list::iterator i = msg_threads.begin(); i != msg_threads.end(); i++ )
+		read->Insert((*i)->OutFD());
 	}
 
 double Manager::NextTimestamp(double* network_time)
@@ -359,30 +359,62 @@ BasicInputMessage* MsgThread::RetrieveIn()
 	return msg;
 	}
 
+int MsgThread::RetrieveIn(BasicInputMessage** msgs, int max)
+	{
+	int n = queue_in.GetBatch(msgs, max);
+
+#ifdef DEBUG
+	for ( int i = 0; i < n; ++i )
+		{
+		string s = Fmt("Retrieved '%s' in %s",  msgs[i]->Name(), Name());
+		Debug(DBG_THREADING, s.c_str());
+		}
+#endif
+
+	return n;
+	}
+
 void MsgThread::Run()
 	{
+	// Taking messages off the queue in batches saves on synchronization
+	// with the main thread when it's sending a lot of them.
+	static const int MAX_BATCH = 64;
+	BasicInputMessage* msgs[MAX_BATCH];
+
 	while ( ! (child_finished || Killed() ) )
 		{
-		BasicInputMessage* msg = RetrieveIn();
+		int n = RetrieveIn(msgs, MAX_BATCH);
 
-		if ( ! msg )
-			continue;
+		for ( int i = 0; i < n; ++i )
+			{
+			BasicInputMessage* msg = msgs[i];
 
-		bool result = msg->Process();
+			if ( child_finished || Killed() )
+				{
+				// Too late for the rest of the batch.
+				delete msg;
+				continue;
+				}
 
-		delete msg;
+			bool result = msg->Process();
 
-		if ( ! result )
-			{
-			Error("terminating thread");
-
-			// This will eventually kill this thread, but only
-			// after all other outgoing messages (in particular
-			// error messages have been processed by then main
-			// thread).
-			SendOut(new KillMeMessage(this));
-			failed = true;
+			delete msg;
+
+			if ( ! result )
+				{
+				Error("terminating thread");
+
+				// This will eventually kill this thread, but only
+				// after all other outgoing messages (in particular
+				// error messages have been processed by then main
+				// thread).
+				SendOut(new KillMeMessage(this));
+				failed = true;
+				}
 			}
+
+		if ( n > 0 )
+			OnBatchProcessed();
 		}
 
 	// In case we haven't sent the finish method yet, do it now. Reading
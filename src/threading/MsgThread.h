@@ -219,6 +219,13 @@ protected:
 	 */
 	virtual bool OnFinish(double network_time) = 0;
 
+	/**
+	 * Triggered for execution in the child thread after it has processed
+	 * a batch of input messages.  Work that benefits from being done for
+	 * several messages at once can be deferred to here.
+	 */
+	virtual void OnBatchProcessed()	{ }
+
 	/**
 	 * Overriden from BasicThread.
 	 *
@@ -240,6 +247,20 @@ private:
 	 */
 	BasicInputMessage* RetrieveIn();
 
+	/**
+	 * Pops up to \a max messages sent by the main thread at once.
+	 *
+	 * Must only be called by the child thread.
+	 *
+	 * @param msgs An array to store the messages in, with ownership
+	 * passed to caller.
+	 *
+	 * @param max The size of the array.
+	 *
+	 * @return The number of messages retrieved, which may be zero.
+	 */
+	int RetrieveIn(BasicInputMessage** msgs, int max);
+
 	/**
 	 * Queues a message for the child.
 	 *
@@ -280,11 +301,18 @@ private:
 
 	/**
 	 * Returns true if there might be at least one message pending for
-	 * the main thread. This function may occasionally return a value not
-	 * indicating the actual state, but won't do so very often.
+	 * the main thread. This is cheaper than HasOut(), but the answer
+	 * may be outdated by the time the caller acts on it.
 	 */
 	bool MightHaveOut() { return queue_out.MaybeReady(); }
 
+	/**
+	 * Returns a file descriptor that becomes ready for reading when the
+	 * child queues a message for the main thread after HasOut() has
+	 * returned false.
+	 */
+	int OutFD() const	{ return queue_out.FD(); }
+
 	/** Sends a message to the main thread signaling that the child process
 	 *  has finished processing. Called from child.
 	 */
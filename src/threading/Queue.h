@@ -2,12 +2,12 @@
 #define THREADING_QUEUE_H
 
 #include <pthread.h>
-#include <queue>
-#include <deque>
 #include <stdint.h>
-#include <sys/time.h>
+#include <poll.h>
+#include <errno.h>
 
 #include "Reporter.h"
+#include "Flare.h"
 #include "BasicThread.h"
 
 #undef Queue // Defined elsewhere unfortunately.
@@ -17,13 +17,14 @@ namespace threading {
 /**
  * A thread-safe single-reader single-writer queue.
  *
- * The implementation uses multiple queues and reads/writes in rotary fashion
- * in an attempt to limit contention.
+ * The implementation is lock-free: elements go into a linked list of
+ * fixed-size chunks, and the two sides synchronize only through atomic
+ * read and write counters. The writer never blocks; the list grows as
+ * needed. A reader waiting for input sleeps on a flare that the writer
+ * fires when it puts something into an empty queue. Its file descriptor
+ * is available through FD(), so that a reader can also select() on it.
  *
  * All Queue instances must be instantiated by Bro's main thread.
- *
- * TODO: Unclear how critical performance is for this qeueue. We could like;y
- * optimize it further if helpful.
  */
 template<typename T>
 class Queue
@@ -47,35 +48,66 @@ public:
 	 * Retrieves one element. This may block for a little while of no
 	 * input is available and eventually return with a null element if
 	 * nothing shows up.
+	 *
+	 * Must only be called by the reader.
 	 */
 	T Get();
 
+	/**
+	 * Retrieves up to \a max elements at once. Blocks like Get() if
+	 * there's nothing to retrieve.
+	 *
+	 * Must only be called by the reader.
+	 *
+	 * @param data An array to store the elements in.
+	 *
+	 * @param max The size of the array.
+	 *
+	 * @return The number of elements retrieved, which may be zero.
+	 */
+	int GetBatch(T* data, int max);
+
 	/**
 	 * Queues one element.
+	 *
+	 * Must only be called by the writer.
 	 */
 	void Put(T data);
 
 	/**
-	 * Returns true if the next Get() operation will succeed.
+	 * Queues \a n elements at once, waking up the reader at most once.
+	 *
+	 * Must only be called by the writer.
+	 */
+	void PutBatch(const T* data, int n);
+
+	/**
+	 * Returns true if the next Get() operation will succeed. If not,
+	 * this also resets FD() until the writer puts the next element.
+	 *
+	 * Must only be called by the reader.
 	 */
 	bool Ready();
 
 	/**
-	 * Returns true if the next Get() operation might succeed. This
-	 * function may occasionally return a value not indicating the actual
-	 * state, but won't do so very often. Note that this means that it can
-	 * consistently return false even if there is something in the Queue.
-	 * You have to check real queue status from time to time to be sure that
-	 * it is empty. In other words, this method helps to avoid locking the queue
-	 * frequently, but doesn't allow you to forgo it completely.
+	 * Returns true if the next Get() operation might succeed. This is
+	 * cheaper than Ready() as it just compares the counters, but the
+	 * answer may be outdated by the time the caller acts on it.
 	 */
-	bool MaybeReady() { return (num_reads != num_writes); }
+	bool MaybeReady()
+		{ return __atomic_load_n(&num_writes, __ATOMIC_RELAXED) != num_reads; }
 
 	/** Wake up the reader if it's currently blocked for input. This is
 	 primarily to give it a chance to check termination quickly.
 	**/
 	void WakeUp();
 
+	/**
+	 * Returns a file descriptor that becomes ready for reading when the
+	 * writer queues something after the reader found the queue empty.
+	 */
+	int FD() const	{ return flare.FD(); }
+
 	/**
 	 * Returns the number of queued items not yet retrieved.
 	 */
@@ -98,179 +130,240 @@ public:
 	void GetStats(Stats* stats);
 
 private:
-	static const int NUM_QUEUES = 8;
+	static const int CHUNK_SIZE = 512;
 
-	pthread_mutex_t mutex[NUM_QUEUES];	// Mutex protected shared accesses.
-	pthread_cond_t has_data[NUM_QUEUES];	// Signals when data becomes available
-	std::queue<T> messages[NUM_QUEUES];	// Actually holds the queued messages
+	struct Chunk {
+		T items[CHUNK_SIZE];
+		Chunk* next;
+	};
 
-	int read_ptr;	// Where the next operation will read from
-	int write_ptr;	// Where the next operation will write to
+	// Blocks until the flare fires or the timeout (in milliseconds)
+	// expires.
+	void Wait(int timeout);
 
-	BasicThread* reader;
-	BasicThread* writer;
+	// Tells the reader that there's new data if it may be waiting.
+	void Signal();
+
+	Chunk* NewChunk();
+	void RecycleChunk(Chunk* c);
 
-	// Statistics.
+	// Accessed only by the reader, except for num_reads, which the
+	// writer reads.
+	Chunk* head;	// Where the next element will be read from
+	int head_pos;
 	uint64_t num_reads;
+
+	// Keep the two sides' fields in separate cache lines.
+	char pad[64];
+
+	// Accessed only by the writer, except for num_writes, which the
+	// reader reads.
+	Chunk* tail;	// Where the next element will be written to
+	int tail_pos;
 	uint64_t num_writes;
-};
 
-inline static void safe_lock(pthread_mutex_t* mutex)
-	{
-	int res = pthread_mutex_lock(mutex);
-	if ( res != 0 )
-		reporter->FatalErrorWithCore("cannot lock mutex: %d(%s)", res, strerror(res));
-	}
+	char pad2[64];
 
-inline static void safe_unlock(pthread_mutex_t* mutex)
-	{
-	if ( pthread_mutex_unlock(mutex) != 0 )
-		reporter->FatalErrorWithCore("cannot unlock mutex");
-	}
+	// Shared.
+	Chunk* spare;	// A consumed chunk kept for reuse
+	int signaled;	// Set when the flare has been fired
+	bro::Flare flare;
+
+	BasicThread* reader;
+	BasicThread* writer;
+};
 
 template<typename T>
 inline Queue<T>::Queue(BasicThread* arg_reader, BasicThread* arg_writer)
 	{
-	read_ptr = 0;
-	write_ptr = 0;
+	head = tail = new Chunk;
+	head->next = 0;
+	head_pos = tail_pos = 0;
 	num_reads = num_writes = 0;
+	spare = 0;
+	signaled = 0;
 	reader = arg_reader;
 	writer = arg_writer;
-
-	for( int i = 0; i < NUM_QUEUES; ++i )
-		{
-		if ( pthread_cond_init(&has_data[i], 0) != 0 )
-			reporter->FatalError("cannot init queue condition variable");
-
-		if ( pthread_mutex_init(&mutex[i], 0) != 0 )
-			reporter->FatalError("cannot init queue mutex");
-		}
 	}
 
 template<typename T>
 inline Queue<T>::~Queue()
 	{
-	for( int i = 0; i < NUM_QUEUES; ++i )
+	while ( head )
 		{
-		pthread_cond_destroy(&has_data[i]);
-		pthread_mutex_destroy(&mutex[i]);
+		Chunk* next = head->next;
+		delete head;
+		head = next;
 		}
+
+	delete spare;
 	}
 
 template<typename T>
-inline T Queue<T>::Get()
+inline typename Queue<T>::Chunk* Queue<T>::NewChunk()
 	{
-	safe_lock(&mutex[read_ptr]);
+	Chunk* c = __atomic_exchange_n(&spare, (Chunk*) 0, __ATOMIC_ACQUIRE);
 
-	int old_read_ptr = read_ptr;
+	if ( ! c )
+		c = new Chunk;
 
-	if ( messages[read_ptr].empty() && ! ((reader && reader->Killed()) || (writer && writer->Killed())) )
-		{
-		struct timespec ts;
-		ts.tv_sec = time(0) + 5;
-		ts.tv_nsec = 0;
+	c->next = 0;
+	return c;
+	}
+
+template<typename T>
+inline void Queue<T>::RecycleChunk(Chunk* c)
+	{
+	delete __atomic_exchange_n(&spare, c, __ATOMIC_RELEASE);
+	}
+
+template<typename T>
+inline T Queue<T>::Get()
+	{
+	T data;
 
-		pthread_cond_timedwait(&has_data[read_ptr], &mutex[read_ptr], &ts);
-		safe_unlock(&mutex[read_ptr]);
+	if ( ! GetBatch(&data, 1) )
 		return 0;
-		}
 
-	else if ( messages[read_ptr].empty() )
+	return data;
+	}
+
+template<typename T>
+inline int Queue<T>::GetBatch(T* data, int max)
+	{
+	if ( ! Ready() )
 		{
-		safe_unlock(&mutex[read_ptr]);
-		return 0;
+		if ( (reader && reader->Killed()) || (writer && writer->Killed()) )
+			return 0;
+
+		Wait(5000);
+
+		if ( ! Ready() )
+			return 0;
 		}
 
-	T data = messages[read_ptr].front();
-	messages[read_ptr].pop();
+	uint64_t avail = __atomic_load_n(&num_writes, __ATOMIC_ACQUIRE) - num_reads;
+	int n = avail < uint64_t(max) ? int(avail) : max;
 
-	read_ptr = (read_ptr + 1) % NUM_QUEUES;
-	++num_reads;
+	for ( int i = 0; i < n; ++i )
+		{
+		data[i] = head->items[head_pos];
+
+		if ( ++head_pos == CHUNK_SIZE )
+			{
+			// The writer linked in the next chunk before
+			// publishing this chunk's last element.
+			Chunk* next = head->next;
+			RecycleChunk(head);
+			head = next;
+			head_pos = 0;
+			}
+		}
 
-	safe_unlock(&mutex[old_read_ptr]);
+	__atomic_store_n(&num_reads, num_reads + n, __ATOMIC_SEQ_CST);
 
-	return data;
+	return n;
 	}
 
 template<typename T>
 inline void Queue<T>::Put(T data)
 	{
-	safe_lock(&mutex[write_ptr]);
-
-	int old_write_ptr = write_ptr;
-
-	bool need_signal = messages[write_ptr].empty();
+	PutBatch(&data, 1);
+	}
 
-	messages[write_ptr].push(data);
+template<typename T>
+inline void Queue<T>::PutBatch(const T* data, int n)
+	{
+	if ( n <= 0 )
+		return;
 
-	if ( need_signal )
-		pthread_cond_signal(&has_data[write_ptr]);
+	for ( int i = 0; i < n; ++i )
+		{
+		tail->items[tail_pos] = data[i];
+
+		if ( ++tail_pos == CHUNK_SIZE )
+			{
+			Chunk* c = NewChunk();
+			tail->next = c;
+			tail = c;
+			tail_pos = 0;
+			}
+		}
 
-	write_ptr = (write_ptr + 1) % NUM_QUEUES;
-	++num_writes;
+	uint64_t old_writes = num_writes;
+	__atomic_store_n(&num_writes, old_writes + n, __ATOMIC_SEQ_CST);
 
-	safe_unlock(&mutex[old_write_ptr]);
+	// If the reader hadn't caught up with us, it'll see the new
+	// elements without being woken. Otherwise it may be about to wait.
+	// The sequentially consistent accesses on both sides guarantee that
+	// either we see it caught up here, or it sees our update before it
+	// waits.
+	if ( __atomic_load_n(&num_reads, __ATOMIC_SEQ_CST) == old_writes )
+		Signal();
 	}
 
+template<typename T>
+inline void Queue<T>::Signal()
+	{
+	if ( ! __atomic_exchange_n(&signaled, 1, __ATOMIC_SEQ_CST) )
+		flare.Fire();
+	}
 
 template<typename T>
 inline bool Queue<T>::Ready()
 	{
-	safe_lock(&mutex[read_ptr]);
-
-	bool ret = (messages[read_ptr].size());
+	if ( __atomic_load_n(&num_writes, __ATOMIC_SEQ_CST) != num_reads )
+		return true;
 
-	safe_unlock(&mutex[read_ptr]);
+	if ( __atomic_load_n(&signaled, __ATOMIC_SEQ_CST) )
+		{
+		// Reset the flare before checking once more, so that a Put()
+		// racing with us either shows up in that check or fires
+		// the flare again.
+		flare.Extinguish();
+		__atomic_store_n(&signaled, 0, __ATOMIC_SEQ_CST);
+		}
 
-	return ret;
+	return __atomic_load_n(&num_writes, __ATOMIC_SEQ_CST) != num_reads;
 	}
 
 template<typename T>
-inline uint64_t Queue<T>::Size()
+inline void Queue<T>::Wait(int timeout)
 	{
-	// Need to lock all queues.
-	for ( int i = 0; i < NUM_QUEUES; i++ )
-		safe_lock(&mutex[i]);
+	struct pollfd pfd;
+	pfd.fd = flare.FD();
+	pfd.events = POLLIN;
+	pfd.revents = 0;
 
-	uint64_t size = 0;
-
-	for ( int i = 0; i < NUM_QUEUES; i++ )
-		size += messages[i].size();
+	if ( poll(&pfd, 1, timeout) < 0 && errno != EINTR )
+		reporter->FatalErrorWithCore("cannot poll queue: %d(%s)", errno, strerror(errno));
+	}
 
-	for ( int i = 0; i < NUM_QUEUES; i++ )
-		safe_unlock(&mutex[i]);
+template<typename T>
+inline uint64_t Queue<T>::Size()
+	{
+	uint64_t reads = __atomic_load_n(&num_reads, __ATOMIC_ACQUIRE);
+	uint64_t writes = __atomic_load_n(&num_writes, __ATOMIC_ACQUIRE);
 
-	return size;
+	// The reader can't get ahead of the writer, but we may have caught
+	// the counters at different times.
+	return writes > reads ? writes - reads : 0;
 	}
 
 template<typename T>
 inline void Queue<T>::GetStats(Stats* stats)
 	{
-	// To be safe, we look all queues. That's probably unneccessary, but
-	// doesn't really hurt.
-	for ( int i = 0; i < NUM_QUEUES; i++ )
-		safe_lock(&mutex[i]);
-
-	stats->num_reads = num_reads;
-	stats->num_writes = num_writes;
-
-	for ( int i = 0; i < NUM_QUEUES; i++ )
-		safe_unlock(&mutex[i]);
+	stats->num_reads = __atomic_load_n(&num_reads, __ATOMIC_ACQUIRE);
+	stats->num_writes = __atomic_load_n(&num_writes, __ATOMIC_ACQUIRE);
 	}
 
 template<typename T>
 inline void Queue<T>::WakeUp()
 	{
-	for ( int i = 0; i < NUM_QUEUES; i++ )
-		{
-		safe_lock(&mutex[i]);
-		pthread_cond_signal(&has_data[i]);
-		safe_unlock(&mutex[i]);
-		}
+	Signal();
 	}
 
 }
 
 
 #endif
-
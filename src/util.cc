@@ -543,7 +543,7 @@ bool is_printable(const char* s, int len)
 
 const char* fmt_bytes(const char* data, int len)
 	{
-	static char buf[1024];
+	static __thread char buf[1024];
 	char* p = buf;
 
 	for ( int i = 0; i < len && p - buf < int(sizeof(buf)); ++i )
@@ -565,8 +565,9 @@ const char* fmt_bytes(const char* data, int len)
 
 const char* fmt(const char* format, ...)
 	{
-	static char* buf = 0;
-	static unsigned int buf_len = 1024;
+	// Per thread, as the communication thread uses fmt() as well.
+	static __thread char* buf = 0;
+	static __thread unsigned int buf_len = 1024;
 
 	if ( ! buf )
 		buf = (char*) safe_malloc(buf_len);